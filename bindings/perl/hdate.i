@@ -4,6 +4,8 @@
 #include "../../src/hdatepp.h"
 %}
 
+// the range methods of Hdate return packed binary strings
+%include "std_string.i"
 %include ../../src/hdatepp.h
 
 // on linux do:
@@ -4,6 +4,15 @@
 #include "../../src/hdatepp.h"
 %}
 
+// the range methods of Hdate return packed binary strings; as bytes,
+// for struct.unpack, rather than as a str decoded from them
+%include "std_string.i"
+%typemap(out) std::string get_gdate_range, std::string get_hdate_range,
+              std::string get_holyday_range, std::string get_parasha_range,
+              std::string get_zmanim_range
+{
+  $result = PyBytes_FromStringAndSize ($1.data (), $1.size ());
+}
 %include ../../src/hdatepp.h
 
 // on linux do:
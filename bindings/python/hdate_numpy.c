@@ -0,0 +1,360 @@
+/*  hdate_numpy.c - NumPy bulk conversions for libhdate
+ *  http://libhdate.sourceforge.net
+ *
+ *  Each function takes array-likes of any shape, converts them once
+ *  to C int arrays, and runs the libhdate _bulk loop over them with
+ *  the GIL released, so that a column of 10^8 dates costs one call
+ *  rather than one Hdate object per row.
+ *
+ *    import hdate_numpy
+ *    jd = hdate_numpy.gdate_to_jd(df.year, df.month, df.day)
+ *    hy, hm, hd = hdate_numpy.jd_to_hdate(jd)
+ *    df["holyday"] = hdate_numpy.holyday(jd, diaspora=True)
+ *    z = hdate_numpy.zmanim(jd, city.latitude, city.longitude)
+ *    z["sunset"][:, 0]
+ *
+ *  Invalid dates give a julian day of 0, and a julian day of 0 gives
+ *  a date of 0/0/0 and holiday and parasha 0.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#include "hdate.h"
+
+
+/************************************************************
+* as_int_array
+*
+* a C-contiguous array of C int of obj, or NULL with an
+* exception set. Other integer and float types are cast.
+************************************************************/
+static PyArrayObject* as_int_array( PyObject* obj )
+{
+	return (PyArrayObject*) PyArray_FROMANY(obj, NPY_INT, 0, 0,
+								NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+}
+
+
+/************************************************************
+* new_like
+*
+* a new C int array of the shape of template
+************************************************************/
+static PyArrayObject* new_like( PyArrayObject* template )
+{
+	return (PyArrayObject*) PyArray_SimpleNew(PyArray_NDIM(template),
+								PyArray_DIMS(template), NPY_INT);
+}
+
+
+/************************************************************
+* broadcast
+*
+* replaces each of the count arrays with a copy broadcast to
+* their common shape, if it is not of that shape already;
+* returns 0, or -1 with an exception set
+************************************************************/
+static int broadcast( PyArrayObject** array, const int count )
+{
+	PyArrayMultiIterObject* multi;
+	PyArrayObject* copy;
+	int i;
+
+	multi = (PyArrayMultiIterObject*) PyArray_MultiIterFromObjects((PyObject**) array, count, 0);
+	if (multi == NULL) return -1;
+	for (i = 0; i < count; i++)
+	{
+		if (PyArray_SIZE(array[i]) == multi->size) continue;
+		copy = (PyArrayObject*) PyArray_SimpleNew(multi->nd, multi->dimensions,
+												  PyArray_TYPE(array[i]));
+		if ( (copy == NULL) || (PyArray_CopyInto(copy, array[i]) != 0) )
+		{
+			Py_XDECREF(copy);
+			Py_DECREF(multi);
+			return -1;
+		}
+		Py_DECREF(array[i]);
+		array[i] = copy;
+	}
+	Py_DECREF(multi);
+	return 0;
+}
+
+
+/************************************************************
+* date_to_jd
+*
+* shared by gdate_to_jd and hdate_to_jd
+************************************************************/
+static PyObject* date_to_jd( PyObject* args, PyObject* kwds,
+			size_t (*convert)( const int*, const int*, const int*, const size_t, int* ) )
+{
+	static char* keywords[] = { "year", "month", "day", NULL };
+	PyObject* obj[3];
+	PyArrayObject* ymd[3] = { NULL, NULL, NULL };	/// year, month, day
+	PyArrayObject* jd = NULL;
+	int i;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO", keywords,
+									 &obj[0], &obj[1], &obj[2]))
+		return NULL;
+	for (i = 0; i < 3; i++)
+	{
+		ymd[i] = as_int_array(obj[i]);
+		if (ymd[i] == NULL) goto done;
+	}
+	if (broadcast(ymd, 3) != 0) goto done;
+	jd = new_like(ymd[0]);
+	if (jd == NULL) goto done;
+
+	Py_BEGIN_ALLOW_THREADS
+	convert(PyArray_DATA(ymd[2]), PyArray_DATA(ymd[1]), PyArray_DATA(ymd[0]),
+			PyArray_SIZE(jd), PyArray_DATA(jd));
+	Py_END_ALLOW_THREADS
+
+done:
+	for (i = 0; i < 3; i++) Py_XDECREF(ymd[i]);
+	return (PyObject*) jd;
+}
+
+
+/************************************************************
+* jd_to_date
+*
+* shared by jd_to_gdate and jd_to_hdate
+************************************************************/
+static PyObject* jd_to_date( PyObject* args, PyObject* kwds,
+			void (*convert)( const int*, const size_t, int*, int*, int* ) )
+{
+	static char* keywords[] = { "jd", NULL };
+	PyObject* jd_obj;
+	PyArrayObject *jd, *year = NULL, *month = NULL, *day = NULL;
+	PyObject* result = NULL;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", keywords, &jd_obj))
+		return NULL;
+	jd = as_int_array(jd_obj);
+	if (jd == NULL) return NULL;
+	year = new_like(jd);
+	month = new_like(jd);
+	day = new_like(jd);
+	if ( (year == NULL) || (month == NULL) || (day == NULL) ) goto done;
+
+	Py_BEGIN_ALLOW_THREADS
+	convert(PyArray_DATA(jd), PyArray_SIZE(jd),
+			PyArray_DATA(day), PyArray_DATA(month), PyArray_DATA(year));
+	Py_END_ALLOW_THREADS
+
+	result = Py_BuildValue("(OOO)", year, month, day);
+
+done:
+	Py_DECREF(jd);
+	Py_XDECREF(year);
+	Py_XDECREF(month);
+	Py_XDECREF(day);
+	return result;
+}
+
+
+/************************************************************
+* jd_to_code
+*
+* shared by holyday and parasha
+************************************************************/
+static PyObject* jd_to_code( PyObject* args, PyObject* kwds,
+			void (*lookup)( const int*, const size_t, const int, int* ) )
+{
+	static char* keywords[] = { "jd", "diaspora", NULL };
+	PyObject* jd_obj;
+	PyArrayObject *jd, *code;
+	int diaspora = 0;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|p", keywords, &jd_obj, &diaspora))
+		return NULL;
+	jd = as_int_array(jd_obj);
+	if (jd == NULL) return NULL;
+	code = new_like(jd);
+	if (code != NULL)
+	{
+		Py_BEGIN_ALLOW_THREADS
+		lookup(PyArray_DATA(jd), PyArray_SIZE(jd), diaspora, PyArray_DATA(code));
+		Py_END_ALLOW_THREADS
+	}
+	Py_DECREF(jd);
+	return (PyObject*) code;
+}
+
+
+/************************************************************
+* zmanim_dtype
+*
+* the structured dtype of hdate_zmanim, one C int field per
+* member, in order
+************************************************************/
+static PyArray_Descr* zmanim_dtype( void )
+{
+	static const char* names[] = { "first_light", "talit", "sunrise",
+		"shema_magen_avraham", "shema", "amidah", "midday", "mincha_gedola",
+		"mincha_ketana", "plag_hamincha", "sunset", "first_stars",
+		"three_stars", "sun_hour" };
+	const Py_ssize_t count = sizeof(names) / sizeof(names[0]);
+	PyArray_Descr* dtype = NULL;
+	PyObject* fields;
+	Py_ssize_t i;
+
+	if (count * sizeof(int) != sizeof(hdate_zmanim))
+	{
+		PyErr_SetString(PyExc_SystemError, "hdate_zmanim does not match its dtype");
+		return NULL;
+	}
+	fields = PyList_New(count);
+	if (fields == NULL) return NULL;
+	for (i = 0; i < count; i++)
+		PyList_SET_ITEM(fields, i, Py_BuildValue("(ss)", names[i], "i"));
+	PyArray_DescrConverter(fields, &dtype);
+	Py_DECREF(fields);
+	return dtype;
+}
+
+
+/************************************************************
+* zmanim
+*
+* the times of each of the days at each of the locations, as
+* a structured array of shape jd.shape + latitude.shape. The
+* work is split over native threads with the GIL released.
+************************************************************/
+static PyObject* zmanim( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	static char* keywords[] = { "jd", "latitude", "longitude", "threads", NULL };
+	PyObject *jd_obj, *lat_obj, *lon_obj;
+	PyArrayObject* jd;
+	PyArrayObject* location[2] = { NULL, NULL };	/// latitude, longitude
+	PyArrayObject* result = NULL;
+	PyArray_Descr* dtype;
+	npy_intp dims[NPY_MAXDIMS];
+	int threads = 0;
+	int nd, i;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|i", keywords,
+									 &jd_obj, &lat_obj, &lon_obj, &threads))
+		return NULL;
+	jd = as_int_array(jd_obj);
+	if (jd == NULL) return NULL;
+	location[0] = (PyArrayObject*) PyArray_FROMANY(lat_obj, NPY_DOUBLE, 0, 0,
+									NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+	location[1] = (PyArrayObject*) PyArray_FROMANY(lon_obj, NPY_DOUBLE, 0, 0,
+									NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+	if ( (location[0] == NULL) || (location[1] == NULL) ||
+		 (broadcast(location, 2) != 0) )
+		goto done;
+
+	nd = PyArray_NDIM(jd) + PyArray_NDIM(location[0]);
+	if (nd > NPY_MAXDIMS)
+	{
+		PyErr_SetString(PyExc_ValueError, "too many dimensions");
+		goto done;
+	}
+	for (i = 0; i < PyArray_NDIM(jd); i++)
+		dims[i] = PyArray_DIM(jd, i);
+	for (i = 0; i < PyArray_NDIM(location[0]); i++)
+		dims[PyArray_NDIM(jd) + i] = PyArray_DIM(location[0], i);
+	dtype = zmanim_dtype();
+	if (dtype == NULL) goto done;
+	result = (PyArrayObject*) PyArray_NewFromDescr(&PyArray_Type, dtype, nd, dims,
+												   NULL, NULL, 0, NULL);
+	if (result == NULL) goto done;
+
+	Py_BEGIN_ALLOW_THREADS
+	hdate_get_utc_zmanim_bulk(PyArray_DATA(jd), PyArray_SIZE(jd),
+							  PyArray_DATA(location[0]), PyArray_DATA(location[1]),
+							  PyArray_SIZE(location[0]), threads, PyArray_DATA(result));
+	Py_END_ALLOW_THREADS
+
+done:
+	Py_DECREF(jd);
+	Py_XDECREF(location[0]);
+	Py_XDECREF(location[1]);
+	return (PyObject*) result;
+}
+
+
+static PyObject* gdate_to_jd( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return date_to_jd(args, kwds, hdate_gdate_to_jd_bulk);
+}
+
+static PyObject* hdate_to_jd( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return date_to_jd(args, kwds, hdate_hdate_to_jd_bulk);
+}
+
+static PyObject* jd_to_gdate( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return jd_to_date(args, kwds, hdate_jd_to_gdate_bulk);
+}
+
+static PyObject* jd_to_hdate( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return jd_to_date(args, kwds, hdate_jd_to_hdate_bulk);
+}
+
+static PyObject* holyday( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return jd_to_code(args, kwds, hdate_get_holyday_bulk);
+}
+
+static PyObject* parasha( PyObject* self, PyObject* args, PyObject* kwds )
+{
+	return jd_to_code(args, kwds, hdate_get_parasha_bulk);
+}
+
+
+static PyMethodDef hdate_numpy_methods[] = {
+	{ "gdate_to_jd", (PyCFunction) gdate_to_jd, METH_VARARGS | METH_KEYWORDS,
+	  "gdate_to_jd(year, month, day) -> julian days of gregorian dates; 0 if invalid.\n"
+	  "The arguments are broadcast against each other." },
+	{ "hdate_to_jd", (PyCFunction) hdate_to_jd, METH_VARARGS | METH_KEYWORDS,
+	  "hdate_to_jd(year, month, day) -> julian days of Hebrew dates; 0 if invalid.\n"
+	  "Months are 1 (Tishrei) - 12 (Elul); in a leap year, Adar is 13 or 14." },
+	{ "jd_to_gdate", (PyCFunction) jd_to_gdate, METH_VARARGS | METH_KEYWORDS,
+	  "jd_to_gdate(jd) -> (year, month, day) of the gregorian dates" },
+	{ "jd_to_hdate", (PyCFunction) jd_to_hdate, METH_VARARGS | METH_KEYWORDS,
+	  "jd_to_hdate(jd) -> (year, month, day) of the Hebrew dates" },
+	{ "holyday", (PyCFunction) holyday, METH_VARARGS | METH_KEYWORDS,
+	  "holyday(jd, diaspora=False) -> holiday codes, as hdate_get_holyday" },
+	{ "parasha", (PyCFunction) parasha, METH_VARARGS | METH_KEYWORDS,
+	  "parasha(jd, diaspora=False) -> parasha codes, as hdate_get_parasha" },
+	{ "zmanim", (PyCFunction) zmanim, METH_VARARGS | METH_KEYWORDS,
+	  "zmanim(jd, latitude, longitude, threads=0) -> the times of each day at each\n"
+	  "location, in seconds from 00:00 utc, as a structured array of shape\n"
+	  "jd.shape + latitude.shape. threads=0 uses one thread per processor." },
+	{ NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef hdate_numpy_module = {
+	PyModuleDef_HEAD_INIT, "hdate_numpy",
+	"NumPy bulk conversions of libhdate", -1, hdate_numpy_methods,
+	NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_hdate_numpy( void )
+{
+	import_array();
+	return PyModule_Create(&hdate_numpy_module);
+}
@@ -10,6 +10,16 @@
 
 from distutils.core import setup, Extension
 
+# The numpy bulk conversions are built only where numpy is installed
+try:
+    import numpy
+    numpy_modules = [Extension('hdate_numpy', ['hdate_numpy.c','../../src/hdate_bulk.c','../../src/hdate_parse_date.c',
+'../../src/deprecated.c','../../src/hdate_julian.c','../../src/hdate_strings.c',
+'../../src/hdate_holyday.c','../../src/hdate_parasha.c','../../src/hdate_sun_time.c'],
+                                include_dirs = [numpy.get_include(), '../../src'])]
+except ImportError:
+    numpy_modules = []
+
 setup(
     name = "hdate",
     description = "Python Hebrew dates Extension",
@@ -20,6 +30,8 @@ setup(
     
     py_modules = ['hdate'],
     ext_modules=[Extension('_hdate', ['../../src/deprecated.c','../../src/hdate_julian.c','../../src/hdate_strings.c',
-'../../src/hdate_holyday.c','../../src/hdate_parasha.c','../../src/hdate_sun_time.c','hdate_wrap.cxx'])],
+'../../src/hdate_holyday.c','../../src/hdate_parasha.c','../../src/hdate_sun_time.c','../../src/hdate_bulk.c','../../src/hdate_parse_date.c',
+'hdate_wrap.cxx'])]
+              + numpy_modules,
     
 )
@@ -37,3 +37,9 @@ print $h->get_gday() . "," . $h->get_gmonth() . "," . $h->get_gyear() . "\n";
 
 # Print hebrew date: 0 - long format
 print $h->get_format_date (0) . "\n";
+
+# Print the parashiot of the coming 30 days, fetched in one call
+@parashiot = unpack ("l*", $h->get_parasha_range (30));
+for $day (0 .. $#parashiot) {
+	print "$day: $parashiot[$day]\n" if $parashiot[$day];
+}
@@ -38,4 +38,8 @@ echo $h->get_gday().".".$h->get_gmonth().",".$h->get_gyear()."\n";
 # Print hebrew date: 0 - long format
 echo $h->get_format_date(0)."\n";
 
+# Print the parashiot of the coming 30 days, fetched in one call
+foreach (array_values(unpack("l*", $h->get_parasha_range(30))) as $day => $parasha)
+	if ($parasha) echo $day.": ".$parasha."\n";
+
 ?>
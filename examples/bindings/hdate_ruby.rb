@@ -37,3 +37,8 @@ puts "#{h.get_gday()},#{h.get_gmonth()},#{h.get_gyear()}"
 
 # Print hebrew date: 0 - long format
 puts h.get_format_date(0);
+
+# Print the parashiot of the coming 30 days, fetched in one call
+h.get_parasha_range(30).unpack("l*").each_with_index do |parasha, day|
+  puts "#{day}: #{parasha}" if parasha != 0
+end
@@ -42,7 +42,12 @@
 #include <stdio.h>		/// For printf, fopen, fclose, fprintf, snprintf. FILE
 #include <sys/stat.h>	/// for mkdir
 #include <sys/types.h>	/// for mkdir
+#include <sys/mman.h>	/// for mmap
+#include <fcntl.h>		/// for open
+#include <unistd.h>		/// for close, unlink
 #include "local_functions.h" /// hcal,hdate common_functions
+#include "custom_days.h"   /// for custom_days_list
+#include "output_buffer.h" /// for output_stdout
 
 #define EXIT_CODE_BAD_PARMS	1
 
@@ -282,45 +287,57 @@ void test_print_custom_days(int custom_days_cnt, int* jdn_list_ptr, char* string
 
 
 
+
+
+
 /************************************************************
-* read_custom_days_file() - parse 'custom days' file
-*      scans the custom_days file once.
-*      For every legitimate parse, determines if that custom day
-*      is in the requested date range.
-*      If so,
-*      1   gets the julian_day_number and store it in a malloc'ed array
-*      2   use asprintf to append/realloc one of the four description
-*          strings for that entry to a second buffer (which will also
-*          need to be freed)
-*      whether to use a line delimiter or a NULL between strings?
-*      Put the pointer to the final jdn_list (or NULL) in jdn_list_ptr
-*      Put the pointer to the final string_list (or NULL) in string_list_ptr
-*      return the number of items found
+* custom day rules and their compiled index
+*
+* The text file is parsed once into an array of fixed-size
+* rules, which is written next to it as a binary index file
+* (custom_days_v1.8.idx). Later runs mmap that index instead
+* of re-parsing the text, for as long as the text file's size
+* and modification time match those recorded in the index
+* header. Each rule carries a snapshot of the keys (eg.
+* CHESHVAN_30, ADAR_IN_LEAP_YEAR) in effect at its line,
+* because the file assigns those sequentially. The rules are
+* evaluated by libhdate (hdate_custom_days_get).
 ************************************************************/
-//  TODO - advancements/postponements for day_types h/g when erev khag, khag, or motzei khag
-int read_custom_days_file(
-			FILE* config_file,
-			int** jdn_list_ptr, char** string_list_ptr,
-			const int d_todo, const int m_todo, const int y_todo,
-			const char calendar_type,
-			/*****************************************************
-			*  calendar_type should always be consistent with
-			*  d_todo, m_todo, y_todo, ie. there should be no
-			*  need to calculate whether any is G or H
-			*****************************************************/
-			hdate_struct range_start,
-			const int text_short_form, const int text_hebrew_form)
-					/// Values for text_short_form, text_hebrew_form
-					/// are defined in libhdate (hdate_strings.c):
-					/// #define HDATE STRING_SHORT   1
-					/// #define HDATE_STRING_LONG    0
-					/// #define HDATE_STRING_HEBREW  1
-					/// #define HDATE_STRING_LOCAL   0
+#define CUSTOM_DAYS_INDEX_SUFFIX ".idx"
+#define CUSTOM_DAYS_INDEX_MAGIC  "hdcdidx2"
+
+/// text[] order is that of the file's four description fields;
+/// see the index calculation in read_custom_days_file
+#define CUSTOM_DAY_TEXT_FIELDS 4
+
+struct custom_day_rule
+{
+	hdate_custom_day_rule	day;
+	char	symbol;
+	char	text[CUSTOM_DAY_TEXT_FIELDS][MAX_STRING_SIZE_LONG+1];
+};
+
+typedef struct
+{
+	char		magic[8];
+	int			record_size;
+	int			count;
+	long long	source_size;
+	long long	source_mtime_sec;
+	long long	source_mtime_nsec;
+} custom_days_index_header;
+
+
+/************************************************************
+* compile_custom_days_file() - parse 'custom days' file
+*      scans the custom_days file once, and returns the number
+*      of valid custom day definitions found. Puts the pointer
+*      to a malloc'ed array of them in rule_list_ptr.
+************************************************************/
+static int compile_custom_days_file( FILE* config_file, custom_day_rule** rule_list_ptr )
 {
-	/// There are 19 mandatory fields on each line of the custom days fiile,
-	/// but since we will only use one of the four text description options,
-	/// the following is 19 - 3.
-	#define NUMBER_OF_CUSTOM_DAYS_FIELDS 16
+	/// There are 19 mandatory fields on each line of the custom days fiile
+	#define NUMBER_OF_CUSTOM_DAYS_FIELDS 19
 
 	char*	input_string = NULL;
 	size_t	input_str_len = 0;
@@ -331,17 +348,10 @@ int read_custom_days_file(
 	int		key_match_count = 0;
 	int		number_of_items = 0;
 
-	int		leap_adj = 0;
-	int		year_bound_adj = 0;
 	char	custom_day_type = '\0'; /// H, G, h, g
-	#define CUSTOM_SYMBOL_LEN 1
 	char	custom_symbol[2] = {'\0','\0'}; /// single char, and string delimiter
-	int		custom_start_year = 0;
-	int		custom_final_year = 0;
-	int		custom_month = 0;
-	int		custom_day_of_month = 0;
-	int		custom_nth = 0 ;		/// 1 <= n <=  5
-	int		custom_day_of_week = 0;
+	char*	text_ptr[CUSTOM_DAY_TEXT_FIELDS] = {NULL, NULL, NULL, NULL};
+	custom_day_rule rule;
 
 	char*	input_key;
 	int 	input_value;
@@ -364,8 +374,6 @@ int read_custom_days_file(
 	int 	key_adar_in_leap_year = 2;
 	int		i;
 
-
-
 	/// adj[] - array defining weekend adjustments
 	/// valid values are -9 <= n <= 9
 	#define WHEN_SHISHI  5
@@ -375,57 +383,29 @@ int read_custom_days_file(
 	#define WHEN_DAY_3   2
 	#define WHEN_DAY_4   3
 	#define WHEN_DAY_5   4
-	int adj[7] = {0,0,0,0,0,0,0};
-	int temp_jd;
-	hdate_struct custom_day_h;
-	char* print_ptr = NULL;
-	size_t print_len;
-	int* new_jdn_list_ptr = NULL;
-	int* jdn_entry = NULL;
-	char* new_string_ptr = NULL;
-	size_t string_list_buffer_size = sizeof(size_t); /// The first atom of this buffer is the array element size
-	size_t string_list_index = sizeof(size_t);
+	custom_day_rule* new_rule_list_ptr = NULL;
 	#define LIST_INCREMENT        10
 
 
-	/************************************************************
-	* sub-procedure for read_custom_days_file()
-	************************************************************/
-	void free_my_mallocs()
-	{
-		if (print_ptr != NULL) {free(print_ptr); print_ptr = NULL;}
-	}
-
-
-	/************************************************************
-	* begin main section of procedure read_custom_days_file()
-	************************************************************/
-	*jdn_list_ptr = NULL;
-	*string_list_ptr = NULL;
-
-	/// set the size of each element in the text buffer array
-	if   (text_short_form)	print_len = MAX_STRING_SIZE_SHORT;
-	else 					print_len = MAX_STRING_SIZE_LONG;
-
+	*rule_list_ptr = NULL;
 	while ( (bytes_read = getline(&input_string, &input_str_len, config_file)) != -1)
 	{
 		line_count++;
 		errno = 0;
 		if ( (input_string[0] == '#') || (input_string[0] == '\n') || (bytes_read == 0) ) continue;
-		free_my_mallocs();
-		const char* scan_spec[4] = {
-			"%1[gGhHY], %1[][({})a-zA-Z#%^&_=\\;:?.,|-], %u, %u, %u, %u, %u, %u,  %m[^,] , %*m[^,] , %*m[^,] , %*m[^,] , %d, %d, %d, %d, %d, %d, %d",
-			"%1[gGhHY], %1[][({})a-zA-Z#%^&_=\\;:?.,|-], %u, %u, %u, %u, %u, %u, %*m[^,] ,  %m[^,] , %*m[^,] , %*m[^,] , %d, %d, %d, %d, %d, %d, %d",
-			"%1[gGhHY], %1[][({})a-zA-Z#%^&_=\\;:?.,|-], %u, %u, %u, %u, %u, %u, %*m[^,] , %*m[^,] ,  %m[^,] , %*m[^,] , %d, %d, %d, %d, %d, %d, %d",
-			"%1[gGhHY], %1[][({})a-zA-Z#%^&_=\\;:?.,|-], %u, %u, %u, %u, %u, %u, %*m[^,] , %*m[^,] , %*m[^,] ,  %m[^,] , %d, %d, %d, %d, %d, %d, %d" };
-		match_count = sscanf(input_string, scan_spec[ (abs(text_hebrew_form-1)*2) + text_short_form],
-			&custom_day_type, &custom_symbol, &custom_start_year, &custom_final_year, &custom_month, &custom_day_of_month, &custom_nth, &custom_day_of_week,
-			&print_ptr,	&adj[WHEN_SHISHI], &adj[WHEN_SHABBAT], &adj[WHEN_RISHON],
-			&adj[WHEN_DAY_2], &adj[WHEN_DAY_3], &adj[WHEN_DAY_4], &adj[WHEN_DAY_5]);
+		for (i=0; i<CUSTOM_DAY_TEXT_FIELDS; i++)
+			if (text_ptr[i] != NULL) {free(text_ptr[i]); text_ptr[i] = NULL;}
+		memset(&rule, 0, sizeof(rule));
+		match_count = sscanf(input_string,
+			"%1[gGhHY], %1[][({})a-zA-Z#%^&_=\\;:?.,|-], %u, %u, %u, %u, %u, %u,  %m[^,] ,  %m[^,] ,  %m[^,] ,  %m[^,] , %d, %d, %d, %d, %d, %d, %d",
+			&custom_day_type, custom_symbol, &rule.day.start_year, &rule.day.final_year, &rule.day.month, &rule.day.day_of_month, &rule.day.nth, &rule.day.day_of_week,
+			&text_ptr[0], &text_ptr[1], &text_ptr[2], &text_ptr[3],
+			&rule.day.adj[WHEN_SHISHI], &rule.day.adj[WHEN_SHABBAT], &rule.day.adj[WHEN_RISHON],
+			&rule.day.adj[WHEN_DAY_2], &rule.day.adj[WHEN_DAY_3], &rule.day.adj[WHEN_DAY_4], &rule.day.adj[WHEN_DAY_5]);
 		if (errno)
 		{
 			// test this error message
-			error(0,errno,"scan error (a)%d at line %d of custom days file, field %d\n", errno, line_count, (match_count<10 ? match_count+1 : match_count+4) );
+			error(0,errno,"scan error (a)%d at line %d of custom days file, field %d\n", errno, line_count, match_count+1 );
 			continue;
 		}
 		if (match_count != NUMBER_OF_CUSTOM_DAYS_FIELDS)
@@ -500,359 +480,83 @@ int read_custom_days_file(
 			if ( !key_value_found )
 			{
 				if (key_name_found == TRUE) match_count = 1;
-				error(0,errno,"scan error (c)%d at line %d of custom days file, field %d\n", errno, line_count, (match_count<10 ? match_count+1 : match_count+4) );
+				error(0,errno,"scan error (c)%d at line %d of custom days file, field %d\n", errno, line_count, match_count+1 );
 			}
 			continue;
 		}
 
 		/************************************************************
 		* At this point, we have successfully scanned/parsed a line
-		* as a basically valid adjustment line of 19 ( minus 3) fields
-		* and are ready to begin sanity and bounds checking. The
-		* sscanf call above has already insured that the values for
-		* adjustments are signed integers, and for years are
-		* unsigned integers.
+		* as a basically valid adjustment line of 19 fields and are
+		* ready to begin sanity and bounds checking. The sscanf call
+		* above has already insured that the values for adjustments
+		* are signed integers, and for years are unsigned integers.
 		************************************************************/
-		int i;
 		for ( i = 0; i < 7; i++ )
 		{
-			if ( ( adj[i] < -9 ) || ( adj[i] > 9 ) )
-			{
-				error(0,errno,"error at line %d of custom days file, adjustment field %d invalid: %d\n", line_count, i+1, adj[i]);
-				continue;
-			}
+			if ( ( rule.day.adj[i] < -9 ) || ( rule.day.adj[i] > 9 ) )
+				error(0,errno,"error at line %d of custom days file, adjustment field %d invalid: %d\n", line_count, i+1, rule.day.adj[i]);
 		}
 
 		switch ( custom_day_type )
 		{
 		case 'G':
 		case 'g':
-			if ( (custom_start_year < HDATE_GREG_YR_LOWER_BOUND) ||
-				 (custom_start_year > HDATE_GREG_YR_UPPER_BOUND) ||
-				 ( (custom_final_year) &&
-				   ( (custom_start_year > custom_final_year)   ||
-					 (custom_final_year > HDATE_GREG_YR_UPPER_BOUND) ||
-					 (custom_final_year < HDATE_GREG_YR_LOWER_BOUND)
+			if ( (rule.day.start_year < HDATE_GREG_YR_LOWER_BOUND) ||
+				 (rule.day.start_year > HDATE_GREG_YR_UPPER_BOUND) ||
+				 ( (rule.day.final_year) &&
+				   ( (rule.day.start_year > rule.day.final_year)   ||
+					 (rule.day.final_year > HDATE_GREG_YR_UPPER_BOUND) ||
+					 (rule.day.final_year < HDATE_GREG_YR_LOWER_BOUND)
 				 ) ) )
 			{
-				error(0,errno,"parameter error (a)%d at line %d of custom days file, start year: %d. end year: %d\n", errno, line_count, custom_start_year, custom_final_year);
+				error(0,errno,"parameter error (a)%d at line %d of custom days file, start year: %d. end year: %d\n", errno, line_count, rule.day.start_year, rule.day.final_year);
 				continue;
 			}
 			break;
 		case 'H':
 		case 'h':
-			if ( (custom_start_year < HDATE_HEB_YR_LOWER_BOUND) ||
-				 (custom_start_year > HDATE_HEB_YR_UPPER_BOUND) ||
-				 ( (custom_final_year) &&
-				   ( (custom_start_year > custom_final_year)   ||
-					 (custom_final_year > HDATE_HEB_YR_UPPER_BOUND) ||
-					 (custom_final_year < HDATE_HEB_YR_LOWER_BOUND)
+			if ( (rule.day.start_year < HDATE_HEB_YR_LOWER_BOUND) ||
+				 (rule.day.start_year > HDATE_HEB_YR_UPPER_BOUND) ||
+				 ( (rule.day.final_year) &&
+				   ( (rule.day.start_year > rule.day.final_year)   ||
+					 (rule.day.final_year > HDATE_HEB_YR_UPPER_BOUND) ||
+					 (rule.day.final_year < HDATE_HEB_YR_LOWER_BOUND)
 				) ) )
 			{
-				error(0,errno,"parameter error (a)%d at line %d of custom days file, start year: %d. end year: %d\n", errno, line_count, custom_start_year, custom_final_year);
+				error(0,errno,"parameter error (a)%d at line %d of custom days file, start year: %d. end year: %d\n", errno, line_count, rule.day.start_year, rule.day.final_year);
 				continue;
 			}
 			break;
-		} /// end switch ( custom_day_type )
-
-
-		/************************************************************
-		* Perform the relatively easy checks to eliminate ALMOST all
-		* the cases of custom days being out of bounds.
-		************************************************************/
-		//*
-		//* The more difficult cases are those in which a custom day's
-		//* 'adjustments' will make it cross over a year boundary.
-		/************************************************************/
-		/// The bit operation on custom_day_type
-		/// is to make g==G and h==H
-		if (calendar_type == (custom_day_type & 0xdf) )
-		{
-			if ( (y_todo < (custom_start_year - 1) ) ||
-				 ( (y_todo < custom_start_year) &&
-				   ( (m_todo != 12) || (custom_month != 1) || (custom_day_of_month > 9) ||
-				     ( ( (calendar_type == 'G') && (d_todo < 22) ) ||
-					   ( (calendar_type == 'H') && (d_todo < 20) ) ) ) ) ) continue;
-			if ( (custom_final_year != 0) &&
-				 ( (y_todo > (custom_final_year + 1) ) ||
-				   ( (y_todo > custom_final_year) &&
-				     ( (m_todo != 1) || (custom_month != 12) || (d_todo > 9) ||
-				       ( ( (calendar_type == 'G') && (custom_day_of_month < 22) ) ||
-					     ( (calendar_type == 'H') && (custom_day_of_month < 20) ) ) ) ) ) ) continue;
-		}
-		else
-		{
-			if (calendar_type == 'G') /// && (custom_day_type == 'H' or 'h')
-			{
-				if ( (y_todo < (custom_start_year - 3761) ) ||
-					 ( (y_todo == (custom_start_year - 3761) ) && /// aug-dec or tish-shvat may be good
-					   ( (m_todo < 8 /** august **/) || (custom_month > 5 /** shvat **/ ) ) ) ) continue;
-				if ( ( custom_final_year != 0 ) &&
-					 ( (y_todo > (custom_final_year - 3760) ) ||
-					   ( (y_todo == (custom_final_year - 3760) ) && /// jan-oct or kislev-elul may be good
-					     ( (m_todo > 10 /** october **/) || (custom_month < 3 /** kislev **/ ) ) ) ) ) continue;
-			}
-			else /// (calendar_type == 'H') && (custom_day_type == 'G' or 'g')
-			{
-				if ( (y_todo < (custom_start_year + 3760) ) ||
-					 ( (y_todo == (custom_start_year + 3760) ) && /// jan-oct or kislev-elul may be good
-					 ( (m_todo < 3 /** kislev **/) || (custom_month > 10 /** octoner **/ ) ) ) ) continue;
-
-				if ( ( custom_final_year != 0 ) &&
-					 ( (y_todo > (custom_final_year + 3761) ) ||
-					   ( (y_todo == (custom_final_year + 3761) ) && /// aug-dec or tish-shvat may be good
-					   ( (m_todo > 5 /** Shvat **/) || (custom_month < 8 /** august **/ ) ) ) ) ) continue;
-			}
-		}
-		// TODO - d_to_do, m_to_do, y_to_do may still be out of bounds. We
-		// must take into account that adjustments may be +/-9 days which could
-		// bump the year and also Heb year switching in Autumn
-
-		/************************************************************
-		* 1] Perform sanity and bounds checking of the remaining
-		*    parameters scanned/parsed
-		* 2] convert the custom_day to the julian_day_number for the
-		*    year the user requested, and
-		* 3] apply any advancements/postponements.
-		************************************************************/
-		leap_adj = 0;
-		switch ( custom_day_type )
-		{
-		case 'G':
-			/// start by tackling a Feb 29 custom day, when user request is not a leap year
-			if ((custom_month==2) && (custom_day_of_month==29)  &&
-				(!validate_hdate(CHECK_DAY_PARM, custom_day_of_month, custom_month, range_start.gd_year, TRUE, &range_start))	)
-			{
-				if (!key_february_29) continue;
-				if (key_february_29 == -1) leap_adj = -1;
-			}
-			else /// not a Feb 29 custom day
-			{
-				if ((!validate_hdate(CHECK_MONTH_PARM, custom_day_of_month, custom_month, range_start.gd_year, TRUE, &range_start)       ) ||
-					(!validate_hdate(CHECK_DAY_PARM, custom_day_of_month, custom_month, range_start.gd_year, TRUE, &range_start)         )  )
-					continue;
-			}
-			/// deal with cases where an adjustment causes a date to cross between December and January
-			year_bound_adj = 0;
-			if (!d_todo)
-			{
-				if      ((m_todo == 12) && (custom_month ==  1)) year_bound_adj =  1;
-				else if ((m_todo ==  1) && (custom_month == 12)) year_bound_adj = -1;
-			}
-
-			hdate_set_gdate( &custom_day_h, custom_day_of_month + leap_adj, custom_month, range_start.gd_year + year_bound_adj);
-			if (adj[custom_day_h.hd_dw-1])
-			{
-				temp_jd = custom_day_h.hd_jd + adj[custom_day_h.hd_dw-1];
-				hdate_set_jd(&custom_day_h, temp_jd);
-			}
-			if ( (!d_todo) && (y_todo > HDATE_HEB_YR_LOWER_BOUND) && (y_todo != custom_day_h.hd_year) )
-			{
-				hdate_set_gdate( &custom_day_h, custom_day_of_month, custom_month, range_start.gd_year+1);
-				if (adj[custom_day_h.hd_dw-1])
-				{
-					temp_jd = custom_day_h.hd_jd + adj[custom_day_h.hd_dw-1];
-					hdate_set_jd(&custom_day_h, temp_jd);
-				}
-			}
-			break;
-		case 'H':
-			/// tackle Cheshvan 30 or Kislev 30 custom day, when user request hasn't those days
-			if ((custom_day_of_month==30) && ((custom_month==2) || (custom_month==3))  &&
-				(!validate_hdate(CHECK_DAY_PARM, custom_day_of_month, custom_month, range_start.hd_year, TRUE, &range_start))	)
-			{
-				if (!key_hleap[custom_month-2]) continue;
-				else if (key_hleap[custom_month-2] == -1) leap_adj = -1;
-			}
-			/// now deal with Adar II when user request isn't a leap year
-			else if ((custom_month==14) && (custom_day_of_month > 0) &&
-				(custom_day_of_month < 30) && (range_start.hd_size_of_year < 383) )
-			{
-				if (!key_adar_II) continue;
-				else if (key_adar_II == -1) custom_month = 6;
-				else if (key_adar_II == 1) custom_month = 7;
-			}
-			/// now deal with Adar I when user request isn't a leap year
-			else if ((custom_month==13) && (custom_day_of_month > 0) && (range_start.hd_size_of_year < 383) )
-			{
-				if (custom_day_of_month > 30) continue; // ?? This should never be possible !
-				custom_month = 6;
-				if (custom_day_of_month == 30)
-				{
-					if (!key_adar_I_30) continue;
-					else if (key_adar_I_30 == -1) leap_adj = -1;
-				}
-				else ///  (custom_day_of_month < 30)
-				{
-					if (!key_adar_I) continue;
-				}
-			}
-			/// now deal with Adar in a leap year
-			else if ((custom_month==6) && (custom_day_of_month > 0) &&
-				(custom_day_of_month < 31) && (range_start.hd_size_of_year > 355) )
-			{
-				if (key_adar_in_leap_year == 1) custom_month = 13;
-				else if (key_adar_in_leap_year == 2) custom_month = 14;
-				else continue;
-			}
-			else /// not a Cheshvan 30, Kislev 30, or Adar custom day for years that don't have them
-			{
-				if ((!validate_hdate(CHECK_MONTH_PARM, custom_day_of_month, custom_month, range_start.hd_year, TRUE, &range_start)       ) ||
-					(!validate_hdate(CHECK_DAY_PARM, custom_day_of_month, custom_month, range_start.hd_year, TRUE, &range_start)         )  )
-					continue;
-			}
-			/// deal with cases where an adjustment causes a date to cross between Ellul and Tishrei
-			year_bound_adj = 0;
-			if (!d_todo)
-			{
-				if      ((m_todo == 12) && (custom_month ==  1)) year_bound_adj =  1;
-				else if ((m_todo ==  1) && (custom_month == 12)) year_bound_adj = -1;
-			}
-
-			hdate_set_hdate( &custom_day_h, custom_day_of_month + leap_adj, custom_month, range_start.hd_year + year_bound_adj);
-			if (adj[custom_day_h.hd_dw-1])
-			{
-				temp_jd = custom_day_h.hd_jd + adj[custom_day_h.hd_dw-1];
-				hdate_set_jd(&custom_day_h, temp_jd);
-			}
-			if ( (!d_todo) && (y_todo <= HDATE_HEB_YR_LOWER_BOUND) && (y_todo != custom_day_h.gd_year) )
-			{
-				hdate_set_hdate( &custom_day_h, custom_day_of_month, custom_month, range_start.hd_year+1); //?
-				if (adj[custom_day_h.hd_dw-1])
-				{
-					temp_jd = custom_day_h.hd_jd + adj[custom_day_h.hd_dw-1];
-					hdate_set_jd(&custom_day_h, temp_jd);
-				}
-			}
-			break;
-		case 'g':
-			if ((!validate_hdate(CHECK_MONTH_PARM, 1, custom_month, range_start.gd_year, TRUE, &range_start)                         ) ||
-				(custom_nth < 1) || (custom_nth > 5) ||
-				(custom_day_of_week < 1) || (custom_day_of_week > 7) )
-				continue;
-			hdate_set_gdate( &custom_day_h, 1, custom_month, range_start.gd_year);
-			temp_jd = custom_day_h.hd_jd + ((custom_nth-1) * 7) + (custom_day_of_week - custom_day_h.hd_dw);
-			hdate_set_jd(&custom_day_h, temp_jd);
-			if ((custom_nth==5) && ( custom_month != custom_day_h.gd_mon))
-			{
-				if ( (!d_todo) && (y_todo > HDATE_HEB_YR_LOWER_BOUND) && (y_todo != custom_day_h.hd_year) )
-				{
-					hdate_set_gdate( &custom_day_h, 1, custom_month, range_start.gd_year+1);
-					temp_jd = custom_day_h.hd_jd + ((custom_nth-1) * 7) + (custom_day_of_week - custom_day_h.hd_dw);
-					hdate_set_jd(&custom_day_h, temp_jd);
-					if ((custom_nth==5) && ( custom_month != custom_day_h.gd_mon)) continue;
-				}
-				else continue;
-			}
-			else if ( (!d_todo) && (y_todo > HDATE_HEB_YR_LOWER_BOUND) && (y_todo != custom_day_h.hd_year) )
-			{
-				hdate_set_gdate( &custom_day_h, 1, custom_month, range_start.gd_year+1);
-				temp_jd = custom_day_h.hd_jd + ((custom_nth-1) * 7) + (custom_day_of_week - custom_day_h.hd_dw);
-				hdate_set_jd(&custom_day_h, temp_jd);
-				if ((custom_nth==5) && ( custom_month != custom_day_h.gd_mon)) continue;
-			}
-			// perform adjustments and verify (again!?!)
-			break;
-		case 'h':
-			if ((!validate_hdate(CHECK_MONTH_PARM, 1, custom_month, range_start.hd_year, TRUE, &range_start)                          )||
-				(custom_nth < 1) || (custom_nth > 5) ||
-				(custom_day_of_week < 1) || (custom_day_of_week > 7) )
-				continue;
-			hdate_set_hdate( &custom_day_h, 1, custom_month, range_start.hd_year);
-			temp_jd = custom_day_h.hd_jd + ((custom_nth-1) * 7) + (custom_day_of_week - custom_day_h.hd_dw);
-			hdate_set_jd(&custom_day_h, temp_jd);
-			if ((custom_nth==5) && ( custom_month != custom_day_h.hd_mon))
-			{
-				if ( (!d_todo) && (y_todo <= HDATE_HEB_YR_LOWER_BOUND) && (y_todo != custom_day_h.gd_year) )
-				{
-					hdate_set_hdate( &custom_day_h, 1, custom_month, range_start.hd_year+1);
-					temp_jd = custom_day_h.hd_jd + ((custom_nth-1) * 7) + (custom_day_of_week - custom_day_h.hd_dw);
-					hdate_set_jd(&custom_day_h, temp_jd);
-					if ((custom_nth==5) && ( custom_month != custom_day_h.hd_mon)) continue;
-				}
-				else continue;
-			}
-			else if ( (!d_todo) && (y_todo <= HDATE_HEB_YR_LOWER_BOUND) && (y_todo != custom_day_h.gd_year) )
-			{
-				hdate_set_hdate( &custom_day_h, 1, custom_month, range_start.hd_year+1);
-				temp_jd = custom_day_h.hd_jd + ((custom_nth-1) * 7) + (custom_day_of_week - custom_day_h.hd_dw);
-				hdate_set_jd(&custom_day_h, temp_jd);
-				if ((custom_nth==5) && ( custom_month != custom_day_h.hd_mon)) continue;
-			}
-			// perform adjustments and verify (again!?!)
-			break;
 		default:
 			error(0,0,"%s: %c %s %d",N_("internal error: illegal custom day type"),custom_day_type, N_("at line number"), line_count);
-			break;
+			continue;
 		} /// end switch ( custom_day_type )
 
-		/************************************************************
-		* At this point, we have computed the jd of the occurrence
-		* of the parsed line's custom_day for the year in question.
-		* Now we range check it against the interval being processed
-		* - either a single day, single month, or single year. This
-		* is non-trivial because the interval and the parse line may
-		* have been denominated in different calendars.
-		* We are depending upon range_start, a parameter passed to us, being
-		* the correct hdate_struct for the first day of the interval.
-		* We compute the hdate_struct for our jd (if hadn't already
-		* been done in the switch for sanity and bounds checking) and
-		* compare its values to the interval parameters passed to us
-		************************************************************/
-		if (d_todo)
+		rule.day.type = custom_day_type;
+		rule.day.cheshvan_30 = key_hleap[0];
+		rule.day.kislev_30 = key_hleap[1];
+		rule.day.february_29 = key_february_29;
+		rule.day.adar_I_30 = key_adar_I_30;
+		rule.day.adar_I = key_adar_I;
+		rule.day.adar_II = key_adar_II;
+		rule.day.adar_in_leap_year = key_adar_in_leap_year;
+		if (!hdate_custom_day_rule_valid(&rule.day))
 		{
-			/// interval is a single day
-			if (custom_day_h.hd_jd != range_start.hd_jd) continue;
+			error(0,0,"error at line %d of custom days file, invalid month, day, nth, day of week, or adjustment\n", line_count);
+			continue;
 		}
-		else
-		{
-			/// our custom_day is too early
-			if (custom_day_h.hd_jd < range_start.hd_jd) continue;
 
-			if (m_todo)
-			{
-				/// interval is for an entire month
-				if (y_todo > HDATE_HEB_YR_LOWER_BOUND)
-				{
-					if ( m_todo != custom_day_h.hd_mon) continue;
-				}
-				else
-				{
-					if ( m_todo != custom_day_h.gd_mon) continue;
-				}
-			}
-			else
-			{
-				/// (!m) interval is for an entire year
-				if (y_todo > HDATE_HEB_YR_LOWER_BOUND)
-				{
-					if (y_todo != custom_day_h.hd_year) continue;
-				}
-				else if ( y_todo != custom_day_h.gd_year) continue;
-			}
-		}
+		/// Fields exceeding the maximum allowed length are truncated
+		rule.symbol = custom_symbol[0];
+		for (i=0; i<CUSTOM_DAY_TEXT_FIELDS; i++)
+			strncpy(rule.text[i], text_ptr[i], MAX_STRING_SIZE_LONG);
 
-		/************************************************************
-		* If we get this far, we can add this custom day to the list
-		* to be returned, and be confident that it will be needed and
-		* used.
-		* 1] increment number of items in list
-		* 2] add the day's jdn to our malloc'ed array
-		* 3] determine which of the four text strings are desired
-		* 		(Heb/Local Long/Short)
-		* 4] realloc/append the text string to string_list
-		*
-		* Values defined in libhdate (hdate_strings.c)
-		*	HDATE STRING_SHORT   1
-		*	HDATE_STRING_LONG    0
-		*	HDATE_STRING_HEBREW  1
-		*	HDATE_STRING_LOCAL   0
-		************************************************************/
-		/// manage jdn target buffer size
+		/// manage target buffer size
 		if (!(number_of_items%LIST_INCREMENT))
 		{
-			new_jdn_list_ptr = realloc(*jdn_list_ptr, sizeof(int)*(number_of_items + LIST_INCREMENT));
-			if (new_jdn_list_ptr == NULL)
+			new_rule_list_ptr = realloc(*rule_list_ptr, sizeof(custom_day_rule)*(number_of_items + LIST_INCREMENT));
+			if (new_rule_list_ptr == NULL)
 			{
 				/// realloc has failed. However, the original pointer and
 				/// all its data are supposed to be fine. For now, let's
@@ -860,58 +564,352 @@ int read_custom_days_file(
 				/// if we've really exhausted memory, we're about to
 				/// seriouly crash anyway
 				// TODO - consider issuing a warning / aborting
-				free_my_mallocs();
-				return number_of_items;
-			}
-			else
-			{
-				*jdn_list_ptr = new_jdn_list_ptr;
-				jdn_entry = ((int*) new_jdn_list_ptr) + number_of_items;
-				new_jdn_list_ptr = NULL;
+				break;
 			}
+			*rule_list_ptr = new_rule_list_ptr;
 		}
+		(*rule_list_ptr)[number_of_items] = rule;
+		number_of_items++;
+	}
+	for (i=0; i<CUSTOM_DAY_TEXT_FIELDS; i++)
+		if (text_ptr[i] != NULL) free(text_ptr[i]);
+	if (input_string != NULL) free(input_string);
+	return number_of_items;
+}
 
-		/// store the custom_day's jdn
-		*jdn_entry = custom_day_h.hd_jd;
-		jdn_entry = jdn_entry + 1;
 
-		/// manage 'text string' target buffer size
-		if (!(number_of_items%LIST_INCREMENT))
+/************************************************************
+* map_custom_days_index
+*
+* mmaps the index file for a custom days file, if the index
+* is a valid one for the current content of that file
+************************************************************/
+static int map_custom_days_index( const char* index_path,
+								  const struct stat* source_stat,
+								  custom_days_list* list )
+{
+	int fd;
+	struct stat index_stat;
+	void* map;
+	const custom_days_index_header* header;
+
+	fd = open(index_path, O_RDONLY);
+	if (fd == -1) return FALSE;
+	if ( (fstat(fd, &index_stat) != 0) ||
+		 (index_stat.st_size < (off_t) sizeof(custom_days_index_header)) )
+	{
+		close(fd);
+		return FALSE;
+	}
+	map = mmap(NULL, index_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return FALSE;
+
+	header = map;
+	if ( (memcmp(header->magic, CUSTOM_DAYS_INDEX_MAGIC, sizeof(header->magic)) != 0) ||
+		 (header->record_size != sizeof(custom_day_rule)) ||
+		 (header->count < 0) ||
+		 (index_stat.st_size != (off_t) ( sizeof(custom_days_index_header) +
+										  sizeof(custom_day_rule) * header->count) ) ||
+		 (header->source_size != source_stat->st_size) ||
+		 (header->source_mtime_sec != source_stat->st_mtim.tv_sec) ||
+		 (header->source_mtime_nsec != source_stat->st_mtim.tv_nsec) )
+	{
+		munmap(map, index_stat.st_size);
+		return FALSE;
+	}
+	list->map = map;
+	list->map_size = index_stat.st_size;
+	list->rule = (const custom_day_rule*) (header + 1);
+	list->count = header->count;
+	return TRUE;
+}
+
+
+/************************************************************
+* write_custom_days_index
+*
+* writes the index file for a custom days file. Failure is
+* silent; the next run will just compile the text file again.
+************************************************************/
+static void write_custom_days_index( const char* index_path,
+									 const struct stat* source_stat,
+									 const custom_day_rule* rule,
+									 const int count )
+{
+	custom_days_index_header header;
+	char* temp_path = NULL;
+	FILE* index_file;
+	int fd;
+	int ok;
+
+	if (asprintf(&temp_path, "%s.XXXXXX", index_path) == -1) return;
+	fd = mkstemp(temp_path);
+	if (fd == -1) { free(temp_path); return; }
+	index_file = fdopen(fd, "w");
+	if (index_file == NULL) { close(fd); unlink(temp_path); free(temp_path); return; }
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CUSTOM_DAYS_INDEX_MAGIC, sizeof(header.magic));
+	header.record_size = sizeof(custom_day_rule);
+	header.count = count;
+	header.source_size = source_stat->st_size;
+	header.source_mtime_sec = source_stat->st_mtim.tv_sec;
+	header.source_mtime_nsec = source_stat->st_mtim.tv_nsec;
+
+	ok = (fwrite(&header, sizeof(header), 1, index_file) == 1) &&
+		 ( (count == 0) ||
+		   (fwrite(rule, sizeof(custom_day_rule), count, index_file) == (size_t) count) );
+	if (fclose(index_file) != 0) ok = FALSE;
+	if ( (!ok) || (rename(temp_path, index_path) != 0) ) unlink(temp_path);
+	free(temp_path);
+}
+
+
+/************************************************************
+* compile_custom_days_engine
+*
+* hands the rules of list to libhdate, which evaluates them
+* lazily, once per year
+************************************************************/
+static void compile_custom_days_engine( custom_days_list* list )
+{
+	hdate_custom_day_rule* day_rules;
+	int i;
+
+	day_rules = malloc( sizeof(hdate_custom_day_rule) * (list->count + 1) );
+	if (day_rules == NULL) return;
+	for (i=0; i<list->count; i++) day_rules[i] = list->rule[i].day;
+	list->engine = hdate_custom_days_new(day_rules, list->count);
+	free(day_rules);
+}
+
+
+/************************************************************
+* load_custom_days
+*
+* fills list with the rules of config_file, either from its
+* index or by compiling it (and then writing its index)
+************************************************************/
+static void load_custom_days( FILE* config_file, const char* config_path,
+							  custom_days_list* list )
+{
+	struct stat source_stat;
+	char* index_path = NULL;
+	custom_day_rule* compiled = NULL;
+
+	memset(list, 0, sizeof(custom_days_list));
+	fflush(config_file);
+	if ( (fstat(fileno(config_file), &source_stat) == 0) &&
+		 (asprintf(&index_path, "%s%s", config_path, CUSTOM_DAYS_INDEX_SUFFIX) != -1) )
+	{
+		if (map_custom_days_index(index_path, &source_stat, list))
 		{
-			string_list_buffer_size = string_list_buffer_size +
-					sizeof(char) * ( (print_len+CUSTOM_SYMBOL_LEN+1) * LIST_INCREMENT);
-			new_string_ptr = realloc(*string_list_ptr, string_list_buffer_size);
-			if (new_string_ptr == NULL)
-			{
-				/// realloc has failed. However, the original pointer and
-				/// all its data are supposed to be fine. For now, let's
-				/// silently abort reading the file because, in practice
-				/// if we've really exhausted memory, we're about to
-				/// seriouly crash anyway
-				// TODO - consider issuing a warning / aborting
-				free_my_mallocs();
-				return number_of_items;
-			}
-			else
-			{
-				*string_list_ptr = new_string_ptr;
-				// FIXME - should only have to do this once,
-				//         upon the initial m(re)alloc.
-				size_t* print_len_ptr = (size_t*) new_string_ptr;
-				*print_len_ptr = print_len;
-				new_string_ptr = NULL;
-			}
+			free(index_path);
+			compile_custom_days_engine(list);
+			return;
 		}
-		/// store the custom_day's text_string
-		memset(*string_list_ptr + string_list_index, custom_symbol[0], sizeof(char) );
+	}
+	else index_path = NULL;
+
+	list->count = compile_custom_days_file(config_file, &compiled);
+	list->compiled = compiled;
+	list->rule = compiled;
+	if (index_path != NULL)
+	{
+		write_custom_days_index(index_path, &source_stat, compiled, list->count);
+		free(index_path);
+	}
+	compile_custom_days_engine(list);
+}
+
+
+/************************************************************
+* free_custom_days
+************************************************************/
+void free_custom_days( custom_days_list* list )
+{
+	hdate_custom_days_free(list->engine);
+	if (list->map != NULL) munmap(list->map, list->map_size);
+	if (list->compiled != NULL) free(list->compiled);
+	memset(list, 0, sizeof(custom_days_list));
+}
+
+
+/************************************************************
+* find_custom_day
+*
+* returns the index of the first custom day on julian day jd
+* in the (sorted) jdn_list, or -1 if there is none. Custom
+* days of the same date remain in the order of the file.
+************************************************************/
+int find_custom_day( const int jd, const int custom_days_cnt, const int* jdn_list_ptr )
+{
+	int low = 0;
+	int high = custom_days_cnt;
+	int middle;
+
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+		if (jdn_list_ptr[middle] < jd) low = middle + 1;
+		else high = middle;
+	}
+	if ( (low < custom_days_cnt) && (jdn_list_ptr[low] == jd) ) return low;
+	return -1;
+}
+
+
+/************************************************************
+* custom_days_interval
+*
+* the julian days of the interval being processed - either a
+* single day, single month, or single year - of which
+* range_start is the first day
+************************************************************/
+static void custom_days_interval( const int d_todo, const int m_todo, const int y_todo,
+								  const char calendar_type, const hdate_struct* range_start,
+								  int* jd_first, int* jd_last )
+{
+	int jd_tishrey1, jd_tishrey1_next_year;
+	int day, month, year;
+
+	*jd_first = range_start->hd_jd;
+	if (d_todo) *jd_last = *jd_first;
+	else if (m_todo)
+	{
+		if (calendar_type == 'H')
+		{
+			/// a Hebrew month has 29 or 30 days
+			*jd_last = hdate_hdate_to_jd(30, m_todo, y_todo, NULL, NULL);
+			hdate_jd_to_hdate(*jd_last, &day, &month, &year, NULL, NULL);
+			if (month != m_todo) *jd_last = *jd_last - 1;
+		}
+		else *jd_last = hdate_gdate_to_jd(
+							hdate_get_size_of_gregorian_month(m_todo, y_todo), m_todo, y_todo);
+	}
+	else
+	{
+		if (calendar_type == 'H')
+		{
+			hdate_hdate_to_jd(1, 1, y_todo, &jd_tishrey1, &jd_tishrey1_next_year);
+			*jd_last = jd_tishrey1_next_year - 1;
+		}
+		else *jd_last = hdate_gdate_to_jd(31, 12, y_todo);
+	}
+}
+
+
+/************************************************************
+* read_custom_days_file() - find the custom days of an interval
+*      Asks libhdate for the custom days of the list's rules in
+*      the requested date range, and
+*      1   stores their julian_day_numbers in a malloc'ed array
+*      2   stores one of the four description strings for each
+*          in a second buffer (which will also need to be freed)
+*      The two arrays are sorted by julian day number, so they
+*      can be searched with find_custom_day(). Custom days of
+*      the same date remain in the order of the file.
+*      Put the pointer to the final jdn_list (or NULL) in jdn_list_ptr
+*      Put the pointer to the final string_list (or NULL) in string_list_ptr
+*      return the number of items found
+************************************************************/
+//  TODO - advancements/postponements for day_types h/g when erev khag, khag, or motzei khag
+int read_custom_days_file(
+			const custom_days_list* list,
+			int** jdn_list_ptr, char** string_list_ptr,
+			const int d_todo, const int m_todo, const int y_todo,
+			const char calendar_type,
+			/*****************************************************
+			*  calendar_type should always be consistent with
+			*  d_todo, m_todo, y_todo, ie. there should be no
+			*  need to calculate whether any is G or H
+			*****************************************************/
+			hdate_struct range_start,
+			const int text_short_form, const int text_hebrew_form)
+					/// Values for text_short_form, text_hebrew_form
+					/// are defined in libhdate (hdate_strings.c):
+					/// #define HDATE STRING_SHORT   1
+					/// #define HDATE_STRING_LONG    0
+					/// #define HDATE_STRING_HEBREW  1
+					/// #define HDATE_STRING_LOCAL   0
+{
+	#define CUSTOM_SYMBOL_LEN 1
+	int number_of_items;
+	int jd_first, jd_last;
+	hdate_custom_day* found = NULL;
+	const hdate_snapshot* snapshot;
+	const custom_day_rule* rule;
+	size_t print_len;
+	int text_field;
+	int i;
+	size_t string_list_index = sizeof(size_t); /// The first atom of this buffer is the array element size
+
+
+	*jdn_list_ptr = NULL;
+	*string_list_ptr = NULL;
+	if ( (list == NULL) || (list->engine == NULL) ) return 0;
+
+	custom_days_interval(d_todo, m_todo, y_todo, calendar_type, &range_start,
+						 &jd_first, &jd_last);
+	/// a snapshot, if it covers the interval, spares evaluating the rules
+	snapshot = list->snapshot;
+	number_of_items = hdate_snapshot_custom_days(snapshot, jd_first, jd_last, NULL, 0);
+	if (number_of_items < 0)
+	{
+		snapshot = NULL;
+		number_of_items = hdate_custom_days_get(list->engine, jd_first, jd_last, NULL, 0);
+	}
+	if (number_of_items <= 0) return 0;
+	found = malloc(sizeof(hdate_custom_day) * number_of_items);
+	if (found == NULL) return 0;
+	if (snapshot != NULL)
+		 number_of_items = hdate_snapshot_custom_days(snapshot, jd_first, jd_last,
+													  found, number_of_items);
+	else number_of_items = hdate_custom_days_get(list->engine, jd_first, jd_last,
+												 found, number_of_items);
+	if (number_of_items <= 0) { free(found); return 0; }
+
+	/************************************************************
+	* Build the two lists to be returned, in date order:
+	* 1] the days' jdn
+	* 2] the days' symbol and text string. The four text strings
+	*    of a rule are (Heb/Local Long/Short); text_field selects
+	*    the desired one, with values defined in libhdate
+	*    (hdate_strings.c)
+	*	HDATE STRING_SHORT   1
+	*	HDATE_STRING_LONG    0
+	*	HDATE_STRING_HEBREW  1
+	*	HDATE_STRING_LOCAL   0
+	************************************************************/
+	if   (text_short_form)	print_len = MAX_STRING_SIZE_SHORT;
+	else 					print_len = MAX_STRING_SIZE_LONG;
+	text_field = (abs(text_hebrew_form-1)*2) + text_short_form;
+
+	*jdn_list_ptr = malloc(sizeof(int) * number_of_items);
+	*string_list_ptr = malloc( sizeof(size_t) +
+			sizeof(char) * ( (print_len+CUSTOM_SYMBOL_LEN+1) * number_of_items) );
+	if ( (*jdn_list_ptr == NULL) || (*string_list_ptr == NULL) )
+	{
+		if (*jdn_list_ptr != NULL) { free(*jdn_list_ptr); *jdn_list_ptr = NULL; }
+		if (*string_list_ptr != NULL) { free(*string_list_ptr); *string_list_ptr = NULL; }
+		free(found);
+		return 0;
+	}
+	*((size_t*) *string_list_ptr) = print_len;
+	for (i=0; i<number_of_items; i++)
+	{
+		rule = &list->rule[found[i].rule];
+		(*jdn_list_ptr)[i] = found[i].jd;
+		memset(*string_list_ptr + string_list_index, rule->symbol, sizeof(char) );
 		string_list_index = string_list_index + sizeof(char);
-		memcpy(*string_list_ptr + string_list_index, print_ptr, (sizeof(char) * print_len) );
+		/// rule->text is null-padded to MAX_STRING_SIZE_LONG+1
+		memcpy(*string_list_ptr + string_list_index, rule->text[text_field], (sizeof(char) * print_len) );
 		string_list_index = string_list_index + ( sizeof(char) * print_len );
 		memset(*string_list_ptr + string_list_index, '\0', sizeof(char));
 		string_list_index = string_list_index + sizeof(char);
-		number_of_items++;
 	}
-	free_my_mallocs();
+	free(found);
 
 	// debug routine
 	// test_print_custom_days(number_of_items, *jdn_list_ptr, *string_list_ptr);
@@ -920,28 +918,44 @@ int read_custom_days_file(
 
 
 /****************************************************
-* read, parse and filter custom_days file
+* the symbol and one description of a rule of a list,
+* as found by hdate_custom_days_get; text_short_form
+* and text_hebrew_form are as for read_custom_days_file.
+* returns NULL if there is no such rule.
+****************************************************/
+const char* get_custom_day_rule_text( const custom_days_list* list,
+						  const int rule, const int text_short_form,
+						  const int text_hebrew_form, char* symbol )
+{
+	if ( (list == NULL) || (rule < 0) || (rule >= list->count) ) return NULL;
+	if (symbol != NULL) *symbol = list->rule[rule].symbol;
+	return list->rule[rule].text[(abs(text_hebrew_form-1)*2) + text_short_form];
+}
+
+
+/****************************************************
+* read, parse and compile custom_days file
 ****************************************************/
 int get_custom_days_file( const char* config_dir,
 						  const char* config_filename,
 						  const char* tz_name_str,
 						  const int quiet_alerts,
-						  FILE** custom_file )
+						  custom_days_list* custom_days )
 {
 	// TODO - create an option for both hcal/hdate to allow a custom path for this file
-	//        pass the default FULL path or the custom FULL path to read_custom_days_file
-	//        and let THAT function open and close the file
-	*custom_file = NULL;
+	FILE *custom_file = NULL;
 	char *custom_file_path = NULL;
 	char *last_slash_location = NULL;
 	int bytes_written = -1;
 
+	memset(custom_days, 0, sizeof(custom_days_list));
+
 	custom_file_path = assemnble_config_file_pathname (
 									config_dir, config_filename,
 									quiet_alerts );
 	if (custom_file_path == NULL) return FALSE;
-	*custom_file = fopen(custom_file_path, "r");
-	if (*custom_file == NULL)
+	custom_file = fopen(custom_file_path, "r");
+	if (custom_file == NULL)
 	{
 		if (errno != ENOENT) { free(custom_file_path); return FALSE; };
 		last_slash_location = strrchr(custom_file_path, '/');
@@ -950,28 +964,134 @@ int get_custom_days_file( const char* config_dir,
 		if ((mkdir(custom_file_path, (mode_t) 0700) != 0) && (errno != EEXIST)) { free(custom_file_path); return FALSE; };
 		*last_slash_location = '/';
 		greetings_to_version_18();
-		if (!quiet_alerts) printf("%s\n", N_("attempting to create a config file ..."));
-		*custom_file = fopen(custom_file_path, "a+");
-		if (*custom_file != NULL)
-			bytes_written = fprintf(*custom_file, "%s", custom_days_file_text);
+		if (!quiet_alerts) output_printf(&output_stdout, "%s\n", N_("attempting to create a config file ..."));
+		custom_file = fopen(custom_file_path, "a+");
+		if (custom_file != NULL)
+			bytes_written = fprintf(custom_file, "%s", custom_days_file_text);
 		if (bytes_written > 0)
 		{
 			if ((tz_name_str == NULL) || (strcmp(tz_name_str, "Asia/Jerusalem") != 0))
-				 bytes_written = fprintf(*custom_file, "%s", custom_israeli_days_text_for_diaspora);
-			else bytes_written = fprintf(*custom_file, "%s", custom_israeli_days_text_for_israel);
+				 bytes_written = fprintf(custom_file, "%s", custom_israeli_days_text_for_diaspora);
+			else bytes_written = fprintf(custom_file, "%s", custom_israeli_days_text_for_israel);
 #ifdef DEBUG
   		if (bytes_written > 0)
-				bytes_written = fprintf(*custom_file, "%s", custom_days_file_debug_text);
+				bytes_written = fprintf(custom_file, "%s", custom_days_file_debug_text);
 #endif
 		}
 		if (bytes_written <= 0)
 		{
 			if (!quiet_alerts) config_file_create_error(errno, custom_file_path);
+			if (custom_file != NULL) fclose(custom_file);
 			{ free(custom_file_path); return FALSE; };
 		}
-		if (!quiet_alerts) printf("%s: %s\n", N_("succeeded creating config file"), custom_file_path);
-		if ( fseek(*custom_file, 0, SEEK_SET) != 0 ) { free(custom_file_path); return FALSE; };
+		if (!quiet_alerts) output_printf(&output_stdout, "%s: %s\n", N_("succeeded creating config file"), custom_file_path);
+		if ( fseek(custom_file, 0, SEEK_SET) != 0 ) { fclose(custom_file); free(custom_file_path); return FALSE; };
 	}
+	load_custom_days(custom_file, custom_file_path, custom_days);
+	fclose(custom_file);
 	free(custom_file_path);
 	return TRUE;
 }
+
+
+/****************************************************
+* read, parse and compile a custom_days file at an
+* explicit path; unlike get_custom_days_file, a missing
+* file is an error, not a cue to create one
+****************************************************/
+int get_custom_days_file_path( const char* custom_file_path,
+						  const int quiet_alerts,
+						  custom_days_list* custom_days )
+{
+	FILE *custom_file = NULL;
+
+	memset(custom_days, 0, sizeof(custom_days_list));
+	custom_file = fopen(custom_file_path, "r");
+	if (custom_file == NULL)
+	{
+		if (!quiet_alerts) error(0, errno, "%s", custom_file_path);
+		return FALSE;
+	}
+	load_custom_days(custom_file, custom_file_path, custom_days);
+	fclose(custom_file);
+	return TRUE;
+}
+
+
+/****************************************************
+* open the calendar snapshot, if there is a current one
+****************************************************/
+hdate_snapshot* get_calendar_snapshot( const char* config_dir,
+								 const char* snapshot_filename,
+								 const int quiet_alerts )
+{
+	char *snapshot_path = NULL;
+	hdate_snapshot* snapshot;
+
+	snapshot_path = assemnble_config_file_pathname (
+								config_dir, snapshot_filename,
+								quiet_alerts );
+	if (snapshot_path == NULL) return NULL;
+	snapshot = hdate_snapshot_open(snapshot_path);
+	free(snapshot_path);
+	return snapshot;
+}
+
+
+/****************************************************
+* write a calendar snapshot of a range of years, with
+* the custom days of the custom_days file. The snapshot
+* becomes stale once the custom_days file is edited.
+****************************************************/
+int write_calendar_snapshot( const char* config_dir,
+								 const char* custom_days_filename,
+								 const char* snapshot_filename,
+								 const char* tz_name_str,
+								 const double lat, const double lon,
+								 const int year_first, const int year_last,
+								 const int quiet_alerts )
+{
+	custom_days_list custom_days;
+	hdate_location location;
+	char *custom_file_path = NULL;
+	char *snapshot_path = NULL;
+	int result = FALSE;
+
+	snapshot_path = assemnble_config_file_pathname (
+								config_dir, snapshot_filename,
+								quiet_alerts );
+	if (!get_custom_days_file(config_dir, custom_days_filename, tz_name_str,
+							  quiet_alerts, &custom_days))
+	{
+		/// not an alert; without it, nothing would say why
+		error(0, errno, "%s: %s", N_("cannot create calendar snapshot"),
+			  (snapshot_path != NULL) ? snapshot_path : snapshot_filename);
+		free(snapshot_path);
+		return FALSE;
+	}
+	custom_file_path = assemnble_config_file_pathname (
+								config_dir, custom_days_filename,
+								quiet_alerts );
+	if ( (custom_file_path != NULL) && (snapshot_path != NULL) )
+	{
+		location.name = NULL;
+		location.tz_name = tz_name_str;
+		location.latitude = lat;
+		location.longitude = lon;
+		if (hdate_snapshot_write(snapshot_path, year_first, year_last,
+								 &location, (tz_name_str == NULL) ? 0 : 1,
+								 custom_days.engine,
+								 (const char* const*) &custom_file_path, 1) == 0)
+		{
+			result = TRUE;
+			if (!quiet_alerts) output_printf(&output_stdout, "%s: %s\n", N_("succeeded creating calendar snapshot"), snapshot_path);
+		}
+		else
+			error(0, errno, "%s: %s", N_("failure attempting to create calendar snapshot"), snapshot_path);
+	}
+	else error(0, 0, "%s: %s", N_("cannot create calendar snapshot"), snapshot_filename);
+	free(custom_file_path);
+	free(snapshot_path);
+	free_custom_days(&custom_days);
+	return result;
+}
@@ -22,18 +22,57 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/// the rules of a custom_days file, either mmap'ed from its
+/// compiled index or compiled into malloc'ed memory, with
+/// the libhdate set that evaluates them
+typedef struct custom_day_rule custom_day_rule;
+typedef struct
+{
+	const custom_day_rule* rule;
+	int count;
+	void* map;					/// the mmap'ed index, or NULL
+	size_t map_size;
+	custom_day_rule* compiled;	/// malloc'ed rules, or NULL
+	hdate_custom_days* engine;	/// the rules, compiled by libhdate
+	const hdate_snapshot* snapshot;	/// if not NULL, consulted before engine
+} custom_days_list;
+
 extern char* get_custom_day_text_ptr(const int index, char* string_list_ptr);
 
 char* get_custom_day_symbol_ptr(const int index, char* string_list_ptr);
 
+const char* get_custom_day_rule_text( const custom_days_list* list,
+								 const int rule, const int text_short_form,
+								 const int text_hebrew_form, char* symbol );
+
 extern int get_custom_days_file( const char* config_dir,
 								 const char* config_filename,
 								 const char* tz_name_str,
 								 const int quiet_alerts,
-								 FILE** custom_file );
+								 custom_days_list* custom_days );
+
+extern int get_custom_days_file_path( const char* custom_file_path,
+								 const int quiet_alerts,
+								 custom_days_list* custom_days );
+
+void free_custom_days( custom_days_list* list );
+
+hdate_snapshot* get_calendar_snapshot( const char* config_dir,
+								 const char* snapshot_filename,
+								 const int quiet_alerts );
+
+int write_calendar_snapshot( const char* config_dir,
+								 const char* custom_days_filename,
+								 const char* snapshot_filename,
+								 const char* tz_name_str,
+								 const double lat, const double lon,
+								 const int year_first, const int year_last,
+								 const int quiet_alerts );
+
+int find_custom_day( const int jd, const int custom_days_cnt, const int* jdn_list_ptr );
 
 int read_custom_days_file(
-			FILE* config_file,
+			const custom_days_list* list,
 			int** jdn_list_ptr, char** string_list_ptr,
 			const int d_todo, const int m_todo, const int y_todo,
 			const char calendar_type,
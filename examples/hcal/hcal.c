@@ -65,12 +65,11 @@
    custom_days_cnt - number of custom days found for interval,
           and the number of entries in each of the associated
           data structures.
-   custom_days_index - presuming custom days are sorted in
-          ascending date order, this is useful for resuming a
-          a scan/search of custom days. However, currently
-          sorting has not been coded.
+   custom_days_index - the index of the custom day most
+          recently found by find_custom_day().
      jdn_list_ptr - a malloc'ed list of {custom_days_cnt} julian
-            day numbers of the custom days found for interval.
+            day numbers of the custom days found for interval,
+            sorted in ascending date order.
      string_list_ptr - a malloc'ed list of {custom_days_cnt}
             uniform lenth strings describing the custom days.
             The first {sizeof(size_t)} bytes is the size of each
@@ -107,11 +106,16 @@
 #include <time.h>		/// For time, tzset
 #include <error.h>		/// For error
 #include <errno.h>		/// For errno
+#include <unistd.h>		/// For fork, dup2, sysconf
+#include <sys/wait.h>	/// For waitpid
+#include <sys/stat.h>	/// For umask, fchmod
 //#include <wchar.h>	/// for unicode character operations
 //#include "memwatch.h"	//  REMOVE - for debugging only
 #include "local_functions.h" /// hcal,hdate common_functions
 #include "custom_days.h" /// hcal,hdate common_functions
 #include "timezone_functions.h"		/// for get_tz_adjustment
+#include "output_buffer.h"		/// for output_stdout
+#include "output_cache.h"		/// for option --cache
 
 
 // Here temporarily for hdate_parse_date
@@ -134,26 +138,26 @@
 #define BAD_CUSTOM_DAY_CNT -1
 
 // for colorization
-#define CODE_BOLD_VIDEO    "%c[1m", 27
-#define CODE_REVERSE_VIDEO "%c[7m", 27
-#define CODE_RESTORE_VIDEO "%c[m", 27
-#define CODE_BLACK         "%c[30m", 27
-#define CODE_LIGHT_RED     "%c[31m", 27
-#define CODE_LIGHT_GREEN   "%c[32m", 27
-#define CODE_LIGHT_BROWN   "%c[33m", 27
-#define CODE_DARK_BLUE     "%c[34m", 27
-#define CODE_LIGHT_PURPLE  "%c[35m", 27
-#define CODE_LIGHT_AQUA    "%c[36m", 27
-#define CODE_LIGHT_GREY    "%c[37m", 27
-#define CODE_BOLD_GREY     "%c[1;30m", 27
-#define CODE_BOLD_RED      "%c[1;31m", 27
-#define CODE_BOLD_GREEN    "%c[1;32m", 27
-#define CODE_BOLD_YELLOW   "%c[1;33m", 27
-#define CODE_BOLD_BLUE     "%c[1;34m", 27
-#define CODE_BOLD_PURPLE   "%c[1;35m", 27
-#define CODE_BOLD_AQUA     "%c[1;36m", 27
-#define CODE_BOLD_WHITE    "%c[1;37m", 27
-#define CODE_BACK_BLUE     "%c[46m", 27
+#define CODE_BOLD_VIDEO    "\033[1m"
+#define CODE_REVERSE_VIDEO "\033[7m"
+#define CODE_RESTORE_VIDEO "\033[m"
+#define CODE_BLACK         "\033[30m"
+#define CODE_LIGHT_RED     "\033[31m"
+#define CODE_LIGHT_GREEN   "\033[32m"
+#define CODE_LIGHT_BROWN   "\033[33m"
+#define CODE_DARK_BLUE     "\033[34m"
+#define CODE_LIGHT_PURPLE  "\033[35m"
+#define CODE_LIGHT_AQUA    "\033[36m"
+#define CODE_LIGHT_GREY    "\033[37m"
+#define CODE_BOLD_GREY     "\033[1;30m"
+#define CODE_BOLD_RED      "\033[1;31m"
+#define CODE_BOLD_GREEN    "\033[1;32m"
+#define CODE_BOLD_YELLOW   "\033[1;33m"
+#define CODE_BOLD_BLUE     "\033[1;34m"
+#define CODE_BOLD_PURPLE   "\033[1;35m"
+#define CODE_BOLD_AQUA     "\033[1;36m"
+#define CODE_BOLD_WHITE    "\033[1;37m"
+#define CODE_BACK_BLUE     "\033[46m"
 #define ELEMENT_WEEKDAY_G      1
 #define ELEMENT_WEEKDAY_H      2
 #define ELEMENT_SHABBAT_DAY    3
@@ -233,6 +237,14 @@ typedef struct {
   time_t epoch_end;       // for dst transition calc
   int menu;
   char* menu_item[MAX_MENU_ITEMS];
+  hdate_snapshot* snapshot;  // precomputed days, or NULL
+  int snapshot_year_first;   // for option --snapshot
+  int snapshot_year_last;
+  int jobs;                  // for option --jobs; 1 = render sequentially
+  char* batch_path;          // for option --batch; manifest of locations
+  char* cache_dir;           // for option --cache; NULL for none
+  cache_key cache_base;      // of the command line and config file
+  char* custom_days_path;    // custom days file, or NULL for the default
 } option_list;
 // END: option_list structure definition
 
@@ -261,7 +273,7 @@ bool in_next = false; // UGH! Temporary global debug variable
 *************************************************/
 int print_version ()
 {
-  printf("hcal (libhdate) 1.8\n\
+  output_printf(&output_stdout, "hcal (libhdate) 1.8\n\
 Copyright (C) 2011-2013, 2022 Boruch Baum; 2004-2010 Yaacov Zamir\n\
 License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n\
 This is free software: you are free to change and redistribute it.\n\
@@ -274,7 +286,7 @@ There is NO WARRANTY, to the extent permitted by law.\n");
 *************************************************/
 void usage_hcal ()
 {
-  printf("%s\n",
+  output_printf(&output_stdout, "%s\n",
 N_("Usage: hcal [options] [coordinates] [timezone] [date_spec]\n\
        hdate [options] [coordinates] [timezone] [julian_day|time_t]\n\n\
        coordinates: -l [NS]yy[.xxx]     -L [EW]xx[.xxx]\n\
@@ -288,7 +300,7 @@ N_("Usage: hcal [options] [coordinates] [timezone] [date_spec]\n\
 *************************************************/
 void try_help_hcal ()
 {
-  printf("%s\n", N_("Try \'hcal --help\' for more information"));
+  output_printf(&output_stdout, "%s\n", N_("Try \'hcal --help\' for more information"));
 }
 
 /**************************************************
@@ -297,7 +309,7 @@ void try_help_hcal ()
 void help ()
 {
   usage_hcal();
-  printf("%s\n", N_("Hebrew calendar\nOPTIONS:\n\
+  output_printf(&output_stdout, "%s\n", N_("Hebrew calendar\nOPTIONS:\n\
    -0 --no-gregorian  default, print only Hebrew month information.\n\
                       exists to override config file setting\n\
    -1 --one-month     over-ride config file setting if you had set\n\
@@ -334,6 +346,23 @@ void help ()
    -L --longitude xx  longitude xx degrees. Negative values are West\n\n\
    --prefer-hebrew    interpret ambiguous mm yy as Hebrew date\n\
    --prefer-gregorian interpret ambiguous mm yy as gregorian date\n\n\
+   --snapshot yyyy[-yyyy]  precompute the holidays, parshiot and custom\n\
+                      days of those gregorian years into a snapshot\n\
+                      file in the config directory, and exit. Later\n\
+                      runs use it until the custom days file changes\n\
+   --jobs[=n]         render the months of a year-long calendar in n\n\
+                      worker processes; default one per processor.\n\
+                      n must follow an =, as in --jobs=4\n\
+   --batch file       print the calendar once for each location listed\n\
+                      in file, into the output file that it names,\n\
+                      --jobs locations at a time. Each line of file is\n\
+                      output latitude longitude timezone\n\
+                        [diaspora|israel|-] [custom_days_file]\n\
+                      '-' takes the value given on the command line\n\
+   --cache dir        keep each month of a year-long calendar in dir,\n\
+                      and reuse it on later runs for as long as none\n\
+                      of its options, location, custom days, time zone\n\
+                      data or locale have changed\n\n\
 All options can be made default in the config file, or menu-ized for\n\
 easy selection.\n\
 Report bugs to: <http://sourceforge.net/tracker/?group_id=63109&atid=502872>\n\
@@ -347,17 +376,17 @@ General help using GNU software: <http://www.gnu.org/gethelp/>\n"));
 *************************************************/
 int html_header ( const int external_css, const int force_hebrew)
 {
-  printf("<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01//EN\"\"http://www.w3.org/TR/html4/strict.dtd\">\n\
+  output_printf(&output_stdout, "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01//EN\"\"http://www.w3.org/TR/html4/strict.dtd\">\n\
 <html>\n\
 <head>\n\
 <meta name=\"generator\" content=\"hcal (libhdate)\">\n\
 <meta http-equiv=\"Content-Type\" content=\"text/html; charset=UTF-8\">\n\
 <style title=\"Normal\" type=\"text/css\" media=\"all\">");
 
-  if (external_css) printf("\n\t@import \"hcal.css\";\n");
+  if (external_css) output_literal(&output_stdout, "\n\t@import \"hcal.css\";\n");
   else
   {
-    printf("\n\
+    output_printf(&output_stdout, "\n\
 img { margin:0; padding: 0;  vertical-align: middle;  border: 0;}\n\
 p {}\n\
 body { background-color: #ffffff; color: #000000; }\n\
@@ -387,17 +416,17 @@ span.gyear { font-size: 24pt; }\n\
 span.hmonth { font-size: 24pt; }\n\
 span.hyear { font-size: 24pt; }\n");
   }
-  printf("</style>\n");
+  output_literal(&output_stdout, "</style>\n");
 
   /// some alternative css styles
-  printf("\n\
+  output_printf(&output_stdout, "\n\
 <link rel=\"alternate stylesheet\" title=\"High contrast\" type=\"text/css\" media=\"screen\" href=\"high_contrast.css\">\n\
 <link rel=\"alternate stylesheet\" title=\"Colorful\" type=\"text/css\" media=\"screen\" href=\"colorful.css\">\n\
 <link rel=\"alternate stylesheet\" title=\"Print\" type=\"text/css\" media=\"all\" href=\"print.css\">\n");
   if ( (force_hebrew) || (hdate_is_hebrew_locale()) )
-    printf("<title>Hebrew Calendar</title>\n</head>\n<body class=\"hebrew\"><center>\n");
+    output_literal(&output_stdout, "<title>Hebrew Calendar</title>\n</head>\n<body class=\"hebrew\"><center>\n");
   else
-    printf("<title>Hebrew Calendar</title>\n</head>\n<body><center>\n");
+    output_literal(&output_stdout, "<title>Hebrew Calendar</title>\n</head>\n<body><center>\n");
   return 0;
 }
 
@@ -408,7 +437,7 @@ span.hyear { font-size: 24pt; }\n");
  *************************************************/
 int html_footer ()
 {
-  printf("<!-- <p>\n\
+  output_printf(&output_stdout, "<!-- <p>\n\
 <a href=\"http://validator.w3.org/check/referer\">\n<img \
 src=\"http://www.w3.org/Icons/valid-html401\"\n\
 alt=\"Valid HTML 4.01!\" height=\"31\" width=\"88\" />\n</a>\n\
@@ -437,7 +466,7 @@ void html_calendar_header( const header_info header, const int calendar_type, in
     else               { align1="left";  bidi_dir="ltr"; }
     h_year_1 = hdate_string(HDATE_STRING_INT, header.h_year_1, HDATE_STRING_LONG, calendar_lang);
     // Hebrew month and year
-    printf("<table width=90%% dir=%s><tr><th align=%s><span class=\"hmonth\">%s </span><span class=\"hyear\">%s</th></tr></table>\n",
+    output_printf(&output_stdout, "<table width=90%% dir=%s><tr><th align=%s><span class=\"hmonth\">%s </span><span class=\"hyear\">%s</th></tr></table>\n",
         bidi_dir, align1,
         hdate_string( HDATE_STRING_HMONTH , header.h_month_2, HDATE_STRING_LONG, calendar_lang),
         h_year_1);
@@ -447,15 +476,15 @@ void html_calendar_header( const header_info header, const int calendar_type, in
     else               { align1="left";  align2="right";  bidi_dir="ltr"; }
     h_year_1 = hdate_string(HDATE_STRING_INT, header.h_year_1, HDATE_STRING_LONG, calendar_lang);
     // Hebrew month and year
-    printf("<table width=90%% dir=%s><tr><th align=%s><span class=\"hmonth\">%s </span><span class=\"hyear\">%s</span></th>",
+    output_printf(&output_stdout, "<table width=90%% dir=%s><tr><th align=%s><span class=\"hmonth\">%s </span><span class=\"hyear\">%s</span></th>",
         bidi_dir, align1,
         hdate_string( HDATE_STRING_HMONTH , header.h_month_2, HDATE_STRING_LONG, calendar_lang),
         h_year_1);
     // gregorian month and year
-    printf("<th align=%s><span class=\"gmonth\">", align2);
+    output_printf(&output_stdout, "<th align=%s><span class=\"gmonth\">", align2);
     if (header.g_month_1 == header.g_month_2)
     {
-      printf("%s </span><span class=\"gyear\">%d</span></th></tr></table>\n",
+      output_printf(&output_stdout, "%s </span><span class=\"gyear\">%d</span></th></tr></table>\n",
           hdate_string( HDATE_STRING_GMONTH , header.g_month_1, HDATE_STRING_LONG, calendar_lang),
           header.g_year_1);
     }
@@ -463,7 +492,7 @@ void html_calendar_header( const header_info header, const int calendar_type, in
     {
       if (header.g_year_1 != header.g_year_2)
       {
-        printf("%s </span><span class=\"gyear\">%d - </span><span class=\"gmonth\">%s </span><span class=\"gyear\">%d</span></th></tr></table>\n",
+        output_printf(&output_stdout, "%s </span><span class=\"gyear\">%d - </span><span class=\"gmonth\">%s </span><span class=\"gyear\">%d</span></th></tr></table>\n",
           hdate_string( HDATE_STRING_GMONTH , header.g_month_1, HDATE_STRING_LONG, calendar_lang),
           header.g_year_1,
           hdate_string( HDATE_STRING_GMONTH , header.g_month_2, HDATE_STRING_LONG, calendar_lang),
@@ -471,7 +500,7 @@ void html_calendar_header( const header_info header, const int calendar_type, in
       }
       else
       {
-        printf("%s - %s </span><span class=\"gyear\">%d</span></th></tr></table>\n",
+        output_printf(&output_stdout, "%s - %s </span><span class=\"gyear\">%d</span></th></tr></table>\n",
           hdate_string( HDATE_STRING_GMONTH , header.g_month_1, HDATE_STRING_LONG, calendar_lang),
           hdate_string( HDATE_STRING_GMONTH , header.g_month_2, HDATE_STRING_LONG, calendar_lang),
           header.g_year_1);
@@ -480,15 +509,15 @@ void html_calendar_header( const header_info header, const int calendar_type, in
     break;
   default:// gregorian primary, with Hebrew correspondence
     // gregorian month and year
-    printf("<table width=90%% dir=ltr><tr><th align=left><span class=\"gmonth\">%s </span><span class=\"gyear\">%d</span></th>",
+    output_printf(&output_stdout, "<table width=90%% dir=ltr><tr><th align=left><span class=\"gmonth\">%s </span><span class=\"gyear\">%d</span></th>",
         hdate_string( HDATE_STRING_GMONTH, header.g_month_1, HDATE_STRING_LONG, calendar_lang),
         header.g_year_1);
     h_year_1 = hdate_string(HDATE_STRING_INT, header.h_year_1, HDATE_STRING_LONG, calendar_lang);
     // Hebrew month and year
-    printf("<th align=right><span class=\"hmonth\">");
+    output_literal(&output_stdout, "<th align=right><span class=\"hmonth\">");
     if (header.h_month_1 == header.h_month_2)
     {
-      printf("%s </span><span class=\"hyear\">%s</span></th></tr></table>\n",
+      output_printf(&output_stdout, "%s </span><span class=\"hyear\">%s</span></th></tr></table>\n",
           hdate_string( HDATE_STRING_HMONTH , header.h_month_1, HDATE_STRING_LONG, calendar_lang),
           h_year_1);
     }
@@ -497,7 +526,7 @@ void html_calendar_header( const header_info header, const int calendar_type, in
       if (header.h_year_1 != header.h_year_2)
       {
         h_year_2 = hdate_string(HDATE_STRING_INT, header.h_year_2, HDATE_STRING_LONG, calendar_lang);
-        printf("%s </span><span class=\"hyear\">%s - </span><span class=\"hmonth\">%s </span><span class=\"hyear\">%s</span></th></tr></table>\n",
+        output_printf(&output_stdout, "%s </span><span class=\"hyear\">%s - </span><span class=\"hmonth\">%s </span><span class=\"hyear\">%s</span></th></tr></table>\n",
           hdate_string( HDATE_STRING_HMONTH , header.h_month_1, HDATE_STRING_LONG, calendar_lang),
           h_year_1,
           hdate_string( HDATE_STRING_HMONTH , header.h_month_2, HDATE_STRING_LONG, calendar_lang),
@@ -506,7 +535,7 @@ void html_calendar_header( const header_info header, const int calendar_type, in
       }
       else
       {
-        printf("%s - %s </span><span class=\"hyear\">%s</span></th></tr></table>\n",
+        output_printf(&output_stdout, "%s - %s </span><span class=\"hyear\">%s</span></th></tr></table>\n",
           hdate_string( HDATE_STRING_HMONTH , header.h_month_1, HDATE_STRING_LONG, calendar_lang),
           hdate_string( HDATE_STRING_HMONTH , header.h_month_2, HDATE_STRING_LONG, calendar_lang),
           h_year_1);
@@ -518,12 +547,12 @@ void html_calendar_header( const header_info header, const int calendar_type, in
     break;
   } // end switch (gregorian
   if (h_year_1 != NULL) free(h_year_1);
-  printf("<table class=main dir=%s>\n<tr>", bidi_dir);
+  output_printf(&output_stdout, "<table class=main dir=%s>\n<tr>", bidi_dir);
   int j;
   for (j = 1; j < 8; j++)
-    printf("<th class=\"week\">%s</th>",
+    output_printf(&output_stdout, "<th class=\"week\">%s</th>",
         hdate_string( HDATE_STRING_DOW, j, HDATE_STRING_LONG, calendar_lang));
-  printf("</tr>\n");
+  output_literal(&output_stdout, "</tr>\n");
 }
 /**************************************************
  *  end HTML functions
@@ -535,24 +564,35 @@ void html_calendar_header( const header_info header, const int calendar_type, in
 *************************************************/
 void colorize_element ( const int color_scheme, const int element )
 {
-  if ( color_scheme > 1 )  printf(CODE_BOLD_VIDEO);
-  switch (element) {
-  case ELEMENT_WEEKDAY_G: printf(CODE_LIGHT_GREY); break;
-  case ELEMENT_WEEKDAY_H: printf(CODE_LIGHT_BROWN); break;
-  case ELEMENT_MONTH_G: printf(CODE_LIGHT_GREY); break;
-  case ELEMENT_MONTH_H: printf(CODE_LIGHT_BROWN); break;
-  case ELEMENT_WEEKDAY_NAMES: printf(CODE_LIGHT_GREEN); break;
-  case ELEMENT_SHABBAT_NAME: printf(CODE_LIGHT_AQUA); break;
-  case ELEMENT_SHABBAT_DAY: printf(CODE_LIGHT_AQUA); break;
-  case ELEMENT_HOLIDAY_DAY: printf(CODE_LIGHT_AQUA); break;
-  case ELEMENT_SHABBAT_TIMES: printf(CODE_LIGHT_PURPLE); break;
-  case ELEMENT_PARASHA: printf(CODE_LIGHT_GREEN); break;
-  case ELEMENT_THIS_SHABBAT_TIMES: printf(CODE_LIGHT_GREEN); break;
-  case ELEMENT_THIS_PARASHA: printf(CODE_LIGHT_GREEN); break;
-  case ELEMENT_HOLIDAY_NAME: printf(CODE_LIGHT_GREY); break;
-  case ELEMENT_TODAY_HOLIDAY_DAY: printf(CODE_LIGHT_GREEN); break;
-  case ELEMENT_TODAY_HOLIDAY_NAME: printf(CODE_LIGHT_GREEN); break;
+  // the escape sequences of the elements, plain and bold, so
+  // that each is a single write
+  #define ELEMENT_CODE(code) { code, CODE_BOLD_VIDEO code }
+  static const char* const element_code[][2] = {
+    ELEMENT_CODE(""),
+    /* ELEMENT_WEEKDAY_G */          ELEMENT_CODE(CODE_LIGHT_GREY),
+    /* ELEMENT_WEEKDAY_H */          ELEMENT_CODE(CODE_LIGHT_BROWN),
+    /* ELEMENT_SHABBAT_DAY */        ELEMENT_CODE(CODE_LIGHT_AQUA),
+    /* ELEMENT_HOLIDAY_DAY */        ELEMENT_CODE(CODE_LIGHT_AQUA),
+    /* ELEMENT_HOLIDAY_FLAG */       ELEMENT_CODE(""),
+    /* ELEMENT_SHABBAT_NAME */       ELEMENT_CODE(CODE_LIGHT_AQUA),
+    /* ELEMENT_WEEKDAY_NAMES */      ELEMENT_CODE(CODE_LIGHT_GREEN),
+    /* ELEMENT_MONTH_G */            ELEMENT_CODE(CODE_LIGHT_GREY),
+    /* ELEMENT_MONTH_H */            ELEMENT_CODE(CODE_LIGHT_BROWN),
+    /* ELEMENT_SHABBAT_TIMES */      ELEMENT_CODE(CODE_LIGHT_PURPLE),
+    /* ELEMENT_PARASHA */            ELEMENT_CODE(CODE_LIGHT_GREEN),
+    /* ELEMENT_THIS_SHABBAT_TIMES */ ELEMENT_CODE(CODE_LIGHT_GREEN),
+    /* ELEMENT_THIS_PARASHA */       ELEMENT_CODE(CODE_LIGHT_GREEN),
+    /* ELEMENT_HOLIDAY_NAME */       ELEMENT_CODE(CODE_LIGHT_GREY),
+    /* ELEMENT_TODAY_HOLIDAY_DAY */  ELEMENT_CODE(CODE_LIGHT_GREEN),
+    /* ELEMENT_TODAY_HOLIDAY_NAME */ ELEMENT_CODE(CODE_LIGHT_GREEN) };
+  #undef ELEMENT_CODE
+
+  if ( (element < 0) || (element > ELEMENT_TODAY_HOLIDAY_NAME) )
+  {
+    if ( color_scheme > 1 ) output_literal(&output_stdout, CODE_BOLD_VIDEO);
+    return;
   }
+  output_text(&output_stdout, element_code[element][color_scheme > 1]);
 }
 
 
@@ -591,8 +631,8 @@ void month_line( const header_info header, const option_list* opt )
     if ( (opt->gregorian != 1) ||
        ( (opt->gregorian == 1) && (header.g_month_1 == header.g_month_2) )||
        (header.g_year_1 != header.g_year_2) )
-      printf("%s %d", g_month, header.g_year_1);
-    else printf("%s", g_month);
+      output_printf(&output_stdout, "%s %d", g_month, header.g_year_1);
+    else output_printf(&output_stdout, "%s", g_month);
 
     /*************************************************
     *  padding info for gregorian date
@@ -609,7 +649,7 @@ void month_line( const header_info header, const option_list* opt )
     if ( (opt->gregorian == 1) && (header.g_month_1 != header.g_month_2) )
     {
       g_month = hdate_string( HDATE_STRING_GMONTH, header.g_month_2, HDATE_STRING_LONG, HDATE_STRING_LOCAL);
-      printf(" - %s %d", g_month, header.g_year_2);
+      output_printf(&output_stdout, " - %s %d", g_month, header.g_year_2);
 
       /*************************************************
       *  padding info for gregorian date
@@ -627,7 +667,7 @@ void month_line( const header_info header, const option_list* opt )
       }
 
     }
-    if (opt->colorize) printf(CODE_RESTORE_VIDEO);
+    if (opt->colorize) output_literal(&output_stdout, CODE_RESTORE_VIDEO);
   }
 
 
@@ -730,8 +770,8 @@ void month_line( const header_info header, const option_list* opt )
   /****************************************************
   *  print padding
   ****************************************************/
-  if (opt->gregorian != 0) printf("%*s",padding," ");
-  else printf("%*s",((padding+2)/2)," ");
+  if (opt->gregorian != 0) output_printf(&output_stdout, "%*s",padding," ");
+  else output_printf(&output_stdout, "%*s",((padding+2)/2)," ");
 
 
   /**************************************************
@@ -739,8 +779,8 @@ void month_line( const header_info header, const option_list* opt )
   *************************************************/
   if (opt->colorize) colorize_element(opt->colorize, ELEMENT_MONTH_H);
   if (opt->bidi) revstr(hebrew_buffer, hebrew_buffer_len);
-  printf("%s", hebrew_buffer);
-  if (opt->colorize) printf(CODE_RESTORE_VIDEO);
+  output_printf(&output_stdout, "%s", hebrew_buffer);
+  if (opt->colorize) output_literal(&output_stdout, CODE_RESTORE_VIDEO);
 
 
   /**************************************************
@@ -757,9 +797,9 @@ void month_line( const header_info header, const option_list* opt )
   if ( (opt->gregorian == 0) && opt->three_month )
   {
     if (header.h_month_1 == 14) // Adar II
-			printf("%*s",((padding-1)/2)-1," ");
+			output_printf(&output_stdout, "%*s",((padding-1)/2)-1," ");
     else
-			printf("%*s",((padding-1)/2)," ");
+			output_printf(&output_stdout, "%*s",((padding-1)/2)," ");
 	}
 }
 
@@ -780,8 +820,8 @@ void dow_line( option_list* opt )
 
     if ( hdate_is_hebrew_locale() || opt->force_hebrew )
     {  // Hebrew heading is a single character per day
-      if (!opt->gregorian) printf("%s%s"," ", hdate_string( HDATE_STRING_DOW, column, HDATE_STRING_SHORT, HDATE_STRING_HEBREW));
-      else printf("%s%s%s", "  ",
+      if (!opt->gregorian) output_printf(&output_stdout, "%s%s"," ", hdate_string( HDATE_STRING_DOW, column, HDATE_STRING_SHORT, HDATE_STRING_HEBREW));
+      else output_printf(&output_stdout, "%s%s%s", "  ",
         hdate_string( HDATE_STRING_DOW, column, HDATE_STRING_SHORT, HDATE_STRING_HEBREW),
         " ");
     }
@@ -789,16 +829,16 @@ void dow_line( option_list* opt )
     {
       if (opt->gregorian == 0)
       {
-        putchar(' ');
-        putchar( *(hdate_string( HDATE_STRING_DOW, column, HDATE_STRING_SHORT, HDATE_STRING_LOCAL)));
+        output_char(&output_stdout, ' ');
+        output_char(&output_stdout,  *(hdate_string( HDATE_STRING_DOW, column, HDATE_STRING_SHORT, HDATE_STRING_LOCAL)));
       }
       else
-        printf("%s%3s", " ",
+        output_printf(&output_stdout, "%s%3s", " ",
             hdate_string( HDATE_STRING_DOW, column, HDATE_STRING_SHORT, HDATE_STRING_LOCAL));
     }
 
     if ( (column == 7) || !opt->gregorian ) padding = 1;
-    if ( (column != 7) || ( ( column == 7) && opt->gregorian ) ) printf("%*s",padding," ");
+    if ( (column != 7) || ( ( column == 7) && opt->gregorian ) ) output_printf(&output_stdout, "%*s",padding," ");
   }
 
   /**************************************************
@@ -808,7 +848,7 @@ void dow_line( option_list* opt )
   {
     if (opt->colorize) colorize_element(opt->colorize, ELEMENT_SHABBAT_NAME);
     dow_column(7);
-    printf(" ");
+    output_literal(&output_stdout, " ");
     if (opt->colorize) colorize_element(opt->colorize, ELEMENT_WEEKDAY_NAMES);
     for (column = 6; column > 0; column--) dow_column(column);
   }
@@ -819,7 +859,7 @@ void dow_line( option_list* opt )
     if (opt->colorize) colorize_element(opt->colorize, ELEMENT_SHABBAT_NAME);
     dow_column(7);
   }
-  if (opt->colorize) printf(CODE_RESTORE_VIDEO);
+  if (opt->colorize) output_literal(&output_stdout, CODE_RESTORE_VIDEO);
 }
 
 
@@ -1013,19 +1053,19 @@ int header ( const int month, const int year, option_list* opt)
       {
           if (!opt->gregorian) calendar_width = CALENDAR_WIDTH_NARROW;
           else calendar_width = CALENDAR_WIDTH_WIDE;
-          printf("%*s",calendar_width," ");
+          output_printf(&output_stdout, "%*s",calendar_width," ");
       }
       else month_line(previous_month, opt);
-      printf("%s", opt->border_spacing);
+      output_printf(&output_stdout, "%s", opt->border_spacing);
     }
     month_line(current_month, opt);
     if (opt->three_month)
     {
-      printf("%s", opt->border_spacing);
+      output_printf(&output_stdout, "%s", opt->border_spacing);
       if (opt->three_month != 12)
         month_line(next_month, opt);
     }
-    printf("\n");
+    output_literal(&output_stdout, "\n");
     /**************************************************
     *  print column headings for days of weeks
     **************************************************/
@@ -1033,18 +1073,18 @@ int header ( const int month, const int year, option_list* opt)
     {
       if  ( (opt->three_month == 12) &&
         ( (fourteenth_month == false) || (opt->gregorian <2) ) )
-        printf("%*s",calendar_width," ");
+        output_printf(&output_stdout, "%*s",calendar_width," ");
       else dow_line(opt);
-      printf("%s", opt->border_spacing);
+      output_printf(&output_stdout, "%s", opt->border_spacing);
     }
     dow_line(opt);
     if (opt->three_month)
     {
-      printf("%s", opt->border_spacing);
+      output_printf(&output_stdout, "%s", opt->border_spacing);
       if (opt->three_month != 12)
         dow_line(opt);
     }
-    printf("\n");
+    output_literal(&output_stdout, "\n");
   }
 
   return 0;
@@ -1058,53 +1098,42 @@ void html_day ( const hdate_struct h, const int month, option_list* opt)
 {
 
   int halachic_day;
-  int* jdn_list_ptr;
   int custom_day_index_to_print = 0;
   char *day_text_ptr = NULL;
   char *hd_day_str = NULL;
   char *holiday_name_class_str = "holiday_name";
   char *holiday_name_align="left";
 
-  halachic_day = hdate_get_halachic_day(&h, opt->diaspora);
+  halachic_day = hdate_snapshot_halachic_day(opt->snapshot, &h, opt->diaspora);
   if ( !halachic_day && opt->custom_days_cnt )
   {
-    for (  opt->custom_days_index = 0,
-        jdn_list_ptr = opt->jdn_list_ptr
-        ;
-        (opt->custom_days_index < opt->custom_days_cnt) &&
-        (!halachic_day)
-        ;
-        opt->custom_days_index = opt->custom_days_index + 1,
-        jdn_list_ptr = jdn_list_ptr + 1
-      )
-    {
-      if (h.hd_jd == *jdn_list_ptr)
-      {
-        halachic_day = BAD_HOLIDAY_TYPE;
-        custom_day_index_to_print = opt->custom_days_index;
-      }
+    opt->custom_days_index = find_custom_day( h.hd_jd, opt->custom_days_cnt, opt->jdn_list_ptr );
+    if (opt->custom_days_index >= 0)
+    {
+      halachic_day = BAD_HOLIDAY_TYPE;
+      custom_day_index_to_print = opt->custom_days_index;
     }
   }
   if (( (opt->gregorian < 2) && (h.hd_mon != month)) ||
     ( (opt->gregorian > 1) && (h.gd_mon != month)) )
   {
     holiday_name_class_str = "out_of_month";
-    printf("<td class=\"out_of_month\">");
+    output_literal(&output_stdout, "<td class=\"out_of_month\">");
   }
-  else if (h.hd_dw == SHABBAT) printf("<td class=\"sat\">");
-  else if (halachic_day) printf("<td class=\"holiday\">");
-  else printf("<td class=\"regular\">");
+  else if (h.hd_dw == SHABBAT) output_literal(&output_stdout, "<td class=\"sat\">");
+  else if (halachic_day) output_literal(&output_stdout, "<td class=\"holiday\">");
+  else output_literal(&output_stdout, "<td class=\"regular\">");
   // Print a day
   if (opt->gregorian == 0) // calendar type = Hebrew only
   {
     hd_day_str = hdate_string(HDATE_STRING_INT, h.hd_day, HDATE_STRING_LONG,opt->force_hebrew);
-    printf("<table class=day><tr class=line1><td class=\"primary_day\">%3s</td></tr>\
+    output_printf(&output_stdout, "<table class=day><tr class=line1><td class=\"primary_day\">%3s</td></tr>\
 <tr class=line2><td>&nbsp;</td></tr>", hd_day_str);
   }
   else if (opt->gregorian == 1) // calendar type = Hebrew primary
   {  // TODO - here
     hd_day_str = hdate_string(HDATE_STRING_INT, h.hd_day, HDATE_STRING_LONG,opt->force_hebrew);
-    printf("<table class=day><tr class=line1><td class=\"primary_day\">%3s</td>\
+    output_printf(&output_stdout, "<table class=day><tr class=line1><td class=\"primary_day\">%3s</td>\
 <td class=\"secondary_day\">%2d&nbsp;%s</td></tr><tr class=line2><td>&nbsp;</td></tr>",
       hd_day_str, h.gd_day,
       hdate_string( HDATE_STRING_GMONTH , h.gd_mon, HDATE_STRING_LONG, opt->force_hebrew));
@@ -1112,7 +1141,7 @@ void html_day ( const hdate_struct h, const int month, option_list* opt)
   else // (opt->gregorian > 1) // calendar type = Gregorian primary
   {
     hd_day_str = hdate_string(HDATE_STRING_INT, h.hd_day, HDATE_STRING_LONG,opt->force_hebrew);
-    printf("<table class=day><tr class=line1><td class=\"primary_day\">%2d</td>\
+    output_printf(&output_stdout, "<table class=day><tr class=line1><td class=\"primary_day\">%2d</td>\
 <td class=\"secondary_day\">%3s&nbsp;%s</td></tr><tr class=line2><td>&nbsp;</td></tr>",
       h.gd_day, hd_day_str,
       hdate_string( HDATE_STRING_HMONTH , h.hd_mon, HDATE_STRING_LONG, opt->force_hebrew));
@@ -1128,12 +1157,12 @@ void html_day ( const hdate_struct h, const int month, option_list* opt)
     {
       day_text_ptr = hdate_string( HDATE_STRING_HOLIDAY, halachic_day, HDATE_STRING_LONG, opt->force_hebrew);
     }
-    printf("<tr class=line3><td align=%s class=\"%s\" colspan=2>%s</td></tr>",
+    output_printf(&output_stdout, "<tr class=line3><td align=%s class=\"%s\" colspan=2>%s</td></tr>",
         holiday_name_align, holiday_name_class_str, day_text_ptr);
   }
-  else printf("<tr class=line3><td class=\"%s\">&nbsp;</td></tr>",holiday_name_class_str);
+  else output_printf(&output_stdout, "<tr class=line3><td class=\"%s\">&nbsp;</td></tr>",holiday_name_class_str);
 
-  printf("</table></td>\n");
+  output_literal(&output_stdout, "</table></td>\n");
 
   if (hd_day_str != NULL) free(hd_day_str);
 }
@@ -1164,7 +1193,7 @@ void day ( const hdate_struct* h, const int month, option_list* opt, const int p
     }
     else if ( !printing_footnote && opt->bold &&
             ( h->hd_dw==7 || holiday_type || custom_day_flag ) )
-      printf(CODE_BOLD_VIDEO);
+      output_literal(&output_stdout, CODE_BOLD_VIDEO);
   }
 
 
@@ -1178,44 +1207,17 @@ void day ( const hdate_struct* h, const int month, option_list* opt, const int p
       day_flag = custom_day_flag;
       return;
     }
-    holiday_type = hdate_get_halachic_day_type(hdate_get_halachic_day(h, opt->diaspora));
+    holiday_type = hdate_get_halachic_day_type(hdate_snapshot_halachic_day(opt->snapshot, h, opt->diaspora));
     day_flag = &holiday_flag[holiday_type];
     if ( !holiday_type && opt->custom_days_cnt )
     {
       // there may be more than one custom day for a single
       // calendar day, so we use the symbol for the first
-      // but will need to iterate over the others for the
-      // next calendar day's symbol
-
-      // This next snippet might be good in the future
-      // but for now the jdn_list isn't sorted ..
-      //for (  ;
-      //    (opt->custom_days_index < opt->custom_days_cnt) &&
-      //    (h.hd_jd > *jdn_list_ptr) ;
-      //    opt->custom_days_index = opt->custom_days_index + 1,
-      //    jdn_list_ptr = jdn_list_ptr + 1
-      //    ) ;
-      //if (h.hd_jd == *jdn_list_ptr)
-      //{
-      //  day_flag = get_custom_day_symbol_ptr(opt->custom_days_index, opt->string_list_ptr);
-      //  holiday_type = BAD_HOLIDAY_TYPE;
-      //}
-      int* jdn_list_ptr;
-      for (  opt->custom_days_index = 0,
-          jdn_list_ptr = opt->jdn_list_ptr
-          ;
-          (opt->custom_days_index < opt->custom_days_cnt) &&
-          (!holiday_type)
-          ;
-          opt->custom_days_index = opt->custom_days_index + 1,
-          jdn_list_ptr = jdn_list_ptr + 1
-        )
+      opt->custom_days_index = find_custom_day( h->hd_jd, opt->custom_days_cnt, opt->jdn_list_ptr );
+      if (opt->custom_days_index >= 0)
       {
-        if (h->hd_jd == *jdn_list_ptr)
-        {
-          day_flag = get_custom_day_symbol_ptr(opt->custom_days_index, opt->string_list_ptr);
-          holiday_type = BAD_HOLIDAY_TYPE;
-        }
+        day_flag = get_custom_day_symbol_ptr(opt->custom_days_index, opt->string_list_ptr);
+        holiday_type = BAD_HOLIDAY_TYPE;
       }
     }
   }
@@ -1231,13 +1233,13 @@ void day ( const hdate_struct* h, const int month, option_list* opt, const int p
     /*************************************************
     *  holiday flag
     *************************************************/
-    if (opt->gregorian == 1) printf("%c", *day_flag);
+    if (opt->gregorian == 1) output_char(&output_stdout, *day_flag);
 
     /*************************************************
     *  Gregorian date entry - color prefix
     *************************************************/
     if (h->hd_jd == opt->jd_today_g)
-        printf(CODE_REVERSE_VIDEO);
+        output_literal(&output_stdout, CODE_REVERSE_VIDEO);
     else colorize_prefix();
 
     /*************************************************
@@ -1246,20 +1248,23 @@ void day ( const hdate_struct* h, const int month, option_list* opt, const int p
     // this next line is necessary to align numbers
     // correctly with bidi (tested using mlterm)
     if ( (h->gd_day < 10) && hdate_is_hebrew_locale() )
-       printf("%d ", h->gd_day);
-    else printf("%2d", h->gd_day);
+    {
+       output_int(&output_stdout, h->gd_day);
+       output_char(&output_stdout, ' ');
+    }
+    else output_int_width(&output_stdout, h->gd_day, 2, ' ');
 
     /*************************************************
     *  Gregorian date entry - color cleanup
     *************************************************/
     if ((h->hd_jd == opt->jd_today_g) || opt->colorize ||
       ( opt->bold && ( (h->hd_dw==7) || holiday_type ) ) )
-      printf(CODE_RESTORE_VIDEO);
+      output_literal(&output_stdout, CODE_RESTORE_VIDEO);
 
     /*************************************************
     *  holiday flag
     *************************************************/
-    if (opt->gregorian > 1) printf("%c", *day_flag);
+    if (opt->gregorian > 1) output_char(&output_stdout, *day_flag);
   }
 
   /*****************************************************
@@ -1278,13 +1283,13 @@ void day ( const hdate_struct* h, const int month, option_list* opt, const int p
 				&& (! opt->mlterm) // FIXME: this condition might not be necessary
 				&& (opt->tmux_bidi)
 				&& ( opt->force_hebrew || hdate_is_hebrew_locale() ))
-      printf(" ");
+      output_literal(&output_stdout, " ");
 
     /*************************************************
     *  Hebrew date entry - color prefix
     *************************************************/
     if (h->hd_jd == opt->jd_today_h)
-        printf(CODE_REVERSE_VIDEO);
+        output_literal(&output_stdout, CODE_REVERSE_VIDEO);
     else colorize_prefix();
 
     /*************************************************
@@ -1311,28 +1316,31 @@ void day ( const hdate_struct* h, const int month, option_list* opt, const int p
 						&& opt->tmux_bidi )
   				// This is an unfortunate kludge to compensate for how most
 	  			// terminal emulators (update: maybe just tmux?) handle bidi.
-					printf("%s",hd_day_str);
+					output_text(&output_stdout, hd_day_str);
 				else
-					printf("%s%s"," ",hd_day_str);
+				{
+					output_char(&output_stdout, ' ');
+					output_text(&output_stdout, hd_day_str);
+				}
 				// This is an unfortunate kludge to compensate for how most
 				// terminal emulators (update: maybe just tmux?) handle bidi.
 				if (opt->tmux_bidi
 						&& !opt->mlterm  // FIXME: not certain this condition is necessary
 						&& (h->hd_day == 10))
-				  printf(" ");
+				  output_literal(&output_stdout, " ");
 			}
 			else if ( (h->hd_day == 20) || (h->hd_day == 30) )
-				printf("%s%s",hd_day_str," ");
-			else printf("%2s", hd_day_str);
+				output_printf(&output_stdout, "%s%s",hd_day_str," ");
+			else output_printf(&output_stdout, "%2s", hd_day_str);
     }
-    else printf("%2s", hd_day_str);
+    else output_printf(&output_stdout, "%2s", hd_day_str);
 
     /*************************************************
     *  Hebrew date entry - color cleanup
     *************************************************/
     if ((h->hd_jd == opt->jd_today_h) || opt->colorize ||
       ( opt->bold && ( (h->hd_dw==7) || holiday_type ) ) )
-      printf(CODE_RESTORE_VIDEO);
+      output_literal(&output_stdout, CODE_RESTORE_VIDEO);
   }
 
   /*****************************************************
@@ -1343,11 +1351,11 @@ void day ( const hdate_struct* h, const int month, option_list* opt, const int p
 
   if ( ( (opt->gregorian >  1)  && (h->gd_mon != month) ) ||
        ( (opt->gregorian == 1)  && (h->hd_mon != month) ) )
-    printf("     "); // leading and trailing out-of-month spaces
+    output_literal(&output_stdout, "     "); // leading and trailing out-of-month spaces
   else if ( (opt->gregorian == 0) && (h->hd_mon != month))
 	{
     if (!in_first_line_prev)
-			printf("  "); // leading and trailing out-of-month spaces
+			output_literal(&output_stdout, "  "); // leading and trailing out-of-month spaces
 	}
   //  in month - print the data
   else
@@ -1381,10 +1389,10 @@ void last_line_padding ( int jd )
 	int padding = 7 - (size_of_month - h.hd_day + 1);
 	// This extra space is needed since 'ל' is a single character
   if (size_of_month == 30)
-		printf(" ");
+		output_literal(&output_stdout, " ");
 	for ( ; padding > 0; padding--)
   {
-		printf("   ");
+		output_literal(&output_stdout, "   ");
 	}
 }
 
@@ -1480,11 +1488,11 @@ void shabbat_data( int jd, hdate_struct* h, hdate_struct* yom_shishi, option_lis
       if (this_week) colorize_element(opt->colorize, ELEMENT_THIS_SHABBAT_TIMES);
       else colorize_element(opt->colorize, ELEMENT_SHABBAT_TIMES);
     }
-    else if (this_week) printf(CODE_BOLD_VIDEO);
-      printf("  %02d:%02d", sunset / 60, sunset % 60);
-    if ( opt->colorize || this_week ) printf(CODE_RESTORE_VIDEO);
+    else if (this_week) output_literal(&output_stdout, CODE_BOLD_VIDEO);
+      output_printf(&output_stdout, "  %02d:%02d", sunset / 60, sunset % 60);
+    if ( opt->colorize || this_week ) output_literal(&output_stdout, CODE_RESTORE_VIDEO);
 
-    printf(" - ");
+    output_literal(&output_stdout, " - ");
 
     // print havdalah time
     if (opt->colorize)
@@ -1492,9 +1500,9 @@ void shabbat_data( int jd, hdate_struct* h, hdate_struct* yom_shishi, option_lis
       if (this_week) colorize_element(opt->colorize, ELEMENT_THIS_SHABBAT_TIMES);
       else colorize_element(opt->colorize, ELEMENT_SHABBAT_TIMES);
     }
-    else if (this_week) printf(CODE_BOLD_VIDEO);
-    printf("%02d:%02d", three_stars / 60, three_stars % 60);
-    if ( opt->colorize || this_week ) printf(CODE_RESTORE_VIDEO);
+    else if (this_week) output_literal(&output_stdout, CODE_BOLD_VIDEO);
+    output_printf(&output_stdout, "%02d:%02d", three_stars / 60, three_stars % 60);
+    if ( opt->colorize || this_week ) output_literal(&output_stdout, CODE_RESTORE_VIDEO);
   }
 
 
@@ -1507,13 +1515,13 @@ void shabbat_data( int jd, hdate_struct* h, hdate_struct* yom_shishi, option_lis
     /*************************************************
     *  print shabbat name - force-hebrew setup
     *************************************************/
-    shabbat_name = hdate_get_parasha (h, opt->diaspora);
+    shabbat_name = hdate_snapshot_parasha(opt->snapshot, h, opt->diaspora);
     if (shabbat_name) shabbat_name_str =
         hdate_string( HDATE_STRING_PARASHA, shabbat_name,
                 HDATE_STRING_SHORT, opt->force_hebrew | opt->bidi);
     else
     {
-      shabbat_name = hdate_get_halachic_day(h, opt->diaspora);
+      shabbat_name = hdate_snapshot_halachic_day(opt->snapshot, h, opt->diaspora);
       if (shabbat_name) shabbat_name_str =
         hdate_string( HDATE_STRING_HOLIDAY,
             shabbat_name,
@@ -1526,7 +1534,7 @@ void shabbat_data( int jd, hdate_struct* h, hdate_struct* yom_shishi, option_lis
         if (this_week) colorize_element(opt->colorize, ELEMENT_THIS_PARASHA);
         else colorize_element(opt->colorize, ELEMENT_PARASHA);
       }
-      else if (this_week) printf(CODE_BOLD_VIDEO);
+      else if (this_week) output_literal(&output_stdout, CODE_BOLD_VIDEO);
 
       if (opt->bidi)
       {
@@ -1536,12 +1544,12 @@ void shabbat_data( int jd, hdate_struct* h, hdate_struct* yom_shishi, option_lis
         shabbat_name_buffer[shabbat_name_str_len] = '\0';
         len = revstr(shabbat_name_buffer, shabbat_name_str_len);
         #define SHABBAT_MARGIN_MAX 16
-        printf("%*s%s", (SHABBAT_MARGIN_MAX - len)," ", shabbat_name_buffer);
+        output_printf(&output_stdout, "%*s%s", (SHABBAT_MARGIN_MAX - len)," ", shabbat_name_buffer);
         free(shabbat_name_buffer);
       }
-      else printf("  %s", shabbat_name_str);
+      else output_printf(&output_stdout, "  %s", shabbat_name_str);
 
-      if ( opt->colorize || this_week ) printf(CODE_RESTORE_VIDEO);
+      if ( opt->colorize || this_week ) output_literal(&output_stdout, CODE_RESTORE_VIDEO);
     }
   }
 }
@@ -1566,7 +1574,7 @@ void week( int jd, const int month, option_list* opt, int final_line)
   /**/     yom_shishi = h;
   /**/   if (opt->html) html_day ( h, month, opt );
   /**/   else day ( &h, month, opt, false, NULL);
-  /**/   if (calendar_column != 6)  printf(" ");
+  /**/   if (calendar_column != 6)  output_literal(&output_stdout, " ");
   /**/ }
   /* END: embedded sub-function: do_calendar_column()   */
 
@@ -1596,7 +1604,7 @@ void week( int jd, const int month, option_list* opt, int final_line)
     {
       do_calendar_column();
       jd--;
-      if (calendar_column == 6) printf(" ");
+      if (calendar_column == 6) output_literal(&output_stdout, " ");
     }
     jd=jd+7;
     hdate_set_jd(&h, jd );
@@ -1790,7 +1798,7 @@ int calendar ( int current_month, int current_year, option_list* opt)
 		in_first_line_prev = true;
   for (calendar_line = max_calendar_lines; calendar_line > 0; calendar_line--)
   {
-    if (opt->html) printf("<tr>\n");
+    if (opt->html) output_literal(&output_stdout, "<tr>\n");
 
     // week line of 'previous' month when printing three months across
     if (opt->three_month)
@@ -1808,7 +1816,7 @@ int calendar ( int current_month, int current_year, option_list* opt)
       week(jd_previous_month, previous_month, opt, calendar_line);
   		in_first_line_prev = false;
       jd_previous_month = jd_previous_month + 7;
-      printf("%s", opt->border_spacing);
+      output_printf(&output_stdout, "%s", opt->border_spacing);
     }
 
     // week line of 'current' month
@@ -1818,7 +1826,7 @@ int calendar ( int current_month, int current_year, option_list* opt)
     // week line of 'next' month when printing three months across
     if (opt->three_month)
     {
-      printf("%s", opt->border_spacing);
+      output_printf(&output_stdout, "%s", opt->border_spacing);
       if (opt->three_month != 12)
       {
         week(jd_next_month, next_month, opt, calendar_line);
@@ -1826,15 +1834,15 @@ int calendar ( int current_month, int current_year, option_list* opt)
       }
     }
 
-    if (opt->html) printf("</tr>\n");
-    else printf("\n");
+    if (opt->html) output_literal(&output_stdout, "</tr>\n");
+    else output_literal(&output_stdout, "\n");
   }
 
 
   /**************************************************
   *  print end of calendar
   *************************************************/
-  if (opt->html) printf("</table>\n</span>");
+  if (opt->html) output_literal(&output_stdout, "</table>\n</span>");
   return 0;
 }
 
@@ -1861,7 +1869,7 @@ void footnote( const hdate_struct* h, const int footnote_month,
         colorize_element(opt->colorize, ELEMENT_HOLIDAY_NAME);
     }
     else if ( opt->bold && (opt->jd_today_h == h->hd_jd) )
-      printf(CODE_BOLD_VIDEO);
+      output_literal(&output_stdout, CODE_BOLD_VIDEO);
   }
   // END: embedded function
 
@@ -1874,24 +1882,24 @@ void footnote( const hdate_struct* h, const int footnote_month,
     len = revstr(bidi_buffer, text_ptr_len);
     #define FOOTNOTE_MARGIN_MAX 20
     colorize_footnote_text();
-    printf("%*s%s  ", (FOOTNOTE_MARGIN_MAX - len)," ", bidi_buffer);
+    output_printf(&output_stdout, "%*s%s  ", (FOOTNOTE_MARGIN_MAX - len)," ", bidi_buffer);
     if ( opt->colorize ||
        ( opt->bold && (opt->jd_today_h == h->hd_jd) ) )
-      printf(CODE_RESTORE_VIDEO);
+      output_literal(&output_stdout, CODE_RESTORE_VIDEO);
     free(bidi_buffer);
   }
 
   // day handles its own colorization
   day( h, footnote_month, opt, true, custom_day_flag);
 
-  if (opt->bidi) printf("\n");
+  if (opt->bidi) output_literal(&output_stdout, "\n");
   else
   {
     colorize_footnote_text();
-    printf("  %s\n", text_ptr);
+    output_printf(&output_stdout, "  %s\n", text_ptr);
     if ( (opt->colorize) ||
        ( (opt->bold) && (opt->jd_today_h == h->hd_jd) ) )
-      printf(CODE_RESTORE_VIDEO);
+      output_literal(&output_stdout, CODE_RESTORE_VIDEO);
   }
 }
 
@@ -1901,7 +1909,6 @@ void footnote( const hdate_struct* h, const int footnote_month,
 void footnotes_all( hdate_struct* h, option_list* opt)
 {
   int jd_counter = h->hd_jd;
-  int* jdn_list_ptr;
 	int holiday;
   int footnote_month = (opt->gregorian < 2) ? h->hd_mon : h->gd_mon;
   char custom_day_flag;
@@ -1909,7 +1916,7 @@ void footnotes_all( hdate_struct* h, option_list* opt)
   while ( ( (opt->gregorian > 1) && (footnote_month == h->gd_mon ) ) ||
           ( (opt->gregorian < 2) && (footnote_month == h->hd_mon ) )  )
   {
-    holiday = hdate_get_halachic_day( h, opt->diaspora );
+    holiday = hdate_snapshot_halachic_day(opt->snapshot, h, opt->diaspora);
     if (holiday)
     {
       footnote( h, footnote_month, opt,
@@ -1921,25 +1928,20 @@ void footnotes_all( hdate_struct* h, option_list* opt)
     }
     if (opt->custom_days_cnt)
     {
-      // This for-loop is very similar to one in function
-      // get_todays_holiday_data(), but here we iterate over the
-      // entire list of custom days to operate on all matches. The
-      // other function aborts on the first match, after getting a
-      // day's flag symbol.
-      for ( opt->custom_days_index = 0,
-            jdn_list_ptr = opt->jdn_list_ptr;
-            (opt->custom_days_index < opt->custom_days_cnt) ;
-            opt->custom_days_index = opt->custom_days_index + 1,
-            jdn_list_ptr = jdn_list_ptr + 1
+      // Unlike function get_todays_holiday_data(), which stops
+      // at the first match after getting a day's flag symbol, here
+      // we operate on all the custom days of the day, which are
+      // adjacent in the sorted list.
+      for ( opt->custom_days_index = find_custom_day( h->hd_jd, opt->custom_days_cnt, opt->jdn_list_ptr );
+            (opt->custom_days_index >= 0) &&
+            (opt->custom_days_index < opt->custom_days_cnt) &&
+            (opt->jdn_list_ptr[opt->custom_days_index] == h->hd_jd) ;
+            opt->custom_days_index = opt->custom_days_index + 1
           )
       {
-        if (h->hd_jd == *jdn_list_ptr)
-        {
-          custom_day_flag = * get_custom_day_symbol_ptr(opt->custom_days_index, opt->string_list_ptr);
-          footnote( h, footnote_month, opt,
-                  get_custom_day_text_ptr( opt->custom_days_index, opt->string_list_ptr ), &custom_day_flag );
-
-        }
+        custom_day_flag = * get_custom_day_symbol_ptr(opt->custom_days_index, opt->string_list_ptr);
+        footnote( h, footnote_month, opt,
+                get_custom_day_text_ptr( opt->custom_days_index, opt->string_list_ptr ), &custom_day_flag );
       }
     }
     hdate_set_jd( h, ++jd_counter );
@@ -1987,17 +1989,22 @@ int month ( int month, int year, option_list* opt)
     // TODO - 'three-month mode custom days...
     //     at this point only for color mode highlighting because
     //     we don't allow foornotes for three month mode
-    FILE *custom_file = NULL;
-    if (get_custom_days_file( "/hcal", "/custom_days_v1.8",
+    custom_days_list custom_days;
+    if ( (opt->custom_days_path != NULL) ?
+         get_custom_days_file_path( opt->custom_days_path,
+                  opt->quiet_alerts, &custom_days) :
+         get_custom_days_file( "/hcal", "/custom_days_v1.8",
                   opt->tz_name_str, opt->quiet_alerts,
-                  &custom_file))
+                  &custom_days))
     {
-      opt->custom_days_cnt = read_custom_days_file(custom_file,
+      // the snapshot's custom days are those of the default file
+      if (opt->custom_days_path == NULL) custom_days.snapshot = opt->snapshot;
+      opt->custom_days_cnt = read_custom_days_file(&custom_days,
                   &opt->jdn_list_ptr, &opt->string_list_ptr,
                   0, month, year,
                   calendar_type, h,
                   HDATE_STRING_LONG, opt->force_hebrew);
-      fclose(custom_file);
+      free_custom_days(&custom_days);
     }
   }
 
@@ -2036,13 +2043,256 @@ int month ( int month, int year, option_list* opt)
   year = (opt->gregorian > 1) ? h.gd_year: h.hd_year;
   header( month, year, opt );
   calendar( month, year, opt );
-  printf("\n");
+  output_literal(&output_stdout, "\n");
   if (opt->footnote) footnotes_all( &h, opt );
   return 0;
 }
 
 
 
+/****************************************************
+* a month of a year-long calendar, as queued by year()
+****************************************************/
+typedef struct {
+  int month;
+  int year;
+  int three_month;     // value of opt->three_month for this month
+  int newlines;        // blank lines to print after it
+  FILE* output;        // rendered by a worker, or NULL
+  pid_t pid;           // of the worker, until it is reaped
+  int status;          // of the worker, once reaped
+} month_job;
+
+#define MAX_MONTH_JOBS 16
+
+
+
+/****************************************************
+* print one queued month, in this process
+****************************************************/
+void print_month_job( month_job* job, option_list* opt )
+{
+  int i;
+  opt->three_month = job->three_month;
+  month( job->month, job->year, opt );
+  for (i=0; i<job->newlines; i++) output_literal(&output_stdout, "\n");
+}
+
+
+
+/****************************************************
+* reap one worker of print_month_jobs
+****************************************************/
+void reap_month_job( month_job* job, const int job_count, const pid_t pid,
+                     const int status )
+{
+  int i;
+  for (i=0; i<job_count; i++)
+    if (job[i].pid == pid)
+    {
+      job[i].pid = 0;
+      job[i].status = status;
+    }
+}
+
+
+
+/****************************************************
+* print one queued month, in this process, into a
+* temporary file
+****************************************************/
+FILE* render_month_job( month_job* job, option_list* opt )
+{
+  FILE* output;
+  int failed;
+
+  output = tmpfile();
+  if (output == NULL) return NULL;
+  output_flush( &output_stdout );
+  failed = output_stdout.failed;
+  output_init( &output_stdout, output );
+  print_month_job( job, opt );
+  output_flush( &output_stdout );
+  if (output_stdout.failed)
+  {
+    fclose(output);
+    output = NULL;
+  }
+  output_init( &output_stdout, stdout );
+  output_stdout.failed = failed;
+  return output;
+}
+
+
+
+/****************************************************
+* the --cache key of the queued months of a location
+****************************************************/
+void location_cache_key( const option_list* opt, cache_key* key )
+{
+  *key = opt->cache_base;
+  cache_key_add_double( key, opt->lat );
+  cache_key_add_double( key, opt->lon );
+  cache_key_add_int( key, opt->tz );
+  cache_key_add_text( key, opt->tz_name_str );
+  cache_key_add_int( key, opt->diaspora );
+  cache_key_add_text( key, getenv("TERM") );
+  cache_key_add_text( key, getenv("MLTERM") );
+  cache_key_add_environment( key, opt->tz_name_str );
+}
+
+
+
+/****************************************************
+* the --cache key of a queued month
+*
+* Of today's date and the custom days, only those
+* within six weeks or so of the month are part of its
+* key, so that a new day or an edited custom day
+* invalidates only the months that show it.
+****************************************************/
+void month_job_cache_key( const month_job* job, const option_list* opt,
+                          const cache_key* location, cache_key* key )
+{
+  hdate_struct h;
+  int jd_first, jd_last, i;
+
+  *key = *location;
+  cache_key_add_int( key, job->month );
+  cache_key_add_int( key, job->year );
+  cache_key_add_int( key, job->three_month );
+  cache_key_add_int( key, job->newlines );
+
+  if (job->year > HDATE_HEB_YR_LOWER_BOUND) hdate_set_hdate( &h, 1, job->month, job->year );
+  else hdate_set_gdate( &h, 1, job->month, job->year );
+  jd_first = h.hd_jd - 45;
+  jd_last = h.hd_jd + 76;
+  cache_key_add_int( key, ( (opt->jd_today_g >= jd_first) && (opt->jd_today_g <= jd_last) ) ? opt->jd_today_g : 0 );
+  cache_key_add_int( key, ( (opt->jd_today_h >= jd_first) && (opt->jd_today_h <= jd_last) ) ? opt->jd_today_h : 0 );
+  for (i=0; i<opt->custom_days_cnt; i++)
+  {
+    if ( (opt->jdn_list_ptr[i] < jd_first) || (opt->jdn_list_ptr[i] > jd_last) ) continue;
+    cache_key_add_int( key, opt->jdn_list_ptr[i] );
+    cache_key_add( key, get_custom_day_symbol_ptr( i, opt->string_list_ptr ), 1 );
+    cache_key_add_text( key, get_custom_day_text_ptr( i, opt->string_list_ptr ) );
+  }
+}
+
+
+
+/****************************************************
+* print the queued months of a year, in order
+*
+* With opt->jobs > 1, all but the first month are
+* rendered by a pool of up to opt->jobs forked workers,
+* each into its own temporary file, which are then
+* copied to stdout in order. The first month is printed
+* here first, because it also reads the custom days and
+* dst transitions that the remaining months share.
+* A month whose worker could not run is printed here,
+* in its turn, so the output is always that of printing
+* them sequentially.
+*
+* With opt->cache_dir, the remaining months are first
+* looked for in the cache, and those rendered anew are
+* stored there.
+****************************************************/
+void print_month_jobs( month_job* job, const int job_count, option_list* opt )
+{
+  int i, running = 0;
+  int status;
+  pid_t pid;
+  char buffer[BUFSIZ];
+  size_t bytes;
+  cache_key location;
+  cache_key key[MAX_MONTH_JOBS];
+  bool cached[MAX_MONTH_JOBS];
+
+  for (i=0; i<job_count; i++)
+  {
+    job[i].output = NULL;
+    job[i].pid = 0;
+    cached[i] = false;
+  }
+  if (job_count == 0) return;
+  print_month_job( &job[0], opt );
+  if (opt->cache_dir != NULL)
+  {
+    location_cache_key( opt, &location );
+    for (i=1; i<job_count; i++)
+    {
+      month_job_cache_key( &job[i], opt, &location, &key[i] );
+      job[i].output = cache_open( opt->cache_dir, &key[i] );
+      job[i].status = 0;
+      cached[i] = (job[i].output != NULL);
+    }
+  }
+  else if (opt->jobs < 2)
+  {
+    for (i=1; i<job_count; i++) print_month_job( &job[i], opt );
+    return;
+  }
+
+  output_flush_stdout();
+  for (i=1; i<job_count; i++)
+  {
+    if (cached[i]) continue;
+    if (opt->jobs < 2)
+    {
+      job[i].output = render_month_job( &job[i], opt );
+      continue;
+    }
+    for ( ; running >= opt->jobs; running--)
+    {
+      pid = wait(&status);
+      if (pid == -1) break;
+      reap_month_job( job, job_count, pid, status );
+    }
+    job[i].output = tmpfile();
+    if (job[i].output == NULL) continue;
+    job[i].pid = fork();
+    if (job[i].pid == 0)
+    {
+      if (dup2( fileno(job[i].output), STDOUT_FILENO ) == -1) _exit(EXIT_FAILURE);
+      output_init( &output_stdout, stdout );
+      print_month_job( &job[i], opt );
+      output_flush_stdout();
+      _exit(0);
+    }
+    if (job[i].pid == -1)
+    {
+      fclose(job[i].output);
+      job[i].output = NULL;
+      continue;
+    }
+    running++;
+  }
+
+  for (i=1; i<job_count; i++)
+  {
+    if (job[i].output != NULL)
+    {
+      if (job[i].pid == 0) status = job[i].status;
+      else if (waitpid( job[i].pid, &status, 0 ) == -1) status = -1;
+      if ( (!WIFEXITED(status)) || (WEXITSTATUS(status) != 0) ) status = -1;
+      if (status == 0)
+      {
+        if ( (opt->cache_dir != NULL) && !cached[i] )
+          cache_store( opt->cache_dir, &key[i], job[i].output );
+        rewind(job[i].output);
+        while ((bytes = fread( buffer, 1, sizeof(buffer), job[i].output )) > 0)
+          output_bytes( &output_stdout, buffer, bytes );
+      }
+      fclose(job[i].output);
+      if (status == 0) continue;
+    }
+    print_month_job( &job[i], opt );
+  }
+  opt->three_month = job[job_count-1].three_month;
+}
+
+
+
 /****************************************************
 * process a request for a year-long calendar
 ****************************************************/
@@ -2050,6 +2300,12 @@ void year( int year_to_do, hdate_struct* h, option_list* opt )
 {
   const int num_of_months = 12;  // how many months in the year
   int month_to_do = 0;
+  month_job job[MAX_MONTH_JOBS];
+  int job_count = 0;
+  int three_month = opt->three_month;
+
+#define QUEUE_MONTH(m, y) \
+  job[job_count++] = (month_job) { (m), (y), three_month, 0, NULL, 0, 0 }
   {
     if (opt->three_month)
     {
@@ -2062,15 +2318,16 @@ void year( int year_to_do, hdate_struct* h, option_list* opt )
            (year_to_do > HDATE_HEB_YR_LOWER_BOUND) &&
            (month_to_do == 8)               )
           month_to_do = 7;
-        month(month_to_do, year_to_do, opt);
+        QUEUE_MONTH(month_to_do, year_to_do);
       }
 
       if  ( (year_to_do > HDATE_HEB_YR_LOWER_BOUND) &&
           ( (h->hd_size_of_year > 355 ) || (opt->gregorian > 1)) )
       {
-        opt->three_month = 12;
-        month(12, year_to_do, opt);
+        three_month = 12;
+        QUEUE_MONTH(12, year_to_do);
       }
+      print_month_jobs( job, job_count, opt );
       if ( (h->hd_size_of_year > 355 ) && (opt->gregorian > 1) )
         opt->three_month = 13;
     }
@@ -2084,24 +2341,26 @@ void year( int year_to_do, hdate_struct* h, option_list* opt )
         if ( ( opt->gregorian < 2 )       &&
            ( h->hd_size_of_year > 355 ) )
         {
-          if (month_to_do == 6) month(13, year_to_do, opt);
+          if (month_to_do == 6) QUEUE_MONTH(13, year_to_do);
           else if (month_to_do == 7)
           {
-            month(14, year_to_do, opt);
-            month(month_to_do, year_to_do, opt);
+            QUEUE_MONTH(14, year_to_do);
+            QUEUE_MONTH(month_to_do, year_to_do);
           }
-          else month(month_to_do, year_to_do, opt);
+          else QUEUE_MONTH(month_to_do, year_to_do);
         }
-        else month(month_to_do, year_to_do, opt);
-         if ((opt->footnote) && (month_to_do<=num_of_months)) printf("\n");
+        else QUEUE_MONTH(month_to_do, year_to_do);
+        if ((opt->footnote) && (month_to_do<=num_of_months)) job[job_count-1].newlines++;
       }
       if ( (opt->gregorian > 1) && (year_to_do > HDATE_HEB_YR_LOWER_BOUND) )
       {
-         if (opt->footnote) printf("\n");
-        month( 1, year_to_do+1, opt) ;
+        if (opt->footnote) job[job_count-1].newlines++;
+        QUEUE_MONTH(1, year_to_do+1);
       }
+      print_month_jobs( job, job_count, opt );
     }
   }
+#undef QUEUE_MONTH
 }
 
 
@@ -2119,6 +2378,7 @@ void exit_main( option_list *opt, const int exit_code)
   }
   if (opt->jdn_list_ptr != NULL) free(opt->jdn_list_ptr);
   if (opt->string_list_ptr != NULL) free(opt->string_list_ptr);
+  hdate_snapshot_close(opt->snapshot);
   exit (exit_code);
 }
 
@@ -2622,6 +2882,10 @@ const struct option long_options[] = {
   {"usage", no_argument, 0, '?'},
   {"mlterm", no_argument, 0, 0},
   {"tmux-bidi", no_argument, 0, 0},
+  {"snapshot", required_argument, 0, 0},
+  {"jobs", optional_argument, 0, 0},
+  {"batch", required_argument, 0, 0},
+  {"cache", required_argument, 0, 0},
   {0, 0, 0, 0}
   };
 
@@ -2726,6 +2990,36 @@ int hcal_parser( const int switch_arg, option_list *opt,
 /** --usage             */  case 32: break;
 /** --mlterm            */  case 33: opt->mlterm = true; break;
 /** --tmux-bidi         */  case 34: opt->tmux_bidi = true; break;
+/** --snapshot          */  case 35:
+      switch (sscanf(optarg, "%d-%d", &opt->snapshot_year_first, &opt->snapshot_year_last))
+      {
+      case 1: opt->snapshot_year_last = opt->snapshot_year_first; break;
+      case 2: break;
+      default: opt->snapshot_year_first = 0;
+      }
+      if ( (opt->snapshot_year_first < HDATE_GREG_YR_LOWER_BOUND) ||
+           (opt->snapshot_year_last > HDATE_GREG_YR_UPPER_BOUND) ||
+           (opt->snapshot_year_first > opt->snapshot_year_last) )
+      {
+        opt->snapshot_year_first = 0;
+        parm_error("--snapshot");
+        error_detected++;
+      }
+      break;
+/** --jobs              */  case 36:
+      if (optarg == NULL) opt->jobs = sysconf(_SC_NPROCESSORS_ONLN);
+      else if (fnmatch( "[[:digit:]]?([[:digit:]])", optarg, FNM_EXTMATCH) == 0)
+        opt->jobs = atoi(optarg);
+      else opt->jobs = 0;
+      if (opt->jobs < 1)
+      {
+        opt->jobs = 1;
+        parm_error("--jobs");
+        error_detected++;
+      }
+      break;
+/** --batch             */  case 37: opt->batch_path = optarg; break;
+/** --cache             */  case 38: opt->cache_dir = optarg; break;
     } // end switch for long_options
     break;
 
@@ -3091,6 +3385,336 @@ void initialize_option_list_struct( option_list* opt )
   opt->epoch_end = 0;
   opt->menu = 0;
   for (int i=0; i<MAX_MENU_ITEMS; i++) opt->menu_item[i] = NULL;
+  opt->snapshot = NULL;
+  opt->snapshot_year_first = 0;
+  opt->snapshot_year_last = 0;
+  opt->jobs = 1;
+  opt->batch_path = NULL;
+  opt->cache_dir = NULL;
+  opt->custom_days_path = NULL;
+}
+
+
+
+/****************************************************
+* produce the user's request, for the location in opt
+****************************************************/
+void print_request( option_list* opt, int argc, char* argv[] )
+{
+  hdate_struct h;
+  int month_to_do = 0;
+  int year_to_do = 0;
+
+  if ((opt->gregorian <2) &&
+      (!opt->not_sunset_aware) &&
+      (check_for_sunset(&h, opt->lat, opt->lon, opt->tz)) )
+    opt->is_after_sunset = true;
+  set_day_needing_highlighting ( &h, opt );
+  parse_and_validate_date_parameters ( &h, opt, argc, argv, &month_to_do, &year_to_do );
+  process_diaspora_awareness( opt );
+  // Now we are ready to produce the user's request
+  if (opt->html)
+		html_header (opt->external_css, opt->force_hebrew);
+  if (opt->one_year)
+    year( year_to_do, &h, opt );
+  else
+		month( month_to_do, year_to_do, opt );
+  if (opt->html)
+		html_footer();
+}
+
+
+
+/****************************************************
+* a location of a --batch manifest
+****************************************************/
+typedef struct {
+  char* output;
+  char* field[5];   // latitude, longitude, timezone, diaspora, custom days
+  int line_number;
+  pid_t pid;
+} batch_location;
+
+#define BATCH_FIELD_NOT_GIVEN(f) ( ((f) == NULL) || (strcmp((f), "-") == 0) )
+
+
+
+/****************************************************
+* free the locations of a --batch manifest
+****************************************************/
+void free_batch_manifest( batch_location* location, const int count )
+{
+  int i, j;
+  for (i=0; i<count; i++)
+  {
+    free(location[i].output);
+    for (j=0; j<5; j++) free(location[i].field[j]);
+  }
+  free(location);
+}
+
+
+
+/****************************************************
+* read a --batch manifest
+*
+* RETURNS: the number of locations, or -1 on error.
+* *location is to be freed by free_batch_manifest
+****************************************************/
+int read_batch_manifest( const char* path, batch_location** location,
+                         const int quiet_alerts )
+{
+  FILE* manifest;
+  char* line = NULL;
+  size_t line_size = 0;
+  char* token;
+  char* save_ptr;
+  int count = 0, allocated = 0, line_number = 0;
+  int i, error_detected = false;
+  batch_location* new_location;
+
+  *location = NULL;
+  manifest = fopen(path, "r");
+  if (manifest == NULL)
+  {
+    error(0, errno, "%s", path);
+    return -1;
+  }
+  while (getline(&line, &line_size, manifest) != -1)
+  {
+    line_number++;
+    token = strtok_r(line, " \t\r\n", &save_ptr);
+    if ( (token == NULL) || (token[0] == '#') ) continue;
+    if (count == allocated)
+    {
+      allocated = (allocated == 0) ? 16 : allocated * 2;
+      new_location = realloc(*location, allocated * sizeof(batch_location));
+      if (new_location == NULL)
+      {
+        error(0, errno, "memory allocation failure");
+        error_detected = true;
+        break;
+      }
+      *location = new_location;
+    }
+    memset(&(*location)[count], 0, sizeof(batch_location));
+    (*location)[count].line_number = line_number;
+    (*location)[count].output = strdup(token);
+    for (i=0; i<5; i++)
+    {
+      token = strtok_r(NULL, " \t\r\n", &save_ptr);
+      if (token == NULL) break;
+      (*location)[count].field[i] = strdup(token);
+    }
+    count++;
+    if (i < 3)
+    {
+      error(0, 0, "%s:%d: %s", path, line_number,
+            N_("expected output latitude longitude timezone"));
+      error_detected = true;
+    }
+    else if ( (!BATCH_FIELD_NOT_GIVEN((*location)[count-1].field[3])) &&
+              (strcmp((*location)[count-1].field[3], "diaspora") != 0) &&
+              (strcmp((*location)[count-1].field[3], "israel") != 0) )
+    {
+      error(0, 0, "%s:%d: %s", path, line_number,
+            N_("expected diaspora, israel or -"));
+      error_detected = true;
+    }
+  }
+  free(line);
+  fclose(manifest);
+  if (error_detected)
+  {
+    free_batch_manifest(*location, count);
+    *location = NULL;
+    return -1;
+  }
+  if ( (count == 0) && (!quiet_alerts) )
+    error(0, 0, "%s: %s", path, N_("no locations"));
+  return count;
+}
+
+
+
+/****************************************************
+* apply the fields of a --batch location to opt and
+* to lat, lon and tz
+*
+* RETURNS: the number of errors detected
+****************************************************/
+int apply_batch_location( const batch_location* location, option_list* opt,
+                          double* lat, double* lon, int* tz )
+{
+  int error_detected = 0;
+  static const char switch_arg[3] = { 'l', 'L', 'z' };
+  int i;
+
+  for (i=0; i<3; i++)
+  {
+    if (BATCH_FIELD_NOT_GIVEN(location->field[i])) continue;
+    if (i == 2) opt->tz_name_str = NULL;
+    optarg = location->field[i];
+    error_detected = error_detected + hcal_parser( switch_arg[i], opt,
+                      lat, lon, tz, opt->tz_name_str, 0 );
+  }
+  if (!BATCH_FIELD_NOT_GIVEN(location->field[3]))
+  {
+    opt->diaspora = (strcmp(location->field[3], "diaspora") == 0);
+    opt->force_israel = !opt->diaspora;
+  }
+  if (!BATCH_FIELD_NOT_GIVEN(location->field[4]))
+    opt->custom_days_path = location->field[4];
+  return error_detected;
+}
+
+
+
+/****************************************************
+* print the calendar of one --batch location, in a
+* worker process; does not return
+*
+* The calendar is printed into a temporary file
+* beside the output file, which replaces the output
+* file only once the calendar is complete.
+****************************************************/
+void print_batch_location( const batch_location* location, option_list* opt,
+                           double lat, double lon, int tz,
+                           int argc, char* argv[] )
+{
+  char* temporary;
+  int fd;
+  mode_t mask;
+  int failed;
+
+  if (apply_batch_location( location, opt, &lat, &lon, &tz ))
+  {
+    error(0, 0, "%s: %s", location->output, N_("bad location"));
+    _exit(EXIT_CODE_BAD_PARMS);
+  }
+  opt->lat = lat;
+  opt->lon = lon;
+  opt->tz = tz;
+  // the locations are already spread over the --jobs
+  opt->jobs = 1;
+
+  if (asprintf(&temporary, "%s.XXXXXX", location->output) < 0)
+  {
+    error(0, errno, "memory allocation failure");
+    _exit(EXIT_FAILURE);
+  }
+  fd = mkstemp(temporary);
+  if (fd == -1)
+  {
+    error(0, errno, "%s", temporary);
+    _exit(EXIT_FAILURE);
+  }
+  // the permissions that creating the output file would give it
+  mask = umask(0);
+  umask(mask);
+  fchmod(fd, 0666 & ~mask);
+  if (dup2( fd, STDOUT_FILENO ) == -1)
+  {
+    error(0, errno, "%s", temporary);
+    unlink(temporary);
+    _exit(EXIT_FAILURE);
+  }
+  close(fd);
+  output_init( &output_stdout, stdout );
+  print_request( opt, argc, argv );
+  output_flush_stdout();
+  failed = output_stdout.failed || ferror(stdout) || (fflush(stdout) != 0);
+  if ( (!failed) && (rename(temporary, location->output) != 0) )
+  {
+    error(0, errno, "%s", location->output);
+    failed = true;
+  }
+  if (failed) unlink(temporary);
+  _exit( failed ? EXIT_FAILURE : 0 );
+}
+
+
+
+/****************************************************
+* process a --batch request
+*
+* Everything common to the locations (the config file,
+* the command line and the snapshot) is read once,
+* here, and the location of every line is checked
+* before any is printed; each location is then
+* printed by a worker process forked from this one,
+* up to opt->jobs at a time.
+*
+* RETURNS: an exit code
+****************************************************/
+int batch( option_list* opt, double lat, double lon, int tz,
+           int argc, char* argv[] )
+{
+  batch_location* location;
+  int count, i, j, running = 0;
+  int status, exit_code = 0;
+  pid_t pid;
+
+  count = read_batch_manifest( opt->batch_path, &location, opt->quiet_alerts );
+  if (count < 0) return EXIT_CODE_BAD_PARMS;
+  for (i=0; i<count; i++)
+  {
+    option_list location_opt = *opt;
+    double location_lat = lat;
+    double location_lon = lon;
+    int location_tz = tz;
+    if (apply_batch_location( &location[i], &location_opt,
+                              &location_lat, &location_lon, &location_tz ))
+    {
+      error(0, 0, "%s:%d: %s", opt->batch_path, location[i].line_number,
+            N_("bad location"));
+      exit_code = EXIT_CODE_BAD_PARMS;
+    }
+    if (location_opt.tz_name_str != opt->tz_name_str)
+      free(location_opt.tz_name_str);
+  }
+  if (exit_code != 0)
+  {
+    free_batch_manifest(location, count);
+    return exit_code;
+  }
+  output_flush_stdout();
+  for (i=0; i<count; i++)
+  {
+    for ( ; running >= opt->jobs; running--)
+    {
+      pid = wait(&status);
+      if (pid == -1) break;
+      for (j=0; j<i; j++)
+        if (location[j].pid == pid)
+        {
+          location[j].pid = 0;
+          if ( (!WIFEXITED(status)) || (WEXITSTATUS(status) != 0) )
+            exit_code = EXIT_FAILURE;
+        }
+    }
+    location[i].pid = fork();
+    if (location[i].pid == 0)
+      print_batch_location( &location[i], opt, lat, lon, tz, argc, argv );
+    if (location[i].pid == -1)
+    {
+      error(0, errno, "%s", location[i].output);
+      exit_code = EXIT_FAILURE;
+      continue;
+    }
+    running++;
+  }
+  for (i=0; i<count; i++)
+  {
+    if (location[i].pid > 0)
+    {
+      if ( (waitpid( location[i].pid, &status, 0 ) == -1) ||
+           (!WIFEXITED(status)) || (WEXITSTATUS(status) != 0) )
+        exit_code = EXIT_FAILURE;
+    }
+  }
+  free_batch_manifest(location, count);
+  return exit_code;
 }
 
 
@@ -3104,11 +3728,10 @@ void initialize_option_list_struct( option_list* opt )
 **************************************************/
 int main (int argc, char *argv[])
 {
-  hdate_struct h;
   int error_detected = false;  // exit after reporting ALL bad parms
-  int month_to_do = 0;
-  int year_to_do = 0;
   option_list opt;
+  output_init( &output_stdout, stdout );
+  atexit( output_flush_stdout );
   initialize_option_list_struct( &opt );
   // lat/lon aren't dups of opt.lat/lon because ...
   double lat = BAD_COORDINATE;  // set to this value for error handling
@@ -3134,22 +3757,30 @@ int main (int argc, char *argv[])
   opt.lat = lat;
   opt.lon = lon;
   opt.tz = tz;
-  if ((opt.gregorian <2) &&
-      (!opt.not_sunset_aware) &&
-      (check_for_sunset(&h, opt.lat, opt.lon, opt.tz)) )
-    opt.is_after_sunset = true;
-  set_day_needing_highlighting ( &h, &opt );
-  parse_and_validate_date_parameters ( &h, &opt, argc, argv, &month_to_do, &year_to_do );
-  process_diaspora_awareness( &opt );
-  // Now we are ready to produce the user's request
-  if (opt.html)
-		html_header (opt.external_css, opt.force_hebrew);
-  if (opt.one_year)
-    year( year_to_do, &h, &opt );
-  else
-		month( month_to_do, year_to_do, &opt );
-  if (opt.html)
-		html_footer();
+  if (opt.snapshot_year_first)
+  {
+    if (!write_calendar_snapshot( "/hcal", "/custom_days_v1.8", "/calendar_snapshot",
+                   opt.tz_name_str, opt.lat, opt.lon,
+                   opt.snapshot_year_first, opt.snapshot_year_last,
+                   opt.quiet_alerts ))
+      exit_main(&opt, EXIT_FAILURE);
+    exit_main(&opt, 0);
+  }
+  opt.snapshot = get_calendar_snapshot( "/hcal", "/calendar_snapshot", opt.quiet_alerts );
+  // a menu selection is not on the command line to be hashed
+  if (opt.menu) opt.cache_dir = NULL;
+  if (opt.cache_dir != NULL)
+  {
+    char* config_file_path;
+    cache_key_init( &opt.cache_base );
+    cache_key_add_args( &opt.cache_base, argc, argv );
+    config_file_path = assemnble_config_file_pathname( "/hcal", "/hcalrc_v1.8", opt.quiet_alerts );
+    cache_key_add_file( &opt.cache_base, config_file_path );
+    if (config_file_path != NULL) free( config_file_path );
+  }
+  if (opt.batch_path != NULL)
+    exit_main(&opt, batch( &opt, lat, lon, tz, argc, argv ));
+  print_request( &opt, argc, argv );
   exit_main(&opt, 0);
   return 0;
 }
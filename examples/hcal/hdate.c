@@ -40,6 +40,10 @@
 #include "custom_days.h"        // hcal,hdate common_functions
 #include <zdump3.h>             // zdump, zdumpinfo
 #include "timezone_functions.h" // for get_tz_adjustment
+#include "hdate_server.h"       // for hdate_server
+#include "output_buffer.h"      // for output_buffer
+#include "ical_export.h"        // for ical_export
+#include "output_cache.h"       // for option --cache
 
 
 #define DATA_WAS_NOT_PRINTED 0
@@ -56,6 +60,16 @@
 #define QUIET_HEBREW         4 // suppress also Hebrew date
 
 
+// machine-oriented output formats (--json, --binary)
+#define RECORD_JSON          1 // one JSON object per line, per day
+#define RECORD_BINARY        2 // fixed-width little-endian records
+
+// the binary record format; see print_record_binary
+#define RECORD_BINARY_MAGIC  "HDATEREC"
+#define RECORD_BINARY_VERSION 1
+#define RECORD_BINARY_FIELDS 28
+
+
 // This is the 'holiday code' used in hdate_holyday.c and hdate_strings.c
 #define EREV_PESACH 38
 
@@ -167,6 +181,14 @@ typedef struct  {
   time_t epoch_end;    // for dst transition calc
   time_t epoch_today;
   int epoch_parm_received;
+  int record_output;     // RECORD_JSON or RECORD_BINARY, else 0
+  char* server_address;  // --server: answer queries on this socket
+  int server_threads;    // 0: one per processor
+  char* ical_export;     // --ical-export: directory, or "-" for stdout
+  char* ical_subscribers;// manifest of calendars for --ical-export
+  int ical_years;        // gregorian years to export, 0 for the date range
+  int ical_threads;      // 0: one per processor
+  char* cache_dir;       // --cache: NULL for none
 } option_list;
 
 
@@ -179,63 +201,6 @@ typedef struct {
 
 
 
-// TODO - move daf yomi and limud yomi into libhdate api
-// Daf Yomi cycle began 02 March 2005 = Julian day 2453432
-#define DAF_YOMI_START 2453432
-#define DAF_YOMI_LEN      2711
-
-typedef struct {
-  int start_day;
-  int num_of_days;
-  char* e_masechet;
-  char* h_masechet; } limud_unit;
-
-static const limud_unit daf_yomi[] = {
-{   0,  63, N_("Berachot"), "ברכות" },
-{  63, 156, N_("Shabbat"), "שבת" },
-{ 219, 104, N_("Eiruvin"), "עירובין" },
-{ 323, 120, N_("Pesachim"), "פסחים" },
-{ 443,  21, N_("Shekalim"), "שקלים" },
-{ 464,  87, N_("Yoma"), "יומא" },
-{ 551,  55, N_("Sukkah"), "סוכה" },
-{ 606,  39, N_("Beitzah"), "ביצה" },
-{ 645,  34, N_("Rosh_HaShannah"), "ראש_השנה" },
-{ 679,  30, N_("Taanit"), "תענית" },
-{ 709,  31, N_("Megillah"), "מגילה" },
-{ 740,  28, N_("Moed_Katan"), "מועד_קטן" },
-{ 768,  26, N_("Chagigah"), "חגיגה" },
-{ 794, 121, N_("Yevamot"), "יבמות" },
-{ 915, 111, N_("Ketubot"), "כתובות" },
-{1026,  90, N_("Nedarim"), "נדרים" },
-{1116,  65, N_("Nazir"), "נזיר" },
-{1181,  48, N_("Sotah"), "סוטה" },
-{1229,  89, N_("Gittin"), "גיטין" },
-{1318,  81, N_("Kiddushin"), "קידושין" },
-{1399, 118, N_("Bava_Kamma"), "בבא_קמא" },
-{1517, 118, N_("Bava_Metzia"), "בבא_מציעא" },
-{1635, 175, N_("Bava_Batra"), "בבא_בתרא" },
-{1810, 112, N_("Sanhedrin"), "סנהדרין" },
-{1922,  23, N_("Makkot"), "מכות" },
-{1945,  48, N_("Shevuot"), "שבועות" },
-{1993,  75, N_("Avodah_Zara"), "עבודה_זרה" },
-{2068,  13, N_("Horayot"), "הוריות" },
-{2081, 119, N_("Zevachim"), "זבחים" },
-{2200, 109, N_("Menachot"), "מנחות" },
-{2309, 141, N_("Chullin"), "חולין" },
-{2450,  60, N_("Bechorot"), "בכורות" },
-{2510,  33, N_("Erchin"), "ערכין" },
-{2543,  33, N_("Temurah"), "תמורה" },
-{2576,  27, N_("Keritut"), "כריתות" },
-{2603,  20, N_("Meilah"), "מעילה" },
-{2623,   1, N_("Meilah-Kinnim"), "מעילה_-_קינים" },
-{2625,   2, N_("Kinnim"), "קינים" },
-{2626,   1, N_("Kinnim-Tamid"), "קינים_-_תמיד" },
-{2627,   8, N_("Tamid"), "תמיד" },
-{2635,   4, N_("Middot"), "מדות" },
-{2639,  72, N_("Niddah"), "נדה" },
-{2711,   0,    "",        ""} };
-
-
 static const char* afikomen[9] = {
   N_("There are no easter eggs in this program. Go away."),
   N_("There is no Chanukah gelt in this program. Leave me alone."),
@@ -254,7 +219,7 @@ static const char* afikomen[9] = {
 ************************************************************/
 int print_version ()
 {
-  printf ("hdate (libhdate) 1.8\n\
+  output_printf(&output_stdout, "hdate (libhdate) 1.8\n\
 Copyright (C) 2011-2013, 2022 Boruch Baum; 2004-2010 Yaacov Zamir\n\
 License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>\n\
 This is free software: you are free to change and redistribute it.\n\
@@ -267,7 +232,7 @@ There is NO WARRANTY, to the extent permitted by law.\n");
 ************************************************************/
 void print_usage_hdate ()
 {
-  printf ("%s\n",
+  output_printf(&output_stdout, "%s\n",
 N_("Usage: hdate [options] [coordinates] [timezone] [date_spec]\n\
        hdate [options] [coordinates] [timezone] [julian_day|time_t]\n\n\
        coordinates: -l [NS]yy[.yyy]     -L [EW]xx[.xxx]\n\
@@ -281,7 +246,7 @@ N_("Usage: hdate [options] [coordinates] [timezone] [date_spec]\n\
 ************************************************************/
 void print_try_help_hdate ()
 {
-  printf ("%s\n", N_("Try \'hdate --help\' for more information"));
+  output_printf(&output_stdout, "%s\n", N_("Try \'hdate --help\' for more information"));
 }
 
 
@@ -292,7 +257,7 @@ void print_help ()
 {
   print_usage_hdate();
 
-  printf ("%s\n", N_("hdate - display Hebrew date information\nOPTIONS:\n\
+  output_printf(&output_stdout, "%s\n", N_("hdate - display Hebrew date information\nOPTIONS:\n\
    -b --bidi          prints hebrew in reverse (visual)\n\
       --visual\n\
    -d --diaspora      force diaspora readings and holidays.\n\
@@ -355,6 +320,31 @@ void print_help ()
    --yom              force Hebrew prefix to Hebrew day of week\n\
    --leshabbat        insert parasha between day of week and day\n\
    --leseder          insert parasha between day of week and day\n\
+   --json             print one JSON object per day, per line, with\n\
+                      times in seconds from 00:00 UTC\n\
+   --binary           print fixed-width binary records, as documented\n\
+                      in the source (print_record_binary)\n\
+   --server address   stay running and answer date, holiday and zmanim\n\
+                      queries, one per line, on a unix socket (when the\n\
+                      address has a '/') or on [host:]port\n\
+   --server-threads n worker threads for --server (default: one per\n\
+                      processor)\n\
+   --ical-export dir  write RFC 5545 calendars of holidays (-h), parshiot\n\
+                      (-r), candle-lighting and havdalah, a file per\n\
+                      gregorian year (dir/yyyy.ics), rewriting only the\n\
+                      years that changed; '-' writes one calendar to\n\
+                      stdout\n\
+   --ical-years n     export n gregorian years from the date given\n\
+   --ical-subscribers file\n\
+                      export a calendar into dir/name/ for each line of\n\
+                      file: name latitude longitude timezone\n\
+                        [diaspora|israel]\n\
+   --ical-threads n   worker threads for --ical-subscribers (default:\n\
+                      one per processor)\n\
+   --cache dir        keep the output in dir, and reuse it on later\n\
+                      runs for as long as none of the options, config\n\
+                      file, custom days, time zone data or locale have\n\
+                      changed. Requests for today are never cached\n\
    --not-sunset-aware don't display next day if after sunset\n\
    --data-first       display data, followed by it's description\n\
    --labels-first     display data descriptions before the data itself\n\
@@ -401,13 +391,13 @@ int print_astronomical_time( char *description,  const int timeval_0, option_lis
   {
     if (!opt->print_epoch)
     {
-      if (!opt->data_first) printf("%s%c --:--\n", descr,delim);
-      else printf("--:-- %s\n", descr);
+      if (!opt->data_first) output_printf(&output_stdout, "%s%c --:--\n", descr,delim);
+      else output_printf(&output_stdout, "--:-- %s\n", descr);
     }
     else // (opt->print_epoch)
     {
-      if (!opt->data_first) printf("%s%c ----------\n", descr,delim);
-      else printf("---------- %s\n", descr);
+      if (!opt->data_first) output_printf(&output_stdout, "%s%c ----------\n", descr,delim);
+      else output_printf(&output_stdout, "---------- %s\n", descr);
     }
     return DATA_WAS_NOT_PRINTED;
   }
@@ -421,13 +411,22 @@ int print_astronomical_time( char *description,  const int timeval_0, option_lis
   }
   if (opt->data_first)
   {
-    if (opt->print_epoch) printf("%10ld %s\n", timeval_1, descr);
-    else printf("%02ld:%02ld %s\n", (timeval_1 / 60) % 24, timeval_1 % 60, descr );
+    if (opt->print_epoch) output_printf(&output_stdout, "%10ld %s\n", timeval_1, descr);
+    else
+    {
+      output_hhmm(&output_stdout, timeval_1);
+      output_printf(&output_stdout, " %s\n", descr);
+    }
   }
   else // (!opt->data_first)
   {
-    if (opt->print_epoch) printf("%s%c %10ld\n", descr, delim, timeval_1);
-    else printf("%s%c %02ld:%02ld\n", descr, delim, (timeval_1 / 60) % 24, timeval_1 % 60 );
+    if (opt->print_epoch) output_printf(&output_stdout, "%s%c %10ld\n", descr, delim, timeval_1);
+    else
+    {
+      output_printf(&output_stdout, "%s%c ", descr, delim);
+      output_hhmm(&output_stdout, timeval_1);
+      output_char(&output_stdout, '\n');
+    }
   }
   return DATA_WAS_PRINTED;
 }
@@ -441,7 +440,7 @@ void print_astronomical_time_tabular( const int  timeval_0, option_list* opt)
 
   if (timeval_0 < 0)
   {
-    printf(",--:--");
+    output_literal(&output_stdout, ",--:--");
     return;
   }
   timeval_1 = opt->epoch_today + timeval_0;
@@ -451,9 +450,10 @@ void print_astronomical_time_tabular( const int  timeval_0, option_list* opt)
         get_tz_adjustment( timeval_1, opt->tz_offset, &opt->tzif_index,
                   opt->tzif_entries, opt->tzif_data );
     if (timeval_1 < 0) timeval_1 = SECONDS_PER_DAY + timeval_1;
-    printf(",%02ld:%02ld", (timeval_1 / 60) % 24, timeval_1 % 60 );
+    output_char(&output_stdout, ',');
+    output_hhmm(&output_stdout, timeval_1);
   }
-  else printf(",%10ld", timeval_1);
+  else output_printf(&output_stdout, ",%10ld", timeval_1);
   return;
 }
 
@@ -461,22 +461,17 @@ void print_astronomical_time_tabular( const int  timeval_0, option_list* opt)
 /************************************************************
 * get daf yomi information
 ************************************************************/
-int daf_yomi_info( const int julian_day, int* daf, char** masechet, int force_hebrew)
+int daf_yomi_info( const int julian_day, int* daf, const char** masechet, int force_hebrew)
 {
-  int index, i;
-
-  if (julian_day < 2453432) return FALSE;
+  hdate_limud limud;
+  const hdate_limud_unit* unit;
 
-  index = (julian_day % DAF_YOMI_START) % DAF_YOMI_LEN;
+  if (!hdate_limud_get(hdate_limud_daf_yomi(), julian_day, &limud)) return FALSE;
+  unit = hdate_limud_cycle_unit(hdate_limud_daf_yomi(), limud.unit);
+  *daf = limud.page;
 
-  for ( i=0; daf_yomi[i+1].start_day <= index ; i++) ;
-
-  // These masechaot ketanot don't all start at 2
-  if ( (index > 2622) && (index < 2639) ) *daf = index - 2601;
-  else *daf = index - daf_yomi[i].start_day + 2;
-
-  if (force_hebrew) *masechet = daf_yomi[i].h_masechet;
-  else *masechet = daf_yomi[i].e_masechet;
+  if (force_hebrew) *masechet = unit->hebrew_name;
+  else *masechet = unit->name;
 
   return TRUE;
 }
@@ -489,7 +484,7 @@ int print_daf_yomi( const int julian_day,
           const int tabular_output, const int data_first )
 {
   int daf;
-  char* masechet;
+  const char* masechet;
 
   char *daf_str;
   char *bidi_buffer, *bidi_buffer2;
@@ -502,10 +497,10 @@ int print_daf_yomi( const int julian_day,
   {
     if (!tabular_output)
     {
-      if (!data_first) printf("%s: %s %d\n", daf_yomi_text, masechet, daf);
-      else printf("%s %d %s\n", masechet, daf, daf_yomi_text);
+      if (!data_first) output_printf(&output_stdout, "%s: %s %d\n", daf_yomi_text, masechet, daf);
+      else output_printf(&output_stdout, "%s %d %s\n", masechet, daf, daf_yomi_text);
     }
-    else  printf(",%s %d", masechet, daf);
+    else  output_printf(&output_stdout, ",%s %d", masechet, daf);
   }
   else
   {
@@ -514,10 +509,10 @@ int print_daf_yomi( const int julian_day,
     {
       if (!tabular_output)
       {
-        if (!data_first) printf("%s: %s %s\n", daf_yomi_text, masechet, daf_str);
-        else printf("%s %s %s\n", masechet, daf_str, daf_yomi_text);
+        if (!data_first) output_printf(&output_stdout, "%s: %s %s\n", daf_yomi_text, masechet, daf_str);
+        else output_printf(&output_stdout, "%s %s %s\n", masechet, daf_str, daf_yomi_text);
       }
-      else printf(",%s %d", masechet, daf);
+      else output_printf(&output_stdout, ",%s %d", masechet, daf);
     }
     else
     {
@@ -528,10 +523,10 @@ int print_daf_yomi( const int julian_day,
       revstr(bidi_buffer2, bidi_buffer_len);
       if (!tabular_output)
       {
-        if (!data_first) printf("%s: %s\n",daf_yomi_text, bidi_buffer2);
-        else printf("%s %s\n", bidi_buffer2 ,daf_yomi_text);
+        if (!data_first) output_printf(&output_stdout, "%s: %s\n",daf_yomi_text, bidi_buffer2);
+        else output_printf(&output_stdout, "%s %s\n", bidi_buffer2 ,daf_yomi_text);
       }
-      else printf(",%s",bidi_buffer2);
+      else output_printf(&output_stdout, ",%s",bidi_buffer2);
       if (bidi_buffer  != NULL)  free(bidi_buffer);
       if (bidi_buffer2 != NULL)  free(bidi_buffer2);
     }
@@ -547,10 +542,10 @@ int print_daf_yomi( const int julian_day,
 int print_ical_header ()
 {
   // Print start of iCal format
-  printf ("BEGIN:VCALENDAR\n");
-  printf ("VERSION:2.0\n");
-  printf ("CALSCALE:GREGORIAN\n");
-  printf ("METHOD:PUBLISH\n");
+  output_literal(&output_stdout, "BEGIN:VCALENDAR\n");
+  output_literal(&output_stdout, "VERSION:2.0\n");
+  output_literal(&output_stdout, "CALSCALE:GREGORIAN\n");
+  output_literal(&output_stdout, "METHOD:PUBLISH\n");
 
   return 0;
 }
@@ -564,7 +559,7 @@ int print_ical_header ()
 int print_ical_footer ()
 {
   // Print end of iCal format
-  printf ("END:VCALENDAR\n");
+  output_literal(&output_stdout, "END:VCALENDAR\n");
 
   return 0;
 }
@@ -680,10 +675,10 @@ int print_date (hdate_struct* h, hdate_struct* tomorrow, const option_list* opt)
   ************************************************************/
   if (opt->iCal)
   {
-    printf ("%s%s %s%s ", for_day_of_g,  hday_int_str, bet_h,
+    output_printf(&output_stdout, "%s%s %s%s ", for_day_of_g,  hday_int_str, bet_h,
         hdate_string( HDATE_STRING_HMONTH , h->hd_mon, opt->short_format, opt->hebrew));
 
-    printf ("%s", hyear_int_str);
+    output_printf(&output_stdout, "%s", hyear_int_str);
   }
 
 
@@ -692,19 +687,19 @@ int print_date (hdate_struct* h, hdate_struct* tomorrow, const option_list* opt)
   ************************************************************/
   else if (opt->short_format)
   {
-    printf ("%d.%d.%d  ", h->gd_day, h->gd_mon, h->gd_year);
+    output_printf(&output_stdout, "%d.%d.%d  ", h->gd_day, h->gd_mon, h->gd_year);
 
 
     if ( !hdate_is_hebrew_locale() && !opt->hebrew )
     {
-      printf ("%d", h->hd_day);
+      output_printf(&output_stdout, "%d", h->hd_day);
     }
     else
     {
-      printf ("%s", hday_int_str);
+      output_printf(&output_stdout, "%s", hday_int_str);
     }
 
-    printf (" %s %s\n",
+    output_printf(&output_stdout, " %s %s\n",
       hdate_string( HDATE_STRING_HMONTH , h->hd_mon, opt->short_format, opt->hebrew),
       hyear_int_str);
   }
@@ -719,7 +714,7 @@ int print_date (hdate_struct* h, hdate_struct* tomorrow, const option_list* opt)
     * Gregorian date - the easy part
     ************************************************************/
     if (opt->quiet < QUIET_GREGORIAN)
-      printf ("%s%s, %d %s%s %d, ",
+      output_printf(&output_stdout, "%s%s, %d %s%s %d, ",
         for_day_of_g,
         hdate_string( HDATE_STRING_DOW, h->hd_dw, opt->short_format, HDATE_STRING_LOCAL),
         h->gd_day,
@@ -809,7 +804,7 @@ int print_date (hdate_struct* h, hdate_struct* tomorrow, const option_list* opt)
     /************************************************************
     * Finally. print the information
     ************************************************************/
-    printf ("%s\n", hebrew_buffer);
+    output_printf(&output_stdout, "%s\n", hebrew_buffer);
 
     /************************************************************
     * CLEANUP - free allocated memory
@@ -1001,21 +996,21 @@ int print_times ( hdate_struct * h, option_list* opt)
     data_printed = TRUE;
     if (opt->quiet >= QUIET_DESCRIPTIONS)
     {
-      if (opt->print_epoch) printf(" %05d\n", sun_hour );
-      else printf(" %02d:%02d:%02d\n", sun_hour/3600, (sun_hour%3600)/60, sun_hour%60 );
+      if (opt->print_epoch) output_printf(&output_stdout, " %05d\n", sun_hour );
+      else output_printf(&output_stdout, " %02d:%02d:%02d\n", sun_hour/3600, (sun_hour%3600)/60, sun_hour%60 );
     }
     else
     {
       if (opt->print_epoch)
       {
-        if (!opt->data_first) printf("%s: %05d\n", sun_hour_text, sun_hour );
-        else printf("%05d %s\n", sun_hour, sun_hour_text);
+        if (!opt->data_first) output_printf(&output_stdout, "%s: %05d\n", sun_hour_text, sun_hour );
+        else output_printf(&output_stdout, "%05d %s\n", sun_hour, sun_hour_text);
       }
       else // (!opt->print_epoch)
       {
-        if (!opt->data_first) printf("%s: %02d:%02d:%02d\n", sun_hour_text,
+        if (!opt->data_first) output_printf(&output_stdout, "%s: %02d:%02d:%02d\n", sun_hour_text,
                       sun_hour/3600, (sun_hour%3600)/60, sun_hour%60 );
-        else printf("%02d:%02d:%02d %s\n", sun_hour/3600, (sun_hour%3600)/60, sun_hour%60,
+        else output_printf(&output_stdout, "%02d:%02d:%02d %s\n", sun_hour/3600, (sun_hour%3600)/60, sun_hour%60,
                     sun_hour_text);
       }
     }
@@ -1046,21 +1041,21 @@ int print_omer (hdate_struct * h, const option_list* opt)
   if (omer_day == 0)   return DATA_WAS_NOT_PRINTED;
 
   if ( !opt->data_first && (opt->quiet < QUIET_DESCRIPTIONS) )
-    printf ("%s: ", omer_text);
+    output_printf(&output_stdout, "%s: ", omer_text);
 
   // short format; just the numeric value
   if (opt->omer == 1)
   {
-    if (!opt->hebrew) printf ("%5d", omer_day);
+    if (!opt->hebrew) output_printf(&output_stdout, "%5d", omer_day);
     else
     {
       omer_int_str = hdate_string(HDATE_STRING_INT, omer_day, HDATE_STRING_LONG, HDATE_STRING_HEBREW);
-      if (!opt->bidi) printf("  %*s", (strlen(omer_int_str)==5?5:4), omer_int_str);
+      if (!opt->bidi) output_printf(&output_stdout, "  %*s", (strlen(omer_int_str)==5?5:4), omer_int_str);
       else
       {
         bidi_buffer_len = asprintf (&bidi_buffer, "%s",  omer_int_str);
         revstr(bidi_buffer, bidi_buffer_len);
-        printf("  %*s", (int)(bidi_buffer_len==5?5:4), bidi_buffer);
+        output_printf(&output_stdout, "  %*s", (int)(bidi_buffer_len==5?5:4), bidi_buffer);
         free(bidi_buffer);
       }
       free(omer_int_str);
@@ -1074,12 +1069,12 @@ int print_omer (hdate_struct * h, const option_list* opt)
 		{
       char* b_l_omer = "בעומר";
       if (opt->la_omer) { b_l_omer = "לעומר"; }
-			printf ("  %2d_%s_%s", omer_day, "ימים", b_l_omer);
+			output_printf(&output_stdout, "  %2d_%s_%s", omer_day, "ימים", b_l_omer);
 		}
 		else
 		{
 			if (omer_day == 1) days_text = day_text;
-			printf ("%2d_%s_%s", omer_day, days_text, in_the_omer_text);
+			output_printf(&output_stdout, "%2d_%s_%s", omer_day, days_text, in_the_omer_text);
 		}
   }
   else // long text format
@@ -1166,7 +1161,7 @@ int print_omer (hdate_struct * h, const option_list* opt)
         hayom, yom,  n1,  days, that_are,  n2,  weeks, vav,  n3,  days2, b_l_omer);
 
       if (opt->bidi) revstr(bidi_buffer, bidi_buffer_len);
-      printf("%s", bidi_buffer);
+      output_printf(&output_stdout, "%s", bidi_buffer);
 
       if (n1 != NULL) free(n1);
       if (n2_needs_free && (n2 != NULL)) free(n2);
@@ -1175,34 +1170,34 @@ int print_omer (hdate_struct * h, const option_list* opt)
     }
     else // !opt->hebrew
     {
-      if (omer_day == 1) printf ("%s ", today_is_day_text);
-      else printf ("%s_", N_("today_is"));
+      if (omer_day == 1) output_printf(&output_stdout, "%s ", today_is_day_text);
+      else output_printf(&output_stdout, "%s_", N_("today_is"));
 
-      printf("%d",omer_day);
+      output_printf(&output_stdout, "%d",omer_day);
 
-      if (omer_day > 1) printf("_%s", days_text);
+      if (omer_day > 1) output_printf(&output_stdout, "_%s", days_text);
 
       if (omer_day > 6)
       {
-        printf("%s_%d_", N_(",_which_is"),omer_day/7);
+        output_printf(&output_stdout, "%s_%d_", N_(",_which_is"),omer_day/7);
 
-        if (omer_day < 14) printf ("%s", N_("week"));
-        else printf("%s", N_("weeks"));
+        if (omer_day < 14) output_printf(&output_stdout, "%s", N_("week"));
+        else output_printf(&output_stdout, "%s", N_("weeks"));
 
         if (omer_day%7 != 0)
         {
-          printf ("_%s_%d", N_("and"), omer_day%7);
-          if (omer_day%7 != 1) printf (" %s",  days_text);
-          else printf ("_%s",  day_text);
+          output_printf(&output_stdout, "_%s_%d", N_("and"), omer_day%7);
+          if (omer_day%7 != 1) output_printf(&output_stdout, " %s",  days_text);
+          else output_printf(&output_stdout, "_%s",  day_text);
         }
-        printf("%s", N_(","));
+        output_printf(&output_stdout, "%s", N_(","));
       }
-      printf("_%s", in_the_omer_text);
+      output_printf(&output_stdout, "_%s", in_the_omer_text);
     }
   }
   if ((opt->data_first) && (opt->quiet < QUIET_DESCRIPTIONS))
-    printf (" %s", omer_text);
-  printf("\n");
+    output_printf(&output_stdout, " %s", omer_text);
+  output_literal(&output_stdout, "\n");
   return DATA_WAS_PRINTED;
 }
 
@@ -1222,7 +1217,7 @@ int print_omer (hdate_struct * h, const option_list* opt)
   reading = hdate_get_parasha (h, opt.diaspora);
   if (reading)
   {
-    printf ("%s  %s\n", N_("Parashat"), hdate_string (reading, short_format));
+    output_printf(&output_stdout, "%s  %s\n", N_("Parashat"), hdate_string (reading, short_format));
     return DATA_WAS_PRINTED;
   }
   else return DATA_WAS_NOT_PRINTED;
@@ -1237,46 +1232,46 @@ void print_tabular_header( const option_list* opt)
 {
   if (opt->quiet >= QUIET_DESCRIPTIONS) return;
 
-  if (opt->quiet < QUIET_GREGORIAN) printf("%s,",N_("Gregorian date"));
-  printf("%s", N_("Hebrew Date"));
+  if (opt->quiet < QUIET_GREGORIAN) output_printf(&output_stdout, "%s,",N_("Gregorian date"));
+  output_printf(&output_stdout, "%s", N_("Hebrew Date"));
 
   if (opt->emesh)
   {
-    if (opt->candles) printf(",%s", candles_text);
-    if (opt->sunset) printf(",%s",sunset_text);
-    if (opt->first_stars) printf(",%s",first_stars_text);
-    if (opt->three_stars) printf(",%s",three_stars_text);
-    if (opt->havdalah) printf(",%s", havdalah_text);
-  }
-  if (opt->first_light) printf(",%s",first_light_text);
-  if (opt->talit) printf(",%s",talit_text);
-  if (opt->sunrise) printf(",%s",sunrise_text);
-  if (opt->magen_avraham) printf(",%s",magen_avraham_text);
-  if (opt->shema) printf(",%s",shema_text);
-  if (opt->amidah) printf(",%s",amidah_text);
-
-  if (opt->end_eating_chometz_ma)   printf(",%s", sof_achilat_chametz_ma_text);
-  if (opt->end_eating_chometz_gra) printf(",%s", sof_achilat_chametz_gra_text);
-  if (opt->end_owning_chometz_ma)   printf(",%s", sof_biur_chametz_ma_text);
-  if (opt->end_owning_chometz_gra) printf(",%s", sof_biur_chametz_gra_text);
-
-
-  if (opt->midday) printf(",%s",midday_text);
-  if (opt->mincha_gedola) printf(",%s",mincha_gedola_text);
-  if (opt->mincha_ketana) printf(",%s",mincha_ketana_text);
-  if (opt->plag_hamincha) printf(",%s",plag_hamincha_text);
-  if (opt->candles) printf(",%s", candles_text);
-  if (opt->sunset) printf(",%s",sunset_text);
-  if (opt->first_stars) printf(",%s",first_stars_text);
-  if (opt->three_stars) printf(",%s",three_stars_text);
-  if (opt->havdalah) printf(",%s", havdalah_text);
-  if (opt->sun_hour) printf(",%s",sun_hour_text);
-  if (opt->daf_yomi) printf(",%s",daf_yomi_text);
-  if (opt->omer) printf(",%s",omer_text);
-  if (opt->parasha) printf(",%s", parasha_text);
-  if (opt->holidays) printf(",%s", holiday_tabular_text);
-  if ( opt->holidays && opt->custom_days_cnt ) printf(";%s", custom_day_tabular_text);
-  printf("\n");
+    if (opt->candles) output_printf(&output_stdout, ",%s", candles_text);
+    if (opt->sunset) output_printf(&output_stdout, ",%s",sunset_text);
+    if (opt->first_stars) output_printf(&output_stdout, ",%s",first_stars_text);
+    if (opt->three_stars) output_printf(&output_stdout, ",%s",three_stars_text);
+    if (opt->havdalah) output_printf(&output_stdout, ",%s", havdalah_text);
+  }
+  if (opt->first_light) output_printf(&output_stdout, ",%s",first_light_text);
+  if (opt->talit) output_printf(&output_stdout, ",%s",talit_text);
+  if (opt->sunrise) output_printf(&output_stdout, ",%s",sunrise_text);
+  if (opt->magen_avraham) output_printf(&output_stdout, ",%s",magen_avraham_text);
+  if (opt->shema) output_printf(&output_stdout, ",%s",shema_text);
+  if (opt->amidah) output_printf(&output_stdout, ",%s",amidah_text);
+
+  if (opt->end_eating_chometz_ma)   output_printf(&output_stdout, ",%s", sof_achilat_chametz_ma_text);
+  if (opt->end_eating_chometz_gra) output_printf(&output_stdout, ",%s", sof_achilat_chametz_gra_text);
+  if (opt->end_owning_chometz_ma)   output_printf(&output_stdout, ",%s", sof_biur_chametz_ma_text);
+  if (opt->end_owning_chometz_gra) output_printf(&output_stdout, ",%s", sof_biur_chametz_gra_text);
+
+
+  if (opt->midday) output_printf(&output_stdout, ",%s",midday_text);
+  if (opt->mincha_gedola) output_printf(&output_stdout, ",%s",mincha_gedola_text);
+  if (opt->mincha_ketana) output_printf(&output_stdout, ",%s",mincha_ketana_text);
+  if (opt->plag_hamincha) output_printf(&output_stdout, ",%s",plag_hamincha_text);
+  if (opt->candles) output_printf(&output_stdout, ",%s", candles_text);
+  if (opt->sunset) output_printf(&output_stdout, ",%s",sunset_text);
+  if (opt->first_stars) output_printf(&output_stdout, ",%s",first_stars_text);
+  if (opt->three_stars) output_printf(&output_stdout, ",%s",three_stars_text);
+  if (opt->havdalah) output_printf(&output_stdout, ",%s", havdalah_text);
+  if (opt->sun_hour) output_printf(&output_stdout, ",%s",sun_hour_text);
+  if (opt->daf_yomi) output_printf(&output_stdout, ",%s",daf_yomi_text);
+  if (opt->omer) output_printf(&output_stdout, ",%s",omer_text);
+  if (opt->parasha) output_printf(&output_stdout, ",%s", parasha_text);
+  if (opt->holidays) output_printf(&output_stdout, ",%s", holiday_tabular_text);
+  if ( opt->holidays && opt->custom_days_cnt ) output_printf(&output_stdout, ";%s", custom_day_tabular_text);
+  output_literal(&output_stdout, "\n");
 return;
 }
 
@@ -1347,7 +1342,7 @@ int print_day_tabular (hdate_struct* h, option_list* opt)
   * print Gregorian date
   ************************************************************/
   if (opt->quiet < QUIET_GREGORIAN)
-    printf ("%d.%d.%d,", h->gd_day, h->gd_mon, h->gd_year);
+    output_printf(&output_stdout, "%d.%d.%d,", h->gd_day, h->gd_mon, h->gd_year);
 
 
   /************************************************************
@@ -1368,7 +1363,7 @@ int print_day_tabular (hdate_struct* h, option_list* opt)
           hdate_string( HDATE_STRING_HMONTH , h->hd_mon, opt->short_format, opt->hebrew),
           hyear_str);
       revstr(hebrew_buffer, hebrew_buffer_len);
-      printf ("%s", hebrew_buffer);
+      output_printf(&output_stdout, "%s", hebrew_buffer);
       if (hebrew_buffer != NULL) free(hebrew_buffer);
     }
     else
@@ -1376,19 +1371,19 @@ int print_day_tabular (hdate_struct* h, option_list* opt)
       // review sometime whether both checks are still necessary (see below for hyear)
       //if ((!hdate_is_hebrew_locale()) && (!opt->hebrew))
       //{  /* non hebrew numbers */
-      //  printf ("%d", h->hd_day);
+      //  output_printf(&output_stdout, "%d", h->hd_day);
       //}
       //else /* Hebrew */
       //{
         hday_str = hdate_string(HDATE_STRING_INT, h->hd_day, HDATE_STRING_LONG,opt->hebrew);
-        printf ("%s", hday_str);
+        output_printf(&output_stdout, "%s", hday_str);
       //}
 
-      printf (" %s ",
+      output_printf(&output_stdout, " %s ",
         hdate_string( HDATE_STRING_HMONTH , h->hd_mon, HDATE_STRING_LONG, opt->hebrew));
 
       hyear_str = hdate_string(HDATE_STRING_INT, h->hd_year, HDATE_STRING_LONG,opt->hebrew);
-      printf ("%s", hyear_str);
+      output_printf(&output_stdout, "%s", hyear_str);
     }
     if (hday_str  != NULL) free(hday_str);
     if (hyear_str != NULL) free(hyear_str);
@@ -1503,10 +1498,10 @@ int print_day_tabular (hdate_struct* h, option_list* opt)
   }
   else
   {
-    if (opt->end_eating_chometz_ma)  printf(",--:--");
-    if (opt->end_eating_chometz_gra) printf(",--:--");
-    if (opt->end_owning_chometz_ma)  printf(",--:--");
-    if (opt->end_owning_chometz_gra) printf(",--:--");
+    if (opt->end_eating_chometz_ma)  output_literal(&output_stdout, ",--:--");
+    if (opt->end_eating_chometz_gra) output_literal(&output_stdout, ",--:--");
+    if (opt->end_owning_chometz_ma)  output_literal(&output_stdout, ",--:--");
+    if (opt->end_owning_chometz_gra) output_literal(&output_stdout, ",--:--");
   }
 
   if (opt->midday) print_astronomical_time_tabular( midday, opt);
@@ -1546,7 +1541,7 @@ int print_day_tabular (hdate_struct* h, option_list* opt)
     }
     print_astronomical_time_tabular( havdalah_time, opt);
   }
-  if (opt->sun_hour) printf(",%02d:%02d:%02d", sun_hour/3600, (sun_hour%3600)/60, sun_hour%60 );
+  if (opt->sun_hour) output_printf(&output_stdout, ",%02d:%02d:%02d", sun_hour/3600, (sun_hour%3600)/60, sun_hour%60 );
 
   /************************************************************
   * end - print times of day
@@ -1561,26 +1556,26 @@ int print_day_tabular (hdate_struct* h, option_list* opt)
   if (opt->omer)
   {
     omer_day = hdate_get_omer_day(h);
-    if (omer_day != 0) printf (",%d", omer_day);
-    else printf(",");
+    if (omer_day != 0) output_printf(&output_stdout, ",%d", omer_day);
+    else output_literal(&output_stdout, ",");
   }
 
   if (opt->parasha)
   {
     if (parasha)
     {
-      if (!opt->bidi) printf (",%s",
+      if (!opt->bidi) output_printf(&output_stdout, ",%s",
             hdate_string( HDATE_STRING_PARASHA, parasha, opt->short_format, opt->hebrew));
       else
       {
         hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
             hdate_string( HDATE_STRING_PARASHA, parasha, opt->short_format, opt->hebrew));
         revstr(hebrew_buffer, hebrew_buffer_len);
-        printf (",%s", hebrew_buffer);
+        output_printf(&output_stdout, ",%s", hebrew_buffer);
         free(hebrew_buffer);
       }
     }
-    else printf(",");
+    else output_literal(&output_stdout, ",");
   }
 
   if (opt->holidays)
@@ -1588,46 +1583,41 @@ int print_day_tabular (hdate_struct* h, option_list* opt)
     if (holiday)
     {
       if (!opt->bidi)
-        printf(",%s", hdate_string( HDATE_STRING_HOLIDAY, holiday, opt->short_format, opt->hebrew));
+        output_printf(&output_stdout, ",%s", hdate_string( HDATE_STRING_HOLIDAY, holiday, opt->short_format, opt->hebrew));
       else
       {
         hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
                   hdate_string( HDATE_STRING_HOLIDAY, holiday, opt->short_format, opt->hebrew));
         revstr(hebrew_buffer, hebrew_buffer_len);
-        printf (",%s", hebrew_buffer);
+        output_printf(&output_stdout, ",%s", hebrew_buffer);
         free(hebrew_buffer);
       }
     }
-    else printf (",");
+    else output_literal(&output_stdout, ",");
 
-    // TODO - I could shrink the jdn_list array upon finding a match. This would require a
-    //        a second array with the index into the custom_day text string array, or having
-    //        the jdn_list array in pairs (jdn & 'index into custom_day text string array'
     if (opt->custom_days_cnt)
     {
       int i;
-      int* jdn_list_ptr = opt->jdn_list_ptr;
-      for (i=0; i<opt->custom_days_cnt; i++)
+      // the jdn_list is sorted, so all of a day's custom days are adjacent
+      for ( i = find_custom_day( h->hd_jd, opt->custom_days_cnt, opt->jdn_list_ptr );
+            (i >= 0) && (i < opt->custom_days_cnt) && (opt->jdn_list_ptr[i] == h->hd_jd);
+            i++ )
       {
-        if (h->hd_jd == *jdn_list_ptr)
+        if (!opt->bidi)
+          output_printf(&output_stdout, ";%s", get_custom_day_text_ptr(i, opt->string_list_ptr));
+        else
         {
-          if (!opt->bidi)
-            printf(";%s", get_custom_day_text_ptr(i, opt->string_list_ptr));
-          else
-          {
-            hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
-                      get_custom_day_text_ptr(i, opt->string_list_ptr));
-            revstr(hebrew_buffer, hebrew_buffer_len);
-            printf (";%s", hebrew_buffer);
-            free(hebrew_buffer);
-          }
+          hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
+                    get_custom_day_text_ptr(i, opt->string_list_ptr));
+          revstr(hebrew_buffer, hebrew_buffer_len);
+          output_printf(&output_stdout, ";%s", hebrew_buffer);
+          free(hebrew_buffer);
         }
-        else jdn_list_ptr = jdn_list_ptr + 1;
       }
     }
   }
 
-  printf("\n");
+  output_literal(&output_stdout, "\n");
 
   if ( opt->print_tomorrow && data_printed && !opt->quiet ) print_alert_sunset();
 
@@ -1686,18 +1676,18 @@ int print_day (hdate_struct * h, option_list* opt)
   ************************************************************/
   if (opt->iCal)
   {
-    printf ("BEGIN:VEVENT\n");
-    printf ("UID:hdate-%ld-%d\n", time(&t), ++iCal_uid_counter);
-    printf ("DTSTART;VALUE=DATE:%04d%02d%02d\n", h->gd_year,
+    output_literal(&output_stdout, "BEGIN:VEVENT\n");
+    output_printf(&output_stdout, "UID:hdate-%ld-%d\n", time(&t), ++iCal_uid_counter);
+    output_printf(&output_stdout, "DTSTART;VALUE=DATE:%04d%02d%02d\n", h->gd_year,
         h->gd_mon, h->gd_day);
-    printf ("SUMMARY:");
+    output_literal(&output_stdout, "SUMMARY:");
   }
 
 
   /************************************************************
   * print the Julian Day Number
   ************************************************************/
-  if (opt->julian) printf ("JDN-%d ", h->hd_jd);
+  if (opt->julian) output_printf(&output_stdout, "JDN-%d ", h->hd_jd);
 
 
   /************************************************************
@@ -1721,15 +1711,15 @@ int print_day (hdate_struct * h, option_list* opt)
   {
     if (holiday)
     {
-      if (opt->quiet < QUIET_DESCRIPTIONS) printf ("%s: ", holiday_text);
+      if (opt->quiet < QUIET_DESCRIPTIONS) output_printf(&output_stdout, "%s: ", holiday_text);
       if (!opt->bidi)
-        printf ("%s\n",  hdate_string( HDATE_STRING_HOLIDAY, holiday, opt->short_format, opt->hebrew));
+        output_printf(&output_stdout, "%s\n",  hdate_string( HDATE_STRING_HOLIDAY, holiday, opt->short_format, opt->hebrew));
       else
       {
         hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
                   hdate_string( HDATE_STRING_HOLIDAY, holiday, opt->short_format, opt->hebrew));
         revstr(hebrew_buffer, hebrew_buffer_len);
-        printf ("%s\n", hebrew_buffer);
+        output_printf(&output_stdout, "%s\n", hebrew_buffer);
         free(hebrew_buffer);
       }
       data_printed = DATA_WAS_PRINTED;
@@ -1737,44 +1727,42 @@ int print_day (hdate_struct * h, option_list* opt)
     if (opt->custom_days_cnt)
     {
       int i;
-      int* jdn_list_ptr = opt->jdn_list_ptr;
-      for (i=0; i<opt->custom_days_cnt; i++)
+      // the jdn_list is sorted, so all of a day's custom days are adjacent
+      for ( i = find_custom_day( h->hd_jd, opt->custom_days_cnt, opt->jdn_list_ptr );
+            (i >= 0) && (i < opt->custom_days_cnt) && (opt->jdn_list_ptr[i] == h->hd_jd);
+            i++ )
       {
-        if (h->hd_jd == *jdn_list_ptr)
+        if (opt->quiet < QUIET_DESCRIPTIONS) output_printf(&output_stdout, "%s: ", custom_day_text);
+        if (!opt->bidi)
+          output_printf(&output_stdout, "%s\n", get_custom_day_text_ptr(i, opt->string_list_ptr));
+        else
         {
-          if (opt->quiet < QUIET_DESCRIPTIONS) printf ("%s: ", custom_day_text);
-          if (!opt->bidi)
-            printf("%s\n", get_custom_day_text_ptr(i, opt->string_list_ptr));
-          else
-          {
-            hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
-                      get_custom_day_text_ptr(i, opt->string_list_ptr));
-            revstr(hebrew_buffer, hebrew_buffer_len);
-            printf ("%s\n", hebrew_buffer);
-            free(hebrew_buffer);
-          }
-          data_printed = DATA_WAS_PRINTED;
+          hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
+                    get_custom_day_text_ptr(i, opt->string_list_ptr));
+          revstr(hebrew_buffer, hebrew_buffer_len);
+          output_printf(&output_stdout, "%s\n", hebrew_buffer);
+          free(hebrew_buffer);
         }
-        jdn_list_ptr = jdn_list_ptr + 1;
+        data_printed = DATA_WAS_PRINTED;
       }
     }
   }
   if (opt->omer) data_printed = data_printed | print_omer (h, opt);
   if (opt->parasha && parasha)
   {
-    if ((opt->quiet < QUIET_DESCRIPTIONS) && (!opt->data_first)) printf ("%s: ", parasha_text);
-    if (!opt->bidi) printf ("%s",
+    if ((opt->quiet < QUIET_DESCRIPTIONS) && (!opt->data_first)) output_printf(&output_stdout, "%s: ", parasha_text);
+    if (!opt->bidi) output_printf(&output_stdout, "%s",
           hdate_string( HDATE_STRING_PARASHA, parasha, opt->short_format, opt->hebrew));
     else
     {
       hebrew_buffer_len =  asprintf (&hebrew_buffer, "%s",
           hdate_string( HDATE_STRING_PARASHA, parasha, opt->short_format, opt->hebrew));
       revstr(hebrew_buffer, hebrew_buffer_len);
-      printf ("%s", hebrew_buffer);
+      output_printf(&output_stdout, "%s", hebrew_buffer);
       free(hebrew_buffer);
     }
-    if ((opt->quiet < QUIET_DESCRIPTIONS) && (opt->data_first)) printf (" %s", parasha_text);
-    printf("\n");
+    if ((opt->quiet < QUIET_DESCRIPTIONS) && (opt->data_first)) output_printf(&output_stdout, " %s", parasha_text);
+    output_literal(&output_stdout, "\n");
     data_printed = DATA_WAS_PRINTED;
   }
   if (opt->daf_yomi) data_printed = data_printed | print_daf_yomi(h->hd_jd, opt->hebrew, opt->bidi, FALSE, opt->data_first);
@@ -1793,13 +1781,13 @@ int print_day (hdate_struct * h, option_list* opt)
   ************************************************************/
   if (opt->iCal)
   {
-    printf ("\nCLASS:PUBLIC\n");
-    printf ("DTEND;VALUE=DATE:%04d%02d%02d\n", h->gd_year,
+    output_literal(&output_stdout, "\nCLASS:PUBLIC\n");
+    output_printf(&output_stdout, "DTEND;VALUE=DATE:%04d%02d%02d\n", h->gd_year,
         h->gd_mon, h->gd_day);
-    printf ("CATEGORIES:Holidays\n");
-    printf ("END:VEVENT\n");
+    output_literal(&output_stdout, "CATEGORIES:Holidays\n");
+    output_literal(&output_stdout, "END:VEVENT\n");
   }
-  else printf("\n");
+  else output_literal(&output_stdout, "\n");
 
   return 0;
 }
@@ -1845,7 +1833,7 @@ int print_gmonth ( option_list* opt, int month, int year)
 
   // print month header
   if (!opt->iCal && !opt->short_format)
-    printf ("\n%s:\n",
+    output_printf(&output_stdout, "\n%s:\n",
       hdate_string( HDATE_STRING_GMONTH, h.gd_mon, opt->short_format, HDATE_STRING_LOCAL));
 
   // print month days
@@ -1909,11 +1897,11 @@ int print_hmonth (hdate_struct * h, option_list* opt,
       revstr(bidi_buffer, bidi_buffer_len);
       if (bidi_buffer_len != -1)
       {
-        printf("\n%s:\n", bidi_buffer);
+        output_printf(&output_stdout, "\n%s:\n", bidi_buffer);
         if (bidi_buffer != NULL) free(bidi_buffer);
       }
     }
-    else printf ("\n%s:\n",
+    else output_printf(&output_stdout, "\n%s:\n",
       hdate_string( HDATE_STRING_HMONTH , h->hd_mon, opt->short_format, opt->hebrew));
   }
 
@@ -1990,7 +1978,7 @@ int print_gyear ( option_list* opt, const int year)
 
   // print year header
   if (!opt->iCal && !opt->short_format)
-    printf ("%d:\n", year);
+    output_printf(&output_stdout, "%d:\n", year);
 
   // print year months
   while (month < 13)
@@ -2017,7 +2005,7 @@ int print_hyear ( option_list* opt, const int year)
   // FIXME - error check for NULL return value
 
   // print year header
-  if (!opt->iCal && !opt->short_format)  printf ("%s:\n", h_int_str);
+  if (!opt->iCal && !opt->short_format)  output_printf(&output_stdout, "%s:\n", h_int_str);
 
   // print year months
   while (month < 13)
@@ -2684,6 +2672,39 @@ int parameter_parser( int switch_arg, option_list *opt,
 /** --no-erev        */  case 70: opt->emesh = FALSE;  break;
 /** --epoch                 */  case 71: /** short opt 'E' */ break;
 /** --usage                 */  case 72: /** short opt '?' */ break;
+/** --server                */  case 73: opt->server_address = optarg; break;
+/** --server-threads        */  case 74:
+      if (fnmatch( "+([[:digit:]])", optarg, FNM_EXTMATCH) == 0)
+        opt->server_threads = atoi(optarg);
+      if (opt->server_threads < 1)
+      {
+        parm_error("--server-threads"); // do not gettext!
+        error_detected++;
+      }
+      break;
+/** --json                  */  case 75: opt->record_output = RECORD_JSON; break;
+/** --binary                */  case 76: opt->record_output = RECORD_BINARY; break;
+/** --ical-export           */  case 77: opt->ical_export = optarg; break;
+/** --ical-subscribers      */  case 78: opt->ical_subscribers = optarg; break;
+/** --ical-years            */  case 79:
+      if (fnmatch( "+([[:digit:]])", optarg, FNM_EXTMATCH) == 0)
+        opt->ical_years = atoi(optarg);
+      if (opt->ical_years < 1)
+      {
+        parm_error("--ical-years"); // do not gettext!
+        error_detected++;
+      }
+      break;
+/** --ical-threads          */  case 80:
+      if (fnmatch( "+([[:digit:]])", optarg, FNM_EXTMATCH) == 0)
+        opt->ical_threads = atoi(optarg);
+      if (opt->ical_threads < 1)
+      {
+        parm_error("--ical-threads"); // do not gettext!
+        error_detected++;
+      }
+      break;
+/** --cache                 */  case 81: opt->cache_dir = optarg; break;
     } // end switch for long_options
     break;
 
@@ -2880,6 +2901,15 @@ const struct option long_options[] = {
 /** 70 */{"no-erev", no_argument,0,0},
 /** 71 */{"epoch",optional_argument,0,'E'},
 /** 72 */{"usage", no_argument, 0, '?'},
+/** 73 */{"server", required_argument,0,0},
+/** 74 */{"server-threads", required_argument,0,0},
+/** 75 */{"json", no_argument,0,0},
+/** 76 */{"binary", no_argument,0,0},
+/** 77 */{"ical-export", required_argument,0,0},
+/** 78 */{"ical-subscribers", required_argument,0,0},
+/** 79 */{"ical-years", required_argument,0,0},
+/** 80 */{"ical-threads", required_argument,0,0},
+/** 81 */{"cache", required_argument,0,0},
 /** eof*/{0, 0, 0, 0}
   };
 
@@ -2948,6 +2978,14 @@ void initialize_option_list_struct( option_list* opt )
   opt->lat = BAD_COORDINATE;
   opt->lon = BAD_COORDINATE;
   opt->tz_name_str = NULL;
+  opt->record_output = 0;
+  opt->server_address = NULL;
+  opt->server_threads = 0;
+  opt->ical_export = NULL;
+  opt->ical_subscribers = NULL;
+  opt->ical_years = 0;
+  opt->ical_threads = 0;
+  opt->cache_dir = NULL;
   // opt->tz_lat = BAD_COORDINATE;
   opt->tz_lon = BAD_COORDINATE;
   opt->tz_offset = BAD_TIMEZONE;
@@ -3332,7 +3370,7 @@ void parse_custom_days_file( int hdate_action,
 														 option_list* opt,
 														 hdate_struct* h_start_day,
 														 yymmdd todo,
-  												   FILE *custom_file )
+  												   custom_days_list* custom_days )
 {
   char calendar_type = 'H';
   switch (hdate_action)
@@ -3371,7 +3409,7 @@ void parse_custom_days_file( int hdate_action,
     break;
   }
   opt->custom_days_cnt = read_custom_days_file(
-                           custom_file,
+                           custom_days,
 													 &opt->jdn_list_ptr,
 													 &opt->string_list_ptr,
 													 todo.day,
@@ -3381,7 +3419,6 @@ void parse_custom_days_file( int hdate_action,
 													 *h_start_day,
 													 opt->short_format,
 													 opt->hebrew );
-  fclose(custom_file);
 }
 
 
@@ -3494,6 +3531,387 @@ void process_normal ( int hdate_action,
 
 
 
+/************************************************************
+* find the last day of the Hebrew month that begins on jd
+************************************************************/
+int last_day_of_hmonth( const int jd )
+{
+  hdate_struct h;
+  hdate_set_jd (&h, jd + 29);
+  if (h.hd_day == 30) return jd + 29;
+  return jd + 28;
+}
+
+
+
+/************************************************************
+* find the range of julian days on which to act
+************************************************************/
+void get_jd_range( int hdate_action,
+                   hdate_struct* h_start_day,
+                   yymmdd todo,
+                   int* jd_first,
+                   int* jd_last )
+{
+  hdate_struct h;
+  switch (hdate_action)
+  {
+  case PROCESS_HEBREW_YEAR:
+    hdate_set_hdate (&h, 1, 1, todo.year);
+    *jd_first = h.hd_jd;
+    *jd_last = h.hd_jd + h.hd_size_of_year - 1;
+    break;
+  case PROCESS_GREGOR_YEAR:
+    hdate_set_gdate (&h, 1, 1, todo.year);
+    *jd_first = h.hd_jd;
+    hdate_set_gdate (&h, 31, 12, todo.year);
+    *jd_last = h.hd_jd;
+    break;
+  case PROCESS_MONTH:
+    if (todo.year >= HDATE_HEB_YR_LOWER_BOUND)
+    {
+      // if leap year, both Adar months
+      if (h_start_day->hd_size_of_year > 365 && todo.month == 6)
+      {
+        hdate_set_hdate (&h, 1, 13, todo.year);
+        *jd_first = h.hd_jd;
+        hdate_set_hdate (&h, 1, 14, todo.year);
+      }
+      else
+      {
+        hdate_set_hdate (&h, 1, todo.month, todo.year);
+        *jd_first = h.hd_jd;
+      }
+      *jd_last = last_day_of_hmonth( h.hd_jd );
+    }
+    else
+    {
+      hdate_set_gdate (&h, 1, todo.month, todo.year);
+      *jd_first = h.hd_jd;
+      *jd_last = h.hd_jd
+                 + hdate_get_size_of_gregorian_month( todo.month, todo.year ) - 1;
+    }
+    break;
+  default: // a single day
+    *jd_first = h_start_day->hd_jd;
+    *jd_last = h_start_day->hd_jd;
+    break;
+  }
+}
+
+
+
+/************************************************************
+* print one day - JSON record
+*
+* times are in seconds from 00:00 UTC, and null for a time
+* that does not occur; custom_day is an index into the
+* custom days list, of the day's first custom day if it has
+* any
+************************************************************/
+void print_record_json( output_buffer* out, hdate_struct* h,
+                        const hdate_zmanim* z, const option_list* opt,
+                        const int holiday, const int parasha,
+                        int custom_day )
+{
+  static const char* const time_names[] = {
+    "first_light", "talit", "sunrise", "shema_magen_avraham", "shema",
+    "amidah", "midday", "mincha_gedola", "mincha_ketana", "plag_hamincha",
+    "sunset", "first_stars", "three_stars", "sun_hour" };
+  const int* time;
+  const char* masechet;
+  int daf;
+  int i;
+
+  output_text(out, "{\"jd\":");
+  output_int(out, h->hd_jd);
+  output_text(out, ",\"gregorian\":{\"year\":");
+  output_int(out, h->gd_year);
+  output_text(out, ",\"month\":");
+  output_int(out, h->gd_mon);
+  output_text(out, ",\"day\":");
+  output_int(out, h->gd_day);
+  output_text(out, "},\"hebrew\":{\"year\":");
+  output_int(out, h->hd_year);
+  output_text(out, ",\"month\":");
+  output_int(out, h->hd_mon);
+  output_text(out, ",\"day\":");
+  output_int(out, h->hd_day);
+  output_text(out, "},\"day_of_week\":");
+  output_int(out, h->hd_dw);
+
+  output_text(out, ",\"holiday\":");
+  output_int(out, holiday);
+  output_text(out, ",\"holiday_name\":");
+  output_json_text(out, holiday ? hdate_string_ref( HDATE_STRING_HOLIDAY, holiday,
+                                   opt->short_format, opt->hebrew, NULL) : NULL);
+  output_text(out, ",\"parasha\":");
+  output_int(out, parasha);
+  output_text(out, ",\"parasha_name\":");
+  output_json_text(out, parasha ? hdate_string_ref( HDATE_STRING_PARASHA, parasha,
+                                   opt->short_format, opt->hebrew, NULL) : NULL);
+  output_text(out, ",\"omer\":");
+  output_int(out, hdate_get_omer_day(h));
+
+  output_text(out, ",\"daf_yomi\":");
+  if (daf_yomi_info( h->hd_jd, &daf, &masechet, opt->hebrew))
+  {
+    output_text(out, "{\"masechet\":");
+    output_json_text(out, masechet);
+    output_text(out, ",\"daf\":");
+    output_int(out, daf);
+    output_char(out, '}');
+  }
+  else output_text(out, "null");
+
+  output_text(out, ",\"custom_days\":[");
+  // the jdn_list is sorted, so all of a day's custom days are adjacent
+  for ( i = custom_day;
+        (i >= 0) && (i < opt->custom_days_cnt) && (opt->jdn_list_ptr[i] == h->hd_jd);
+        i++ )
+  {
+    if (i != custom_day) output_char(out, ',');
+    output_json_text(out, get_custom_day_text_ptr(i, opt->string_list_ptr));
+  }
+  output_char(out, ']');
+
+  if (z != NULL)
+  {
+    output_text(out, ",\"times\":{");
+    time = &z->first_light;
+    for (i = 0; i < 14; i++)
+    {
+      if (i) output_char(out, ',');
+      output_char(out, '"');
+      output_text(out, time_names[i]);
+      output_text(out, "\":");
+      if (time[i] == HDATE_NO_ZMAN) output_text(out, "null");
+      else output_int(out, time[i]);
+    }
+    output_char(out, '}');
+  }
+  output_text(out, "}\n");
+}
+
+
+
+/************************************************************
+* print one day - binary record
+*
+* The output begins with a header of the eight bytes
+* RECORD_BINARY_MAGIC followed by the RECORD_BINARY_VERSION
+* and the size of a record in bytes, each as below. Then one
+* record per day of RECORD_BINARY_FIELDS 32 bit little-endian
+* integers:
+*   julian day,
+*   gregorian year, month, day, Hebrew year, month, day,
+*   day of week (1 - Sunday), holiday, parasha, day of omer,
+*   daf yomi masechet (index in the cycle, or -1), daf,
+*   number of custom days (their names are only in --json),
+*   first light, talit, sunrise, shema (M"A), shema, amidah,
+*   midday, mincha gedola, mincha ketana, plag hamincha,
+*   sunset, first stars, three stars, in seconds from 00:00
+*   UTC, and the length of a sun hour in seconds; the times
+*   are HDATE_NO_ZMAN (-720) if they do not occur or if no
+*   time option was given
+************************************************************/
+void print_record_binary( output_buffer* out, hdate_struct* h,
+                          const hdate_zmanim* z, const option_list* opt,
+                          const int holiday, const int parasha,
+                          const int custom_day )
+{
+  hdate_limud limud;
+  const int* time;
+  int count = 0;
+  int i;
+
+  output_int32_le(out, h->hd_jd);
+  output_int32_le(out, h->gd_year);
+  output_int32_le(out, h->gd_mon);
+  output_int32_le(out, h->gd_day);
+  output_int32_le(out, h->hd_year);
+  output_int32_le(out, h->hd_mon);
+  output_int32_le(out, h->hd_day);
+  output_int32_le(out, h->hd_dw);
+  output_int32_le(out, holiday);
+  output_int32_le(out, parasha);
+  output_int32_le(out, hdate_get_omer_day(h));
+  if (hdate_limud_get(hdate_limud_daf_yomi(), h->hd_jd, &limud))
+  {
+    output_int32_le(out, limud.unit);
+    output_int32_le(out, limud.page);
+  }
+  else
+  {
+    output_int32_le(out, -1);
+    output_int32_le(out, 0);
+  }
+  for ( i = custom_day;
+        (i >= 0) && (i < opt->custom_days_cnt) && (opt->jdn_list_ptr[i] == h->hd_jd);
+        i++ )
+    count++;
+  output_int32_le(out, count);
+  time = (z != NULL) ? &z->first_light : NULL;
+  for (i = 0; i < 14; i++)
+    output_int32_le(out, (time != NULL) ? time[i] : HDATE_NO_ZMAN);
+}
+
+
+
+/************************************************************
+* print a range of days as JSON or binary records
+*
+* RETURNS: an exit code
+************************************************************/
+int process_records ( int hdate_action,
+                      option_list* opt,
+                      hdate_struct* h_start_day,
+                      yymmdd todo )
+{
+  hdate_struct h;
+  hdate_zmanim* zmanim = NULL;
+  int* jd = NULL;
+  int jd_first, jd_last, days, i;
+  int holiday, parasha, custom_day;
+
+  get_jd_range( hdate_action, h_start_day, todo, &jd_first, &jd_last );
+  days = jd_last - jd_first + 1;
+
+  // the times of the whole range are computed at once, and
+  // only if a time option was given
+  if (opt->time_option_requested)
+  {
+    jd = malloc( days * sizeof(int) );
+    zmanim = malloc( days * sizeof(hdate_zmanim) );
+    if ( (jd == NULL) || (zmanim == NULL) )
+    {
+      error(0, errno, "%s", N_("memory allocation failure"));
+      free(jd);
+      free(zmanim);
+      return EXIT_FAILURE;
+    }
+    for (i = 0; i < days; i++) jd[i] = jd_first + i;
+    hdate_get_utc_zmanim_bulk( jd, days, &opt->lat, &opt->lon, 1, 0, zmanim );
+  }
+
+  if (opt->record_output == RECORD_BINARY)
+  {
+    output_bytes( &output_stdout, RECORD_BINARY_MAGIC, 8 );
+    output_int32_le( &output_stdout, RECORD_BINARY_VERSION );
+    output_int32_le( &output_stdout, RECORD_BINARY_FIELDS * 4 );
+  }
+
+  // a cursor into the sorted custom days list
+  custom_day = 0;
+  for (i = 0; i < days; i++)
+  {
+    hdate_set_jd (&h, jd_first + i);
+    parasha = hdate_get_parasha (&h, opt->diaspora);
+    holiday = hdate_get_halachic_day (&h, opt->diaspora);
+    // options -R, -H are restrictive filters, as for the other outputs
+    if ( (opt->only_if_parasha && opt->only_if_holiday && !parasha && !holiday)  ||
+         (opt->only_if_parasha && !opt->only_if_holiday && !parasha)        ||
+         (opt->only_if_holiday && !opt->only_if_parasha && !holiday)        )
+      continue;
+    // move to the day's first custom day, if any
+    while ( (custom_day >= 0) && (custom_day < opt->custom_days_cnt) &&
+            (opt->jdn_list_ptr[custom_day] < h.hd_jd) )
+      custom_day++;
+    if (opt->record_output == RECORD_JSON)
+      print_record_json( &output_stdout, &h, (zmanim != NULL) ? &zmanim[i] : NULL, opt,
+                         holiday, parasha, custom_day );
+    else
+      print_record_binary( &output_stdout, &h, (zmanim != NULL) ? &zmanim[i] : NULL, opt,
+                           holiday, parasha, custom_day );
+  }
+  free(jd);
+  free(zmanim);
+
+  if ( !output_flush( &output_stdout ) || (fflush(stdout) != 0) )
+  {
+    error(0, errno, "%s", N_("write error"));
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
+
+
+
+/************************************************************
+* export iCalendar files, of the command line location or
+* of a manifest of subscribers
+*
+* RETURNS: an exit code
+************************************************************/
+int process_ical_export ( int hdate_action,
+                          option_list* opt,
+                          hdate_struct* h_start_day,
+                          yymmdd todo,
+                          const custom_days_list* custom_days )
+{
+  ical_options options;
+  ical_subscriber location;
+  ical_subscriber* subscriber = &location;
+  hdate_struct h;
+  int count = 1;
+  int exit_code;
+
+  get_jd_range( hdate_action, h_start_day, todo, &options.jd_first, &options.jd_last );
+  if (opt->ical_years)
+  {
+    hdate_set_jd (&h, options.jd_first);
+    hdate_set_gdate (&h, 1, 1, h.gd_year);
+    options.jd_first = h.hd_jd;
+    hdate_set_gdate (&h, 31, 12, h.gd_year + opt->ical_years - 1);
+    options.jd_last = h.hd_jd;
+  }
+  options.hebrew = opt->hebrew;
+  options.short_format = opt->short_format;
+  options.holidays = opt->holidays;
+  options.parasha = opt->parasha;
+  options.candles = 0;
+  if (opt->candles)
+    options.candles = (opt->candles != 1) ? opt->candles : DEFAULT_CANDLES_MINUTES;
+  options.havdalah = 0;
+  if (opt->havdalah)
+    options.havdalah = (opt->havdalah != 1) ? opt->havdalah : DEFAULT_MOTZASH_MINUTES;
+  // a calendar of nothing is of no use to anyone
+  if ( !options.holidays && !options.parasha && !options.candles && !options.havdalah )
+  {
+    options.holidays = TRUE;
+    options.parasha = TRUE;
+  }
+  options.threads = opt->ical_threads;
+  options.quiet = opt->quiet;
+  options.custom_days = custom_days;
+
+  if (opt->ical_subscribers != NULL)
+  {
+    count = read_ical_subscribers( opt->ical_subscribers, &subscriber,
+                                   opt->diaspora, opt->quiet );
+    if (count < 0) return EXIT_CODE_BAD_PARMS;
+  }
+  else
+  {
+    location.name = NULL;
+    location.lat = opt->lat;
+    location.lon = opt->lon;
+    location.tz_name = opt->tz_name_str;
+    location.diaspora = opt->diaspora;
+  }
+  exit_code = ical_export( &options, subscriber, count, opt->ical_export );
+  if (subscriber != &location) free_ical_subscribers( subscriber, count );
+
+  if ( !output_flush( &output_stdout ) || (fflush(stdout) != 0) )
+  {
+    error(0, errno, "%s", N_("write error"));
+    return EXIT_FAILURE;
+  }
+  return exit_code;
+}
+
+
+
 /************************************************************
  *
  *
@@ -3517,8 +3935,11 @@ int main (int argc, char *argv[])
   int hdate_action = PROCESS_NOTHING;
   char* tz_name_verified = NULL;
   int error_detected = FALSE;    // exit after reporting ALL bad parms
-  FILE *custom_file = NULL;
+  custom_days_list custom_days;
   int custom_days_file_ready = FALSE;
+  int exit_code = 0;
+  output_init( &output_stdout, stdout );
+  atexit( output_flush_stdout );
   initialize_option_list_struct( &opt );
 
   //  TODO - verify that I'm not needlessly setting locale repeatedly
@@ -3527,7 +3948,7 @@ int main (int argc, char *argv[])
   parse_command_line( argc, argv, &opt, &error_detected );
   if (opt.afikomen)  // undocumented feature
   {
-    printf("%s\n", afikomen[opt.afikomen-1]);
+    output_printf(&output_stdout, "%s\n", afikomen[opt.afikomen-1]);
     exit(0);
   }
   if (opt.menu)
@@ -3537,8 +3958,9 @@ int main (int argc, char *argv[])
   // exist, we can create it
   custom_days_file_ready = get_custom_days_file( "/hdate", "/custom_days_v1.8",
                 opt.tz_name_str, opt.quiet,
-                &custom_file);
-  if (!opt.holidays) fclose(custom_file);
+                &custom_days);
+  if ( (!opt.holidays) && (opt.server_address == NULL) && (opt.ical_export == NULL) )
+    free_custom_days(&custom_days);
   // Determine the date range on which to act
   // See compiler macro definitions PROCESS_*
   hdate_action = parse_and_validate_date_parameters ( &h_start_day,
@@ -3559,6 +3981,17 @@ int main (int argc, char *argv[])
     exit_main(&opt, EXIT_CODE_BAD_PARMS);
   }
   determine_diaspora_awareness( &opt );
+  if (opt.server_address != NULL)
+  {
+    server_options server;
+    server.address = opt.server_address;
+    server.threads = opt.server_threads;
+    server.diaspora = opt.diaspora;
+    server.hebrew = opt.hebrew;
+    server.quiet = opt.quiet;
+    server.custom_days = custom_days_file_ready ? &custom_days : NULL;
+    exit_main(&opt, hdate_server( &server ));
+  }
   if (opt.times)
     set_times_options ( &opt );
   set_hdate_structs( hdate_action, &h_start_day, &h_day_after_final_day, todo );
@@ -3581,6 +4014,11 @@ int main (int argc, char *argv[])
     opt.epoch_today = opt.epoch_start;
   }
 
+  // the subscribers of --ical-subscribers bring their own locations
+  if ( (opt.ical_export != NULL) && (opt.ical_subscribers != NULL) )
+    exit_main(&opt, process_ical_export( hdate_action, &opt, &h_start_day, todo,
+                             custom_days_file_ready ? &custom_days : NULL ));
+
   process_location_parms(  &opt.lat, &opt.lon, opt.tz_lon,
               &opt.tz_offset,  opt.tz_name_str, &tz_name_verified,
               opt.epoch_start, opt.epoch_end,
@@ -3629,13 +4067,54 @@ int main (int argc, char *argv[])
     }
   }
 
+  if (opt.ical_export != NULL)
+    exit_main(&opt, process_ical_export( hdate_action, &opt, &h_start_day, todo,
+                             custom_days_file_ready ? &custom_days : NULL ));
+
+  // the output for today changes with the clock, and that
+  // of a menu selection with what is not on the command line
+  if ( (opt.cache_dir != NULL) && (!opt.menu) &&
+       (hdate_action != PROCESS_TODAY) && (hdate_action != PROCESS_EPOCH_DAY) )
+  {
+    cache_key key;
+    char* path;
+    int jd_first, jd_last;
+    cache_key_init( &key );
+    cache_key_add_args( &key, argc, argv );
+    path = assemnble_config_file_pathname( "/hcal", "/hcalrc_v1.8", opt.quiet );
+    cache_key_add_file( &key, path );
+    if (path != NULL) free( path );
+    path = assemnble_config_file_pathname( "/hdate", "/custom_days_v1.8", opt.quiet );
+    cache_key_add_file( &key, path );
+    if (path != NULL) free( path );
+    cache_key_add_environment( &key, opt.tz_name_str );
+    // the days themselves, because a partial date takes the rest
+    // of the date from today
+    get_jd_range( hdate_action, &h_start_day, todo, &jd_first, &jd_last );
+    cache_key_add_int( &key, jd_first );
+    cache_key_add_int( &key, jd_last );
+    if (cache_fetch( opt.cache_dir, &key, &output_stdout ))
+    {
+      if ( opt.holidays && custom_days_file_ready) free_custom_days(&custom_days);
+      exit_main(&opt, 0);
+    }
+    cache_record( opt.cache_dir, &key, &output_stdout );
+  }
+
   if ( opt.holidays && custom_days_file_ready)
-    parse_custom_days_file( hdate_action, &opt, &h_start_day, todo, custom_file );
+  {
+    parse_custom_days_file( hdate_action, &opt, &h_start_day, todo, &custom_days );
+    free_custom_days(&custom_days);
+  }
 
-  if (opt.tablular_output)
+  if (opt.record_output)
+    exit_code = process_records( hdate_action, &opt, &h_start_day, todo );
+  else if (opt.tablular_output)
     process_tabular( hdate_action, &opt, &h_start_day, todo );
   else
 		process_normal( hdate_action, &opt, &h_start_day, todo );
 
+  cache_record_end( &output_stdout, exit_code == 0 );
+  if (opt.record_output) exit_main(&opt, exit_code);
   return 0;
   }
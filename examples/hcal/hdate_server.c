@@ -0,0 +1,557 @@
+/** hdate_server.c            http://libhdate.sourceforge.net
+ * hdate --server: answer date, holiday and zmanim queries over a
+ * socket, from one long-running process
+ *
+ * The protocol is one request per line, answered by one line of
+ * JSON, in order; a client may send any number of requests before
+ * reading the answers. Requests:
+ *
+ *   date YYYY-MM-DD [diaspora|israel]     a gregorian date
+ *   hdate YYYY-MM-DD [diaspora|israel]    a Hebrew date; month 13 is
+ *                                         Adar I, 14 Adar II
+ *   zmanim YYYY-MM-DD latitude longitude  times of a gregorian date,
+ *                                         in seconds from 00:00 utc
+ *   ping
+ *   quit                                  close the connection
+ *
+ * Failed requests are answered {"ok":false,"error":"..."}. A connection
+ * that sends nothing, or reads nothing, for SERVER_IDLE_TIMEOUT seconds
+ * is closed, so that idle clients can not hold all the worker threads.
+ *
+ * The custom days, the interned names of libhdate and the daf yomi
+ * table are loaded once, and shared by all worker threads.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <hdate.h>		/// For hebrew date (gcc -I ../../src)
+#include <support.h>	/// libhdate general macros, including for gettext
+#include <stdlib.h>		/// For malloc, strtod
+#include <stdio.h>		/// For snprintf
+#include <stdarg.h>		/// For va_list
+#include <string.h>		/// For strtok_r, memchr
+#include <error.h>		/// For error
+#include <errno.h>		/// For errno
+#include <signal.h>		/// For sigwait
+#include <pthread.h>	/// For pthread_create
+#include <unistd.h>		/// For read, close, unlink, sysconf
+#include <netdb.h>		/// For getaddrinfo
+#include <sys/socket.h>	/// For socket, bind, listen, accept
+#include <sys/stat.h>	/// For lstat
+#include <sys/time.h>	/// For struct timeval
+#include <sys/un.h>		/// For sockaddr_un
+#include "custom_days.h"
+#include "hdate_server.h"
+
+/// a request line may be no longer than this
+#define SERVER_INPUT_SIZE 4096
+/// custom days reported per day, at most
+#define SERVER_MAX_CUSTOM_DAYS 8
+#define SERVER_DEFAULT_HOST "127.0.0.1"
+/// seconds a connection may wait on its client
+#define SERVER_IDLE_TIMEOUT 30
+
+
+/// the answers to the requests of one read, sent with one write
+typedef struct
+{
+	char* data;
+	size_t length;
+	size_t size;
+} answer_buffer;
+
+typedef struct
+{
+	const server_options* options;
+	int listen_fd;
+} server_state;
+
+
+/************************************************************
+* append formatted text to an answer buffer; on allocation
+* failure the text is dropped and the connection closed
+* by send_answers
+************************************************************/
+static void append( answer_buffer* out, const char* format, ... )
+{
+	va_list ap;
+	int length;
+	char* data;
+
+	if (out->size == 0) return;
+	for (;;)
+	{
+		va_start(ap, format);
+		length = vsnprintf(out->data + out->length, out->size - out->length, format, ap);
+		va_end(ap);
+		if (length < 0) return;
+		if (out->length + length < out->size)
+		{
+			out->length += length;
+			return;
+		}
+		data = realloc(out->data, out->size + length + 1024);
+		if (data == NULL)
+		{
+			out->size = 0;
+			return;
+		}
+		out->data = data;
+		out->size += length + 1024;
+	}
+}
+
+
+/************************************************************
+* append a JSON string, or null
+************************************************************/
+static void append_string( answer_buffer* out, const char* text )
+{
+	const unsigned char* c;
+
+	if (text == NULL) { append(out, "null"); return; }
+	append(out, "\"");
+	for (c = (const unsigned char*) text; *c; c++)
+	{
+		if ( (*c == '"') || (*c == '\\') ) append(out, "\\%c", *c);
+		else if (*c < 0x20) append(out, "\\u%04x", *c);
+		else append(out, "%c", *c);
+	}
+	append(out, "\"");
+}
+
+
+/************************************************************
+* append a failure answer
+************************************************************/
+static void append_error( answer_buffer* out, const char* message )
+{
+	append(out, "{\"ok\":false,\"error\":");
+	append_string(out, message);
+	append(out, "}\n");
+}
+
+
+/************************************************************
+* parse a YYYY-MM-DD date; returns non-zero on success
+************************************************************/
+static int parse_ymd( const char* text, int* year, int* month, int* day )
+{
+	char extra;
+	if (text == NULL) return FALSE;
+	return (sscanf(text, "%d-%d-%d%c", year, month, day, &extra) == 3);
+}
+
+
+/************************************************************
+* parse an optional diaspora|israel argument
+************************************************************/
+static int parse_diaspora( const char* text, const int by_default, int* diaspora )
+{
+	if (text == NULL) *diaspora = by_default;
+	else if (strcmp(text, "diaspora") == 0) *diaspora = TRUE;
+	else if (strcmp(text, "israel") == 0) *diaspora = FALSE;
+	else return FALSE;
+	return TRUE;
+}
+
+
+/************************************************************
+* answer a date or hdate request for a julian day
+************************************************************/
+static void answer_date( const server_options* options, const int jd,
+						 const int diaspora, answer_buffer* out )
+{
+	hdate_struct h;
+	hdate_limud limud;
+	const hdate_limud_unit* unit;
+	hdate_custom_day found[SERVER_MAX_CUSTOM_DAYS];
+	const char* text;
+	char symbol;
+	int holiday, parasha, count, i;
+
+	hdate_set_jd(&h, jd);
+	holiday = hdate_get_halachic_day(&h, diaspora);
+	parasha = hdate_get_parasha(&h, diaspora);
+
+	append(out, "{\"ok\":true,\"jd\":%d,\"gregorian\":{\"year\":%d,\"month\":%d,\"day\":%d},",
+		   jd, h.gd_year, h.gd_mon, h.gd_day);
+	append(out, "\"hebrew\":{\"year\":%d,\"month\":%d,\"day\":%d,\"month_name\":",
+		   h.hd_year, h.hd_mon, h.hd_day);
+	append_string(out, hdate_string_ref(HDATE_STRING_HMONTH, h.hd_mon, 0, options->hebrew, NULL));
+	append(out, "},\"day_of_week\":%d,\"diaspora\":%s,\"holiday\":%d,\"holiday_name\":",
+		   h.hd_dw, diaspora ? "true" : "false", holiday);
+	append_string(out, holiday ? hdate_string_ref(HDATE_STRING_HOLIDAY, holiday, 0, options->hebrew, NULL) : NULL);
+	append(out, ",\"parasha\":%d,\"parasha_name\":", parasha);
+	append_string(out, parasha ? hdate_string_ref(HDATE_STRING_PARASHA, parasha, 0, options->hebrew, NULL) : NULL);
+	append(out, ",\"omer\":%d,\"daf_yomi\":", hdate_get_omer_day(&h));
+	if (hdate_limud_get(hdate_limud_daf_yomi(), jd, &limud))
+	{
+		unit = hdate_limud_cycle_unit(hdate_limud_daf_yomi(), limud.unit);
+		append(out, "{\"masechet\":");
+		append_string(out, options->hebrew ? unit->hebrew_name : unit->name);
+		append(out, ",\"daf\":%d}", limud.page);
+	}
+	else append(out, "null");
+
+	append(out, ",\"custom_days\":[");
+	count = 0;
+	if ( (options->custom_days != NULL) && (options->custom_days->engine != NULL) )
+		count = hdate_custom_days_get(options->custom_days->engine, jd, jd,
+									  found, SERVER_MAX_CUSTOM_DAYS);
+	if (count > SERVER_MAX_CUSTOM_DAYS) count = SERVER_MAX_CUSTOM_DAYS;
+	for (i = 0; i < count; i++)
+	{
+		text = get_custom_day_rule_text(options->custom_days, found[i].rule,
+										0, options->hebrew, &symbol);
+		append(out, "%s{\"symbol\":\"%c\",\"name\":", (i == 0) ? "" : ",",
+			   ( (symbol == '"') || (symbol == '\\') ) ? ' ' : symbol);
+		append_string(out, text);
+		append(out, "}");
+	}
+	append(out, "]}\n");
+}
+
+
+/************************************************************
+* answer a zmanim request
+************************************************************/
+static void answer_zmanim( const int jd, const double latitude,
+						   const double longitude, answer_buffer* out )
+{
+	hdate_zmanim z;
+
+	hdate_get_utc_zmanim_bulk(&jd, 1, &latitude, &longitude, 1, 1, &z);
+	append(out, "{\"ok\":true,\"jd\":%d,\"latitude\":%g,\"longitude\":%g,"
+		   "\"first_light\":%d,\"talit\":%d,\"sunrise\":%d,"
+		   "\"shema_magen_avraham\":%d,\"shema\":%d,\"amidah\":%d,"
+		   "\"midday\":%d,\"mincha_gedola\":%d,\"mincha_ketana\":%d,"
+		   "\"plag_hamincha\":%d,\"sunset\":%d,\"first_stars\":%d,"
+		   "\"three_stars\":%d,\"sun_hour\":%d}\n",
+		   jd, latitude, longitude, z.first_light, z.talit, z.sunrise,
+		   z.shema_magen_avraham, z.shema, z.amidah, z.midday,
+		   z.mincha_gedola, z.mincha_ketana, z.plag_hamincha, z.sunset,
+		   z.first_stars, z.three_stars, z.sun_hour);
+}
+
+
+/************************************************************
+* answer one request line
+*
+* returns FALSE if the connection is to be closed
+************************************************************/
+static int answer( const server_options* options, char* line, answer_buffer* out )
+{
+	char* save_ptr;
+	char* command;
+	char* argument[4];
+	char* end;
+	int year, month, day, jd, diaspora, i;
+	double latitude, longitude;
+
+	command = strtok_r(line, " \t\r", &save_ptr);
+	if (command == NULL) return TRUE;
+	for (i = 0; i < 4; i++) argument[i] = strtok_r(NULL, " \t\r", &save_ptr);
+
+	if (strcmp(command, "ping") == 0) append(out, "{\"ok\":true}\n");
+	else if (strcmp(command, "quit") == 0) return FALSE;
+	else if ( (strcmp(command, "date") == 0) || (strcmp(command, "hdate") == 0) )
+	{
+		if ( (argument[2] != NULL) || (!parse_ymd(argument[0], &year, &month, &day)) ||
+			 (!parse_diaspora(argument[1], options->diaspora, &diaspora)) )
+			append_error(out, "expected: date|hdate YYYY-MM-DD [diaspora|israel]");
+		else if ( (command[0] == 'd') ?
+				  (hdate_gdate_to_jd_bulk(&day, &month, &year, 1, &jd) == 0) :
+				  (hdate_hdate_to_jd_bulk(&day, &month, &year, 1, &jd) == 0) )
+			append_error(out, "invalid date");
+		else answer_date(options, jd, diaspora, out);
+	}
+	else if (strcmp(command, "zmanim") == 0)
+	{
+		if ( (argument[3] != NULL) || (argument[2] == NULL) ||
+			 (!parse_ymd(argument[0], &year, &month, &day)) )
+			append_error(out, "expected: zmanim YYYY-MM-DD latitude longitude");
+		else if (hdate_gdate_to_jd_bulk(&day, &month, &year, 1, &jd) == 0)
+			append_error(out, "invalid date");
+		else
+		{
+			latitude = strtod(argument[1], &end);
+			if ( (*end != '\0') || (latitude < -90.0) || (latitude > 90.0) )
+				append_error(out, "invalid latitude");
+			else
+			{
+				longitude = strtod(argument[2], &end);
+				if ( (*end != '\0') || (longitude < -180.0) || (longitude > 180.0) )
+					append_error(out, "invalid longitude");
+				else answer_zmanim(jd, latitude, longitude, out);
+			}
+		}
+	}
+	else append_error(out, "unknown request");
+	return TRUE;
+}
+
+
+/************************************************************
+* send the answers so far; returns FALSE on failure
+************************************************************/
+static int send_answers( const int fd, answer_buffer* out )
+{
+	size_t sent = 0;
+	ssize_t n;
+
+	if (out->size == 0) return FALSE;
+	while (sent < out->length)
+	{
+		n = send(fd, out->data + sent, out->length - sent, MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			return FALSE;
+		}
+		sent += n;
+	}
+	out->length = 0;
+	return TRUE;
+}
+
+
+/************************************************************
+* serve one connection until the client closes it or quits
+************************************************************/
+static void serve_connection( const server_options* options, const int fd )
+{
+	char input[SERVER_INPUT_SIZE];
+	size_t used = 0;
+	ssize_t n;
+	char* line;
+	char* newline;
+	int open = TRUE;
+	int at_end = FALSE;
+	answer_buffer out = { NULL, 0, 0 };
+
+	out.data = malloc(SERVER_INPUT_SIZE);
+	if (out.data != NULL) out.size = SERVER_INPUT_SIZE;
+	while (open)
+	{
+		n = read(fd, input + used, sizeof(input) - used);
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+		if (n == 0)
+		{
+			/// a last request, without its newline
+			if (used == 0) break;
+			input[used++] = '\n';
+			at_end = TRUE;
+		}
+		else used += n;
+		/// answer every complete line of this read, then send them all
+		line = input;
+		while ( open &&
+				((newline = memchr(line, '\n', input + used - line)) != NULL) )
+		{
+			*newline = '\0';
+			open = answer(options, line, &out);
+			line = newline + 1;
+		}
+		used = input + used - line;
+		memmove(input, line, used);
+		if (used == sizeof(input))
+		{
+			append_error(&out, "request too long");
+			open = FALSE;
+		}
+		if (at_end) open = FALSE;
+		if (!send_answers(fd, &out)) break;
+	}
+	free(out.data);
+	close(fd);
+}
+
+
+/************************************************************
+* a worker thread: accept and serve connections, forever
+************************************************************/
+static void* server_worker( void* arg )
+{
+	const server_state* state = arg;
+	const struct timeval timeout = { SERVER_IDLE_TIMEOUT, 0 };
+	int fd;
+
+	for (;;)
+	{
+		fd = accept(state->listen_fd, NULL, NULL);
+		if (fd < 0)
+		{
+			if ( (errno == EINTR) || (errno == ECONNABORTED) ) continue;
+			if ( (errno == EMFILE) || (errno == ENFILE) ) { sleep(1); continue; }
+			break;
+		}
+		/// a read or write that times out fails, with EAGAIN, and
+		/// closes the connection
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		serve_connection(state->options, fd);
+	}
+	return NULL;
+}
+
+
+/************************************************************
+* open the listening socket; returns it, or -1
+************************************************************/
+static int server_listen( const char* address )
+{
+	struct sockaddr_un unix_address;
+	struct addrinfo hints, *result, *ai;
+	struct stat st;
+	char* host;
+	const char* port;
+	int fd = -1, one = 1, status;
+
+	if (strchr(address, '/') != NULL)
+	{
+		if (strlen(address) >= sizeof(unix_address.sun_path))
+		{
+			error(0, 0, "%s: %s", address, N_("socket path too long"));
+			return -1;
+		}
+		memset(&unix_address, 0, sizeof(unix_address));
+		unix_address.sun_family = AF_UNIX;
+		strcpy(unix_address.sun_path, address);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		/// a socket left by a server that did not exit cleanly refuses
+		/// connections, and may be replaced; one that accepts them
+		/// belongs to a server that is still running
+		if ( (fd >= 0) && (lstat(address, &st) == 0) && (S_ISSOCK(st.st_mode)) )
+		{
+			if (connect(fd, (struct sockaddr*) &unix_address, sizeof(unix_address)) == 0)
+			{
+				error(0, 0, "%s: %s", address, N_("a server is already running there"));
+				close(fd);
+				return -1;
+			}
+			if (errno == ECONNREFUSED) unlink(address);
+			close(fd);
+			fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		}
+		if ( (fd < 0) ||
+			 (bind(fd, (struct sockaddr*) &unix_address, sizeof(unix_address)) != 0) ||
+			 (listen(fd, SOMAXCONN) != 0) )
+		{
+			error(0, errno, "%s", address);
+			if (fd >= 0) close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	host = strdup(address);
+	if (host == NULL) return -1;
+	port = strrchr(host, ':');
+	if (port == NULL) port = host;
+	else *((char*) port++) = '\0';
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	status = getaddrinfo( ( (port == host) || (host[0] == '\0') ) ? SERVER_DEFAULT_HOST : host,
+						  port, &hints, &result );
+	if (status != 0)
+	{
+		error(0, 0, "%s: %s", address, gai_strerror(status));
+		free(host);
+		return -1;
+	}
+	for (ai = result; ai != NULL; ai = ai->ai_next)
+	{
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (fd < 0) continue;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if ( (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0) &&
+			 (listen(fd, SOMAXCONN) == 0) )
+			break;
+		close(fd);
+		fd = -1;
+	}
+	if (fd < 0) error(0, errno, "%s", address);
+	freeaddrinfo(result);
+	free(host);
+	return fd;
+}
+
+
+/************************************************************
+* run the server until SIGINT, SIGTERM or SIGHUP
+*
+* returns an exit code
+************************************************************/
+int hdate_server( const server_options* options )
+{
+	server_state state;
+	sigset_t signals;
+	pthread_t thread;
+	long threads, i, started = 0;
+	int signal_number;
+	int create_error = 0;
+
+	/// build the tables that the workers share now, so that no
+	/// worker builds them while the others are answering
+	if ( (hdate_string_table_init() != 0) || (hdate_limud_daf_yomi() == NULL) )
+	{
+		error(0, ENOMEM, "%s", N_("failure starting server"));
+		return EXIT_FAILURE;
+	}
+
+	state.options = options;
+	state.listen_fd = server_listen(options->address);
+	if (state.listen_fd < 0) return EXIT_FAILURE;
+
+	/// the workers inherit this mask, so that only sigwait, below,
+	/// sees the signals
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigaddset(&signals, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	threads = options->threads;
+	if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads <= 0) threads = 1;
+	for (i = 0; i < threads; i++)
+	{
+		/// pthread_create returns its error, rather than set errno
+		create_error = pthread_create(&thread, NULL, server_worker, &state);
+		if (create_error != 0) break;
+		pthread_detach(thread);
+		started++;
+	}
+	if (started == 0)
+	{
+		error(0, create_error, "%s", N_("failure starting server threads"));
+		close(state.listen_fd);
+		return EXIT_FAILURE;
+	}
+	if (!options->quiet)
+		error(0, 0, "%s %s, %ld %s", N_("serving on"), options->address,
+			  started, N_("threads"));
+
+	sigwait(&signals, &signal_number);
+	close(state.listen_fd);
+	if (strchr(options->address, '/') != NULL) unlink(options->address);
+	return 0;
+}
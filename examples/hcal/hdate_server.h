@@ -0,0 +1,29 @@
+/** hdate_server.h            http://libhdate.sourceforge.net
+ * hdate --server: answer date, holiday and zmanim queries over a
+ * socket, from one long-running process
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+typedef struct
+{
+	const char* address;		/// a path for a unix socket, else [host:]port
+	int threads;				/// worker threads; 0 for one per processor
+	int diaspora;				/// for requests that do not say
+	int hebrew;					/// give names in Hebrew
+	int quiet;					/// suppress alerts
+	const custom_days_list* custom_days;	/// may be NULL
+} server_options;
+
+int hdate_server( const server_options* options );
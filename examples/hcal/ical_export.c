@@ -0,0 +1,960 @@
+/** ical_export.c            http://libhdate.sourceforge.net
+ * hdate --ical-export: write RFC 5545 calendars of holidays, parshiot,
+ * custom days and Shabbat times, one file per gregorian year, for one
+ * location or for a manifest of subscribers
+ *
+ * Everything of an event that does not depend on its date - the folded
+ * and escaped SUMMARY of each holiday and parasha, the DTSTAMP, the
+ * UID suffix and TZID of each calendar - is prepared once, so that an
+ * event is written as a few copies of ready fragments. The UID of an
+ * event is made of its date, its kind and the calendar, so that it is
+ * the same each time the calendar is exported.
+ *
+ * A year is rendered in memory and compared with the file already in
+ * the export directory, ignoring DTSTAMP; only a year that differs is
+ * written, through a temporary file that is renamed over the old one
+ * so that a reader never sees half a calendar. Subscribers are spread
+ * over worker threads, each exporting whole calendars.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <hdate.h>		/// For hebrew date (gcc -I ../../src)
+#include <support.h>	/// libhdate general macros, including for gettext
+#include <stdlib.h>		/// For malloc, strtod, getenv
+#include <stdio.h>		/// For FILE, open_memstream, rename
+#include <string.h>		/// For strlen, memcmp, strtok_r
+#include <time.h>		/// For time, gmtime_r
+#include <error.h>		/// For error
+#include <errno.h>		/// For errno
+#include <pthread.h>	/// For pthread_create
+#include <unistd.h>		/// For sysconf, getpid
+#include <sys/stat.h>	/// For mkdir
+#include <zdump3.h>		/// For zdump_zone_open, zdump_r, zdump_offset
+#include "custom_days.h"
+#include "output_buffer.h"
+#include "ical_export.h"
+
+#define ICAL_HOLIDAYS		40	/// holiday codes, as in hdate_strings.c
+#define ICAL_PARSHIOT		62
+/// a content line is folded after this many octets
+#define ICAL_LINE_OCTETS	75
+#define ICAL_PRODID			"-//libhdate//hdate//EN"
+#define SECONDS_PER_DAY		86400
+/// the julian day of 1 January 1970
+#define JD_EPOCH			2440588
+
+
+/// the fragments shared by all the calendars of an export
+typedef struct
+{
+	char* holiday[ICAL_HOLIDAYS];	/// "SUMMARY:...\r\n"
+	char* parasha[ICAL_PARSHIOT];
+	char* candles;
+	char* havdalah;
+	char dtstamp[32];				/// "DTSTAMP:...\r\n"
+} ical_templates;
+
+/// the fragments of one calendar
+typedef struct
+{
+	const ical_options* options;
+	const ical_templates* templates;
+	const ical_subscriber* subscriber;
+	const zd_zone* zone;			/// NULL for times in UTC
+	char* dtstart_time;				/// "DTSTART;TZID=...:" or "DTSTART:"
+	char uid_suffix[32];			/// "-<hash>@libhdate\r\n"
+} ical_calendar;
+
+/// the subscribers not yet taken by a worker
+typedef struct
+{
+	const ical_options* options;
+	const ical_templates* templates;
+	const ical_subscriber* subscriber;
+	int count;
+	int next;
+	int exit_code;
+	const char* directory;
+	pthread_mutex_t lock;			/// guards next, exit_code, and stdout
+} ical_queue;
+
+static const char event_begin[] = "BEGIN:VEVENT\r\nUID:";
+static const char all_day_tail[] =
+	"TRANSP:TRANSPARENT\r\nCLASS:PUBLIC\r\nEND:VEVENT\r\n";
+static const char timed_tail[] = "CLASS:PUBLIC\r\nEND:VEVENT\r\n";
+
+
+/************************************************************
+* a content line, "name:value\r\n", with value escaped as
+* TEXT and the line folded at ICAL_LINE_OCTETS octets, but
+* never within a UTF-8 character
+*
+* returns its length; it is written to line only if line
+* is not NULL
+************************************************************/
+static size_t content_line( char* line, const char* name, const char* value )
+{
+	const unsigned char* c;
+	size_t length = 0;
+	int column = 0;
+	int width, i;
+	char escape;
+
+	#define PUT(ch) do { if (line != NULL) line[length] = (ch); length++; } while (0)
+	for ( ; *name; name++, column++) PUT(*name);
+	PUT(':');
+	column++;
+	for (c = (const unsigned char*) value; *c; c++)
+	{
+		escape = 0;
+		if ( (*c == '\\') || (*c == ';') || (*c == ',') ) escape = *c;
+		else if (*c == '\n') escape = 'n';
+		else if (*c < 0x20) continue;
+		if (escape) width = 2;
+		else if (*c < 0x80) width = 1;
+		else if (*c >= 0xf0) width = 4;
+		else if (*c >= 0xe0) width = 3;
+		else if (*c >= 0xc0) width = 2;
+		else continue;	/// a stray continuation byte
+		/// drop a truncated character, as a custom day may end with one
+		for (i = 1; (!escape) && (i < width) && ((c[i] & 0xc0) == 0x80); i++);
+		if ( (!escape) && (i < width) ) continue;
+		if (column + width > ICAL_LINE_OCTETS)
+		{
+			PUT('\r'); PUT('\n'); PUT(' ');
+			column = 1;
+		}
+		column += width;
+		if (escape) { PUT('\\'); PUT(escape); continue; }
+		for (i = 0; i < width; i++) PUT(c[i]);
+		c += width - 1;
+	}
+	PUT('\r'); PUT('\n');
+	PUT('\0');
+	#undef PUT
+	return length - 1;
+}
+
+
+/************************************************************
+* a content line, in malloc'ed memory; NULL on failure
+************************************************************/
+static char* new_content_line( const char* name, const char* value )
+{
+	char* line;
+
+	if (value == NULL) return NULL;
+	line = malloc(content_line(NULL, name, value) + 1);
+	if (line != NULL) content_line(line, name, value);
+	return line;
+}
+
+
+/************************************************************
+* append a content line
+************************************************************/
+static void output_content_line( output_buffer* out, const char* name,
+								 const char* value )
+{
+	char small[512];
+	char* line = small;
+	size_t length;
+
+	length = content_line(NULL, name, value);
+	if ( (length >= sizeof(small)) && ((line = malloc(length + 1)) == NULL) )
+		return;
+	content_line(line, name, value);
+	output_bytes(out, line, length);
+	if (line != small) free(line);
+}
+
+
+/************************************************************
+* append a date, YYYYMMDD
+************************************************************/
+static void output_date( output_buffer* out, const int year,
+						 const int month, const int day )
+{
+	output_int_width(out, year, 4, '0');
+	output_int_width(out, month, 2, '0');
+	output_int_width(out, day, 2, '0');
+}
+
+
+/************************************************************
+* append a date and time, YYYYMMDDTHHMMSS, of seconds from
+* the epoch
+************************************************************/
+static void output_date_time( output_buffer* out, const time_t t )
+{
+	struct tm tm;
+
+	gmtime_r(&t, &tm);
+	output_date(out, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+	output_char(out, 'T');
+	output_int_width(out, tm.tm_hour, 2, '0');
+	output_int_width(out, tm.tm_min, 2, '0');
+	output_int_width(out, tm.tm_sec, 2, '0');
+}
+
+
+/************************************************************
+* append a UTC offset, +HHMM[SS]
+************************************************************/
+static void output_utc_offset( output_buffer* out, int seconds )
+{
+	output_char(out, (seconds < 0) ? '-' : '+');
+	if (seconds < 0) seconds = -seconds;
+	output_int_width(out, seconds / 3600, 2, '0');
+	output_int_width(out, (seconds / 60) % 60, 2, '0');
+	if (seconds % 60) output_int_width(out, seconds % 60, 2, '0');
+}
+
+
+/************************************************************
+* prepare the fragments shared by all calendars
+************************************************************/
+static int make_templates( const ical_options* options, ical_templates* t )
+{
+	const char* epoch;
+	time_t now;
+	struct tm tm;
+	int i;
+
+	memset(t, 0, sizeof(ical_templates));
+	for (i = 1; i < ICAL_HOLIDAYS; i++)
+		t->holiday[i] = new_content_line("SUMMARY",
+			hdate_string_ref(HDATE_STRING_HOLIDAY, i, options->short_format,
+							 options->hebrew, NULL));
+	for (i = 1; i < ICAL_PARSHIOT; i++)
+		t->parasha[i] = new_content_line("SUMMARY",
+			hdate_string_ref(HDATE_STRING_PARASHA, i, options->short_format,
+							 options->hebrew, NULL));
+	t->candles = new_content_line("SUMMARY", _("candle-lighting"));
+	t->havdalah = new_content_line("SUMMARY", _("havdalah"));
+	if ( (t->candles == NULL) || (t->havdalah == NULL) ) return FALSE;
+
+	/// as for reproducible builds, a fixed time may be given
+	epoch = getenv("SOURCE_DATE_EPOCH");
+	now = (epoch != NULL) ? (time_t) strtoll(epoch, NULL, 10) : time(NULL);
+	gmtime_r(&now, &tm);
+	strftime(t->dtstamp, sizeof(t->dtstamp), "DTSTAMP:%Y%m%dT%H%M%SZ\r\n", &tm);
+	return TRUE;
+}
+
+
+static void free_templates( ical_templates* t )
+{
+	int i;
+
+	for (i = 0; i < ICAL_HOLIDAYS; i++) free(t->holiday[i]);
+	for (i = 0; i < ICAL_PARSHIOT; i++) free(t->parasha[i]);
+	free(t->candles);
+	free(t->havdalah);
+}
+
+
+/************************************************************
+* prepare the fragments of one calendar
+************************************************************/
+static int open_calendar( const ical_options* options,
+						  const ical_templates* templates,
+						  const ical_subscriber* subscriber,
+						  ical_calendar* calendar )
+{
+	char key[128];
+	const unsigned char* c;
+	unsigned long long hash = 14695981039346656037ULL;	/// FNV-1a
+	int status;
+
+	calendar->options = options;
+	calendar->templates = templates;
+	calendar->subscriber = subscriber;
+	calendar->zone = NULL;
+
+	/// a named subscriber keeps its UIDs when its location changes
+	if (subscriber->name != NULL)
+		snprintf(key, sizeof(key), "%s", subscriber->name);
+	else
+		snprintf(key, sizeof(key), "%.4f,%.4f,%s", subscriber->lat, subscriber->lon,
+				 (subscriber->tz_name != NULL) ? subscriber->tz_name : "UTC");
+	for (c = (const unsigned char*) key; *c; c++)
+		hash = (hash ^ *c) * 1099511628211ULL;
+	snprintf(calendar->uid_suffix, sizeof(calendar->uid_suffix),
+			 "-%016llx@libhdate\r\n", hash);
+
+	if (subscriber->tz_name != NULL)
+	{
+		status = zdump_zone_open(subscriber->tz_name, &calendar->zone);
+		if (status != ZD_SUCCESS)
+		{
+			error(0, 0, "%s: %s", subscriber->tz_name, N_("timezone not found"));
+			return FALSE;
+		}
+		if (asprintf(&calendar->dtstart_time, "DTSTART;TZID=%s:",
+					 subscriber->tz_name) < 0)
+			return FALSE;
+	}
+	else if ((calendar->dtstart_time = strdup("DTSTART:")) == NULL)
+		return FALSE;
+	return TRUE;
+}
+
+
+/************************************************************
+* append a VTIMEZONE with the observances of a range of
+* days, as the transitions that the zone data lists
+************************************************************/
+static void output_vtimezone( output_buffer* out, const ical_calendar* calendar,
+							  const int jd_first, const int jd_last )
+{
+	zdumpinfo* zd = NULL;
+	time_t start, end, onset;
+	int entries = 0;
+	int i, offset_from;
+
+	if (calendar->zone == NULL) return;
+	/// a day of margin, for local times of the first and last days
+	start = (time_t) (jd_first - 1 - JD_EPOCH) * SECONDS_PER_DAY;
+	end = (time_t) (jd_last + 2 - JD_EPOCH) * SECONDS_PER_DAY;
+	if ( (zdump_r(calendar->zone, start, end, &entries, (void**) &zd) != 0)
+		 || (entries == 0) )
+		return;
+	output_literal(out, "BEGIN:VTIMEZONE\r\n");
+	output_content_line(out, "TZID", calendar->subscriber->tz_name);
+	offset_from = zd[0].utc_offset;
+	for (i = 0; i < entries; i++)
+	{
+		onset = (i == 0) ? start : zd[i].start;
+		if (zd[i].save_secs) output_literal(out, "BEGIN:DAYLIGHT\r\nDTSTART:");
+		else output_literal(out, "BEGIN:STANDARD\r\nDTSTART:");
+		/// the onset is a local time of the observance it ends
+		output_date_time(out, onset + offset_from);
+		output_literal(out, "\r\nTZOFFSETFROM:");
+		output_utc_offset(out, offset_from);
+		output_literal(out, "\r\nTZOFFSETTO:");
+		output_utc_offset(out, zd[i].utc_offset);
+		output_literal(out, "\r\n");
+		if (zd[i].abbr[0] != '\0') output_content_line(out, "TZNAME", zd[i].abbr);
+		if (zd[i].save_secs) output_literal(out, "END:DAYLIGHT\r\n");
+		else output_literal(out, "END:STANDARD\r\n");
+		offset_from = zd[i].utc_offset;
+	}
+	output_literal(out, "END:VTIMEZONE\r\n");
+	free(zd);
+}
+
+
+/************************************************************
+* append the beginning of a VCALENDAR
+************************************************************/
+static void output_calendar_header( output_buffer* out,
+									const ical_calendar* calendar,
+									const int jd_first, const int jd_last )
+{
+	output_literal(out, "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:" ICAL_PRODID
+				   "\r\nCALSCALE:GREGORIAN\r\nMETHOD:PUBLISH\r\n");
+	if (calendar->subscriber->name != NULL)
+		output_content_line(out, "X-WR-CALNAME", calendar->subscriber->name);
+	if (calendar->subscriber->tz_name != NULL)
+		output_content_line(out, "X-WR-TIMEZONE", calendar->subscriber->tz_name);
+	output_vtimezone(out, calendar, jd_first, jd_last);
+}
+
+
+/************************************************************
+* append the beginning of an event, up to its DTSTART
+************************************************************/
+static void output_event_head( output_buffer* out, const ical_calendar* calendar,
+							   const hdate_struct* h, const char* kind,
+							   const int index )
+{
+	output_literal(out, event_begin);
+	output_date(out, h->gd_year, h->gd_mon, h->gd_day);
+	output_char(out, '-');
+	output_text(out, kind);
+	output_char(out, '-');
+	output_int(out, index);
+	output_text(out, calendar->uid_suffix);
+	output_text(out, calendar->templates->dtstamp);
+}
+
+
+/************************************************************
+* append the beginning of an all-day event, up to its
+* SUMMARY
+************************************************************/
+static void output_all_day_head( output_buffer* out, const ical_calendar* calendar,
+								 const hdate_struct* h, const char* kind,
+								 const int index )
+{
+	int day, month, year;
+
+	output_event_head(out, calendar, h, kind, index);
+	output_literal(out, "DTSTART;VALUE=DATE:");
+	output_date(out, h->gd_year, h->gd_mon, h->gd_day);
+	/// DTEND is exclusive
+	hdate_jd_to_gdate(h->hd_jd + 1, &day, &month, &year);
+	output_literal(out, "\r\nDTEND;VALUE=DATE:");
+	output_date(out, year, month, day);
+	output_literal(out, "\r\n");
+}
+
+
+/************************************************************
+* append an event at a time, in seconds from 00:00 UTC
+************************************************************/
+static void output_timed_event( output_buffer* out, const ical_calendar* calendar,
+								const hdate_struct* h, const char* kind,
+								const int utc_seconds, const char* summary )
+{
+	time_t t;
+	int offset;
+
+	/// to the minute, as hdate prints times
+	t = (time_t) (h->hd_jd - JD_EPOCH) * SECONDS_PER_DAY + utc_seconds;
+	t = t - (t % 60);
+	output_event_head(out, calendar, h, kind, 0);
+	output_text(out, calendar->dtstart_time);
+	if (calendar->zone == NULL)
+	{
+		output_date_time(out, t);
+		output_char(out, 'Z');
+	}
+	else
+	{
+		if (zdump_offset(calendar->zone, t, &offset, NULL, NULL) != 0) offset = 0;
+		output_date_time(out, t + offset);
+	}
+	output_literal(out, "\r\n");
+	output_text(out, summary);
+	output_literal(out, timed_tail);
+}
+
+
+/************************************************************
+* append the events of a range of days
+*
+* returns FALSE on memory allocation failure
+************************************************************/
+static int output_events( output_buffer* out, const ical_calendar* calendar,
+						  const int jd_first, const int jd_last )
+{
+	const ical_options* options = calendar->options;
+	const ical_templates* templates = calendar->templates;
+	const ical_subscriber* subscriber = calendar->subscriber;
+	const custom_days_list* custom = options->custom_days;
+	hdate_custom_day* found = NULL;
+	hdate_zmanim* zmanim = NULL;
+	int* jd = NULL;
+	hdate_struct h;
+	const char* text;
+	int days, count = 0, next = 0;
+	int holiday, parasha, i;
+
+	days = jd_last - jd_first + 1;
+	if ( options->holidays && (custom != NULL) && (custom->engine != NULL) )
+	{
+		count = hdate_custom_days_get(custom->engine, jd_first, jd_last, NULL, 0);
+		if (count > 0)
+		{
+			found = malloc(count * sizeof(hdate_custom_day));
+			if (found == NULL) return FALSE;
+			count = hdate_custom_days_get(custom->engine, jd_first, jd_last,
+										  found, count);
+		}
+		if (count < 0) { free(found); return FALSE; }
+	}
+	if ( options->candles || options->havdalah )
+	{
+		/// the calendars are spread over the threads, so the times
+		/// of each are computed in one thread
+		jd = malloc(days * sizeof(int));
+		zmanim = malloc(days * sizeof(hdate_zmanim));
+		if ( (jd == NULL) || (zmanim == NULL) )
+		{
+			free(found); free(jd); free(zmanim);
+			return FALSE;
+		}
+		for (i = 0; i < days; i++) jd[i] = jd_first + i;
+		hdate_get_utc_zmanim_bulk(jd, days, &subscriber->lat, &subscriber->lon,
+								  1, 1, zmanim);
+	}
+
+	for (i = 0; i < days; i++)
+	{
+		hdate_set_jd(&h, jd_first + i);
+		if (options->holidays)
+		{
+			holiday = hdate_get_halachic_day(&h, subscriber->diaspora);
+			if ( (holiday > 0) && (holiday < ICAL_HOLIDAYS)
+				 && (templates->holiday[holiday] != NULL) )
+			{
+				output_all_day_head(out, calendar, &h, "holiday", holiday);
+				output_text(out, templates->holiday[holiday]);
+				output_literal(out, "CATEGORIES:Holidays\r\n");
+				output_literal(out, all_day_tail);
+			}
+			/// the custom days are sorted by day, then by rule
+			for ( ; (next < count) && (found[next].jd == h.hd_jd); next++)
+			{
+				text = get_custom_day_rule_text(custom, found[next].rule,
+										options->short_format, options->hebrew, NULL);
+				if (text == NULL) continue;
+				output_all_day_head(out, calendar, &h, "custom", found[next].rule);
+				output_content_line(out, "SUMMARY", text);
+				output_literal(out, "CATEGORIES:Holidays\r\n");
+				output_literal(out, all_day_tail);
+			}
+		}
+		if ( options->parasha && (h.hd_dw == 7) )
+		{
+			parasha = hdate_get_parasha(&h, subscriber->diaspora);
+			if ( (parasha > 0) && (parasha < ICAL_PARSHIOT)
+				 && (templates->parasha[parasha] != NULL) )
+			{
+				output_all_day_head(out, calendar, &h, "parasha", parasha);
+				output_text(out, templates->parasha[parasha]);
+				output_literal(out, "CATEGORIES:Parasha\r\n");
+				output_literal(out, all_day_tail);
+			}
+		}
+		if ( options->candles && (h.hd_dw == 6)
+			 && (zmanim[i].sunset != HDATE_NO_ZMAN) )
+			output_timed_event(out, calendar, &h, "candles",
+							   zmanim[i].sunset - (options->candles * 60),
+							   templates->candles);
+		if ( options->havdalah && (h.hd_dw == 7)
+			 && (zmanim[i].sunset != HDATE_NO_ZMAN) )
+			output_timed_event(out, calendar, &h, "havdalah",
+							   zmanim[i].sunset + (options->havdalah * 60),
+							   templates->havdalah);
+	}
+	free(found);
+	free(jd);
+	free(zmanim);
+	return TRUE;
+}
+
+
+/************************************************************
+* compare a rendered calendar with a file, ignoring the
+* DTSTAMP lines of both; returns TRUE if they are the same
+************************************************************/
+static int same_calendar( const char* data, const size_t length, const char* path )
+{
+	FILE* file;
+	char* old;
+	long old_length;
+	const char *a, *a_end, *b, *b_end, *a_eol, *b_eol;
+	int same;
+
+	file = fopen(path, "r");
+	if (file == NULL) return FALSE;
+	if ( (fseek(file, 0, SEEK_END) != 0) || ((old_length = ftell(file)) < 0)
+		 || (fseek(file, 0, SEEK_SET) != 0)
+		 || ((old = malloc(old_length + 1)) == NULL) )
+	{
+		fclose(file);
+		return FALSE;
+	}
+	same = (fread(old, 1, old_length, file) == (size_t) old_length);
+	fclose(file);
+
+	#define SKIP_DTSTAMP(p, end, eol) \
+		while ( ((end) - (p) >= 8) && (memcmp((p), "DTSTAMP:", 8) == 0) ) \
+		{ \
+			(eol) = memchr((p), '\n', (end) - (p)); \
+			(p) = ((eol) == NULL) ? (end) : (eol) + 1; \
+		}
+	a = data; a_end = data + length;
+	b = old; b_end = old + old_length;
+	while (same)
+	{
+		SKIP_DTSTAMP(a, a_end, a_eol);
+		SKIP_DTSTAMP(b, b_end, b_eol);
+		if ( (a == a_end) || (b == b_end) )
+		{
+			same = ( (a == a_end) && (b == b_end) );
+			break;
+		}
+		a_eol = memchr(a, '\n', a_end - a);
+		b_eol = memchr(b, '\n', b_end - b);
+		a_eol = (a_eol == NULL) ? a_end : a_eol + 1;
+		b_eol = (b_eol == NULL) ? b_end : b_eol + 1;
+		same = ( (a_eol - a == b_eol - b) && (memcmp(a, b, a_eol - a) == 0) );
+		a = a_eol;
+		b = b_eol;
+	}
+	#undef SKIP_DTSTAMP
+	free(old);
+	return same;
+}
+
+
+/************************************************************
+* write a file through a temporary file; returns TRUE on
+* success
+************************************************************/
+static int replace_file( const char* path, const char* data, const size_t length )
+{
+	char* temporary;
+	FILE* file;
+	int written;
+
+	if (asprintf(&temporary, "%s.%d.tmp", path, (int) getpid()) < 0) return FALSE;
+	file = fopen(temporary, "w");
+	if (file == NULL)
+	{
+		error(0, errno, "%s", temporary);
+		free(temporary);
+		return FALSE;
+	}
+	written = (fwrite(data, 1, length, file) == length);
+	written = (fclose(file) == 0) && written;
+	if ( !written || (rename(temporary, path) != 0) )
+	{
+		error(0, errno, "%s", path);
+		unlink(temporary);
+		free(temporary);
+		return FALSE;
+	}
+	free(temporary);
+	return TRUE;
+}
+
+
+/************************************************************
+* export one calendar into a directory, a file per year
+*
+* returns an exit code
+************************************************************/
+static int export_calendar( const ical_calendar* calendar, const char* directory,
+							pthread_mutex_t* stdout_lock )
+{
+	const ical_options* options = calendar->options;
+	output_buffer* out;
+	FILE* memory;
+	char* data = NULL;
+	size_t length = 0;
+	char* path;
+	hdate_struct h;
+	int jd_first, jd_last, year, year_last, day, month;
+	int exit_code = 0;
+
+	if ( (mkdir(directory, 0777) != 0) && (errno != EEXIST) )
+	{
+		error(0, errno, "%s", directory);
+		return EXIT_FAILURE;
+	}
+	out = malloc(sizeof(output_buffer));
+	if (out == NULL) return EXIT_FAILURE;
+	hdate_jd_to_gdate(options->jd_first, &day, &month, &year);
+	hdate_jd_to_gdate(options->jd_last, &day, &month, &year_last);
+	for ( ; year <= year_last; year++)
+	{
+		hdate_set_gdate(&h, 1, 1, year);
+		jd_first = (h.hd_jd < options->jd_first) ? options->jd_first : h.hd_jd;
+		hdate_set_gdate(&h, 31, 12, year);
+		jd_last = (h.hd_jd > options->jd_last) ? options->jd_last : h.hd_jd;
+
+		memory = open_memstream(&data, &length);
+		if (memory == NULL) { exit_code = EXIT_FAILURE; break; }
+		output_init(out, memory);
+		output_calendar_header(out, calendar, jd_first, jd_last);
+		if (!output_events(out, calendar, jd_first, jd_last))
+			exit_code = EXIT_FAILURE;
+		output_literal(out, "END:VCALENDAR\r\n");
+		output_flush(out);
+		if ( (fclose(memory) != 0) || out->failed ) exit_code = EXIT_FAILURE;
+		if (exit_code != 0)
+		{
+			error(0, 0, "%s", N_("memory allocation failure"));
+			free(data);
+			break;
+		}
+
+		if (asprintf(&path, "%s/%04d.ics", directory, year) < 0)
+		{
+			free(data);
+			exit_code = EXIT_FAILURE;
+			break;
+		}
+		if (!same_calendar(data, length, path))
+		{
+			if (replace_file(path, data, length))
+			{
+				pthread_mutex_lock(stdout_lock);
+				output_text(&output_stdout, path);
+				output_char(&output_stdout, '\n');
+				pthread_mutex_unlock(stdout_lock);
+			}
+			else exit_code = EXIT_FAILURE;
+		}
+		free(path);
+		free(data);
+		data = NULL;
+	}
+	free(out);
+	return exit_code;
+}
+
+
+/************************************************************
+* a worker thread: export calendars until none are left
+************************************************************/
+static void* export_worker( void* arg )
+{
+	ical_queue* queue = arg;
+	ical_calendar calendar;
+	char* directory;
+	int i, exit_code;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&queue->lock);
+		i = queue->next++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->count) break;
+
+		calendar.dtstart_time = NULL;
+		if (queue->subscriber[i].name == NULL) directory = strdup(queue->directory);
+		else if (asprintf(&directory, "%s/%s", queue->directory,
+						  queue->subscriber[i].name) < 0)
+			directory = NULL;
+		if ( (directory == NULL) ||
+			 !open_calendar(queue->options, queue->templates,
+							&queue->subscriber[i], &calendar) )
+			exit_code = EXIT_FAILURE;
+		else exit_code = export_calendar(&calendar, directory, &queue->lock);
+		free(calendar.dtstart_time);
+		free(directory);
+
+		if (exit_code != 0)
+		{
+			pthread_mutex_lock(&queue->lock);
+			queue->exit_code = exit_code;
+			pthread_mutex_unlock(&queue->lock);
+		}
+	}
+	return NULL;
+}
+
+
+/************************************************************
+* stream one calendar, of the whole range, to stdout
+************************************************************/
+static int export_stdout( const ical_calendar* calendar )
+{
+	const ical_options* options = calendar->options;
+
+	output_calendar_header(&output_stdout, calendar, options->jd_first,
+						   options->jd_last);
+	if (!output_events(&output_stdout, calendar, options->jd_first,
+					   options->jd_last))
+	{
+		error(0, 0, "%s", N_("memory allocation failure"));
+		return EXIT_FAILURE;
+	}
+	output_literal(&output_stdout, "END:VCALENDAR\r\n");
+	return 0;
+}
+
+
+/************************************************************
+* export calendars; see ical_export.h
+************************************************************/
+int ical_export( const ical_options* options,
+				 const ical_subscriber* subscriber, const int count,
+				 const char* directory )
+{
+	ical_templates templates;
+	ical_calendar calendar;
+	ical_queue queue;
+	pthread_t* thread;
+	long threads, i, started = 0;
+	int exit_code;
+
+	if (count <= 0) return 0;
+	if (!make_templates(options, &templates))
+	{
+		error(0, 0, "%s", N_("memory allocation failure"));
+		free_templates(&templates);
+		return EXIT_FAILURE;
+	}
+
+	if (strcmp(directory, "-") == 0)
+	{
+		calendar.dtstart_time = NULL;
+		if (open_calendar(options, &templates, &subscriber[0], &calendar))
+			exit_code = export_stdout(&calendar);
+		else exit_code = EXIT_FAILURE;
+		free(calendar.dtstart_time);
+		free_templates(&templates);
+		return exit_code;
+	}
+
+	if ( (mkdir(directory, 0777) != 0) && (errno != EEXIST) )
+	{
+		error(0, errno, "%s", directory);
+		free_templates(&templates);
+		return EXIT_FAILURE;
+	}
+	queue.options = options;
+	queue.templates = &templates;
+	queue.subscriber = subscriber;
+	queue.count = count;
+	queue.next = 0;
+	queue.exit_code = 0;
+	queue.directory = directory;
+	pthread_mutex_init(&queue.lock, NULL);
+
+	threads = options->threads;
+	if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads <= 0) threads = 1;
+	if (threads > count) threads = count;
+	thread = malloc(threads * sizeof(pthread_t));
+	/// the calling thread is a worker too
+	for (i = 1; (thread != NULL) && (i < threads); i++)
+	{
+		if (pthread_create(&thread[started], NULL, export_worker, &queue) != 0) break;
+		started++;
+	}
+	export_worker(&queue);
+	for (i = 0; i < started; i++) pthread_join(thread[i], NULL);
+	free(thread);
+	pthread_mutex_destroy(&queue.lock);
+	free_templates(&templates);
+	return queue.exit_code;
+}
+
+
+/************************************************************
+* free a manifest of subscribers
+************************************************************/
+void free_ical_subscribers( ical_subscriber* subscriber, const int count )
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		free((char*) subscriber[i].name);
+		free((char*) subscriber[i].tz_name);
+	}
+	free(subscriber);
+}
+
+
+/************************************************************
+* read a manifest of subscribers; see ical_export.h
+************************************************************/
+int read_ical_subscribers( const char* path, ical_subscriber** subscriber,
+						   const int diaspora, const int quiet )
+{
+	FILE* manifest;
+	char* line = NULL;
+	size_t line_size = 0;
+	char* field[5];
+	char* save_ptr;
+	char* end_lat;
+	char* end_lon;
+	int count = 0, allocated = 0, line_number = 0;
+	int i, error_detected = FALSE;
+	ical_subscriber* new_subscriber;
+	ical_subscriber* s;
+
+	*subscriber = NULL;
+	manifest = fopen(path, "r");
+	if (manifest == NULL)
+	{
+		error(0, errno, "%s", path);
+		return -1;
+	}
+	while (getline(&line, &line_size, manifest) != -1)
+	{
+		line_number++;
+		field[0] = strtok_r(line, " \t\r\n", &save_ptr);
+		if ( (field[0] == NULL) || (field[0][0] == '#') ) continue;
+		for (i = 1; i < 5; i++) field[i] = strtok_r(NULL, " \t\r\n", &save_ptr);
+		if (field[3] == NULL)
+		{
+			error(0, 0, "%s:%d: %s", path, line_number,
+				  N_("expected name latitude longitude timezone"));
+			error_detected = TRUE;
+			continue;
+		}
+		if (count == allocated)
+		{
+			allocated = (allocated == 0) ? 16 : allocated * 2;
+			new_subscriber = realloc(*subscriber, allocated * sizeof(ical_subscriber));
+			if (new_subscriber == NULL)
+			{
+				error(0, errno, "%s", N_("memory allocation failure"));
+				error_detected = TRUE;
+				break;
+			}
+			*subscriber = new_subscriber;
+		}
+		s = &(*subscriber)[count++];
+		s->name = strdup(field[0]);
+		s->tz_name = (strcmp(field[3], "UTC") == 0) ? NULL : strdup(field[3]);
+		s->lat = strtod(field[1], &end_lat);
+		s->lon = strtod(field[2], &end_lon);
+		s->diaspora = diaspora;
+		if ( (*end_lat != '\0') || (*end_lon != '\0') ||
+			 (s->lat < -90) || (s->lat > 90) || (s->lon < -180) || (s->lon > 180) )
+		{
+			error(0, 0, "%s:%d: %s", path, line_number, N_("bad location"));
+			error_detected = TRUE;
+		}
+		/// the name is a directory of the export
+		if ( (strchr(field[0], '/') != NULL) || (strcmp(field[0], ".") == 0)
+			 || (strcmp(field[0], "..") == 0) )
+		{
+			error(0, 0, "%s:%d: %s", path, line_number, N_("bad name"));
+			error_detected = TRUE;
+		}
+		/// and two calendars in one directory would overwrite each other
+		for (i = 0; i < count - 1; i++)
+			if ( ((*subscriber)[i].name != NULL) &&
+				 (strcmp((*subscriber)[i].name, field[0]) == 0) )
+			{
+				error(0, 0, "%s:%d: %s: %s", path, line_number,
+					  N_("duplicate name"), field[0]);
+				error_detected = TRUE;
+				break;
+			}
+		if (field[4] == NULL) continue;
+		else if (strcmp(field[4], "diaspora") == 0) s->diaspora = TRUE;
+		else if (strcmp(field[4], "israel") == 0) s->diaspora = FALSE;
+		else
+		{
+			error(0, 0, "%s:%d: %s", path, line_number,
+				  N_("expected diaspora or israel"));
+			error_detected = TRUE;
+		}
+	}
+	free(line);
+	fclose(manifest);
+	if (error_detected)
+	{
+		free_ical_subscribers(*subscriber, count);
+		*subscriber = NULL;
+		return -1;
+	}
+	if ( (count == 0) && !quiet )
+		error(0, 0, "%s: %s", path, N_("no subscribers"));
+	return count;
+}
@@ -0,0 +1,66 @@
+/** ical_export.h            http://libhdate.sourceforge.net
+ * hdate --ical-export: write RFC 5545 calendars of holidays, parshiot,
+ * custom days and Shabbat times, one file per gregorian year, for one
+ * location or for a manifest of subscribers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// what is common to all the calendars of an export
+typedef struct
+{
+	int jd_first;				/// the range of days to export
+	int jd_last;
+	int hebrew;					/// give names in Hebrew
+	int short_format;
+	int holidays;				/// all-day events for holidays and custom days
+	int parasha;				/// all-day events for the weekly reading
+	int candles;				/// candle lighting, minutes before sunset; 0 for none
+	int havdalah;				/// havdalah, minutes after sunset; 0 for none
+	int threads;				/// worker threads; 0 for one per processor
+	int quiet;					/// suppress alerts
+	const custom_days_list* custom_days;	/// may be NULL
+} ical_options;
+
+/// one calendar: a location, and where its files go
+typedef struct
+{
+	const char* name;			/// a subdirectory of the export directory,
+								/// and a part of each UID; may be NULL
+	double lat;
+	double lon;
+	const char* tz_name;		/// the TZID of times, eg. Asia/Jerusalem;
+								/// NULL to give times in UTC
+	int diaspora;
+} ical_subscriber;
+
+/// write the calendars of count subscribers, one file per gregorian
+/// year into directory/name/, or into directory itself for a
+/// subscriber without a name, rewriting only the years whose events
+/// have changed; the path of each file written is printed to stdout.
+/// A directory "-" streams the whole range of the first subscriber
+/// to stdout as one calendar. Returns an exit code
+int ical_export( const ical_options* options,
+				 const ical_subscriber* subscriber, const int count,
+				 const char* directory );
+
+/// read a manifest of subscribers, a line for each of
+///   name latitude longitude timezone [diaspora|israel]
+/// ignoring blank lines and those beginning with '#'.
+/// Returns the number of subscribers, or -1 on error; *subscriber
+/// is to be freed by free_ical_subscribers
+int read_ical_subscribers( const char* path, ical_subscriber** subscriber,
+						   const int diaspora, const int quiet );
+
+void free_ical_subscribers( ical_subscriber* subscriber, const int count );
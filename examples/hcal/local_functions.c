@@ -44,6 +44,7 @@
 
 #include "local_functions.h"  // for macro definitions used by other programs
 #include "timezone_functions.h" // for get_lat_lon_from_zonetab_file, read_sys_tz_string_from_file
+#include "output_buffer.h"    // for output_stdout
 #include <zdump3.h>        // for zdump
 
 #define EXIT_CODE_BAD_PARMS  1
@@ -857,10 +858,11 @@ int validate_hdate (const int parameter_to_check,
 ************************************************************/
 void greetings_to_version_18()
 {
-  printf("%s\n",N_("\
+  output_printf(&output_stdout, "%s\n",N_("\
 This seems to be to be your first time using this version (1.8).\n\
 Please read the new documentation in the man page and config files.\n\
 Press <enter> to continue."));
+  output_flush_stdout();
   getchar();
 }
 
@@ -939,7 +941,7 @@ int get_config_file(  const char* config_dir_name,
     if ((mkdir(config_file_path, (mode_t) 0700) != 0) && (errno != EEXIST)) { free(config_file_path); return FALSE; };
     *last_slash_location = '/';
     greetings_to_version_18();
-    if (!quiet_alerts) printf("%s\n", N_("attempting to create a config file ..."));
+    if (!quiet_alerts) output_printf(&output_stdout, "%s\n", N_("attempting to create a config file ..."));
     *config_file = fopen(config_file_path, "a+");
     if ( (*config_file == NULL) ||
        ( fprintf(*config_file, "%s", default_config_file_text) < 0 ) )
@@ -948,7 +950,7 @@ int get_config_file(  const char* config_dir_name,
       if (!quiet_alerts) config_file_create_error(errno, config_file_path);
       { free(config_file_path); return FALSE; };
     }
-    if (!quiet_alerts) printf("%s: %s\n", N_("succeeded creating config file"), config_file_path);
+    if (!quiet_alerts) output_printf(&output_stdout, "%s: %s\n", N_("succeeded creating config file"), config_file_path);
     if ( fseek(*config_file, 0, SEEK_SET) != 0 ) { free(config_file_path); return FALSE; }
   }
   free(config_file_path);
@@ -1108,8 +1110,8 @@ int menu_select( char* menu_list[], int max_menu_items )
   for (i=0; i< max_menu_items; i++)
   {
     if (menu_list[i] == NULL) break;
-    if (i==0) printf("\n%s:\n\n", N_("your custom menu options (from your config file)"));
-    printf("     %d: %s\n",i,menu_list[i]);
+    if (i==0) output_printf(&output_stdout, "\n%s:\n\n", N_("your custom menu options (from your config file)"));
+    output_printf(&output_stdout, "     %d: %s\n",i,menu_list[i]);
   }
   j = i;
   if (i == 0)
@@ -1117,14 +1119,15 @@ int menu_select( char* menu_list[], int max_menu_items )
     error(0,0,N_("ALERT: -m (--menu) option specified, but no menu items in config file"));
     return -1;
   }
-  printf("\n%s: ",N_("enter your selection, or <return> to continue"));
+  output_printf(&output_stdout, "\n%s: ",N_("enter your selection, or <return> to continue"));
+  output_flush_stdout();
   i = getchar() - 48; // effectively converts valid values to integers
   if ((i < 0) || (i >= j))
   {
     error(0,0,N_("menu selection received was out of bounds"));
     return -1;
   }
-  printf("\n");
+  output_literal(&output_stdout, "\n");
   return i;
 }
 
@@ -0,0 +1,267 @@
+/** output_buffer.c            http://libhdate.sourceforge.net
+ * a reusable output buffer for hcal and hdate, written out in large
+ * blocks instead of by a printf per field
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>		/// For FILE, fwrite, vsnprintf
+#include <stdarg.h>		/// For va_list
+#include <string.h>		/// For memcpy, memchr, strlen
+#include <unistd.h>		/// For isatty
+#include "output_buffer.h"
+
+
+output_buffer output_stdout;
+
+
+/************************************************************
+* begin using an output buffer
+************************************************************/
+void output_init( output_buffer* out, FILE* stream )
+{
+	out->stream = stream;
+	out->length = 0;
+	out->failed = 0;
+	out->line_buffered = isatty(fileno(stream));
+	out->copy = NULL;
+}
+
+
+/************************************************************
+* write out what is buffered
+************************************************************/
+int output_flush( output_buffer* out )
+{
+	if ( (out->length != 0) &&
+		 (fwrite(out->data, 1, out->length, out->stream) != out->length) )
+		out->failed = -1;
+	if ( (out->length != 0) && (out->copy != NULL) &&
+		 (fwrite(out->data, 1, out->length, out->copy) != out->length) )
+		out->failed = -1;
+	out->length = 0;
+	return !out->failed;
+}
+
+
+/************************************************************
+* write out what is buffered for stdout
+************************************************************/
+void output_flush_stdout( void )
+{
+	output_flush(&output_stdout);
+	fflush(stdout);
+}
+
+
+/************************************************************
+* append bytes
+************************************************************/
+void output_bytes( output_buffer* out, const char* bytes, size_t length )
+{
+	if (out->length + length > OUTPUT_BUFFER_SIZE)
+	{
+		output_flush(out);
+		/// too large to be worth copying
+		if (length > OUTPUT_BUFFER_SIZE)
+		{
+			if (fwrite(bytes, 1, length, out->stream) != length) out->failed = -1;
+			if ( (out->copy != NULL) &&
+				 (fwrite(bytes, 1, length, out->copy) != length) )
+				out->failed = -1;
+			return;
+		}
+	}
+	memcpy(out->data + out->length, bytes, length);
+	out->length += length;
+	if ( out->line_buffered && (memchr(bytes, '\n', length) != NULL) )
+		output_flush(out);
+}
+
+
+/************************************************************
+* append a null-terminated string
+************************************************************/
+void output_text( output_buffer* out, const char* text )
+{
+	output_bytes(out, text, strlen(text));
+}
+
+
+/************************************************************
+* append a character
+************************************************************/
+void output_char( output_buffer* out, const char c )
+{
+	if (out->length == OUTPUT_BUFFER_SIZE) output_flush(out);
+	out->data[out->length++] = c;
+	if ( out->line_buffered && (c == '\n') ) output_flush(out);
+}
+
+
+/************************************************************
+* append formatted text
+************************************************************/
+void output_printf( output_buffer* out, const char* format, ... )
+{
+	va_list ap, ap_copy;
+	int length;
+	char* text;
+
+	va_start(ap, format);
+	length = vsnprintf(out->data + out->length,
+					   OUTPUT_BUFFER_SIZE - out->length, format, ap);
+	va_end(ap);
+	if (length < 0) return;
+	if (out->length + length < OUTPUT_BUFFER_SIZE)
+	{
+		text = out->data + out->length;
+		out->length += length;
+		if ( out->line_buffered && (memchr(text, '\n', length) != NULL) )
+			output_flush(out);
+		return;
+	}
+	/// it did not fit; make room, and format it again
+	output_flush(out);
+	va_start(ap, format);
+	if (length < OUTPUT_BUFFER_SIZE)
+	{
+		vsnprintf(out->data, OUTPUT_BUFFER_SIZE, format, ap);
+		out->length = length;
+		if (out->line_buffered && (memchr(out->data, '\n', length) != NULL) )
+			output_flush(out);
+	}
+	else
+	{
+		va_copy(ap_copy, ap);
+		if (vfprintf(out->stream, format, ap) < 0) out->failed = -1;
+		if ( (out->copy != NULL) && (vfprintf(out->copy, format, ap_copy) < 0) )
+			out->failed = -1;
+		va_end(ap_copy);
+	}
+	va_end(ap);
+}
+
+
+/************************************************************
+* append a decimal integer
+************************************************************/
+void output_int( output_buffer* out, long value )
+{
+	char digits[24];
+	char* start = digits + sizeof(digits);
+	unsigned long magnitude;
+
+	magnitude = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+	do
+	{
+		*--start = '0' + (magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+	if (value < 0) *--start = '-';
+	output_bytes(out, start, digits + sizeof(digits) - start);
+}
+
+
+/************************************************************
+* append a padded decimal integer
+************************************************************/
+void output_int_width( output_buffer* out, long value, const int width,
+					   const char pad )
+{
+	char digits[24];
+	char* start = digits + sizeof(digits);
+	unsigned long magnitude;
+	int length;
+
+	magnitude = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+	do
+	{
+		*--start = '0' + (magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+	length = digits + sizeof(digits) - start + (value < 0);
+	/// as printf, a '0' pad goes after the sign, a ' ' pad before it
+	if ( (value < 0) && (pad == '0') ) output_char(out, '-');
+	for ( ; length < width; length++) output_char(out, pad);
+	if ( (value < 0) && (pad != '0') ) output_char(out, '-');
+	output_bytes(out, start, digits + sizeof(digits) - start);
+}
+
+
+/************************************************************
+* append a time of day
+************************************************************/
+void output_hhmm( output_buffer* out, const long minutes )
+{
+	char text[5];
+
+	text[0] = '0' + ((minutes / 60) % 24) / 10;
+	text[1] = '0' + ((minutes / 60) % 24) % 10;
+	text[2] = ':';
+	text[3] = '0' + (minutes % 60) / 10;
+	text[4] = '0' + (minutes % 60) % 10;
+	output_bytes(out, text, 5);
+}
+
+
+/************************************************************
+* append a JSON string
+************************************************************/
+void output_json_text( output_buffer* out, const char* text )
+{
+	static const char hex[] = "0123456789abcdef";
+	const unsigned char* c;
+	const unsigned char* plain;
+
+	if (text == NULL)
+	{
+		output_bytes(out, "null", 4);
+		return;
+	}
+	output_char(out, '"');
+	/// copy runs of characters that need no escape in one piece
+	plain = (const unsigned char*) text;
+	for (c = plain; *c; c++)
+	{
+		if ( (*c != '"') && (*c != '\\') && (*c >= 0x20) ) continue;
+		output_bytes(out, (const char*) plain, c - plain);
+		output_char(out, '\\');
+		if (*c >= 0x20) output_char(out, *c);
+		else
+		{
+			output_bytes(out, "u00", 3);
+			output_char(out, hex[*c >> 4]);
+			output_char(out, hex[*c & 0xf]);
+		}
+		plain = c + 1;
+	}
+	output_bytes(out, (const char*) plain, c - plain);
+	output_char(out, '"');
+}
+
+
+/************************************************************
+* append a 32 bit little-endian integer
+************************************************************/
+void output_int32_le( output_buffer* out, const long value )
+{
+	char bytes[4];
+
+	bytes[0] = value & 0xff;
+	bytes[1] = (value >> 8) & 0xff;
+	bytes[2] = (value >> 16) & 0xff;
+	bytes[3] = (value >> 24) & 0xff;
+	output_bytes(out, bytes, 4);
+}
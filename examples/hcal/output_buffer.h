@@ -0,0 +1,80 @@
+/** output_buffer.h            http://libhdate.sourceforge.net
+ * a reusable output buffer for hcal and hdate, written out in large
+ * blocks instead of by a printf per field
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define OUTPUT_BUFFER_SIZE 65536
+
+typedef struct
+{
+	FILE* stream;		/// where a flush writes to
+	size_t length;		/// bytes waiting to be written
+	int failed;			/// non-zero once a write has failed
+	int line_buffered;	/// flush at each newline, as stdio does for
+						/// a terminal
+	FILE* copy;			/// if not NULL, also receives all that is
+						/// written, as for output_cache
+	char data[OUTPUT_BUFFER_SIZE];
+} output_buffer;
+
+/// stdout, for all the printing of hcal and hdate; anything else
+/// written to stdout must follow output_flush(&output_stdout)
+extern output_buffer output_stdout;
+
+/// begin using a buffer, or begin again after the stream has been
+/// redirected
+void output_init( output_buffer* out, FILE* stream );
+
+/// write out what is buffered; returns non-zero on success, ie.
+/// if no write to the stream has failed
+int output_flush( output_buffer* out );
+
+/// output_flush(&output_stdout), for atexit
+void output_flush_stdout( void );
+
+void output_bytes( output_buffer* out, const char* bytes, size_t length );
+
+void output_text( output_buffer* out, const char* text );
+
+/// a string literal, its length known at compile time
+#define output_literal(out, literal) \
+	output_bytes((out), (literal), sizeof(literal) - 1)
+
+void output_char( output_buffer* out, const char c );
+
+/// formatted text, as printf
+void output_printf( output_buffer* out, const char* format, ... )
+#ifdef __GNUC__
+	__attribute__ ((format (printf, 2, 3)))
+#endif
+	;
+
+/// a decimal integer, without locale formatting
+void output_int( output_buffer* out, long value );
+
+/// a decimal integer, padded on the left with pad to at least width
+/// characters, as printf "%2d" (pad ' ') or "%02d" (pad '0')
+void output_int_width( output_buffer* out, long value, const int width,
+					   const char pad );
+
+/// a time of day, hh:mm, as printf "%02d:%02d", from minutes
+void output_hhmm( output_buffer* out, const long minutes );
+
+/// a JSON string, quoted and escaped; NULL gives null
+void output_json_text( output_buffer* out, const char* text );
+
+/// a 32 bit integer, little-endian
+void output_int32_le( output_buffer* out, const long value );
@@ -0,0 +1,355 @@
+/** output_cache.c            http://libhdate.sourceforge.net
+ * a directory of rendered output for hcal and hdate, each file named
+ * by a hash of everything its rendering depended on
+ *
+ * A key hashes the inputs of an output - the command line, the config
+ * file, the location, the custom days, the time zone data, the version
+ * and the locale - so that an output found under its key can be copied
+ * instead of being computed again, and a change to any input is a
+ * different key. Nothing is ever invalidated in place; stale outputs
+ * are merely never asked for again, and the directory may be emptied
+ * at any time.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <support.h>	/// libhdate general macros
+#include <stdlib.h>		/// For getenv, atexit
+#include <stdio.h>		/// For FILE, snprintf, rename
+#include <string.h>		/// For strcmp, strncmp
+#include <locale.h>		/// For setlocale
+#include <error.h>		/// For error
+#include <errno.h>		/// For errno
+#include <unistd.h>		/// For getpid, unlink
+#include <sys/stat.h>	/// For mkdir
+#include "output_buffer.h"
+#include "output_cache.h"
+
+/// change this whenever a change to hcal or hdate changes their
+/// output, for a build that does not define PACKAGE_VERSION
+#define CACHE_FORMAT 1
+#ifndef PACKAGE_VERSION
+#define PACKAGE_VERSION "unknown"
+#endif
+
+#define FNV_PRIME 1099511628211ULL
+#define DEFAULT_TZDIR "/usr/share/zoneinfo"
+
+/// the recording of cache_record
+static char* recording_path = NULL;
+static char* recording_temporary = NULL;
+
+
+/************************************************************
+* begin a key
+************************************************************/
+void cache_key_init( cache_key* key )
+{
+	key->hash[0] = 14695981039346656037ULL;
+	key->hash[1] = 0x84222325cbf29ce4ULL;
+}
+
+
+/************************************************************
+* add bytes to a key; the two hashes are FNV-1a and FNV-1
+************************************************************/
+void cache_key_add( cache_key* key, const void* data, const size_t length )
+{
+	const unsigned char* c = data;
+	const unsigned char* end = c + length;
+
+	for ( ; c < end; c++)
+	{
+		key->hash[0] = (key->hash[0] ^ *c) * FNV_PRIME;
+		key->hash[1] = (key->hash[1] * FNV_PRIME) ^ *c;
+	}
+}
+
+
+void cache_key_add_text( cache_key* key, const char* text )
+{
+	/// 0xff does not occur in UTF-8
+	if (text == NULL) cache_key_add(key, "\xff", 2);
+	else cache_key_add(key, text, strlen(text) + 1);
+}
+
+
+void cache_key_add_int( cache_key* key, const long value )
+{
+	char text[24];
+	snprintf(text, sizeof(text), "%ld", value);
+	cache_key_add_text(key, text);
+}
+
+
+void cache_key_add_double( cache_key* key, const double value )
+{
+	char text[32];
+	snprintf(text, sizeof(text), "%.9g", value);
+	cache_key_add_text(key, text);
+}
+
+
+/************************************************************
+* add the contents of a file to a key
+************************************************************/
+void cache_key_add_file( cache_key* key, const char* path )
+{
+	FILE* file;
+	char buffer[BUFSIZ];
+	size_t bytes;
+	long total = 0;
+
+	file = (path != NULL) ? fopen(path, "r") : NULL;
+	if (file == NULL)
+	{
+		cache_key_add(key, "\xfe", 2);
+		return;
+	}
+	while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		cache_key_add(key, buffer, bytes);
+		total += bytes;
+	}
+	fclose(file);
+	cache_key_add_int(key, total);
+}
+
+
+/************************************************************
+* add a command line to a key
+************************************************************/
+void cache_key_add_args( cache_key* key, const int argc, char* argv[] )
+{
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--cache") == 0) { i++; continue; }
+		if (strncmp(argv[i], "--cache=", 8) == 0) continue;
+		/// hcal's output is the same with any number of --jobs
+		if ( (strcmp(argv[i], "--jobs") == 0) ||
+			 (strncmp(argv[i], "--jobs=", 7) == 0) ) continue;
+		cache_key_add_text(key, argv[i]);
+	}
+	cache_key_add_text(key, NULL);
+}
+
+
+/************************************************************
+* add what every output depends on to a key
+************************************************************/
+void cache_key_add_environment( cache_key* key, const char* tz_name )
+{
+	const char* tzdir;
+	char* path;
+	char version[64];
+	FILE* file;
+
+	cache_key_add_text(key, PACKAGE_VERSION);
+	cache_key_add_int(key, CACHE_FORMAT);
+	cache_key_add_text(key, setlocale(LC_ALL, NULL));
+	cache_key_add_text(key, getenv("TZ"));
+
+	/// the version of the time zone data, if it says, and the
+	/// zone itself, in case it does not
+	tzdir = getenv("TZDIR");
+	if (tzdir == NULL) tzdir = DEFAULT_TZDIR;
+	version[0] = '\0';
+	if (asprintf(&path, "%s/tzdata.zi", tzdir) >= 0)
+	{
+		file = fopen(path, "r");
+		if (file != NULL)
+		{
+			if (fgets(version, sizeof(version), file) == NULL) version[0] = '\0';
+			fclose(file);
+		}
+		free(path);
+	}
+	cache_key_add_text(key, version);
+	if (tz_name == NULL) cache_key_add_file(key, "/etc/localtime");
+	else if (asprintf(&path, "%s/%s", tzdir, tz_name) >= 0)
+	{
+		cache_key_add_file(key, path);
+		free(path);
+	}
+}
+
+
+/************************************************************
+* the path of the output for a key, malloc'ed; NULL on failure
+************************************************************/
+static char* cache_path( const char* directory, const cache_key* key )
+{
+	char* path;
+
+	if (asprintf(&path, "%s/%016llx%016llx", directory,
+				 key->hash[0], key->hash[1]) < 0)
+		return NULL;
+	return path;
+}
+
+
+/************************************************************
+* open an output
+************************************************************/
+FILE* cache_open( const char* directory, const cache_key* key )
+{
+	FILE* file;
+	char* path;
+
+	path = cache_path(directory, key);
+	if (path == NULL) return NULL;
+	file = fopen(path, "r");
+	free(path);
+	return file;
+}
+
+
+/************************************************************
+* fetch an output
+************************************************************/
+int cache_fetch( const char* directory, const cache_key* key,
+				 output_buffer* out )
+{
+	FILE* file;
+	char buffer[BUFSIZ];
+	size_t bytes;
+	int found;
+
+	file = cache_open(directory, key);
+	if (file == NULL) return FALSE;
+	while ((bytes = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		output_bytes(out, buffer, bytes);
+	found = !ferror(file);
+	fclose(file);
+	return found;
+}
+
+
+/************************************************************
+* create the cache directory, if it is not there yet
+************************************************************/
+static int make_cache_directory( const char* directory )
+{
+	if ( (mkdir(directory, 0777) != 0) && (errno != EEXIST) )
+	{
+		error(0, errno, "%s", directory);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+/************************************************************
+* store an output
+************************************************************/
+int cache_store( const char* directory, const cache_key* key, FILE* data )
+{
+	char* path;
+	char* temporary;
+	FILE* file;
+	char buffer[BUFSIZ];
+	size_t bytes;
+	int stored = TRUE;
+
+	if (!make_cache_directory(directory)) return FALSE;
+	path = cache_path(directory, key);
+	if (path == NULL) return FALSE;
+	if (asprintf(&temporary, "%s.%d.tmp", path, (int) getpid()) < 0)
+	{
+		free(path);
+		return FALSE;
+	}
+	file = fopen(temporary, "w");
+	if (file == NULL) stored = FALSE;
+	else
+	{
+		rewind(data);
+		while ((bytes = fread(buffer, 1, sizeof(buffer), data)) > 0)
+			if (fwrite(buffer, 1, bytes, file) != bytes) stored = FALSE;
+		if (ferror(data)) stored = FALSE;
+		stored = (fclose(file) == 0) && stored;
+		stored = stored && (rename(temporary, path) == 0);
+		if (!stored) unlink(temporary);
+	}
+	free(temporary);
+	free(path);
+	return stored;
+}
+
+
+/************************************************************
+* discard an unfinished recording, at exit
+************************************************************/
+static void discard_recording( void )
+{
+	if (recording_temporary != NULL) unlink(recording_temporary);
+}
+
+
+/************************************************************
+* begin recording an output
+************************************************************/
+int cache_record( const char* directory, const cache_key* key,
+				  output_buffer* out )
+{
+	static int registered = FALSE;
+
+	if ( (recording_path != NULL) || !make_cache_directory(directory) )
+		return FALSE;
+	recording_path = cache_path(directory, key);
+	if (recording_path == NULL) return FALSE;
+	if (asprintf(&recording_temporary, "%s.%d.tmp", recording_path,
+				 (int) getpid()) < 0)
+	{
+		free(recording_path);
+		recording_path = NULL;
+		return FALSE;
+	}
+	output_flush(out);
+	out->copy = fopen(recording_temporary, "w");
+	if (out->copy == NULL)
+	{
+		free(recording_path);
+		free(recording_temporary);
+		recording_path = NULL;
+		recording_temporary = NULL;
+		return FALSE;
+	}
+	if (!registered) registered = (atexit(discard_recording) == 0);
+	return TRUE;
+}
+
+
+/************************************************************
+* end recording an output
+************************************************************/
+int cache_record_end( output_buffer* out, const int keep )
+{
+	int stored;
+
+	if (out->copy == NULL) return FALSE;
+	output_flush(out);
+	stored = keep && !out->failed;
+	stored = (fclose(out->copy) == 0) && stored;
+	out->copy = NULL;
+	stored = stored && (rename(recording_temporary, recording_path) == 0);
+	if (!stored) unlink(recording_temporary);
+	free(recording_path);
+	free(recording_temporary);
+	recording_path = NULL;
+	recording_temporary = NULL;
+	return stored;
+}
@@ -0,0 +1,71 @@
+/** output_cache.h            http://libhdate.sourceforge.net
+ * a directory of rendered output for hcal and hdate, each file named
+ * by a hash of everything its rendering depended on
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// the hash of the inputs of an output; two independent 64 bit FNV-1a
+/// hashes, so that a collision is not a practical concern
+typedef struct
+{
+	unsigned long long hash[2];
+} cache_key;
+
+void cache_key_init( cache_key* key );
+
+void cache_key_add( cache_key* key, const void* data, const size_t length );
+
+/// a string; NULL hashes differently than ""
+void cache_key_add_text( cache_key* key, const char* text );
+
+void cache_key_add_int( cache_key* key, const long value );
+
+void cache_key_add_double( cache_key* key, const double value );
+
+/// the contents of a file; a missing file hashes differently than an
+/// empty one
+void cache_key_add_file( cache_key* key, const char* path );
+
+/// the command line, without the options that do not change the
+/// output: --cache and its argument, and --jobs[=n]
+void cache_key_add_args( cache_key* key, const int argc, char* argv[] );
+
+/// what every output depends on: the program and library version,
+/// the locale and TZ, and the time zone data of tz_name (the system
+/// time zone if NULL)
+void cache_key_add_environment( cache_key* key, const char* tz_name );
+
+/// the output for key in directory, opened for reading; NULL if there
+/// is none
+FILE* cache_open( const char* directory, const cache_key* key );
+
+/// if directory holds an output for key, append it to out and return
+/// non-zero
+int cache_fetch( const char* directory, const cache_key* key,
+				 output_buffer* out );
+
+/// store the whole of a file as the output for key, replacing any
+/// prior one atomically; returns non-zero on success
+int cache_store( const char* directory, const cache_key* key, FILE* data );
+
+/// begin recording everything written to out, to be stored as the
+/// output for key by cache_record_end; one recording at a time
+int cache_record( const char* directory, const cache_key* key,
+				  output_buffer* out );
+
+/// flush out and, if keep is non-zero and nothing has failed, store
+/// what was recorded; otherwise discard it. Returns non-zero if it
+/// was stored
+int cache_record_end( output_buffer* out, const int keep );
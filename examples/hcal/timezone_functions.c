@@ -33,6 +33,7 @@
 #include <sys/stat.h>	/// for stat
 #include <locale.h>		/// for setlocale
 #include <zdump3.h>		/// for struct zdumpinfo
+#include <hdate.h>		/// for hdate_zone_tab_search
 #include "timezone_functions.h"
 
 #define TZIF1_FIELD_SIZE 4
@@ -739,152 +740,63 @@ char* read_sys_tz_string_from_file()
 *   	what is at the location nn above.
 * cc	is an extended description of the timezone location.
 *
+* The library reads and indexes the file once, upon first use;
+* see hdate_zone_tab_search().
+*
 * returns FALSE upon any failure.
 *
 ***********************************************************************/
 int get_lat_lon_from_zonetab_file( const char* input_string, char** tz_name, double *lat, double *lon, int quiet_alerts )
 {
+	const hdate_zone_tab_entry* entry;
+	const char* search_string;
+	size_t search_len;
 
-	double convert_from_dms( long in_val, int num_of_digits )
-	{
-		/// sanity check performed by caller, so we know
-		/// that the number is four or six digits for latitude
-    /// and four, five, six or seven digits for longitude
-    long val = labs(in_val);
-    int sign = (in_val > 0) ? 1 : -1;
-		switch (num_of_digits)
-		{
-			case 4:
-			case 5: return (sign * (val/100 + (double)(val%100)/60) );
-			case 6:
-			case 7: return (sign * (val/10000 + (double)((val/100)%100)/60 + (double)(val%100)/3600));
-      default: return BAD_COORDINATE;
-		}
-	}
-
-	char*	tzdir_path;
-	char*	zonetab_path;
-	const char*	default_zonetab_path = "/usr/share/zoneinfo/zone.tab";
-
-	FILE*	tzfile;
-	char*	lat_and_lon = NULL;
-	char*	zonetab_string = NULL;
-	size_t	zonetab_str_len;
-	int		end_of_zonetab_file = FALSE;
-	int		match_count = 0;
-	char*	search_string;
-	char*	search_result_ptr = NULL;
-	char	number_string[9];
-	size_t	lat_end, lon_end;
-
-
-	/** In Debian, the TZDIR environmental variable is unset
-	 ** and the default is used, but the POSIX spec allows for
-	 ** a flexible location ofTZDIR. */
-	setlocale(LC_TIME,"");
-	tzdir_path = getenv("TZDIR");
-	if ((tzdir_path == NULL) ||
-		(asprintf( &zonetab_path, "%s/zone,tab", tzdir_path) == -1) )
-		tzfile = fopen(default_zonetab_path, "rb");
-	else
-	{
-		tzfile = fopen(zonetab_path, "rb");
-		free(zonetab_path);
-	}
-	if (tzfile == NULL)	return FALSE;
-
-	/// trim spaces. replace embedded spaces with underscores.
-	search_result_ptr = (char*) input_string + strspn(input_string," ");
-	match_count = strlen(search_result_ptr);
-	if (!match_count)
+	search_string = input_string + strspn(input_string," ");
+	search_len = strlen(search_string);
+	while ( (search_len) && (search_string[search_len - 1] == ' ') )
+		search_len--;
+	if (!search_len)
 	{
 		error(0,0,"time zone string is all blanks");
 		return FALSE;
 	}
-	while ( (match_count) && ( search_result_ptr[match_count] == ' ' ) )
-		match_count --;
-	search_string = malloc( match_count + 1 );
-	memcpy( search_string, search_result_ptr, match_count);
-	search_string[match_count] = '\0';
-	while ( (search_result_ptr=strchr(search_string,' '))!=NULL )
-		*search_result_ptr = '_';
-	search_result_ptr = NULL;
-
-	while ( (end_of_zonetab_file!=TRUE) && (search_result_ptr == NULL) )
-	{
-		end_of_zonetab_file = getline(&zonetab_string, &zonetab_str_len, tzfile);
-		if ( end_of_zonetab_file!=TRUE )
-		{
-			// TODO - need to free tz_name when not the zone we're looking for!
-			match_count = sscanf(zonetab_string,"%*2c %m[+0-9-] %ms %*[^\n]", &lat_and_lon, tz_name);
-			if (match_count == 2)
-			{
-				search_result_ptr = strcasestr(*tz_name, search_string);
-				if (search_result_ptr != NULL)
-				{
-					lat_end = strcspn( &lat_and_lon[1], "+-");
-					if (! ((lat_end == 4) || (lat_end == 6) ))
-					{
-						if (!quiet_alerts) printf("error parsing latitude from zone.tab file\n");
-						*lat = BAD_COORDINATE;
-						*lon = BAD_COORDINATE;
-					}
-					else
-					{
-						memcpy(&number_string, lat_and_lon, lat_end+1);
-						number_string[lat_end+1] = '\0';
-						*lat = convert_from_dms ( atol(number_string), lat_end);
-						lon_end = strlen( &lat_and_lon[lat_end+2]);
-						if (! ((lon_end == 5) || (lon_end == 7) ))
-						{
-							if (!quiet_alerts) printf("error parsing longitude from zone.tab file. lon_end = %ld\n", lon_end);
-							*lat = BAD_COORDINATE;
-							*lon = BAD_COORDINATE;
-						}
-						else
-						{
-							memcpy(&number_string, &lat_and_lon[lat_end+1], lon_end+1);
-							number_string[lon_end+1] = '\0';
-							*lon = convert_from_dms ( atol(number_string), lon_end);
-//							if (!quiet_alerts) print_alert_coordinate_pair(search_string);
-							if ( (!quiet_alerts) && (strlen(*tz_name) != strlen(search_string)) )
-								error(0,0,"%s \"%s\" %s \"%s\"", N_("ALERT: interpreting timezone entered"), input_string, N_("as"), *tz_name);
-						}
-					}
-				}
-			}
-			if (lat_and_lon != NULL)
-			{
-				free(lat_and_lon);
-				lat_and_lon = NULL;
-			}
-		}
-	}
-	fclose(tzfile);
-	free(search_string);
-	free(zonetab_string);
-	if (search_result_ptr != NULL) return TRUE;
-	return FALSE;
+	entry = hdate_zone_tab_search(search_string);
+	if (entry == NULL) return FALSE;
+	*tz_name = strdup(entry->name);
+	*lat = entry->latitude;
+	*lon = entry->longitude;
+	if ( (!quiet_alerts) && (strlen(*tz_name) != search_len) )
+		error(0,0,"%s \"%s\" %s \"%s\"", N_("ALERT: interpreting timezone entered"), input_string, N_("as"), *tz_name);
+	return TRUE;
 }
 
 
 /// get tz adjustment (with daylight savings time awareness)
+///    t may be anywhere in the interval dumped into tzif_data, in
+///    any order; *tzif_index is set to the entry in effect at t.
 int get_tz_adjustment(	const time_t t, const int tz, int *tzif_index,
 						const int tzif_entries, const void *tzif_data )
 {
 	int tz_adjustment = JERUSALEM_STANDARD_TIME_IN_MINUTES;
 	zdumpinfo * zd;
+	int low, high, mid;
 	if (tz != BAD_TIMEZONE) tz_adjustment = tz;
 	else if ( (tzif_entries == 0) || (tzif_data == NULL) )
 		error(0,0,"run time error: function get_tz_adjustment, reverting to Jerusalem Standard time");
 	else
 	{
 		zd = (void*) tzif_data;
-		if (   (*tzif_index < (tzif_entries - 1) )
-			&& (zd[*tzif_index + 1].start < t ) )
+		/// the last entry starting before t; entry 0 if none
+		low = 0;
+		high = tzif_entries - 1;
+		while (low < high)
 		{
-			*tzif_index = *tzif_index + 1;
+			mid = high - (high - low) / 2;
+			if (zd[mid].start < t) low = mid;
+			else high = mid - 1;
 		}
+		*tzif_index = low;
 		tz_adjustment = (zd[*tzif_index].utc_offset) / 60 ;
 	}
 	return tz_adjustment;
@@ -27,6 +27,9 @@
 #ifndef __HDATE_H__
 #define __HDATE_H__
 
+#include <stddef.h>  /// for size_t
+#include <time.h>    /// for time_t
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -741,6 +744,36 @@ hdate_is_hebrew_locale();
 */
 char* hdate_string( int type_of_string, int index, int short_form, int hebrew_form);
 
+/**
+ @brief   Return an interned name, and its length
+ @return  a pointer to a static string, or NULL if the type or index
+          is out of range. The string is resolved (translated) only
+          once, and the pointer remains valid for the life of the
+          process, even across hdate_string_table_reset().
+ @param type_of_string 	1 = day of week, 2 = parshaot, 3 = hmonth,
+						4 = gmonth, 5 = holiday (see hdate_string)
+ @param index        as for hdate_string
+ @param short_form   0 = long format
+ @param hebrew_form  0 = not hebrew (native/embedded)
+ @param len          if not NULL, receives the length of the string,
+                     in bytes, excluding the terminating null
+*/
+const char* hdate_string_ref( int type_of_string, int index, int short_form,
+						int hebrew_form, size_t* len);
+
+/**
+ @brief   resolve all name translations into the interned string table
+          now, instead of upon first use
+ @return  0 on success, -1 on memory allocation failure
+*/
+int hdate_string_table_init();
+
+/**
+ @brief   discard the interned string table, so that the next lookup
+          re-resolves all names (eg. after a change of locale)
+*/
+void hdate_string_table_reset();
+
 /** @def HDATE_STRING_INT
   @brief for function hdate_string: identifies string type: integer
 */
@@ -809,12 +842,942 @@ char* hdate_string( int type_of_string, int index, int short_form, int hebrew_fo
 */
 int hdate_parse_month_text_string( const char* month_text );
 
+/** @def HDATE_CALENDAR_GREGORIAN
+  @brief for function hdate_match_month_name: month is gregorian
+*/
+#define HDATE_CALENDAR_GREGORIAN 1
+
+/** @def HDATE_CALENDAR_HEBREW
+  @brief for function hdate_match_month_name: month is Hebrew
+*/
+#define HDATE_CALENDAR_HEBREW    2
+
+/** @def HDATE_MONTH_MATCH_PREFIX
+  @brief for function hdate_match_month_name: also accept an
+         unambiguous prefix of a month name
+*/
+#define HDATE_MONTH_MATCH_PREFIX 1
+
+/**
+ @brief   match a month name, in any spelling accepted by
+          hdate_parse_month_text_string, using a trie compiled once,
+          for the LC_TIME locale of the environment, without changing
+          the locale of the process. Matching is case-insensitive for latin
+          characters, and byte-exact for Hebrew (UTF-8).
+
+ @return  month number (1 - 12 gregorian, 1 - 14 Hebrew), or 0 if
+          there is no match, or if a prefix is ambiguous
+ @param text      the month name; need not be null terminated
+ @param len       the number of bytes of text to match
+ @param flags     0, or HDATE_MONTH_MATCH_PREFIX
+ @param calendar  if not NULL, receives HDATE_CALENDAR_GREGORIAN or
+                  HDATE_CALENDAR_HEBREW, or 0 if there is no match
+*/
+int hdate_match_month_name( const char* text, size_t len, int flags, int* calendar );
+
 
 int hdate_parse_date( const char* parm_a, const char* parm_b, const char* parm_c,
 					 int* ret_year, int* ret_month, int* ret_day, const int parm_cnt,
 					 const int prefer_hebrew, const int prefer_2_parm_ym,
 					 const int base_year_h, const int base_year_g );
 
+/** @def HDATE_PARSE_SUCCESS
+  @brief for function hdate_parse_date_r: parameters parsed
+*/
+#define HDATE_PARSE_SUCCESS              0
+/** @def HDATE_PARSE_ERR_YEAR
+  @brief for function hdate_parse_date_r: year is non-numeric or out of bounds
+*/
+#define HDATE_PARSE_ERR_YEAR             1
+/** @def HDATE_PARSE_ERR_MONTH
+  @brief for function hdate_parse_date_r: month is unrecognized or out of bounds
+*/
+#define HDATE_PARSE_ERR_MONTH            2
+/** @def HDATE_PARSE_ERR_DAY
+  @brief for function hdate_parse_date_r: day is out of bounds
+*/
+#define HDATE_PARSE_ERR_DAY              3
+/** @def HDATE_PARSE_ERR_MISMATCH
+  @brief for function hdate_parse_date_r: Hebrew/gregorian month and year mix
+*/
+#define HDATE_PARSE_ERR_MISMATCH         4
+/** @def HDATE_PARSE_ERR_MULTIPLE_MONTHS
+  @brief for function hdate_parse_date_r: more than one month name
+*/
+#define HDATE_PARSE_ERR_MULTIPLE_MONTHS  5
+/** @def HDATE_PARSE_ERR_MULTIPLE_YEARS
+  @brief for function hdate_parse_date_r: more than one four-digit year
+*/
+#define HDATE_PARSE_ERR_MULTIPLE_YEARS   6
+/** @def HDATE_PARSE_ERR_PARM_COUNT
+  @brief for function hdate_parse_date_r: parm_cnt is not 1 - 3
+*/
+#define HDATE_PARSE_ERR_PARM_COUNT       7
+/** @def HDATE_PARSE_ERR_UNEXPECTED
+  @brief for function hdate_parse_date_r: internal inconsistency
+*/
+#define HDATE_PARSE_ERR_UNEXPECTED       8
+/** @def HDATE_PARSE_ERR_UNSUPPORTED
+  @brief for function hdate_parse_date_r: three numeric gregorian
+         parameters, which are not yet supported
+*/
+#define HDATE_PARSE_ERR_UNSUPPORTED      9
+/** @def HDATE_PARSE_ERR_INCOMPLETE
+  @brief for function hdate_parse_date_bulk: row lacks a day or a month
+*/
+#define HDATE_PARSE_ERR_INCOMPLETE      10
+/** @def HDATE_PARSE_ERR_ROW_LENGTH
+  @brief for function hdate_parse_date_bulk: row exceeds HDATE_PARSE_BULK_ROW_MAX
+*/
+#define HDATE_PARSE_ERR_ROW_LENGTH      11
+/** @def HDATE_PARSE_ERR_FORMAT
+  @brief for the hdate_parse_iso_ functions: text is not YYYY-MM-DD
+*/
+#define HDATE_PARSE_ERR_FORMAT          12
+
+/** @def HDATE_PARSE_BULK_ROW_MAX
+  @brief for function hdate_parse_date_bulk: longest row accepted, in bytes
+*/
+#define HDATE_PARSE_BULK_ROW_MAX       128
+
+/** @def HDATE_PARSE_MAX_CANDIDATES
+  @brief for function hdate_parse_date_r: size of the candidate array
+*/
+#define HDATE_PARSE_MAX_CANDIDATES       3
+
+/** @struct hdate_parse_candidate
+  @brief one reading of the parameters passed to hdate_parse_date_r
+*/
+typedef struct
+{
+	/** year */
+	int year;
+	/** month: 1 - 12 gregorian, 101 - 114 Hebrew, 0 if none was given */
+	int month;
+	/** day of month, or 0 if none was given */
+	int day;
+} hdate_parse_candidate;
+
+/** @struct hdate_parse_result
+  @brief result of function hdate_parse_date_r
+*/
+typedef struct
+{
+	/** HDATE_PARSE_SUCCESS or one of the HDATE_PARSE_ERR_ values */
+	int error;
+	/** the parameter (1 - 3, ie. a - c) causing the error; 0 if unknown */
+	int error_parm;
+	/** the preferred reading */
+	hdate_parse_candidate date;
+	/** the number of valid entries in candidate[] */
+	int candidate_count;
+	/** other readings, under the opposite preference settings */
+	hdate_parse_candidate candidate[HDATE_PARSE_MAX_CANDIDATES];
+} hdate_parse_result;
+
+/**
+ @brief   reentrant variant of hdate_parse_date, which prints nothing,
+          and which resolves ambiguous parameters relative to a
+          caller-supplied reference date instead of the system clock.
+          It may be called concurrently from multiple threads.
+
+ @return  HDATE_PARSE_SUCCESS, or one of the HDATE_PARSE_ERR_ values,
+          which is also stored in result->error
+ @param parm_a, parm_b, parm_c  parameter strings, as for hdate_parse_date
+ @param parm_cnt        number of parameters to parse (1 - 3)
+ @param prefer_hebrew   as for hdate_parse_date
+ @param prefer_parm     HDATE_PREFER_YM or HDATE_PREFER_MD
+ @param base_year_h     base for two-digit Hebrew years
+ @param base_year_g     base for two-digit gregorian years
+ @param reference       the date that stands in for 'today'
+ @param want_candidates if non-zero, also return the readings obtained
+                        with the opposite preference settings
+ @param result          receives the parse result
+*/
+int hdate_parse_date_r( const char* parm_a, const char* parm_b, const char* parm_c,
+					 const int parm_cnt, const int prefer_hebrew, const int prefer_parm,
+					 const int base_year_h, const int base_year_g,
+					 hdate_struct const *reference, const int want_candidates,
+					 hdate_parse_result* result );
+
+/**
+ @brief   parse a buffer of date strings, one per row, into julian day
+          numbers. Fields within a row may be separated by spaces,
+          tabs, '/', '-', '.' or ','; months may be numeric or named,
+          Hebrew or gregorian. Each row is parsed as by
+          hdate_parse_date_r, and must resolve to a complete date.
+
+ @return  the number of rows parsed, which is at most max_rows
+ @param buffer          the rows; need not be null terminated
+ @param len             length of buffer, in bytes
+ @param delimiter       row separator, eg. '\n'
+ @param at_end          non-zero if buffer is the last of the input;
+                        otherwise a last row without its delimiter is
+                        not parsed, as its remainder may be in the
+                        next buffer
+ @param prefer_hebrew   as for hdate_parse_date
+ @param prefer_parm     HDATE_PREFER_YM or HDATE_PREFER_MD
+ @param base_year_h     base for two-digit Hebrew years
+ @param base_year_g     base for two-digit gregorian years
+ @param reference       the date that stands in for 'today'
+ @param jd              receives the julian day number of each row,
+                        or 0 for a row with an error
+ @param row_error       receives HDATE_PARSE_SUCCESS or an
+                        HDATE_PARSE_ERR_ value for each row
+ @param max_rows        capacity of jd and row_error
+ @param bytes_used      if not NULL, receives the number of bytes of
+                        buffer consumed, for resuming a partial parse:
+                        the rows parsed and their delimiters
+*/
+size_t hdate_parse_date_bulk( const char* buffer, const size_t len, const char delimiter,
+					 const int at_end,
+					 const int prefer_hebrew, const int prefer_parm,
+					 const int base_year_h, const int base_year_g,
+					 hdate_struct const *reference,
+					 int* jd, int* row_error, const size_t max_rows,
+					 size_t* bytes_used );
+
+/** @def HDATE_ISO_DATE_BUFFER_SIZE
+  @brief minimum buffer size for the hdate_format_iso_ functions
+*/
+#define HDATE_ISO_DATE_BUFFER_SIZE 11
+
+/**
+ @brief   parse an ISO-8601 gregorian date, YYYY-MM-DD
+ @return  HDATE_PARSE_SUCCESS, HDATE_PARSE_ERR_FORMAT, or
+          HDATE_PARSE_ERR_YEAR / _MONTH / _DAY for values out of range
+ @param text  the date; need not be null terminated
+ @param len   number of bytes of text to parse
+ @param h     receives the date; untouched upon error
+*/
+int hdate_parse_iso_gdate( const char* text, const size_t len, hdate_struct* h );
+
+/**
+ @brief   parse a canonical numeric Hebrew date, YYYY-MM-DD, in which
+          months are numbered 1 (Tishrei) - 12 (Elul), with Adar I = 13
+          and Adar II = 14. In a leap year, Adar must be given as 13 or
+          14; otherwise, 13 and 14 are invalid.
+ @return  HDATE_PARSE_SUCCESS, HDATE_PARSE_ERR_FORMAT, or
+          HDATE_PARSE_ERR_YEAR / _MONTH / _DAY for values out of range
+ @param text  the date; need not be null terminated
+ @param len   number of bytes of text to parse
+ @param h     receives the date; untouched upon error
+*/
+int hdate_parse_iso_hdate( const char* text, const size_t len, hdate_struct* h );
+
+/**
+ @brief   format the gregorian date of h as ISO-8601, YYYY-MM-DD
+ @return  the length of the string (10), or -1 if buffer is too small
+ @param h       the date
+ @param buffer  receives the null-terminated string
+ @param size    size of buffer; at least HDATE_ISO_DATE_BUFFER_SIZE
+*/
+int hdate_format_iso_gdate( hdate_struct const* h, char* buffer, const size_t size );
+
+/**
+ @brief   format the Hebrew date of h in canonical numeric form,
+          YYYY-MM-DD, with Adar I = 13 and Adar II = 14
+ @return  the length of the string (10), or -1 if buffer is too small
+ @param h       the date
+ @param buffer  receives the null-terminated string
+ @param size    size of buffer; at least HDATE_ISO_DATE_BUFFER_SIZE
+*/
+int hdate_format_iso_hdate( hdate_struct const* h, char* buffer, const size_t size );
+
+/** @def HDATE_DAY_TABLE_SIZE
+  @brief maximum number of days in an hdate_day_table
+*/
+#define HDATE_DAY_TABLE_SIZE 366
+
+/** @struct hdate_day_table
+  @brief local midnights, offsets and sunsets of each day of a
+         gregorian year, for one timezone and location
+*/
+typedef struct
+{
+	/** The gregorian year. */
+	int year;
+	/** The julian day number of January 1st. */
+	int jd_first;
+	/** The number of days in the year. */
+	int days;
+	/** The UTC offset at local noon of each day, in seconds east of UTC. */
+	int utc_offset[HDATE_DAY_TABLE_SIZE];
+	/** The instant of local midnight starting each day, in seconds from
+	    epoch; midnight[days] is the start of the following year. */
+	time_t midnight[HDATE_DAY_TABLE_SIZE + 1];
+	/** The instant of sunset of each day, in seconds from epoch. */
+	time_t sunset[HDATE_DAY_TABLE_SIZE];
+} hdate_day_table;
+
+/**
+ @brief   compute the day table of a gregorian year for a timezone
+          and location
+ @return  0 on success, or a ZD_ error code if the timezone could
+          not be loaded
+ @param table      receives the table
+ @param tzname     timezone name, eg. Asia/Jerusalem; if NULL, the
+                   system timezone
+ @param year       gregorian year
+ @param latitude   latitude to use in calculations
+ @param longitude  longitude to use in calculations
+*/
+int hdate_day_table_init( hdate_day_table* table, const char* tzname, const int year,
+					  const double latitude, const double longitude );
+
+/**
+ @brief   the julian day of the local civil date at an instant
+ @return  the julian day, or 0 if t is outside the year of the table
+ @param table  as computed by hdate_day_table_init
+ @param t      seconds from epoch
+*/
+int hdate_day_table_civil_jd( hdate_day_table const* table, const time_t t );
+
+/**
+ @brief   the julian day whose Hebrew date is in effect at an instant;
+          the Hebrew date changes at sunset
+ @return  the julian day, or 0 if t is outside the year of the table.
+          After sunset of December 31st, the result is January 1st of
+          the following year.
+ @param table  as computed by hdate_day_table_init
+ @param t      seconds from epoch
+*/
+int hdate_day_table_hebrew_jd( hdate_day_table const* table, const time_t t );
+
+/** @struct hdate_zone_tab_entry
+  @brief a line of the system zone.tab file
+*/
+typedef struct
+{
+	/** The timezone name, eg. Asia/Jerusalem. */
+	const char* name;
+	/** The ISO 3166 country code. */
+	char country[3];
+	/** The latitude of the zone's principal location. */
+	double latitude;
+	/** The longitude of the zone's principal location. */
+	double longitude;
+	/** The comment column; may be empty. */
+	const char* comment;
+} hdate_zone_tab_entry;
+
+/**
+ @brief   the number of entries in the zone.tab index. The file is
+          read upon first use of any hdate_zone_tab function.
+ @return  the number of entries, or 0 if zone.tab could not be read
+*/
+size_t hdate_zone_tab_count( void );
+
+/**
+ @brief   an entry of the zone.tab index, in file order
+ @return  the entry, or NULL if index is out of range
+ @param index  0 to hdate_zone_tab_count() - 1
+*/
+const hdate_zone_tab_entry* hdate_zone_tab_get( const size_t index );
+
+/**
+ @brief   look up a timezone by its exact name, ignoring case
+ @return  the entry, or NULL if not found
+ @param name  eg. Asia/Jerusalem
+*/
+const hdate_zone_tab_entry* hdate_zone_tab_find( const char* name );
+
+/**
+ @brief   search for a timezone by part of its name, ignoring case.
+          Leading and trailing spaces are ignored, and embedded
+          spaces match underscores, so that "new york" finds
+          America/New_York.
+ @return  an exact match if there is one, else the first matching
+          entry in file order, or NULL
+ @param text  the search string
+*/
+const hdate_zone_tab_entry* hdate_zone_tab_search( const char* text );
+
+/**
+ @brief   the zone.tab entry whose coordinates are nearest a point
+ @return  the entry, or NULL if the index is empty
+ @param latitude     of the point
+ @param longitude    of the point
+ @param distance_km  if not NULL, receives the distance to the entry
+*/
+const hdate_zone_tab_entry* hdate_zone_tab_nearest( const double latitude,
+					const double longitude, double* distance_km );
+
+/**
+ @brief   great-circle distance between two points, in kilometers
+ @return  the distance
+*/
+double hdate_distance_km( const double lat_a, const double lon_a,
+					const double lat_b, const double lon_b );
+
+/** @struct hdate_location
+  @brief a named place, for hdate_location_index
+*/
+typedef struct
+{
+	/** The name of the place, eg. Jerusalem; may be NULL. */
+	const char* name;
+	/** The timezone of the place, eg. Asia/Jerusalem; may be NULL. */
+	const char* tz_name;
+	/** The latitude of the place. */
+	double latitude;
+	/** The longitude of the place. */
+	double longitude;
+} hdate_location;
+
+/** @struct hdate_location_index
+  @brief a spatial index of locations, built by hdate_location_index_new.
+         Once built, it may be queried from any number of threads.
+*/
+typedef struct hdate_location_index hdate_location_index;
+
+/**
+ @brief   build a nearest-location index
+ @return  the index, to be released with hdate_location_index_free,
+          or NULL upon memory allocation failure
+ @param cities         locations to include; may be NULL. The strings
+                       are copied.
+ @param count          number of cities
+ @param with_zone_tab  if non-zero, also include the locations of the
+                       system zone.tab file, named for their city, eg.
+                       "New York" for America/New_York
+*/
+hdate_location_index* hdate_location_index_new( const hdate_location* cities,
+					const size_t count, const int with_zone_tab );
+
+/**
+ @brief   release an index built by hdate_location_index_new
+ @param index  the index; may be NULL
+*/
+void hdate_location_index_free( hdate_location_index* index );
+
+/**
+ @brief   the location nearest a point
+ @return  the location, owned by the index, or NULL if the index
+          is empty
+ @param index        as built by hdate_location_index_new
+ @param latitude     of the point
+ @param longitude    of the point
+ @param distance_km  if not NULL, receives the great-circle distance
+*/
+const hdate_location* hdate_location_nearest( hdate_location_index const* index,
+					const double latitude, const double longitude,
+					double* distance_km );
+
+/**
+ @brief   the timezone for a point, taken from the nearest location
+          that has one. Without zone boundary data, this is an
+          approximation that may be wrong close to a border.
+ @return  the timezone name, owned by the index, or NULL if no
+          location in the index has a timezone
+ @param index        as built by hdate_location_index_new
+ @param latitude     of the point
+ @param longitude    of the point
+*/
+const char* hdate_location_timezone( hdate_location_index const* index,
+					const double latitude, const double longitude );
+
+/** @def HDATE_CUSTOM_DAY_HEBREW
+  @brief custom day type: a Hebrew date
+*/
+#define HDATE_CUSTOM_DAY_HEBREW 'H'
+/** @def HDATE_CUSTOM_DAY_GREGORIAN
+  @brief custom day type: a gregorian date
+*/
+#define HDATE_CUSTOM_DAY_GREGORIAN 'G'
+/** @def HDATE_CUSTOM_DAY_HEBREW_NTH
+  @brief custom day type: the nth day of the week of a Hebrew month
+*/
+#define HDATE_CUSTOM_DAY_HEBREW_NTH 'h'
+/** @def HDATE_CUSTOM_DAY_GREGORIAN_NTH
+  @brief custom day type: the nth day of the week of a gregorian month
+*/
+#define HDATE_CUSTOM_DAY_GREGORIAN_NTH 'g'
+
+/** @struct hdate_custom_day_rule
+  @brief a recurring custom day, as in the custom_days file of hcal
+         and hdate. Set the defaults with hdate_custom_day_rule_init.
+         The keys for dates that some years lack take the values
+         0 - skip the year, 1 - mark the following day (for adar_II,
+         Nissan), or -1 - mark the prior day (for adar_II, Adar).
+*/
+typedef struct
+{
+	/** HDATE_CUSTOM_DAY_HEBREW, _GREGORIAN, _HEBREW_NTH or _GREGORIAN_NTH */
+	char type;
+	/** The first year, in the calendar of the type */
+	int start_year;
+	/** The final year, or 0 for none */
+	int final_year;
+	/** Hebrew months are 1 - 12, with Adar I = 13 and Adar II = 14 */
+	int month;
+	/** For types H and G */
+	int day_of_month;
+	/** For types h and g: 1 - 5 */
+	int nth;
+	/** For types h and g: 1 - 7, 7 being Shabbat */
+	int day_of_week;
+	/** For types H and G, days (-9 - 9) to advance or postpone the day
+	    when it falls on a day of the week; indexed by day_of_week - 1 */
+	int adj[7];
+	/** Cheshvan 30 in a year without it */
+	int cheshvan_30;
+	/** Kislev 30 in a year without it */
+	int kislev_30;
+	/** 29 February in a year without it */
+	int february_29;
+	/** Adar I 1 - 29 in a year without Adar I: 0 - skip, 1 - Adar */
+	int adar_I;
+	/** Adar I 30 in a year without Adar I (1 marks 1 Nissan) */
+	int adar_I_30;
+	/** Adar II 1 - 29 in a year without Adar II */
+	int adar_II;
+	/** Adar in a leap year: 1 - Adar I, 2 - Adar II */
+	int adar_in_leap_year;
+} hdate_custom_day_rule;
+
+/** @struct hdate_custom_day
+  @brief a custom day found by hdate_custom_days_get
+*/
+typedef struct
+{
+	/** The julian day */
+	int jd;
+	/** The index of its rule, as given to hdate_custom_days_new */
+	int rule;
+} hdate_custom_day;
+
+/** @struct hdate_custom_days
+  @brief a compiled set of custom day rules, built by
+         hdate_custom_days_new. It may be queried from any number of
+         threads.
+*/
+typedef struct hdate_custom_days hdate_custom_days;
+
+/**
+ @brief   set a rule to the defaults of the custom_days file: no
+          adjustments, Cheshvan 30, Kislev 30, 29 February and Adar I 30
+          on the following day in years without them, Adar I 1 - 29
+          skipped in years without Adar I, Adar II on Adar in years
+          without Adar II, and Adar on Adar II in leap years
+ @param rule  the rule to set
+*/
+void hdate_custom_day_rule_init( hdate_custom_day_rule* rule );
+
+/**
+ @brief   check that a rule's fields are all within their ranges
+ @return  non-zero if the rule is valid, otherwise 0
+ @param rule  the rule to check
+*/
+int hdate_custom_day_rule_valid( hdate_custom_day_rule const* rule );
+
+/**
+ @brief   compile a set of custom day rules
+ @return  the set, to be released with hdate_custom_days_free, or
+          NULL if a rule is invalid or upon memory allocation failure
+ @param rules  the rules; they are copied
+ @param count  number of rules
+*/
+hdate_custom_days* hdate_custom_days_new( const hdate_custom_day_rule* rules,
+					const size_t count );
+
+/**
+ @brief   release a set built by hdate_custom_days_new
+ @param set  the set; may be NULL
+*/
+void hdate_custom_days_free( hdate_custom_days* set );
+
+/**
+ @brief   the custom days of a set in a range of julian days. Each
+          year of a calendar is evaluated once, upon first use.
+ @return  the number of custom days in the range, which may be more
+          than max_days, or -1 upon memory allocation failure
+ @param set       as built by hdate_custom_days_new
+ @param jd_first  first julian day of the range
+ @param jd_last   last julian day of the range
+ @param days      receives up to max_days custom days, sorted by julian
+                  day and then by rule; may be NULL if max_days is 0
+ @param max_days  size of days
+*/
+int hdate_custom_days_get( hdate_custom_days* set, const int jd_first,
+					const int jd_last, hdate_custom_day* days,
+					const size_t max_days );
+
+/** @struct hdate_limud_unit
+  @brief a unit of a daily learning cycle, eg. a masechet of daf yomi
+*/
+typedef struct
+{
+	/** The name of the unit, in English transliteration */
+	const char* name;
+	/** The name of the unit, in Hebrew */
+	const char* hebrew_name;
+	/** The page (daf, chapter, ...) learned on its first day */
+	int first_page;
+	/** The number of days the unit is learned, one page a day */
+	int days;
+} hdate_limud_unit;
+
+/** @struct hdate_limud
+  @brief the learning of a day, found by hdate_limud_get
+*/
+typedef struct
+{
+	/** The number of the cycle */
+	int cycle;
+	/** The day of the cycle, from 0 */
+	int day;
+	/** The index of the unit, for hdate_limud_cycle_unit */
+	int unit;
+	/** The page of the unit, eg. the daf */
+	int page;
+} hdate_limud;
+
+/** @struct hdate_limud_cycle
+  @brief a daily learning cycle, defined by hdate_limud_cycle_new.
+         It may be queried from any number of threads.
+*/
+typedef struct hdate_limud_cycle hdate_limud_cycle;
+
+/**
+ @brief   define a daily learning cycle, eg. Yerushalmi or Rambam
+ @return  the cycle, to be released with hdate_limud_cycle_free, or
+          NULL if a unit has no days or upon memory allocation failure
+ @param units        the units of the cycle, in order; the strings
+                     are copied
+ @param count        number of units
+ @param epoch_jd     julian day on which a cycle began
+ @param first_cycle  the number of that cycle
+*/
+hdate_limud_cycle* hdate_limud_cycle_new( const hdate_limud_unit* units,
+					const size_t count, const int epoch_jd, const int first_cycle );
+
+/**
+ @brief   release a cycle defined by hdate_limud_cycle_new
+ @param cycle  the cycle; may be NULL
+*/
+void hdate_limud_cycle_free( hdate_limud_cycle* cycle );
+
+/**
+ @brief   the daf yomi (Babylonian Talmud) cycle, from its eleventh
+          cycle, which began 02 March 2005
+ @return  the cycle, owned by the library, or NULL upon memory
+          allocation failure
+*/
+const hdate_limud_cycle* hdate_limud_daf_yomi( void );
+
+/**
+ @brief   a unit of a cycle
+ @return  the unit, owned by the cycle, or NULL if there is no such unit
+ @param cycle  the cycle
+ @param unit   index of the unit, as in hdate_limud
+*/
+const hdate_limud_unit* hdate_limud_cycle_unit( hdate_limud_cycle const* cycle,
+					const int unit );
+
+/**
+ @brief   the learning of a day
+ @return  non-zero if the cycle had begun by that day, otherwise 0
+ @param cycle   the cycle
+ @param jd      julian day
+ @param limud   receives the learning of the day
+*/
+int hdate_limud_get( hdate_limud_cycle const* cycle, const int jd,
+					hdate_limud* limud );
+
+/**
+ @brief   the learning of a range of days
+ @return  the number of days in the range on which the cycle had begun
+ @param cycle     the cycle
+ @param jd_first  first julian day of the range
+ @param count     number of days in the range
+ @param limud     receives the learning of each day; days before the
+                  cycle began have unit -1
+*/
+size_t hdate_limud_get_range( hdate_limud_cycle const* cycle, const int jd_first,
+					const size_t count, hdate_limud* limud );
+
+/** @struct hdate_snapshot
+  @brief a calendar snapshot file, opened by hdate_snapshot_open: the
+         holidays, parashiot and custom days of a range of gregorian
+         years, and the dst transitions of a set of locations, as
+         computed by hdate_snapshot_write. Queries of days outside the
+         snapshot, or of a NULL snapshot, fall back to computation.
+         It may be queried from any number of threads.
+*/
+typedef struct hdate_snapshot hdate_snapshot;
+
+/**
+ @brief   compute a snapshot of a range of years and write it to a
+          file, replacing any prior file atomically
+ @return  0 on success, or -1 upon failure, with errno set
+ @param path            the snapshot file
+ @param year_first      first gregorian year
+ @param year_last       last gregorian year
+ @param locations       locations whose dst transitions to include;
+                        may be NULL
+ @param location_count  number of locations
+ @param custom_days     custom days to include; may be NULL
+ @param sources         files the snapshot is computed from, eg. a
+                        custom days file. If any of them later
+                        changes, the snapshot will not be opened.
+                        May be NULL.
+ @param source_count    number of sources
+*/
+int hdate_snapshot_write( const char* path, const int year_first, const int year_last,
+					const hdate_location* locations, const size_t location_count,
+					hdate_custom_days* custom_days,
+					const char* const* sources, const size_t source_count );
+
+/**
+ @brief   open a snapshot written by hdate_snapshot_write
+ @return  the snapshot, to be released with hdate_snapshot_close, or
+          NULL if the file is absent, is not a snapshot of this
+          version for this machine, or is stale: one of its
+          sources has changed
+ @param path  the snapshot file
+*/
+hdate_snapshot* hdate_snapshot_open( const char* path );
+
+/**
+ @brief   release a snapshot opened by hdate_snapshot_open
+ @param snapshot  the snapshot; may be NULL
+*/
+void hdate_snapshot_close( hdate_snapshot* snapshot );
+
+/**
+ @brief   the range of julian days of a snapshot
+ @return  non-zero if the snapshot covers every day of the range,
+          otherwise 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param jd_first  first julian day of the range
+ @param jd_last   last julian day of the range
+*/
+int hdate_snapshot_covers( hdate_snapshot const* snapshot, const int jd_first,
+					const int jd_last );
+
+/**
+ @brief   the halachic holiday of a day, as hdate_get_halachic_day,
+          from the snapshot if it covers the day, otherwise computed
+ @return  the number of the holiday, or 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param h         the day
+ @param diaspora  if non-zero, give diaspora holidays
+*/
+int hdate_snapshot_halachic_day( hdate_snapshot const* snapshot,
+					hdate_struct const* h, const int diaspora );
+
+/**
+ @brief   the holiday or Israeli custom day of a day, as
+          hdate_get_holyday, from the snapshot if it covers the day,
+          otherwise computed
+ @return  the number of the holiday, or 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param h         the day
+ @param diaspora  if non-zero, give diaspora holidays
+*/
+int hdate_snapshot_holyday( hdate_snapshot const* snapshot,
+					hdate_struct const* h, const int diaspora );
+
+/**
+ @brief   the parasha of a day, as hdate_get_parasha, from the
+          snapshot if it covers the day, otherwise computed
+ @return  the number of the parasha, or 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param h         the day
+ @param diaspora  if non-zero, give the diaspora reading
+*/
+int hdate_snapshot_parasha( hdate_snapshot const* snapshot,
+					hdate_struct const* h, const int diaspora );
+
+/**
+ @brief   the custom days of a snapshot in a range of julian days,
+          as hdate_custom_days_get for the set it was written with
+ @return  the number of custom days in the range, which may be more
+          than max_days, or -1 if the snapshot has no custom days or
+          does not cover the range, in which case the caller should
+          compute them
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param jd_first  first julian day of the range
+ @param jd_last   last julian day of the range
+ @param days      receives up to max_days custom days, sorted by julian
+                  day and then by rule; may be NULL if max_days is 0
+ @param max_days  size of days
+*/
+int hdate_snapshot_custom_days( hdate_snapshot const* snapshot, const int jd_first,
+					const int jd_last, hdate_custom_day* days,
+					const size_t max_days );
+
+/**
+ @brief   find a location of a snapshot by its timezone
+ @return  the index of the first location with that timezone, or -1
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param tz_name   timezone name, eg. Asia/Jerusalem
+*/
+int hdate_snapshot_find_location( hdate_snapshot const* snapshot, const char* tz_name );
+
+/**
+ @brief   the UTC offset of a location of a snapshot at an instant
+ @return  0 on success, or -1 if the snapshot does not cover the
+          instant or the location has no timezone, in which case the
+          caller should use zdump_offset
+ @param snapshot    as opened by hdate_snapshot_open; may be NULL
+ @param location    index of the location, as from
+                    hdate_snapshot_find_location
+ @param t           seconds from epoch
+ @param utc_offset  receives the offset, in seconds east of UTC
+ @param isdst       if not NULL, receives non-zero if dst is in effect
+*/
+int hdate_snapshot_utc_offset( hdate_snapshot const* snapshot, const int location,
+					const time_t t, int* utc_offset, int* isdst );
+
+/**
+ @brief   convert arrays of gregorian dates to julian days
+ @return  the number of valid dates
+ @param day    days of month, 1..31
+ @param month  months, 1..12
+ @param year   years, eg. 2001
+ @param count  number of dates
+ @param jd     receives the julian day of each date, or 0 for an
+               invalid date; may be the same array as an input
+*/
+size_t hdate_gdate_to_jd_bulk( const int* day, const int* month, const int* year,
+					const size_t count, int* jd );
+
+/**
+ @brief   convert arrays of Hebrew dates to julian days. Months are
+          numbered as for hdate_parse_iso_hdate.
+ @return  the number of valid dates
+ @param day    days of month, 1..30
+ @param month  months, 1..12, or 13 and 14 for Adar I and II
+ @param year   years, eg. 5771
+ @param count  number of dates
+ @param jd     receives the julian day of each date, or 0 for an
+               invalid date; may be the same array as an input
+*/
+size_t hdate_hdate_to_jd_bulk( const int* day, const int* month, const int* year,
+					const size_t count, int* jd );
+
+/**
+ @brief   convert an array of julian days to gregorian dates
+ @param jd     julian days; days outside the gregorian years
+               HDATE_GREG_YR_LOWER_BOUND - _UPPER_BOUND, eg. the 0
+               of an invalid date, give a date of 0/0/0
+ @param count  number of days
+ @param day    receives the day of month of each
+ @param month  receives the month of each
+ @param year   receives the year of each
+*/
+void hdate_jd_to_gdate_bulk( const int* jd, const size_t count,
+					int* day, int* month, int* year );
+
+/**
+ @brief   convert an array of julian days to Hebrew dates
+ @param jd     julian days, as for hdate_jd_to_gdate_bulk
+ @param count  number of days
+ @param day    receives the day of month of each
+ @param month  receives the month of each, 1..14 (13 - Adar I,
+               14 - Adar II)
+ @param year   receives the year of each
+*/
+void hdate_jd_to_hdate_bulk( const int* jd, const size_t count,
+					int* day, int* month, int* year );
+
+/**
+ @brief   the holidays of an array of julian days, as hdate_get_holyday
+ @param jd        julian days, as for hdate_jd_to_gdate_bulk; invalid
+                  days give 0
+ @param count     number of days
+ @param diaspora  if non-zero, give diaspora holidays
+ @param holyday   receives the holiday number of each day, or 0
+*/
+void hdate_get_holyday_bulk( const int* jd, const size_t count, const int diaspora,
+					int* holyday );
+
+/**
+ @brief   the parashiot of an array of julian days, as hdate_get_parasha
+ @param jd        julian days, as for hdate_jd_to_gdate_bulk; invalid
+                  days give 0
+ @param count     number of days
+ @param diaspora  if non-zero, give the diaspora reading
+ @param parasha   receives the parasha number of each day, or 0 if it
+                  has no reading
+*/
+void hdate_get_parasha_bulk( const int* jd, const size_t count, const int diaspora,
+					int* parasha );
+
+/** The value of a time of day that does not occur, when the sun does
+    not reach the altitude it is reckoned by, as near the poles */
+#define HDATE_NO_ZMAN -720
+
+/** @struct hdate_zmanim
+  @brief the times of a day, in seconds from 00:00 utc, as printed
+         by the hdate example program. Times reckoned from a time
+         that does not occur are themselves HDATE_NO_ZMAN.
+*/
+typedef struct
+{
+	/** alot hashachar, sun 16.01 degrees below the horizon */
+	int first_light;
+	/** misheyakir, sun 11 degrees below the horizon */
+	int talit;
+	/** sunrise */
+	int sunrise;
+	/** end of shema, Magen Avraham */
+	int shema_magen_avraham;
+	/** end of shema, GR"A */
+	int shema;
+	/** end of the amidah, GR"A */
+	int amidah;
+	/** chatzot */
+	int midday;
+	/** mincha gedola, half an hour after chatzot */
+	int mincha_gedola;
+	/** mincha ketana */
+	int mincha_ketana;
+	/** plag hamincha */
+	int plag_hamincha;
+	/** sunset */
+	int sunset;
+	/** tzeit hakochavim, sun 6 degrees below the horizon */
+	int first_stars;
+	/** three stars, sun 8.5 degrees below the horizon */
+	int three_stars;
+	/** sha'a zmanit of the GR"A, in seconds */
+	int sun_hour;
+} hdate_zmanim;
+
+/**
+ @brief   the times of a gregorian date at a location
+ @param day        this day of month
+ @param month      this month
+ @param year       this year
+ @param latitude   latitude to use in calculations
+ @param longitude  longitude to use in calculations
+ @param zmanim     receives the times of the day
+*/
+void hdate_get_utc_zmanim( const int day, const int month, const int year,
+					const double latitude, const double longitude,
+					hdate_zmanim* zmanim );
+
+/**
+ @brief   the times of an array of julian days at an array of locations
+ @param jd         julian days, as for hdate_jd_to_gdate_bulk; the times
+                  of invalid days are all HDATE_NO_ZMAN
+ @param days       number of days
+ @param latitude   latitudes of the locations
+ @param longitude  longitudes of the locations
+ @param locations  number of locations
+ @param threads    number of threads to compute with; 0 for one per
+                  online processor
+ @param zmanim     receives days * locations times, those of each day at
+                  each location in turn: zmanim[day * locations + location]
+*/
+void hdate_get_utc_zmanim_bulk( const int* jd, const size_t days,
+					const double* latitude, const double* longitude,
+					const size_t locations, const int threads,
+					hdate_zmanim* zmanim );
+
 int hdate_get_size_of_hebrew_month( const unsigned int month, const unsigned int hebrew_year_type);
 
 int hdate_get_size_of_gregorian_month( const unsigned int month, const unsigned int year);
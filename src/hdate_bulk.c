@@ -0,0 +1,409 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  bulk conversions: the date conversions and holiday and parasha
+ *  lookups over arrays, for bindings that work on columns of dates
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "hdate.h"
+#include "support.h"
+
+/// julian days of 1 January 1000 and 31 December 2999, the
+/// bounds of HDATE_GREG_YR_LOWER_BOUND and _UPPER_BOUND
+#define JD_LOWER_BOUND 2086303
+#define JD_UPPER_BOUND 2816787
+
+
+/************************************************************
+* valid_jd
+************************************************************/
+static int valid_jd( const int jd )
+{
+	return ( (jd >= JD_LOWER_BOUND) && (jd <= JD_UPPER_BOUND) );
+}
+
+
+/************************************************************
+* valid_hdate
+*
+* the checks of hdate_parse_iso_hdate; returns the julian day,
+* or 0 if the date is invalid
+************************************************************/
+static int valid_hdate( const int day, const int month, const int year )
+{
+	int jd, jd_tishrey1, jd_tishrey1_next_year;
+	int check_day, check_month, check_year;
+
+	if ( (year < HDATE_HEB_YR_LOWER_BOUND) || (year > HDATE_HEB_YR_UPPER_BOUND) ||
+		 (month < 1) || (month > 14) || (day < 1) || (day > 30) )
+		return 0;
+	jd = hdate_hdate_to_jd(day, month, year, &jd_tishrey1, &jd_tishrey1_next_year);
+	if (jd_tishrey1_next_year - jd_tishrey1 > 355)
+	{
+		if (month == 6) return 0;
+	}
+	else if (month > 12) return 0;
+	hdate_jd_to_hdate(jd, &check_day, &check_month, &check_year, NULL, NULL);
+	if ( (check_day != day) || (check_month != month) || (check_year != year) )
+		return 0;
+	return jd;
+}
+
+
+/**
+ @brief   convert arrays of gregorian dates to julian days
+ @return  the number of valid dates
+ @param day    days of month, 1..31
+ @param month  months, 1..12
+ @param year   years, eg. 2001
+ @param count  number of dates
+ @param jd     receives the julian day of each date, or 0 for an
+               invalid date; may be the same array as an input
+*/
+size_t
+hdate_gdate_to_jd_bulk( const int* day, const int* month, const int* year,
+						const size_t count, int* jd )
+{
+	size_t i, valid = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		if ( (year[i] < HDATE_GREG_YR_LOWER_BOUND) || (year[i] > HDATE_GREG_YR_UPPER_BOUND) ||
+			 (month[i] < 1) || (month[i] > 12) || (day[i] < 1) ||
+			 (day[i] > hdate_get_size_of_gregorian_month(month[i], year[i])) )
+		{
+			jd[i] = 0;
+			continue;
+		}
+		jd[i] = hdate_gdate_to_jd(day[i], month[i], year[i]);
+		valid++;
+	}
+	return valid;
+}
+
+
+/**
+ @brief   convert arrays of Hebrew dates to julian days. Months are
+          numbered as for hdate_parse_iso_hdate.
+ @return  the number of valid dates
+ @param day    days of month, 1..30
+ @param month  months, 1..12, or 13 and 14 for Adar I and II
+ @param year   years, eg. 5771
+ @param count  number of dates
+ @param jd     receives the julian day of each date, or 0 for an
+               invalid date; may be the same array as an input
+*/
+size_t
+hdate_hdate_to_jd_bulk( const int* day, const int* month, const int* year,
+						const size_t count, int* jd )
+{
+	size_t i, valid = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		jd[i] = valid_hdate(day[i], month[i], year[i]);
+		if (jd[i] != 0) valid++;
+	}
+	return valid;
+}
+
+
+/**
+ @brief   convert an array of julian days to gregorian dates
+ @param jd     julian days; days outside the gregorian years
+               HDATE_GREG_YR_LOWER_BOUND - _UPPER_BOUND, eg. the 0
+               of an invalid date, give a date of 0/0/0
+ @param count  number of days
+ @param day    receives the day of month of each
+ @param month  receives the month of each
+ @param year   receives the year of each
+*/
+void
+hdate_jd_to_gdate_bulk( const int* jd, const size_t count,
+						int* day, int* month, int* year )
+{
+	size_t i;
+	int d, m, y;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!valid_jd(jd[i])) d = m = y = 0;
+		else hdate_jd_to_gdate(jd[i], &d, &m, &y);
+		day[i] = d;
+		month[i] = m;
+		year[i] = y;
+	}
+}
+
+
+/**
+ @brief   convert an array of julian days to Hebrew dates
+ @param jd     julian days, as for hdate_jd_to_gdate_bulk
+ @param count  number of days
+ @param day    receives the day of month of each
+ @param month  receives the month of each, 1..14 (13 - Adar I,
+               14 - Adar II)
+ @param year   receives the year of each
+*/
+void
+hdate_jd_to_hdate_bulk( const int* jd, const size_t count,
+						int* day, int* month, int* year )
+{
+	size_t i;
+	int d, m, y;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!valid_jd(jd[i])) d = m = y = 0;
+		else hdate_jd_to_hdate(jd[i], &d, &m, &y, NULL, NULL);
+		day[i] = d;
+		month[i] = m;
+		year[i] = y;
+	}
+}
+
+
+/**
+ @brief   the holidays of an array of julian days, as hdate_get_holyday
+ @param jd        julian days, as for hdate_jd_to_gdate_bulk; invalid
+                  days give 0
+ @param count     number of days
+ @param diaspora  if non-zero, give diaspora holidays
+ @param holyday   receives the holiday number of each day, or 0
+*/
+void
+hdate_get_holyday_bulk( const int* jd, const size_t count, const int diaspora,
+						int* holyday )
+{
+	hdate_struct h;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!valid_jd(jd[i])) { holyday[i] = 0; continue; }
+		hdate_set_jd(&h, jd[i]);
+		holyday[i] = hdate_get_holyday(&h, diaspora);
+	}
+}
+
+
+/**
+ @brief   the parashiot of an array of julian days, as hdate_get_parasha
+ @param jd        julian days, as for hdate_jd_to_gdate_bulk; invalid
+                  days give 0
+ @param count     number of days
+ @param diaspora  if non-zero, give the diaspora reading
+ @param parasha   receives the parasha number of each day, or 0 if it
+                  has no reading
+*/
+void
+hdate_get_parasha_bulk( const int* jd, const size_t count, const int diaspora,
+						int* parasha )
+{
+	hdate_struct h;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!valid_jd(jd[i])) { parasha[i] = 0; continue; }
+		hdate_set_jd(&h, jd[i]);
+		parasha[i] = hdate_get_parasha(&h, diaspora);
+	}
+}
+
+
+/************************************************************
+* zman
+*
+* base + hours sha'ot zmaniot of sun_hour, or HDATE_NO_ZMAN
+* if either does not occur
+************************************************************/
+static int zman( const int base, const int sun_hour, const double hours )
+{
+	if ( (base == HDATE_NO_ZMAN) || (sun_hour == HDATE_NO_ZMAN) )
+		return HDATE_NO_ZMAN;
+	return base + (int) (hours * sun_hour);
+}
+
+
+/**
+ @brief   the times of a gregorian date at a location
+ @param day        this day of month
+ @param month      this month
+ @param year       this year
+ @param latitude   latitude to use in calculations
+ @param longitude  longitude to use in calculations
+ @param zmanim     receives the times of the day
+*/
+void
+hdate_get_utc_zmanim( const int day, const int month, const int year,
+					  const double latitude, const double longitude,
+					  hdate_zmanim* zmanim )
+{
+	int place_holder;
+	int ma_sun_hour;
+
+	hdate_get_utc_sun_time_deg_seconds(day, month, year, latitude, longitude, 90.833,
+									   &zmanim->sunrise, &zmanim->sunset);
+	hdate_get_utc_sun_time_deg_seconds(day, month, year, latitude, longitude, 106.01,
+									   &zmanim->first_light, &place_holder);
+	hdate_get_utc_sun_time_deg_seconds(day, month, year, latitude, longitude, 101.0,
+									   &zmanim->talit, &place_holder);
+	hdate_get_utc_sun_time_deg_seconds(day, month, year, latitude, longitude, 96.0,
+									   &place_holder, &zmanim->first_stars);
+	hdate_get_utc_sun_time_deg_seconds(day, month, year, latitude, longitude, 98.5,
+									   &place_holder, &zmanim->three_stars);
+
+	/// sha'a zmanit according to the GR"A and to the Magen Avraham
+	if ( (zmanim->sunrise == HDATE_NO_ZMAN) || (zmanim->sunset == HDATE_NO_ZMAN) )
+	{
+		zmanim->sun_hour = HDATE_NO_ZMAN;
+		zmanim->midday = HDATE_NO_ZMAN;
+	}
+	else
+	{
+		zmanim->sun_hour = (zmanim->sunset - zmanim->sunrise) / 12;
+		zmanim->midday = (zmanim->sunset + zmanim->sunrise) / 2;
+	}
+	if ( (zmanim->first_light == HDATE_NO_ZMAN) || (zmanim->first_stars == HDATE_NO_ZMAN) )
+		ma_sun_hour = HDATE_NO_ZMAN;
+	else ma_sun_hour = (zmanim->first_stars - zmanim->first_light) / 12;
+
+	zmanim->shema_magen_avraham = zman(zmanim->first_light, ma_sun_hour, 3);
+	zmanim->shema = zman(zmanim->sunrise, zmanim->sun_hour, 3);
+	zmanim->amidah = zman(zmanim->sunrise, zmanim->sun_hour, 4);
+	zmanim->mincha_gedola = (zmanim->midday == HDATE_NO_ZMAN) ?
+							HDATE_NO_ZMAN : zmanim->midday + (30 * 60);
+	zmanim->mincha_ketana = zman(zmanim->sunrise, zmanim->sun_hour, 9.5);
+	zmanim->plag_hamincha = zman(zmanim->sunrise, zmanim->sun_hour, 10.75);
+}
+
+
+/// the share of hdate_get_utc_zmanim_bulk of one thread
+typedef struct
+{
+	const int* jd;
+	size_t first_cell;			/// of the days * locations results
+	size_t last_cell;			/// one past
+	const double* latitude;
+	const double* longitude;
+	size_t locations;
+	hdate_zmanim* zmanim;
+} zmanim_work;
+
+
+/************************************************************
+* zmanim_worker
+************************************************************/
+static void* zmanim_worker( void* arg )
+{
+	const zmanim_work* work = arg;
+	hdate_zmanim* zmanim;
+	size_t cell, i, j, k;
+	size_t converted = (size_t) -1;	/// the day of day, month, year
+	int day = 0, month = 0, year = 0;
+
+	for (cell = work->first_cell; cell < work->last_cell; cell++)
+	{
+		i = cell / work->locations;
+		j = cell % work->locations;
+		zmanim = &work->zmanim[cell];
+		if (!valid_jd(work->jd[i]))
+		{
+			for (k = 0; k < sizeof(hdate_zmanim) / sizeof(int); k++)
+				((int*) zmanim)[k] = HDATE_NO_ZMAN;
+			continue;
+		}
+		if (converted != i)
+		{
+			hdate_jd_to_gdate(work->jd[i], &day, &month, &year);
+			converted = i;
+		}
+		hdate_get_utc_zmanim(day, month, year, work->latitude[j],
+							 work->longitude[j], zmanim);
+	}
+	return NULL;
+}
+
+
+/**
+ @brief   the times of an array of julian days at an array of locations
+ @param jd         julian days, as for hdate_jd_to_gdate_bulk; the times
+                  of invalid days are all HDATE_NO_ZMAN
+ @param days       number of days
+ @param latitude   latitudes of the locations
+ @param longitude  longitudes of the locations
+ @param locations  number of locations
+ @param threads    number of threads to compute with; 0 for one per
+                  online processor
+ @param zmanim     receives days * locations times, those of each day at
+                  each location in turn: zmanim[day * locations + location]
+*/
+void
+hdate_get_utc_zmanim_bulk( const int* jd, const size_t days,
+						   const double* latitude, const double* longitude,
+						   const size_t locations, const int threads,
+						   hdate_zmanim* zmanim )
+{
+	zmanim_work* work;
+	pthread_t* thread;
+	size_t count, cells, i;
+	long processors;
+
+	cells = days * locations;
+	count = threads;
+	if (threads <= 0)
+	{
+		processors = sysconf(_SC_NPROCESSORS_ONLN);
+		count = (processors > 0) ? processors : 1;
+	}
+	if (count > cells) count = cells;
+	if (count == 0) return;
+
+	work = malloc( count * sizeof(zmanim_work) );
+	thread = malloc( count * sizeof(pthread_t) );
+	if ( (work == NULL) || (thread == NULL) ) count = 1;
+
+	/// each thread takes a contiguous run of results, so that one day
+	/// at many locations is shared out as well as many days at one.
+	/// The last run is done by the calling thread, as is any run whose
+	/// thread could not be started.
+	for (i = 0; i < count; i++)
+	{
+		zmanim_work w = { jd, cells * i / count, cells * (i + 1) / count,
+						  latitude, longitude, locations, zmanim };
+		if (count == 1)
+		{
+			zmanim_worker(&w);
+			break;
+		}
+		work[i] = w;
+		if ( (i == count - 1) ||
+			 (pthread_create(&thread[i], NULL, zmanim_worker, &work[i]) != 0) )
+		{
+			thread[i] = pthread_self();
+			zmanim_worker(&work[i]);
+		}
+	}
+	for (i = 0; (count > 1) && (i < count); i++)
+		if (!pthread_equal(thread[i], pthread_self()))
+			pthread_join(thread[i], NULL);
+	free(work);
+	free(thread);
+}
@@ -0,0 +1,526 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  custom days: rules for recurring Hebrew or gregorian dates,
+ *  evaluated lazily and memoized per calendar year
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "hdate.h"
+#include "support.h"
+
+/// an advancement or postponement may move a custom day this many
+/// days from its date, and so into an adjacent year
+#define MAX_ADJUSTMENT 9
+
+#define CALENDAR_HEBREW    0
+#define CALENDAR_GREGORIAN 1
+
+
+/// the custom days of all the rules of one calendar, for one year
+/// of that calendar, sorted by julian day and then rule
+typedef struct
+{
+	int year;
+	int count;
+	hdate_custom_day* day;
+} year_memo;
+
+struct hdate_custom_days
+{
+	hdate_custom_day_rule* rule;	/// [count]
+	size_t count;
+	int has_calendar[2];
+	pthread_mutex_t lock;			/// guards memo
+	year_memo* memo[2];				/// [memo_count], sorted by year
+	size_t memo_count[2];
+	size_t memo_size[2];
+};
+
+
+/************************************************************
+* day_of_week
+*
+* 1 = Sunday ... 7 = Shabbat, as hd_dw of hdate_struct
+************************************************************/
+static int day_of_week( const int jd )
+{
+	return (jd + 1) % 7 + 1;
+}
+
+
+/************************************************************
+* hebrew_date_exists
+*
+* month 6 is Adar of a regular year; a leap year has 13
+* and 14 instead
+************************************************************/
+static int hebrew_date_exists( const int day, const int month, const int year )
+{
+	int check_day, check_month, check_year;
+
+	if ( (day < 1) || (day > 30) || (month < 1) || (month > 14) ) return FALSE;
+	hdate_jd_to_hdate(hdate_hdate_to_jd(day, month, year, NULL, NULL),
+					  &check_day, &check_month, &check_year, NULL, NULL);
+	return (check_day == day) && (check_month == month) && (check_year == year);
+}
+
+
+/************************************************************
+* gregorian_date_exists
+************************************************************/
+static int gregorian_date_exists( const int day, const int month, const int year )
+{
+	if ( (month < 1) || (month > 12) ) return FALSE;
+	return (day >= 1) && (day <= hdate_get_size_of_gregorian_month(month, year));
+}
+
+
+/************************************************************
+* hebrew_occurrence
+*
+* the julian day of a type H rule in a Hebrew year, applying
+* the keys for dates that year lacks, and the weekday
+* adjustments. Returns FALSE if the rule skips the year.
+************************************************************/
+static int hebrew_occurrence( const hdate_custom_day_rule* rule, const int year, int* jd )
+{
+	int day = rule->day_of_month;
+	int month = rule->month;
+	int key;
+	int jd_tishrey1, jd_tishrey1_next_year;
+	int leap_year;
+
+	hdate_hdate_to_jd(1, 1, year, &jd_tishrey1, &jd_tishrey1_next_year);
+	leap_year = (jd_tishrey1_next_year - jd_tishrey1) > 355;
+
+	if ( (day == 30) && ((month == 2) || (month == 3)) &&
+		 (!hebrew_date_exists(day, month, year)) )
+	{
+		/// Cheshvan 30 or Kislev 30; 1 marks it on the next day
+		key = (month == 2) ? rule->cheshvan_30 : rule->kislev_30;
+		if (!key) return FALSE;
+		if (key == -1) day = 29;
+	}
+	else if ( (month == 14) && (day < 30) && (!leap_year) )
+	{
+		if (!rule->adar_II) return FALSE;
+		month = (rule->adar_II == -1) ? 6 : 7;
+	}
+	else if ( (month == 13) && (!leap_year) )
+	{
+		/// Adar I 30 is 1 Nissan, unless moved back to 29 Adar
+		month = 6;
+		if (day == 30)
+		{
+			if (!rule->adar_I_30) return FALSE;
+			if (rule->adar_I_30 == -1) day = 29;
+		}
+		else if (!rule->adar_I) return FALSE;
+	}
+	else if ( (month == 6) && leap_year )
+	{
+		month = (rule->adar_in_leap_year == 1) ? 13 : 14;
+	}
+	else if (!hebrew_date_exists(day, month, year)) return FALSE;
+
+	*jd = hdate_hdate_to_jd(day, month, year, NULL, NULL);
+	*jd = *jd + rule->adj[day_of_week(*jd) - 1];
+	return TRUE;
+}
+
+
+/************************************************************
+* gregorian_occurrence
+*
+* as hebrew_occurrence, for a type G rule
+************************************************************/
+static int gregorian_occurrence( const hdate_custom_day_rule* rule, const int year, int* jd )
+{
+	int day = rule->day_of_month;
+
+	if ( (rule->month == 2) && (day == 29) && (!gregorian_date_exists(day, 2, year)) )
+	{
+		/// 1 marks it on 1 March
+		if (!rule->february_29) return FALSE;
+		if (rule->february_29 == -1) day = 28;
+	}
+	else if (!gregorian_date_exists(day, rule->month, year)) return FALSE;
+
+	*jd = hdate_gdate_to_jd(day, rule->month, year);
+	*jd = *jd + rule->adj[day_of_week(*jd) - 1];
+	return TRUE;
+}
+
+
+/************************************************************
+* nth_weekday_occurrence
+*
+* the julian day of a type h or g rule: the nth day_of_week
+* of a month. Returns FALSE if the year lacks the month, or
+* the month lacks an nth such day.
+************************************************************/
+static int nth_weekday_occurrence( const hdate_custom_day_rule* rule, const int year, int* jd )
+{
+	int jd_first;
+	int day, month, check_year;
+
+	if (rule->type == HDATE_CUSTOM_DAY_HEBREW_NTH)
+	{
+		if (!hebrew_date_exists(1, rule->month, year)) return FALSE;
+		jd_first = hdate_hdate_to_jd(1, rule->month, year, NULL, NULL);
+	}
+	else
+	{
+		if (!gregorian_date_exists(1, rule->month, year)) return FALSE;
+		jd_first = hdate_gdate_to_jd(1, rule->month, year);
+	}
+	*jd = jd_first + ((rule->day_of_week - day_of_week(jd_first) + 7) % 7) +
+		  ((rule->nth - 1) * 7);
+
+	if (rule->type == HDATE_CUSTOM_DAY_HEBREW_NTH)
+		hdate_jd_to_hdate(*jd, &day, &month, &check_year, NULL, NULL);
+	else
+		hdate_jd_to_gdate(*jd, &day, &month, &check_year);
+	return (month == rule->month);
+}
+
+
+/************************************************************
+* rule_calendar
+************************************************************/
+static int rule_calendar( const hdate_custom_day_rule* rule )
+{
+	if ( (rule->type == HDATE_CUSTOM_DAY_HEBREW) ||
+		 (rule->type == HDATE_CUSTOM_DAY_HEBREW_NTH) )
+		return CALENDAR_HEBREW;
+	return CALENDAR_GREGORIAN;
+}
+
+
+/************************************************************
+* compare_custom_day
+************************************************************/
+static int compare_custom_day( const void* a, const void* b )
+{
+	const hdate_custom_day* x = a;
+	const hdate_custom_day* y = b;
+
+	if (x->jd != y->jd) return (x->jd < y->jd) ? -1 : 1;
+	return x->rule - y->rule;
+}
+
+
+/************************************************************
+* evaluate_year
+*
+* all the custom days of the rules of a calendar, for one
+* year of it. Returns FALSE upon memory allocation failure.
+************************************************************/
+static int evaluate_year( const hdate_custom_days* set, const int calendar,
+						  const int year, year_memo* memo )
+{
+	const hdate_custom_day_rule* rule;
+	size_t i;
+	int jd, found;
+
+	memo->year = year;
+	memo->count = 0;
+	memo->day = malloc( (set->count + 1) * sizeof(hdate_custom_day) );
+	if (memo->day == NULL) return FALSE;
+
+	for (i = 0; i < set->count; i++)
+	{
+		rule = &set->rule[i];
+		if ( (rule_calendar(rule) != calendar) || (year < rule->start_year) ||
+			 ( (rule->final_year) && (year > rule->final_year) ) )
+			continue;
+		switch (rule->type)
+		{
+		case HDATE_CUSTOM_DAY_HEBREW:    found = hebrew_occurrence(rule, year, &jd); break;
+		case HDATE_CUSTOM_DAY_GREGORIAN: found = gregorian_occurrence(rule, year, &jd); break;
+		default:                         found = nth_weekday_occurrence(rule, year, &jd); break;
+		}
+		if (!found) continue;
+		memo->day[memo->count].jd = jd;
+		memo->day[memo->count].rule = i;
+		memo->count++;
+	}
+	qsort(memo->day, memo->count, sizeof(hdate_custom_day), compare_custom_day);
+	return TRUE;
+}
+
+
+/************************************************************
+* year_lookup
+*
+* the memo of a year, evaluating it upon first use. Must be
+* called with set->lock held. Returns NULL upon memory
+* allocation failure.
+************************************************************/
+static const year_memo* year_lookup( hdate_custom_days* set, const int calendar,
+									 const int year )
+{
+	size_t low = 0;
+	size_t high = set->memo_count[calendar];
+	size_t middle;
+	year_memo* memo = set->memo[calendar];
+	year_memo new_memo;
+
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+		if (memo[middle].year < year) low = middle + 1;
+		else high = middle;
+	}
+	if ( (low < set->memo_count[calendar]) && (memo[low].year == year) )
+		return &memo[low];
+
+	if (set->memo_count[calendar] == set->memo_size[calendar])
+	{
+		memo = realloc(memo, (set->memo_size[calendar] * 2 + 8) * sizeof(year_memo));
+		if (memo == NULL) return NULL;
+		set->memo[calendar] = memo;
+		set->memo_size[calendar] = set->memo_size[calendar] * 2 + 8;
+	}
+	if (!evaluate_year(set, calendar, year, &new_memo)) return NULL;
+	memmove(&memo[low + 1], &memo[low],
+			(set->memo_count[calendar] - low) * sizeof(year_memo));
+	memo[low] = new_memo;
+	set->memo_count[calendar]++;
+	return &memo[low];
+}
+
+
+/**
+ @brief   set a rule to the defaults of the custom_days file: no
+          adjustments, Cheshvan 30, Kislev 30, 29 February and Adar I 30
+          on the following day in years without them, Adar I 1 - 29
+          skipped in years without Adar I, Adar II on Adar in years
+          without Adar II, and Adar on Adar II in leap years
+ @param rule  the rule to set
+*/
+void hdate_custom_day_rule_init( hdate_custom_day_rule* rule )
+{
+	memset(rule, 0, sizeof(hdate_custom_day_rule));
+	rule->type = HDATE_CUSTOM_DAY_HEBREW;
+	rule->cheshvan_30 = 1;
+	rule->kislev_30 = 1;
+	rule->february_29 = 1;
+	rule->adar_I = 0;
+	rule->adar_I_30 = 1;
+	rule->adar_II = -1;
+	rule->adar_in_leap_year = 2;
+}
+
+
+/**
+ @brief   check that a rule's fields are all within their ranges
+ @return  non-zero if the rule is valid, otherwise 0
+ @param rule  the rule to check
+*/
+int hdate_custom_day_rule_valid( hdate_custom_day_rule const* rule )
+{
+	int lower, upper, i;
+
+	switch (rule->type)
+	{
+	case HDATE_CUSTOM_DAY_HEBREW:
+		if ( (rule->month < 1) || (rule->month > 14) ||
+			 (rule->day_of_month < 1) || (rule->day_of_month > 30) )
+			return FALSE;
+		break;
+	case HDATE_CUSTOM_DAY_GREGORIAN:
+		if ( (rule->month < 1) || (rule->month > 12) ||
+			 (rule->day_of_month < 1) || (rule->day_of_month > 31) )
+			return FALSE;
+		break;
+	case HDATE_CUSTOM_DAY_HEBREW_NTH:
+	case HDATE_CUSTOM_DAY_GREGORIAN_NTH:
+		if ( (rule->month < 1) ||
+			 (rule->month > ((rule->type == HDATE_CUSTOM_DAY_HEBREW_NTH) ? 14 : 12)) ||
+			 (rule->nth < 1) || (rule->nth > 5) ||
+			 (rule->day_of_week < 1) || (rule->day_of_week > 7) )
+			return FALSE;
+		break;
+	default:
+		return FALSE;
+	}
+
+	if (rule_calendar(rule) == CALENDAR_HEBREW)
+	{
+		lower = HDATE_HEB_YR_LOWER_BOUND;
+		upper = HDATE_HEB_YR_UPPER_BOUND;
+	}
+	else
+	{
+		lower = HDATE_GREG_YR_LOWER_BOUND;
+		upper = HDATE_GREG_YR_UPPER_BOUND;
+	}
+	if ( (rule->start_year < lower) || (rule->start_year > upper) ||
+		 ( (rule->final_year) &&
+		   ( (rule->final_year < rule->start_year) || (rule->final_year > upper) ) ) )
+		return FALSE;
+
+	for (i = 0; i < 7; i++)
+		if ( (rule->adj[i] < -MAX_ADJUSTMENT) || (rule->adj[i] > MAX_ADJUSTMENT) )
+			return FALSE;
+
+	if ( (rule->cheshvan_30 < -1) || (rule->cheshvan_30 > 1) ||
+		 (rule->kislev_30 < -1) || (rule->kislev_30 > 1) ||
+		 (rule->february_29 < -1) || (rule->february_29 > 1) ||
+		 (rule->adar_I < 0) || (rule->adar_I > 1) ||
+		 (rule->adar_I_30 < -1) || (rule->adar_I_30 > 1) ||
+		 (rule->adar_II < -1) || (rule->adar_II > 1) ||
+		 (rule->adar_in_leap_year < 1) || (rule->adar_in_leap_year > 2) )
+		return FALSE;
+	return TRUE;
+}
+
+
+/**
+ @brief   compile a set of custom day rules
+ @return  the set, to be released with hdate_custom_days_free, or
+          NULL if a rule is invalid (see hdate_custom_day_rule_valid)
+          or upon memory allocation failure
+ @param rules  the rules; they are copied
+ @param count  number of rules
+*/
+hdate_custom_days* hdate_custom_days_new( const hdate_custom_day_rule* rules,
+										  const size_t count )
+{
+	hdate_custom_days* set;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+		if (!hdate_custom_day_rule_valid(&rules[i])) return NULL;
+
+	set = calloc(1, sizeof(hdate_custom_days));
+	if (set == NULL) return NULL;
+	set->rule = malloc( (count + 1) * sizeof(hdate_custom_day_rule) );
+	if (set->rule == NULL)
+	{
+		free(set);
+		return NULL;
+	}
+	if (count) memcpy(set->rule, rules, count * sizeof(hdate_custom_day_rule));
+	set->count = count;
+	for (i = 0; i < count; i++) set->has_calendar[rule_calendar(&rules[i])] = TRUE;
+	pthread_mutex_init(&set->lock, NULL);
+	return set;
+}
+
+
+/**
+ @brief   release a set built by hdate_custom_days_new
+ @param set  the set; may be NULL
+*/
+void hdate_custom_days_free( hdate_custom_days* set )
+{
+	int calendar;
+	size_t i;
+
+	if (set == NULL) return;
+	for (calendar = CALENDAR_HEBREW; calendar <= CALENDAR_GREGORIAN; calendar++)
+	{
+		for (i = 0; i < set->memo_count[calendar]; i++) free(set->memo[calendar][i].day);
+		free(set->memo[calendar]);
+	}
+	pthread_mutex_destroy(&set->lock);
+	free(set->rule);
+	free(set);
+}
+
+
+/**
+ @brief   the custom days of a set in a range of julian days. Each
+          year of a calendar is evaluated once, upon first use.
+ @return  the number of custom days in the range, which may be more
+          than max_days, or -1 upon memory allocation failure
+ @param set       as built by hdate_custom_days_new
+ @param jd_first  first julian day of the range
+ @param jd_last   last julian day of the range
+ @param days      receives up to max_days custom days, sorted by julian
+                  day and then by rule; may be NULL if max_days is 0
+ @param max_days  size of days
+*/
+int hdate_custom_days_get( hdate_custom_days* set, const int jd_first,
+						   const int jd_last, hdate_custom_day* days,
+						   const size_t max_days )
+{
+	hdate_custom_day* found = NULL;
+	hdate_custom_day* new_found;
+	size_t found_count = 0;
+	size_t found_size = 0;
+	const year_memo* memo;
+	int calendar, year, year_first, year_last;
+	int day, month, i;
+
+	if ( (set == NULL) || (jd_last < jd_first) ) return 0;
+
+	pthread_mutex_lock(&set->lock);
+	for (calendar = CALENDAR_HEBREW; calendar <= CALENDAR_GREGORIAN; calendar++)
+	{
+		if (!set->has_calendar[calendar]) continue;
+		if (calendar == CALENDAR_HEBREW)
+		{
+			hdate_jd_to_hdate(jd_first - MAX_ADJUSTMENT, &day, &month, &year_first, NULL, NULL);
+			hdate_jd_to_hdate(jd_last + MAX_ADJUSTMENT, &day, &month, &year_last, NULL, NULL);
+			if (year_first < HDATE_HEB_YR_LOWER_BOUND) year_first = HDATE_HEB_YR_LOWER_BOUND;
+			if (year_last > HDATE_HEB_YR_UPPER_BOUND) year_last = HDATE_HEB_YR_UPPER_BOUND;
+		}
+		else
+		{
+			hdate_jd_to_gdate(jd_first - MAX_ADJUSTMENT, &day, &month, &year_first);
+			hdate_jd_to_gdate(jd_last + MAX_ADJUSTMENT, &day, &month, &year_last);
+			if (year_first < HDATE_GREG_YR_LOWER_BOUND) year_first = HDATE_GREG_YR_LOWER_BOUND;
+			if (year_last > HDATE_GREG_YR_UPPER_BOUND) year_last = HDATE_GREG_YR_UPPER_BOUND;
+		}
+
+		for (year = year_first; year <= year_last; year++)
+		{
+			memo = year_lookup(set, calendar, year);
+			if (memo == NULL) goto allocation_failure;
+			for (i = 0; i < memo->count; i++)
+			{
+				if ( (memo->day[i].jd < jd_first) || (memo->day[i].jd > jd_last) ) continue;
+				if (found_count == found_size)
+				{
+					new_found = realloc(found, (found_size * 2 + 16) * sizeof(hdate_custom_day));
+					if (new_found == NULL) goto allocation_failure;
+					found = new_found;
+					found_size = found_size * 2 + 16;
+				}
+				found[found_count++] = memo->day[i];
+			}
+		}
+	}
+	pthread_mutex_unlock(&set->lock);
+
+	if (found_count == 0) return 0;
+	qsort(found, found_count, sizeof(hdate_custom_day), compare_custom_day);
+	if (days != NULL)
+		memcpy(days, found, ((found_count < max_days) ? found_count : max_days) *
+							sizeof(hdate_custom_day));
+	free(found);
+	return found_count;
+
+allocation_failure:
+	pthread_mutex_unlock(&set->lock);
+	free(found);
+	return -1;
+}
@@ -0,0 +1,180 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  per-zone, per-year table of local midnights and sunsets, for
+ *  converting instants to civil and Hebrew (sunset-based) dates
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include "hdate.h"
+#include "support.h"
+#include "zdump3.h"
+
+/// julian day number of 1970-01-01
+#define JD_EPOCH 2440588
+#define SECONDS_PER_DAY 86400
+/// sun altitude of sunset, as used by hdate_get_utc_sun_time
+#define SUNSET_DEGREES 90.833
+
+
+/************************************************************
+* local_midnight
+*
+* the instant of local midnight starting julian day jd. When
+* the clocks skip midnight, the day starts at the first local
+* time after it; a day skipped entirely starts and ends at the
+* same instant.
+************************************************************/
+static time_t local_midnight( const zd_zone* zone, const int jd )
+{
+	time_t utc_midnight = (time_t) (jd - JD_EPOCH) * SECONDS_PER_DAY;
+	time_t midnight, later;
+	int utc_offset = 0;
+	int check_offset = 0;
+
+	zdump_offset(zone, utc_midnight, &utc_offset, NULL, NULL);
+	zdump_offset(zone, utc_midnight - utc_offset, &utc_offset, NULL, NULL);
+	midnight = utc_midnight - utc_offset;
+	zdump_offset(zone, midnight, &check_offset, NULL, NULL);
+	if (check_offset != utc_offset)
+	{
+		later = utc_midnight - check_offset;
+		if (later > midnight) midnight = later;
+	}
+	return midnight;
+}
+
+
+/************************************************************
+* sunset_instant
+*
+* the instant of sunset of the solar day of julian day jd, or
+* -1 if the sun does not set.
+************************************************************/
+static time_t sunset_instant( const int jd, const double latitude, const double longitude )
+{
+	int day, month, year, sunrise, sunset;
+
+	hdate_jd_to_gdate(jd, &day, &month, &year);
+	hdate_get_utc_sun_time_deg_seconds(day, month, year, latitude, longitude,
+				SUNSET_DEGREES, &sunrise, &sunset);
+	if ( (sunrise == HDATE_NO_ZMAN) && (sunset == HDATE_NO_ZMAN) ) return -1;
+	return (time_t) (jd - JD_EPOCH) * SECONDS_PER_DAY + sunset;
+}
+
+
+/************************************************************
+* first_after
+*
+* index of the first element of times[0..count) greater than
+* t, or count. times must be ascending.
+************************************************************/
+static int first_after( const time_t* times, const int count, const time_t t )
+{
+	int low = 0;
+	int high = count;
+	int mid;
+
+	while (low < high)
+	{
+		mid = low + (high - low) / 2;
+		if (times[mid] <= t) low = mid + 1;
+		else high = mid;
+	}
+	return low;
+}
+
+
+/**
+ @brief   compute the day table of a gregorian year for a timezone
+          and location
+ @return  0 on success, or a ZD_ error code if the timezone could
+          not be loaded
+ @param table      receives the table
+ @param tzname     timezone name, eg. Asia/Jerusalem; if NULL, the
+                   system timezone
+ @param year       gregorian year
+ @param latitude   latitude to use in calculations
+ @param longitude  longitude to use in calculations
+*/
+int
+hdate_day_table_init( hdate_day_table* table, const char* tzname, const int year,
+					  const double latitude, const double longitude )
+{
+	const zd_zone* zone;
+	int result;
+	int i, jd;
+	time_t sunset;
+
+	result = zdump_zone_open(tzname, &zone);
+	if (result != 0) return result;
+
+	table->year = year;
+	table->jd_first = hdate_gdate_to_jd(1, 1, year);
+	table->days = hdate_gdate_to_jd(1, 1, year + 1) - table->jd_first;
+	table->midnight[0] = local_midnight(zone, table->jd_first);
+	for (i = 0; i < table->days; i++)
+	{
+		jd = table->jd_first + i;
+		table->midnight[i+1] = local_midnight(zone, jd + 1);
+		zdump_offset(zone, table->midnight[i] + (SECONDS_PER_DAY / 2),
+					 &table->utc_offset[i], NULL, NULL);
+		/// far from the zone's meridian, the solar day of the same
+		/// date may set on the civil day before or after
+		sunset = sunset_instant(jd, latitude, longitude);
+		if (sunset >= table->midnight[i+1])
+			sunset = sunset_instant(jd - 1, latitude, longitude);
+		else if ( (sunset != -1) && (sunset < table->midnight[i]) )
+			sunset = sunset_instant(jd + 1, latitude, longitude);
+		/// where the sun does not set, the date changes at midnight
+		if ( (sunset == -1) || (sunset >= table->midnight[i+1]) )
+			sunset = table->midnight[i+1];
+		else if (sunset < table->midnight[i]) sunset = table->midnight[i];
+		table->sunset[i] = sunset;
+	}
+	return 0;
+}
+
+
+/**
+ @brief   the julian day of the local civil date at an instant
+ @return  the julian day, or 0 if t is outside the year of the table
+ @param table  as computed by hdate_day_table_init
+ @param t      seconds from epoch
+*/
+int
+hdate_day_table_civil_jd( hdate_day_table const* table, const time_t t )
+{
+	if ( (t < table->midnight[0]) || (t >= table->midnight[table->days]) ) return 0;
+	return table->jd_first + first_after(table->midnight, table->days + 1, t) - 1;
+}
+
+
+/**
+ @brief   the julian day whose Hebrew date is in effect at an instant;
+          the Hebrew date changes at sunset
+ @return  the julian day, or 0 if t is outside the year of the table.
+          After sunset of December 31st, the result is January 1st of
+          the following year.
+ @param table  as computed by hdate_day_table_init
+ @param t      seconds from epoch
+*/
+int
+hdate_day_table_hebrew_jd( hdate_day_table const* table, const time_t t )
+{
+	if ( (t < table->midnight[0]) || (t >= table->midnight[table->days]) ) return 0;
+	return table->jd_first + first_after(table->sunset, table->days, t);
+}
@@ -0,0 +1,193 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  fixed-format date exchange: ISO-8601 gregorian (YYYY-MM-DD) and
+ *  the canonical numeric Hebrew form (YYYY-MM-DD, Adar I = 13,
+ *  Adar II = 14).
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hdate.h"
+#include "support.h"
+
+/// length of "YYYY-MM-DD", without the terminating null
+#define ISO_DATE_LEN 10
+
+
+/************************************************************
+* iso_digits
+*
+* reads count decimal digits. returns the value, or -1 if
+* any of the characters is not a digit.
+************************************************************/
+static int iso_digits( const char* text, const int count )
+{
+	int i, value = 0;
+
+	for (i=0; i<count; i++)
+	{
+		if ( (text[i] < '0') || (text[i] > '9') ) return -1;
+		value = (value * 10) + (text[i] - '0');
+	}
+	return value;
+}
+
+
+/************************************************************
+* iso_split
+*
+* checks the YYYY-MM-DD layout, and extracts its fields.
+* returns an HDATE_PARSE_ code.
+************************************************************/
+static int iso_split( const char* text, const size_t len,
+					int* year, int* month, int* day )
+{
+	if ( (text == NULL) || (len != ISO_DATE_LEN) ||
+		 (text[4] != '-') || (text[7] != '-') )
+		return HDATE_PARSE_ERR_FORMAT;
+	*year  = iso_digits(text, 4);
+	*month = iso_digits(text + 5, 2);
+	*day   = iso_digits(text + 8, 2);
+	if ( (*year < 0) || (*month < 0) || (*day < 0) )
+		return HDATE_PARSE_ERR_FORMAT;
+	return HDATE_PARSE_SUCCESS;
+}
+
+
+/************************************************************
+* iso_join
+*
+* writes YYYY-MM-DD and a terminating null. returns the
+* length written, or -1 if buffer is too small or a field
+* does not fit.
+************************************************************/
+static int iso_join( char* buffer, const size_t size,
+					const int year, const int month, const int day )
+{
+	if ( (buffer == NULL) || (size < HDATE_ISO_DATE_BUFFER_SIZE) ) return -1;
+	if ( (year < 0) || (year > 9999) || (month < 1) || (month > 99) ||
+		 (day < 1) || (day > 99) )
+		return -1;
+
+	buffer[0] = '0' + (year / 1000);
+	buffer[1] = '0' + (year / 100) % 10;
+	buffer[2] = '0' + (year / 10) % 10;
+	buffer[3] = '0' + (year % 10);
+	buffer[4] = '-';
+	buffer[5] = '0' + (month / 10);
+	buffer[6] = '0' + (month % 10);
+	buffer[7] = '-';
+	buffer[8] = '0' + (day / 10);
+	buffer[9] = '0' + (day % 10);
+	buffer[10] = '\0';
+	return ISO_DATE_LEN;
+}
+
+
+/**
+ @brief   parse an ISO-8601 gregorian date, YYYY-MM-DD
+ @return  HDATE_PARSE_SUCCESS, HDATE_PARSE_ERR_FORMAT, or
+          HDATE_PARSE_ERR_YEAR / _MONTH / _DAY for values out of range
+ @param text  the date; need not be null terminated
+ @param len   number of bytes of text to parse
+ @param h     receives the date; untouched upon error
+*/
+int hdate_parse_iso_gdate( const char* text, const size_t len, hdate_struct* h )
+{
+	int year, month, day, ret_val;
+
+	ret_val = iso_split(text, len, &year, &month, &day);
+	if (ret_val != HDATE_PARSE_SUCCESS) return ret_val;
+
+	if ( (year < HDATE_GREG_YR_LOWER_BOUND) || (year > HDATE_GREG_YR_UPPER_BOUND) )
+		return HDATE_PARSE_ERR_YEAR;
+	if ( (month < 1) || (month > 12) ) return HDATE_PARSE_ERR_MONTH;
+	if ( (day < 1) || (day > hdate_get_size_of_gregorian_month(month, year)) )
+		return HDATE_PARSE_ERR_DAY;
+
+	hdate_set_jd(h, hdate_gdate_to_jd(day, month, year));
+	return HDATE_PARSE_SUCCESS;
+}
+
+
+/**
+ @brief   parse a canonical numeric Hebrew date, YYYY-MM-DD, in which
+          months are numbered 1 (Tishrei) - 12 (Elul), with Adar I = 13
+          and Adar II = 14. In a leap year, Adar must be given as 13 or
+          14; otherwise, 13 and 14 are invalid.
+ @return  HDATE_PARSE_SUCCESS, HDATE_PARSE_ERR_FORMAT, or
+          HDATE_PARSE_ERR_YEAR / _MONTH / _DAY for values out of range
+ @param text  the date; need not be null terminated
+ @param len   number of bytes of text to parse
+ @param h     receives the date; untouched upon error
+*/
+int hdate_parse_iso_hdate( const char* text, const size_t len, hdate_struct* h )
+{
+	int year, month, day, ret_val;
+	int jd, jd_tishrey1, jd_tishrey1_next_year;
+	int size_of_year;
+	int check_day, check_month, check_year;
+
+	ret_val = iso_split(text, len, &year, &month, &day);
+	if (ret_val != HDATE_PARSE_SUCCESS) return ret_val;
+
+	if ( (year < HDATE_HEB_YR_LOWER_BOUND) || (year > HDATE_HEB_YR_UPPER_BOUND) )
+		return HDATE_PARSE_ERR_YEAR;
+	if ( (month < 1) || (month > 14) ) return HDATE_PARSE_ERR_MONTH;
+
+	jd = hdate_hdate_to_jd(day, month, year, &jd_tishrey1, &jd_tishrey1_next_year);
+	size_of_year = jd_tishrey1_next_year - jd_tishrey1;
+	if (size_of_year > 355)
+	{
+		if (month == 6) return HDATE_PARSE_ERR_MONTH;
+	}
+	else if (month > 12) return HDATE_PARSE_ERR_MONTH;
+
+	/// hdate_get_year_type() is not reliable for years before 3744,
+	/// so check the day by converting back from the julian day
+	if ( (day < 1) || (day > 30) ) return HDATE_PARSE_ERR_DAY;
+	hdate_jd_to_hdate(jd, &check_day, &check_month, &check_year, NULL, NULL);
+	if ( (check_day != day) || (check_month != month) || (check_year != year) )
+		return HDATE_PARSE_ERR_DAY;
+
+	hdate_set_jd(h, jd);
+	return HDATE_PARSE_SUCCESS;
+}
+
+
+/**
+ @brief   format the gregorian date of h as ISO-8601, YYYY-MM-DD
+ @return  the length of the string (10), or -1 if buffer is too small
+ @param h       the date
+ @param buffer  receives the null-terminated string
+ @param size    size of buffer; at least HDATE_ISO_DATE_BUFFER_SIZE
+*/
+int hdate_format_iso_gdate( hdate_struct const* h, char* buffer, const size_t size )
+{
+	return iso_join(buffer, size, h->gd_year, h->gd_mon, h->gd_day);
+}
+
+
+/**
+ @brief   format the Hebrew date of h in canonical numeric form,
+          YYYY-MM-DD, with Adar I = 13 and Adar II = 14
+ @return  the length of the string (10), or -1 if buffer is too small
+ @param h       the date
+ @param buffer  receives the null-terminated string
+ @param size    size of buffer; at least HDATE_ISO_DATE_BUFFER_SIZE
+*/
+int hdate_format_iso_hdate( hdate_struct const* h, char* buffer, const size_t size )
+{
+	return iso_join(buffer, size, h->hd_year, h->hd_mon, h->hd_day);
+}
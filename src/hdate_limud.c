@@ -0,0 +1,286 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  limud yomi: daily learning cycles, such as daf yomi, as a
+ *  precomputed table of the unit and page of each day of a cycle
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "hdate.h"
+#include "support.h"
+
+/// The eleventh daf yomi cycle began 02 March 2005
+#define DAF_YOMI_START 2453432
+#define DAF_YOMI_FIRST_CYCLE 11
+
+
+/// The masechtot ketanot at the end of Kodashim share dafim, so
+/// their units are listed by the daf on which each day begins.
+static const hdate_limud_unit daf_yomi[] = {
+{ N_("Berachot"), "ברכות", 2, 63 },
+{ N_("Shabbat"), "שבת", 2, 156 },
+{ N_("Eiruvin"), "עירובין", 2, 104 },
+{ N_("Pesachim"), "פסחים", 2, 120 },
+{ N_("Shekalim"), "שקלים", 2, 21 },
+{ N_("Yoma"), "יומא", 2, 87 },
+{ N_("Sukkah"), "סוכה", 2, 55 },
+{ N_("Beitzah"), "ביצה", 2, 39 },
+{ N_("Rosh_HaShannah"), "ראש_השנה", 2, 34 },
+{ N_("Taanit"), "תענית", 2, 30 },
+{ N_("Megillah"), "מגילה", 2, 31 },
+{ N_("Moed_Katan"), "מועד_קטן", 2, 28 },
+{ N_("Chagigah"), "חגיגה", 2, 26 },
+{ N_("Yevamot"), "יבמות", 2, 121 },
+{ N_("Ketubot"), "כתובות", 2, 111 },
+{ N_("Nedarim"), "נדרים", 2, 90 },
+{ N_("Nazir"), "נזיר", 2, 65 },
+{ N_("Sotah"), "סוטה", 2, 48 },
+{ N_("Gittin"), "גיטין", 2, 89 },
+{ N_("Kiddushin"), "קידושין", 2, 81 },
+{ N_("Bava_Kamma"), "בבא_קמא", 2, 118 },
+{ N_("Bava_Metzia"), "בבא_מציעא", 2, 118 },
+{ N_("Bava_Batra"), "בבא_בתרא", 2, 175 },
+{ N_("Sanhedrin"), "סנהדרין", 2, 112 },
+{ N_("Makkot"), "מכות", 2, 23 },
+{ N_("Shevuot"), "שבועות", 2, 48 },
+{ N_("Avodah_Zara"), "עבודה_זרה", 2, 75 },
+{ N_("Horayot"), "הוריות", 2, 13 },
+{ N_("Zevachim"), "זבחים", 2, 119 },
+{ N_("Menachot"), "מנחות", 2, 109 },
+{ N_("Chullin"), "חולין", 2, 141 },
+{ N_("Bechorot"), "בכורות", 2, 60 },
+{ N_("Erchin"), "ערכין", 2, 33 },
+{ N_("Temurah"), "תמורה", 2, 33 },
+{ N_("Keritut"), "כריתות", 2, 27 },
+{ N_("Meilah"), "מעילה", 2, 20 },
+{ N_("Meilah-Kinnim"), "מעילה_-_קינים", 22, 2 },
+{ N_("Kinnim"), "קינים", 24, 1 },
+{ N_("Kinnim-Tamid"), "קינים_-_תמיד", 25, 1 },
+{ N_("Tamid"), "תמיד", 26, 8 },
+{ N_("Middot"), "מדות", 34, 4 },
+{ N_("Niddah"), "נדה", 2, 72 } };
+
+
+/// day[i] is the unit and page of day i of the cycle, so that a
+/// lookup is a division and an index rather than a search
+struct hdate_limud_cycle
+{
+	int epoch_jd;
+	int first_cycle;
+	int length;					/// days in a cycle
+	hdate_limud_unit* unit;		/// [count]
+	size_t count;
+	struct { int unit; int page; }* day;	/// [length]
+	char* strings;				/// copies of the names
+	int builtin;				/// not to be freed
+};
+
+static hdate_limud_cycle* daf_yomi_cycle = NULL;
+static pthread_once_t daf_yomi_once = PTHREAD_ONCE_INIT;
+
+
+/************************************************************
+* build_daf_yomi
+************************************************************/
+static void build_daf_yomi( void )
+{
+	daf_yomi_cycle = hdate_limud_cycle_new( daf_yomi,
+							sizeof(daf_yomi) / sizeof(daf_yomi[0]),
+							DAF_YOMI_START, DAF_YOMI_FIRST_CYCLE );
+	if (daf_yomi_cycle != NULL) daf_yomi_cycle->builtin = TRUE;
+}
+
+
+/**
+ @brief   define a daily learning cycle
+ @return  the cycle, to be released with hdate_limud_cycle_free, or
+          NULL if a unit has no days or upon memory allocation failure
+ @param units        the units of the cycle, in order; the strings
+                     are copied
+ @param count        number of units
+ @param epoch_jd     julian day on which a cycle began
+ @param first_cycle  the number of that cycle
+*/
+hdate_limud_cycle*
+hdate_limud_cycle_new( const hdate_limud_unit* units, const size_t count,
+					   const int epoch_jd, const int first_cycle )
+{
+	hdate_limud_cycle* cycle;
+	size_t strings_size = 0;
+	size_t i;
+	int length = 0;
+	int day, offset;
+	char* next_string;
+
+	if (count == 0) return NULL;
+	for (i = 0; i < count; i++)
+	{
+		if (units[i].days < 1) return NULL;
+		length += units[i].days;
+		if (units[i].name != NULL) strings_size += strlen(units[i].name) + 1;
+		if (units[i].hebrew_name != NULL) strings_size += strlen(units[i].hebrew_name) + 1;
+	}
+
+	cycle = calloc(1, sizeof(hdate_limud_cycle));
+	if (cycle == NULL) return NULL;
+	cycle->epoch_jd = epoch_jd;
+	cycle->first_cycle = first_cycle;
+	cycle->length = length;
+	cycle->count = count;
+	cycle->unit = malloc( count * sizeof(hdate_limud_unit) );
+	cycle->day = malloc( length * sizeof(cycle->day[0]) );
+	cycle->strings = malloc( strings_size + 1 );
+	if ( (cycle->unit == NULL) || (cycle->day == NULL) || (cycle->strings == NULL) )
+	{
+		hdate_limud_cycle_free(cycle);
+		return NULL;
+	}
+
+	next_string = cycle->strings;
+	day = 0;
+	for (i = 0; i < count; i++)
+	{
+		cycle->unit[i] = units[i];
+		if (units[i].name != NULL)
+		{
+			cycle->unit[i].name = strcpy(next_string, units[i].name);
+			next_string += strlen(next_string) + 1;
+		}
+		if (units[i].hebrew_name != NULL)
+		{
+			cycle->unit[i].hebrew_name = strcpy(next_string, units[i].hebrew_name);
+			next_string += strlen(next_string) + 1;
+		}
+		for (offset = 0; offset < units[i].days; offset++, day++)
+		{
+			cycle->day[day].unit = i;
+			cycle->day[day].page = units[i].first_page + offset;
+		}
+	}
+	return cycle;
+}
+
+
+/**
+ @brief   release a cycle defined by hdate_limud_cycle_new
+ @param cycle  the cycle; may be NULL. The daf yomi cycle of the
+               library is not released.
+*/
+void
+hdate_limud_cycle_free( hdate_limud_cycle* cycle )
+{
+	if ( (cycle == NULL) || (cycle->builtin) ) return;
+	free(cycle->unit);
+	free(cycle->day);
+	free(cycle->strings);
+	free(cycle);
+}
+
+
+/**
+ @brief   the daf yomi (Babylonian Talmud) cycle, from its eleventh
+          cycle, which began 02 March 2005
+ @return  the cycle, owned by the library, or NULL upon memory
+          allocation failure
+*/
+const hdate_limud_cycle*
+hdate_limud_daf_yomi( void )
+{
+	pthread_once(&daf_yomi_once, build_daf_yomi);
+	return daf_yomi_cycle;
+}
+
+
+/**
+ @brief   a unit of a cycle
+ @return  the unit, owned by the cycle, or NULL if there is no such unit
+ @param cycle  the cycle
+ @param unit   index of the unit, as in hdate_limud
+*/
+const hdate_limud_unit*
+hdate_limud_cycle_unit( hdate_limud_cycle const* cycle, const int unit )
+{
+	if ( (cycle == NULL) || (unit < 0) || ((size_t) unit >= cycle->count) )
+		return NULL;
+	return &cycle->unit[unit];
+}
+
+
+/**
+ @brief   the learning of a day
+ @return  non-zero if the cycle had begun by that day, otherwise 0
+ @param cycle   the cycle
+ @param jd      julian day
+ @param limud   receives the learning of the day
+*/
+int
+hdate_limud_get( hdate_limud_cycle const* cycle, const int jd, hdate_limud* limud )
+{
+	int day;
+
+	if ( (cycle == NULL) || (jd < cycle->epoch_jd) ) return FALSE;
+	day = (jd - cycle->epoch_jd) % cycle->length;
+	limud->cycle = cycle->first_cycle + (jd - cycle->epoch_jd) / cycle->length;
+	limud->day = day;
+	limud->unit = cycle->day[day].unit;
+	limud->page = cycle->day[day].page;
+	return TRUE;
+}
+
+
+/**
+ @brief   the learning of a range of days
+ @return  the number of days in the range on which the cycle had begun
+ @param cycle     the cycle
+ @param jd_first  first julian day of the range
+ @param count     number of days in the range
+ @param limud     receives the learning of each day; days before the
+                  cycle began have unit -1
+*/
+size_t
+hdate_limud_get_range( hdate_limud_cycle const* cycle, const int jd_first,
+					   const size_t count, hdate_limud* limud )
+{
+	size_t i = 0;
+	size_t found = 0;
+	int jd = jd_first;
+	int number, day;
+
+	if (cycle == NULL) return 0;
+	for (; (i < count) && (jd < cycle->epoch_jd); i++, jd++)
+	{
+		memset(&limud[i], 0, sizeof(hdate_limud));
+		limud[i].unit = -1;
+	}
+	if (i == count) return 0;
+
+	number = cycle->first_cycle + (jd - cycle->epoch_jd) / cycle->length;
+	day = (jd - cycle->epoch_jd) % cycle->length;
+	for (; i < count; i++, found++)
+	{
+		limud[i].cycle = number;
+		limud[i].day = day;
+		limud[i].unit = cycle->day[day].unit;
+		limud[i].page = cycle->day[day].page;
+		if (++day == cycle->length)
+		{
+			day = 0;
+			number++;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,310 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  nearest-location index: a k-d tree of the zone.tab locations and
+ *  of any cities supplied by the caller
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "hdate.h"
+#include "support.h"
+
+#define EARTH_RADIUS_KM 6371.0
+#define RADIANS(x) ((x) * M_PI / 180.0)
+
+
+/// The tree is implicit: the node of a range of 'order' is the
+/// middle element, splitting the points of the range on axis
+/// (depth % 3) of their unit vectors. Chord length is monotonic
+/// with great-circle distance, so the nearest point in space is
+/// also the nearest on the globe.
+struct hdate_location_index
+{
+	hdate_location* location;	/// [count]
+	double (*point)[3];			/// [count] unit vectors
+	size_t* order;				/// [count] the tree
+	size_t count;
+	char* strings;				/// copies of the names
+};
+
+
+/************************************************************
+* to_unit_vector
+************************************************************/
+static void to_unit_vector( const double latitude, const double longitude, double* point )
+{
+	point[0] = cos(RADIANS(latitude)) * cos(RADIANS(longitude));
+	point[1] = cos(RADIANS(latitude)) * sin(RADIANS(longitude));
+	point[2] = sin(RADIANS(latitude));
+}
+
+
+/************************************************************
+* kd_select
+*
+* partially sorts order[low..high) so that order[nth] holds the
+* point that belongs there when ordered on axis (quickselect)
+************************************************************/
+static void kd_select( const hdate_location_index* index, size_t low, size_t high,
+					   const size_t nth, const int axis )
+{
+	size_t* order = index->order;
+	size_t i, store, swap;
+	double pivot;
+
+	while (high - low > 1)
+	{
+		swap = order[low + (high - low) / 2];
+		order[low + (high - low) / 2] = order[high - 1];
+		order[high - 1] = swap;
+		pivot = index->point[swap][axis];
+		for (i = store = low; i < high - 1; i++)
+		{
+			if (index->point[order[i]][axis] < pivot)
+			{
+				swap = order[i]; order[i] = order[store]; order[store] = swap;
+				store++;
+			}
+		}
+		swap = order[store]; order[store] = order[high - 1]; order[high - 1] = swap;
+		if (store == nth) return;
+		if (nth < store) high = store;
+		else low = store + 1;
+	}
+}
+
+
+/************************************************************
+* kd_build
+************************************************************/
+static void kd_build( const hdate_location_index* index, const size_t low,
+					  const size_t high, const int axis )
+{
+	size_t middle = low + (high - low) / 2;
+
+	if (high - low < 2) return;
+	kd_select(index, low, high, middle, axis);
+	kd_build(index, low, middle, (axis + 1) % 3);
+	kd_build(index, middle + 1, high, (axis + 1) % 3);
+}
+
+
+/************************************************************
+* kd_nearest
+*
+* searches order[low..high) for the point nearest query. If
+* need_tz, only locations with a timezone are considered.
+************************************************************/
+static void kd_nearest( const hdate_location_index* index, const size_t low,
+						const size_t high, const int axis, const double* query,
+						const int need_tz, size_t* best, double* best_d2 )
+{
+	size_t middle, node;
+	double d2, diff;
+	const double* point;
+
+	if (low >= high) return;
+	middle = low + (high - low) / 2;
+	node = index->order[middle];
+	point = index->point[node];
+	d2 = (point[0] - query[0]) * (point[0] - query[0]) +
+		 (point[1] - query[1]) * (point[1] - query[1]) +
+		 (point[2] - query[2]) * (point[2] - query[2]);
+	if ( (d2 < *best_d2) && ((!need_tz) || (index->location[node].tz_name != NULL)) )
+	{
+		*best_d2 = d2;
+		*best = node;
+	}
+	diff = query[axis] - point[axis];
+	if (diff < 0)
+	{
+		kd_nearest(index, low, middle, (axis + 1) % 3, query, need_tz, best, best_d2);
+		if (diff * diff < *best_d2)
+			kd_nearest(index, middle + 1, high, (axis + 1) % 3, query, need_tz, best, best_d2);
+	}
+	else
+	{
+		kd_nearest(index, middle + 1, high, (axis + 1) % 3, query, need_tz, best, best_d2);
+		if (diff * diff < *best_d2)
+			kd_nearest(index, low, middle, (axis + 1) % 3, query, need_tz, best, best_d2);
+	}
+}
+
+
+/************************************************************
+* zone_city_name
+*
+* the city part of a zone name, eg. "New York" for
+* America/New_York, written to buffer
+************************************************************/
+static char* zone_city_name( const char* zone_name, char* buffer )
+{
+	const char* city = strrchr(zone_name, '/');
+	char* ptr;
+
+	strcpy(buffer, (city == NULL) ? zone_name : city + 1);
+	for (ptr = buffer; *ptr != '\0'; ptr++) if (*ptr == '_') *ptr = ' ';
+	return buffer + strlen(buffer) + 1;
+}
+
+
+/**
+ @brief   build a nearest-location index
+ @return  the index, to be released with hdate_location_index_free,
+          or NULL upon memory allocation failure
+ @param cities         locations to include; may be NULL. The strings
+                       are copied.
+ @param count          number of cities
+ @param with_zone_tab  if non-zero, also include the locations of the
+                       system zone.tab file, named for their city, eg.
+                       "New York" for America/New_York
+*/
+hdate_location_index*
+hdate_location_index_new( const hdate_location* cities, const size_t count,
+						  const int with_zone_tab )
+{
+	hdate_location_index* index;
+	const hdate_zone_tab_entry* zone;
+	size_t zone_count = 0;
+	size_t strings_size = 0;
+	size_t i;
+	char* next_string;
+
+	if (with_zone_tab) zone_count = hdate_zone_tab_count();
+	for (i = 0; i < count; i++)
+	{
+		if (cities[i].name != NULL) strings_size += strlen(cities[i].name) + 1;
+		if (cities[i].tz_name != NULL) strings_size += strlen(cities[i].tz_name) + 1;
+	}
+	for (i = 0; i < zone_count; i++)
+		strings_size += strlen(hdate_zone_tab_get(i)->name) + 1;
+
+	index = calloc(1, sizeof(hdate_location_index));
+	if (index == NULL) return NULL;
+	index->count = count + zone_count;
+	index->location = malloc( (index->count + 1) * sizeof(hdate_location) );
+	index->point = malloc( (index->count + 1) * sizeof(double[3]) );
+	index->order = malloc( (index->count + 1) * sizeof(size_t) );
+	index->strings = malloc( strings_size + 1 );
+	if ( (index->location == NULL) || (index->point == NULL) ||
+		 (index->order == NULL) || (index->strings == NULL) )
+	{
+		hdate_location_index_free(index);
+		return NULL;
+	}
+
+	next_string = index->strings;
+	for (i = 0; i < count; i++)
+	{
+		index->location[i] = cities[i];
+		if (cities[i].name != NULL)
+		{
+			index->location[i].name = strcpy(next_string, cities[i].name);
+			next_string += strlen(next_string) + 1;
+		}
+		if (cities[i].tz_name != NULL)
+		{
+			index->location[i].tz_name = strcpy(next_string, cities[i].tz_name);
+			next_string += strlen(next_string) + 1;
+		}
+	}
+	for (i = 0; i < zone_count; i++)
+	{
+		zone = hdate_zone_tab_get(i);
+		index->location[count + i].name = next_string;
+		next_string = zone_city_name(zone->name, next_string);
+		index->location[count + i].tz_name = zone->name;
+		index->location[count + i].latitude = zone->latitude;
+		index->location[count + i].longitude = zone->longitude;
+	}
+	for (i = 0; i < index->count; i++)
+	{
+		to_unit_vector(index->location[i].latitude, index->location[i].longitude,
+					   index->point[i]);
+		index->order[i] = i;
+	}
+	kd_build(index, 0, index->count, 0);
+	return index;
+}
+
+
+/**
+ @brief   release an index built by hdate_location_index_new
+ @param index  the index; may be NULL
+*/
+void
+hdate_location_index_free( hdate_location_index* index )
+{
+	if (index == NULL) return;
+	free(index->location);
+	free(index->point);
+	free(index->order);
+	free(index->strings);
+	free(index);
+}
+
+
+/**
+ @brief   the location nearest a point
+ @return  the location, owned by the index, or NULL if the index
+          is empty
+ @param index        as built by hdate_location_index_new
+ @param latitude     of the point
+ @param longitude    of the point
+ @param distance_km  if not NULL, receives the great-circle distance
+*/
+const hdate_location*
+hdate_location_nearest( hdate_location_index const* index,
+						const double latitude, const double longitude,
+						double* distance_km )
+{
+	double query[3];
+	double best_d2 = HUGE_VAL;
+	size_t best = 0;
+
+	if ( (index == NULL) || (index->count == 0) ) return NULL;
+	to_unit_vector(latitude, longitude, query);
+	kd_nearest(index, 0, index->count, 0, query, FALSE, &best, &best_d2);
+	if (distance_km != NULL) *distance_km = 2 * EARTH_RADIUS_KM * asin(sqrt(best_d2) / 2);
+	return &index->location[best];
+}
+
+
+/**
+ @brief   the timezone for a point, taken from the nearest location
+          that has one. Without zone boundary data, this is an
+          approximation that may be wrong close to a border.
+ @return  the timezone name, owned by the index, or NULL if no
+          location in the index has a timezone
+ @param index        as built by hdate_location_index_new
+ @param latitude     of the point
+ @param longitude    of the point
+*/
+const char*
+hdate_location_timezone( hdate_location_index const* index,
+						 const double latitude, const double longitude )
+{
+	double query[3];
+	double best_d2 = HUGE_VAL;
+	size_t best = 0;
+
+	if ( (index == NULL) || (index->count == 0) ) return NULL;
+	to_unit_vector(latitude, longitude, query);
+	kd_nearest(index, 0, index->count, 0, query, TRUE, &best, &best_d2);
+	if (best_d2 == HUGE_VAL) return NULL;
+	return index->location[best].tz_name;
+}
@@ -56,6 +56,9 @@ typedef struct {
 	int prefer_parm;
 	int base_year_h;
 	int base_year_g;
+	hdate_struct const *reference;	/// stands in for 'today'
+	int error;						/// HDATE_PARSE_ERR_*
+	int error_parm;					/// 1 - 3 = parm a - c; 0 = unknown
 	} parse_date_struct;
 
 static char * day_text		 = N_("day");
@@ -76,6 +79,18 @@ void print_parm_mismatch_error()
 			N_("month and year parameters mismatched (Hebrew/gregorian mix)"));
 }
 
+/****************************************************
+* set_parse_error
+*   records an error for the caller, instead of
+*   printing it. Always returns FALSE.
+***************************************************/
+static int set_parse_error( parse_date_struct* p, const int error_code, const int parm )
+{
+	p->error = error_code;
+	p->error_parm = parm;
+	return FALSE;
+}
+
 
 
 /****************************************************
@@ -116,7 +131,7 @@ int hdate_get_size_of_gregorian_month( const unsigned int month, const unsigned
 	if ((month < 1) || (month > 12) || (year < HDATE_GREG_YR_LOWER_BOUND) || (year > HDATE_GREG_YR_UPPER_BOUND)) return -1;
 	switch (month)
 	{
-	case 1: case 3: case 5: case 7: case 10: case 12: return 31; break;
+	case 1: case 3: case 5: case 7: case 8: case 10: case 12: return 31; break;
 	case 4: case 6: case 9: case 11: return 30; break;
 	case 2:
 		if (year%4) return 28;
@@ -132,7 +147,7 @@ int hdate_get_size_of_gregorian_month( const unsigned int month, const unsigned
 /****************************************************
 * initial_parse
 ***************************************************/
-int initial_parse( const char* parm_str, int* parm_val, int* parm_id, parse_date_struct* p )
+int initial_parse( const char* parm_str, int* parm_val, int* parm_id, parse_date_struct* p, const int parm )
 {
 	const char* digits = "0123456789";
 	int parm_span, parm_len;
@@ -144,7 +159,7 @@ int initial_parse( const char* parm_str, int* parm_val, int* parm_id, parse_date
 		*parm_val = atoi(parm_str);
 		if (   (*parm_val > HDATE_HEB_YR_UPPER_BOUND) ||
 			 ( (*parm_val < YR_LOWER_4_BOUND) && (*parm_val > YR_UPPER_2_BOUND) ) )
-			{print_parm_error(year_text); return FALSE;}
+			return set_parse_error(p, HDATE_PARSE_ERR_YEAR, parm);
 		else
 		{
 			if (*parm_val <= GDAY_UPPER_BOUND) return TRUE;
@@ -155,7 +170,7 @@ int initial_parse( const char* parm_str, int* parm_val, int* parm_id, parse_date
 	else
 	{
 		*parm_val = hdate_parse_month_text_string(parm_str);
-		if (!*parm_val) {print_parm_error(month_text); return FALSE;}
+		if (!*parm_val) return set_parse_error(p, HDATE_PARSE_ERR_MONTH, parm);
 		*parm_id = MUST_BE_MONTH;
 		*p->ret_month = *parm_val;
 	}
@@ -209,10 +224,10 @@ int second_parse( int a, int b, parse_date_struct* p)
 	if (*p->ret_year >= HDATE_HEB_YR_LOWER_BOUND)
 	{
 		if ((a > HDAY_UPPER_BOUND) || (b > HDAY_UPPER_BOUND))
-						{print_parm_error(day_text); return FALSE;};
+						return set_parse_error(p, HDATE_PARSE_ERR_DAY, 0);
 		if (b > HMONTH_UPPER_BOUND)
 		{
-			if (a > HMONTH_UPPER_BOUND)	{print_parm_error(month_text); return FALSE;}
+			if (a > HMONTH_UPPER_BOUND)	return set_parse_error(p, HDATE_PARSE_ERR_MONTH, 0);
 			*p->ret_month = a + 100;
 			*p->ret_day = b;
 		}
@@ -230,7 +245,7 @@ int second_parse( int a, int b, parse_date_struct* p)
 		//				{print_parm_error(day_text); return FALSE;};
 		if (a > GMONTH_UPPER_BOUND)
 		{
-			if (b > GMONTH_UPPER_BOUND)	{print_parm_error(month_text); return FALSE;}
+			if (b > GMONTH_UPPER_BOUND)	return set_parse_error(p, HDATE_PARSE_ERR_MONTH, 0);
 			*p->ret_month = b;
 			*p->ret_day = a;
 		}
@@ -244,7 +259,7 @@ int second_parse( int a, int b, parse_date_struct* p)
 	{
 		if (a > HMONTH_UPPER_BOUND)
 		{
-			if (b > HMONTH_UPPER_BOUND)	{print_parm_error(month_text); return FALSE;}
+			if (b > HMONTH_UPPER_BOUND)	return set_parse_error(p, HDATE_PARSE_ERR_MONTH, 0);
 			if ( (b > GMONTH_UPPER_BOUND) || (p->prefer_hebrew) )
 			{
 				*p->ret_month = b + 100;
@@ -380,10 +395,9 @@ int hebrew_three_parm_parse( parse_date_struct* p )
 /****************************************************
 * gregorian_three_parm_parse
 ***************************************************/
-int gregorian_three_parm_parse()
+int gregorian_three_parm_parse( parse_date_struct* p )
 {
-	printf("ERROR: reached function gregorian_three_parm_parse in local_functions, but it hasn't been coded yet\n");
-	return TRUE;
+	return set_parse_error(p, HDATE_PARSE_ERR_UNSUPPORTED, 0);
 }
 
 
@@ -423,131 +437,114 @@ int gregorian_three_parm_parse()
 	// char* locale_time_settings_string = setlocale(LC_TIME, "");
 	// or peek in /usr/share/i18n/locales
 	// or something simpler?
-int hdate_parse_date( const char* parm_a, const char* parm_b, const char* parm_c,
-					 int* ret_year, int* ret_month, int* ret_day, const int parm_cnt,
-					 const int prefer_hebrew, const int prefer_parm,
-					 const int base_year_h, const int base_year_g )
+static int parse_date_core( const char* parm_a, const char* parm_b, const char* parm_c,
+					 const int parm_cnt, parse_date_struct* p )
 {
-	hdate_struct h;
-	parse_date_struct p;
-
-	p.a_id = UNKNOWN_STATE;
-	p.b_id = UNKNOWN_STATE;
-	p.c_id = UNKNOWN_STATE;
-	p.a_val = BAD_DATE_VALUE;
-	p.b_val = BAD_DATE_VALUE;
-	p.c_val = BAD_DATE_VALUE;
-	p.ret_year = ret_year;
-	p.ret_month = ret_month;
-	p.ret_day = ret_day;
-	p.prefer_hebrew = prefer_hebrew;
-	p.prefer_parm = prefer_parm;
-	p.base_year_g = base_year_g;
-	p.base_year_h = base_year_h;
+	hdate_struct const *h = p->reference;
+	const int base_year_h = p->base_year_h;
+	const int base_year_g = p->base_year_g;
+
+	p->a_id = UNKNOWN_STATE;
+	p->b_id = UNKNOWN_STATE;
+	p->c_id = UNKNOWN_STATE;
+	p->a_val = BAD_DATE_VALUE;
+	p->b_val = BAD_DATE_VALUE;
+	p->c_val = BAD_DATE_VALUE;
+	p->error = HDATE_PARSE_SUCCESS;
+	p->error_parm = 0;
 
 	switch (parm_cnt)
 	{
-	case 3:	if (!initial_parse(parm_c, &p.c_val, &p.c_id, &p )) return FALSE;
+	case 3:	if (!initial_parse(parm_c, &p->c_val, &p->c_id, p, 3 )) return FALSE;
 			/// and fall through ...
-	case 2:	if (!initial_parse(parm_b, &p.b_val, &p.b_id, &p )) return FALSE;
+	case 2:	if (!initial_parse(parm_b, &p->b_val, &p->b_id, p, 2 )) return FALSE;
 			/// and fall through ...
-	case 1:	if (!initial_parse(parm_a, &p.a_val, &p.a_id, &p )) return FALSE;
+	case 1:	if (!initial_parse(parm_a, &p->a_val, &p->a_id, p, 1 )) return FALSE;
 			break;
-	default: return FALSE;
+	default: return set_parse_error(p, HDATE_PARSE_ERR_PARM_COUNT, 0);
 	}
 
 	/// The definite ids from the initial parse are alphabetic months
 	/// and four-digit years, and there can only be one of each
-	if ( (p.a_id + p.b_id + p.c_id) >= (MUST_BE_MONTH*2) )
-	{
-		error(0,0,"%s: %s",error_text, N_("multiple month parameters detected"));
-		return FALSE;
-	}
-	if ( ((p.a_id + p.b_id + p.c_id)%10) > MUST_BE_YEAR  )
-	{
-		error(0,0,"%s: %s",error_text, N_("multiple year parameters detected"));
-		return FALSE;
-	}
+	if ( (p->a_id + p->b_id + p->c_id) >= (MUST_BE_MONTH*2) )
+		return set_parse_error(p, HDATE_PARSE_ERR_MULTIPLE_MONTHS, 0);
+	if ( ((p->a_id + p->b_id + p->c_id)%10) > MUST_BE_YEAR  )
+		return set_parse_error(p, HDATE_PARSE_ERR_MULTIPLE_YEARS, 0);
 
 	if (parm_cnt == 1)
 	{
-		*p.ret_day = 0;
-		if (p.a_id == MUST_BE_MONTH)     /// month name was parsed
+		*p->ret_day = 0;
+		if (p->a_id == MUST_BE_MONTH)     /// month name was parsed
 		{
-			hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
-			if (p.a_val > 100)
+			if (p->a_val > 100)
 			{
-				*p.ret_year = h.hd_year;
-				if ( (p.a_val > 112) && (h.hd_size_of_year < 383 ) )
-					*p.ret_month = 106;
+				*p->ret_year = h->hd_year;
+				if ( (p->a_val > 112) && (h->hd_size_of_year < 383 ) )
+					*p->ret_month = 106;
 			}
-			else	*p.ret_year = h.gd_year;
+			else	*p->ret_year = h->gd_year;
 		}
-		else if (p.a_id != MUST_BE_YEAR) /// two-digit value < 32
+		else if (p->a_id != MUST_BE_YEAR) /// two-digit value < 32
 		{
-			if (p.prefer_parm == HDATE_PREFER_YM)
+			if (p->prefer_parm == HDATE_PREFER_YM)
 			{
-				if (!p.prefer_hebrew)
+				if (!p->prefer_hebrew)
 				{
-					if (p.a_val <= GMONTH_UPPER_BOUND)
+					if (p->a_val <= GMONTH_UPPER_BOUND)
 					{
-						*p.ret_month = p.a_val;
-						hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
-						*p.ret_year = h.gd_year;
+						*p->ret_month = p->a_val;
+						*p->ret_year = h->gd_year;
 					}
 					else
 					{
-						*p.ret_month = 0;
-						*p.ret_year = p.a_val + p.base_year_g;
+						*p->ret_month = 0;
+						*p->ret_year = p->a_val + p->base_year_g;
 					}
 				}
-				else /// (p.prefer_hebrew)
+				else /// (p->prefer_hebrew)
 				{
-					if (p.a_val <= HMONTH_UPPER_BOUND)
+					if (p->a_val <= HMONTH_UPPER_BOUND)
 					{
-						hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
-						if ( (p.a_val > GMONTH_UPPER_BOUND) && (h.hd_size_of_year < 383 ) )
+						if ( (p->a_val > GMONTH_UPPER_BOUND) && (h->hd_size_of_year < 383 ) )
 						{
-							*p.ret_month = 0;
-							*p.ret_year = p.a_val + p.base_year_h;
+							*p->ret_month = 0;
+							*p->ret_year = p->a_val + p->base_year_h;
 						}
-						*p.ret_month = p.a_val + 100;
-						*p.ret_year = h.hd_year;;
+						*p->ret_month = p->a_val + 100;
+						*p->ret_year = h->hd_year;;
 					}
 				}
 			}
-			else /// (p.prefer_parm == HDATE_PREFER_MD)
+			else /// (p->prefer_parm == HDATE_PREFER_MD)
 			{
-				if (p.prefer_hebrew)
+				if (p->prefer_hebrew)
 				{
-					hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
-					if (p.a_val <= hdate_get_size_of_hebrew_month(h.hd_mon, h.hd_year_type))
+					if (p->a_val <= hdate_get_size_of_hebrew_month(h->hd_mon, h->hd_year_type))
 					{
-						*p.ret_day = p.a_val;
-						*p.ret_month = h.hd_mon + 100;
-						*p.ret_year = h.hd_year;
+						*p->ret_day = p->a_val;
+						*p->ret_month = h->hd_mon + 100;
+						*p->ret_year = h->hd_year;
 					}
 					else  /// treat as two digit Hebrew year
 					{
-						*p.ret_day = 0;
-						*p.ret_month = 0;
-						*p.ret_year = p.a_val + base_year_h;
+						*p->ret_day = 0;
+						*p->ret_month = 0;
+						*p->ret_year = p->a_val + base_year_h;
 					}
 				}
-				else /// (!p.prefer_hebrew)
+				else /// (!p->prefer_hebrew)
 				{
-					hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
-					if ( p.a_val <= hdate_get_size_of_gregorian_month( h.gd_mon, h.gd_year) )
+					if ( p->a_val <= hdate_get_size_of_gregorian_month( h->gd_mon, h->gd_year) )
 					{
-						*p.ret_day = p.a_val;
-						*p.ret_month = h.gd_mon;
-						*p.ret_year = h.gd_year;
+						*p->ret_day = p->a_val;
+						*p->ret_month = h->gd_mon;
+						*p->ret_year = h->gd_year;
 					}
 					else /// treat as two digit gregorian year
 					{
-						*p.ret_day = 0;
-						*p.ret_month = 0;
-						*p.ret_year = p.a_val + base_year_g;
+						*p->ret_day = 0;
+						*p->ret_month = 0;
+						*p->ret_year = p->a_val + base_year_g;
 					}
 				}
 			}
@@ -557,189 +554,452 @@ int hdate_parse_date( const char* parm_a, const char* parm_b, const char* parm_c
 
 	if (parm_cnt == 2)
 	{
-		switch (p.a_id + p.b_id)
+		switch (p->a_id + p->b_id)
 		{
-	default: error(0,0,"%s: %s",error_text, N_("unexpected error in parse_date\n"));
-			return FALSE;
+	default: return set_parse_error(p, HDATE_PARSE_ERR_UNEXPECTED, 0);
 			break;
 	case 11:	/// MUST_BE_YEAR && MUST_BE_MONTH
-			if ( ( (*p.ret_year >= HDATE_HEB_YR_LOWER_BOUND) && (*p.ret_month < 101) ) ||
-			     ( (*p.ret_year <= HDATE_GREG_YR_UPPER_BOUND) && (*p.ret_month > 100) ) )
-			{
-				print_parm_mismatch_error();
-				return FALSE;
-			}
-			*p.ret_day = 0;
-			if (*p.ret_year <= YR_UPPER_2_BOUND) /// 32-99
-				set_gh_year_month( *p.ret_year, *p.ret_month, &p );
+			if ( ( (*p->ret_year >= HDATE_HEB_YR_LOWER_BOUND) && (*p->ret_month < 101) ) ||
+			     ( (*p->ret_year <= HDATE_GREG_YR_UPPER_BOUND) && (*p->ret_month > 100) ) )
+				return set_parse_error(p, HDATE_PARSE_ERR_MISMATCH, 0);
+			*p->ret_day = 0;
+			if (*p->ret_year <= YR_UPPER_2_BOUND) /// 32-99
+				set_gh_year_month( *p->ret_year, *p->ret_month, p );
 			// TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
 			break;
 	case 10:	/// MUST_BE_MONTH
-			if (p.a_id == MUST_BE_MONTH) *p.ret_year = p.b_val;
-			else  *p.ret_year = p.a_val;
-			if (p.prefer_parm == HDATE_PREFER_YM)
+			if (p->a_id == MUST_BE_MONTH) *p->ret_year = p->b_val;
+			else  *p->ret_year = p->a_val;
+			if (p->prefer_parm == HDATE_PREFER_YM)
 			{
-				*p.ret_day = 0;
-				set_gh_year_month( *p.ret_year, *p.ret_month, &p );
+				*p->ret_day = 0;
+				set_gh_year_month( *p->ret_year, *p->ret_month, p );
 			}
 			else /// prefer two parm as dd mm
 			{
-				/// *p.ret_year is temporarily
+				/// *p->ret_year is temporarily
 				/// holding the expected day value
-				if (*p.ret_month > 100)
+				if (*p->ret_month > 100)
 				{
-					if (*p.ret_year > HDAY_UPPER_BOUND)
+					if (*p->ret_year > HDAY_UPPER_BOUND)
 					{
-						*p.ret_day = 0;
-						set_gh_year_month( *p.ret_year, *p.ret_month, &p );
+						*p->ret_day = 0;
+						set_gh_year_month( *p->ret_year, *p->ret_month, p );
 					}
 					else
 					{
-						*p.ret_day = *p.ret_year;
-						hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
-						*p.ret_year = h.hd_year;
+						*p->ret_day = *p->ret_year;
+						*p->ret_year = h->hd_year;
 					}
 				}
 				else
 				{
-					*p.ret_day = *p.ret_year;
-					hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
-					*p.ret_year = h.gd_year;
+					*p->ret_day = *p->ret_year;
+					*p->ret_year = h->gd_year;
 				}
 			}
 			break;
 	case  1:	/// MUST_BE_YEAR
 			/// since we have only two parms, and one must be a year
 			/// we insist that the other be a month
-			*p.ret_day = 0;
-			if (p.a_id == MUST_BE_YEAR)
-				 *p.ret_month = p.b_val;
-			else *p.ret_month = p.a_val;
-			if (*p.ret_month > HMONTH_UPPER_BOUND)
-			{
-				print_parm_error(month_text);
-				return FALSE;
-			}
-			if (*p.ret_year >= HDATE_HEB_YR_LOWER_BOUND)
-				set_hmonth( *p.ret_month, &p );
-			else if ( (*p.ret_year >= YR_LOWER_4_BOUND) &&
-					  (*p.ret_month > GMONTH_UPPER_BOUND) )
+			*p->ret_day = 0;
+			if (p->a_id == MUST_BE_YEAR)
+				 *p->ret_month = p->b_val;
+			else *p->ret_month = p->a_val;
+			if (*p->ret_month > HMONTH_UPPER_BOUND)
+				return set_parse_error(p, HDATE_PARSE_ERR_MONTH, 0);
+			if (*p->ret_year >= HDATE_HEB_YR_LOWER_BOUND)
+				set_hmonth( *p->ret_month, p );
+			else if ( (*p->ret_year >= YR_LOWER_4_BOUND) &&
+					  (*p->ret_month > GMONTH_UPPER_BOUND) )
+				return set_parse_error(p, HDATE_PARSE_ERR_MONTH, 0);
+			else if (*p->ret_year <= YR_UPPER_2_BOUND)
 			{
-				print_parm_error(month_text);
-				return FALSE;
-			}
-			else if (*p.ret_year <= YR_UPPER_2_BOUND)
-			{
-				if ( (p.prefer_hebrew) ||
-					 (*p.ret_month > GMONTH_UPPER_BOUND) )
+				if ( (p->prefer_hebrew) ||
+					 (*p->ret_month > GMONTH_UPPER_BOUND) )
 				{
-					*p.ret_year = *p.ret_year + p.base_year_h;
-					set_hmonth( *p.ret_month, &p );
+					*p->ret_year = *p->ret_year + p->base_year_h;
+					set_hmonth( *p->ret_month, p );
 				}
-				else *p.ret_year = *p.ret_year + p.base_year_g;
+				else *p->ret_year = *p->ret_year + p->base_year_g;
 			}
 			return TRUE;
 			break;
 	case  0: /// both parms are in UNKNOWN_STATE
 			 /// ie. numeric, 0 < n < 32
-			if ((p.a_val > HMONTH_UPPER_BOUND) && (p.b_val > HMONTH_UPPER_BOUND))
-				{print_parm_error(month_text); return FALSE;}
-			if ((p.prefer_hebrew) ||
-				((p.a_val > GMONTH_UPPER_BOUND) && (p.b_val > GMONTH_UPPER_BOUND)))
+			if ((p->a_val > HMONTH_UPPER_BOUND) && (p->b_val > HMONTH_UPPER_BOUND))
+				return set_parse_error(p, HDATE_PARSE_ERR_MONTH, 0);
+			if ((p->prefer_hebrew) ||
+				((p->a_val > GMONTH_UPPER_BOUND) && (p->b_val > GMONTH_UPPER_BOUND)))
 			{
-				*p.ret_year = p.a_val + base_year_h;
-				if (p.a_val > HMONTH_UPPER_BOUND)
-					*p.ret_month = p.b_val;
-				else *p.ret_month = p.a_val; /// preference of mm yy
-				set_hmonth( *p.ret_month, &p );
+				*p->ret_year = p->a_val + base_year_h;
+				if (p->a_val > HMONTH_UPPER_BOUND)
+					*p->ret_month = p->b_val;
+				else *p->ret_month = p->a_val; /// preference of mm yy
+				set_hmonth( *p->ret_month, p );
 			}
 			else /// prefer gregorian
 			{
-				*p.ret_year = p.a_val + p.base_year_g;
-				if (p.b_val > GMONTH_UPPER_BOUND)
-					 *p.ret_month = p.a_val;
-				else *p.ret_month = p.b_val;
+				*p->ret_year = p->a_val + p->base_year_g;
+				if (p->b_val > GMONTH_UPPER_BOUND)
+					 *p->ret_month = p->a_val;
+				else *p->ret_month = p->b_val;
 			}
 		}
 		return TRUE;
 	}
 
 	/// three parameters
-	switch (p.a_id + p.b_id + p.c_id)
+	switch (p->a_id + p->b_id + p->c_id)
 	{
-	default: error(0,0,"%s: %s",error_text, N_("unexpected error in parse_date\n"));
-			return FALSE;
+	default: return set_parse_error(p, HDATE_PARSE_ERR_UNEXPECTED, 0);
 			break;
 	case 11:	/// MUST_BE_YEAR && MUST_BE_MONTH
-			if ( ( (*p.ret_year >= HDATE_HEB_YR_LOWER_BOUND) && (*p.ret_month < 101) ) ||
-			     ( (*p.ret_year <= HDATE_GREG_YR_UPPER_BOUND) && (*p.ret_month > 100) ) )
-			{
-				print_parm_mismatch_error();
-				return FALSE;
-			}
-			if (*p.ret_year <= YR_UPPER_2_BOUND) /// 32-99
-				set_gh_year_month( *p.ret_year, *p.ret_month, &p );
-			if (p.a_id == UNKNOWN_STATE) *p.ret_day = p.a_val;
-			else if (p.b_id == UNKNOWN_STATE) *p.ret_day = p.b_val;
-			else *p.ret_day = p.c_val;
+			if ( ( (*p->ret_year >= HDATE_HEB_YR_LOWER_BOUND) && (*p->ret_month < 101) ) ||
+			     ( (*p->ret_year <= HDATE_GREG_YR_UPPER_BOUND) && (*p->ret_month > 100) ) )
+				return set_parse_error(p, HDATE_PARSE_ERR_MISMATCH, 0);
+			if (*p->ret_year <= YR_UPPER_2_BOUND) /// 32-99
+				set_gh_year_month( *p->ret_year, *p->ret_month, p );
+			if (p->a_id == UNKNOWN_STATE) *p->ret_day = p->a_val;
+			else if (p->b_id == UNKNOWN_STATE) *p->ret_day = p->b_val;
+			else *p->ret_day = p->c_val;
 			// TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
 			break;
 	case 10:	/// MUST_BE_MONTH
-			if (p.a_id == MUST_BE_MONTH)
+			if (p->a_id == MUST_BE_MONTH)
 			{
 				/// personal prejudice to prefer mmmm dd yy
-				*p.ret_day = p.b_val; // TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
-				set_gh_year_month( p.c_val, p.a_val, &p );
+				*p->ret_day = p->b_val; // TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
+				set_gh_year_month( p->c_val, p->a_val, p );
 			}
-			else if (p.b_id == MUST_BE_MONTH)
+			else if (p->b_id == MUST_BE_MONTH)
 			{
 				/// prefer dd mmmm yy because its more natural in Hebrew though
 				/// had it been three numeric fields, I would favor yy mm dd
-				*p.ret_day = p.a_val; // TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
-				set_gh_year_month( p.c_val, p.b_val, &p );
+				*p->ret_day = p->a_val; // TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
+				set_gh_year_month( p->c_val, p->b_val, p );
 			}
-			else ///(p.c_id == MUST_BE_MONTH)
+			else ///(p->c_id == MUST_BE_MONTH)
 			{
 				/// tough call - my intuition is yy dd mmmm
-				*p.ret_day = p.b_val; // TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
-				set_gh_year_month( p.a_val, p.c_val, &p );
+				*p->ret_day = p->b_val; // TODO - test that validate_date faults day 31 and some day 30 in Hebrew month
+				set_gh_year_month( p->a_val, p->c_val, p );
 			}
 			break;
 	case  1:	/// MUST_BE_YEAR
-			if      (p.a_id == MUST_BE_YEAR) return second_parse(p.b_val, p.c_val, &p );
-			else if (p.b_id == MUST_BE_YEAR) return second_parse(p.a_val, p.c_val, &p );
-			else return second_parse(p.a_val, p.b_val, &p );
+			if      (p->a_id == MUST_BE_YEAR) return second_parse(p->b_val, p->c_val, p );
+			else if (p->b_id == MUST_BE_YEAR) return second_parse(p->a_val, p->c_val, p );
+			else return second_parse(p->a_val, p->b_val, p );
 			break;
 	case  0: /// all three parms are in UNKNOWN_STATE
 			 /// ie. numeric, 0 < n < 32
-			if ((p.a_val > HMONTH_UPPER_BOUND) &&
-				(p.b_val > HMONTH_UPPER_BOUND) &&
-				(p.c_val > HMONTH_UPPER_BOUND) )
-			{
-				print_parm_error(month_text);
-				return FALSE;
-			}
-			if ( (p.a_val > GMONTH_UPPER_BOUND) &&
-				 (p.b_val > GMONTH_UPPER_BOUND) &&
-				 (p.c_val > GMONTH_UPPER_BOUND) )
+			if ((p->a_val > HMONTH_UPPER_BOUND) &&
+				(p->b_val > HMONTH_UPPER_BOUND) &&
+				(p->c_val > HMONTH_UPPER_BOUND) )
+				return set_parse_error(p, HDATE_PARSE_ERR_MONTH, 0);
+			if ( (p->a_val > GMONTH_UPPER_BOUND) &&
+				 (p->b_val > GMONTH_UPPER_BOUND) &&
+				 (p->c_val > GMONTH_UPPER_BOUND) )
 			{
 				/// MUST be hebrew
-				if ( check_two_of_three_gt( p.a_val, p.b_val, p.c_val, HDAY_UPPER_BOUND ) )
-				{
-					print_parm_mismatch_error();
-					return FALSE;
-				}
-				return hebrew_three_parm_parse( &p );
+				if ( check_two_of_three_gt( p->a_val, p->b_val, p->c_val, HDAY_UPPER_BOUND ) )
+					return set_parse_error(p, HDATE_PARSE_ERR_MISMATCH, 0);
+				return hebrew_three_parm_parse( p );
 			}
-			if ( check_two_of_three_gt( p.a_val, p.b_val, p.c_val, HDAY_UPPER_BOUND ) )
+			if ( check_two_of_three_gt( p->a_val, p->b_val, p->c_val, HDAY_UPPER_BOUND ) )
 			{
-				return gregorian_three_parm_parse();
+				return gregorian_three_parm_parse( p );
 			}
-			if ( (p.prefer_hebrew) &&
-				 ( ! check_two_of_three_gt( p.a_val, p.b_val, p.c_val, HDAY_UPPER_BOUND ) ) )
-				return hebrew_three_parm_parse( &p );
-			else return gregorian_three_parm_parse();
+			if ( (p->prefer_hebrew) &&
+				 ( ! check_two_of_three_gt( p->a_val, p->b_val, p->c_val, HDAY_UPPER_BOUND ) ) )
+				return hebrew_three_parm_parse( p );
+			else return gregorian_three_parm_parse( p );
 			break;
-	} /// end switch (p.a_id + p.b_id + p.c_id)
+	} /// end switch (p->a_id + p->b_id + p->c_id)
 	return TRUE;
 }
+
+
+/************************************************************
+* hdate_parse_date_r
+*
+* reentrant variant of hdate_parse_date: it prints nothing,
+* and rather than reading the system clock for 'today', it
+* uses the caller's reference date. Errors are returned as
+* HDATE_PARSE_ERR_* codes in result->error.
+*
+* When want_candidates is set, the parse is also performed
+* with the opposite prefer_hebrew and prefer_parm settings,
+* and any different readings are returned as candidates, so
+* the caller can tell that the input was ambiguous.
+************************************************************/
+int hdate_parse_date_r( const char* parm_a, const char* parm_b, const char* parm_c,
+					 const int parm_cnt, const int prefer_hebrew, const int prefer_parm,
+					 const int base_year_h, const int base_year_g,
+					 hdate_struct const *reference, const int want_candidates,
+					 hdate_parse_result* result )
+{
+	parse_date_struct p;
+	hdate_parse_candidate alt;
+	int i, j;
+
+	result->date.year = 0;
+	result->date.month = 0;
+	result->date.day = 0;
+	result->candidate_count = 0;
+
+	p.ret_year = &result->date.year;
+	p.ret_month = &result->date.month;
+	p.ret_day = &result->date.day;
+	p.prefer_hebrew = prefer_hebrew;
+	p.prefer_parm = prefer_parm;
+	p.base_year_g = base_year_g;
+	p.base_year_h = base_year_h;
+	p.reference = reference;
+
+	parse_date_core( parm_a, parm_b, parm_c, parm_cnt, &p );
+	result->error = p.error;
+	result->error_parm = p.error_parm;
+	if ( (result->error != HDATE_PARSE_SUCCESS) || (!want_candidates) )
+		return result->error;
+
+	/// i = 1 flips prefer_hebrew, i = 2 flips prefer_parm, i = 3 both
+	for (i=1; i<4; i++)
+	{
+		alt.year = 0;
+		alt.month = 0;
+		alt.day = 0;
+		p.ret_year = &alt.year;
+		p.ret_month = &alt.month;
+		p.ret_day = &alt.day;
+		p.prefer_hebrew = (i & 1) ? !prefer_hebrew : prefer_hebrew;
+		p.prefer_parm = (i & 2) ? !prefer_parm : prefer_parm;
+		if (!parse_date_core( parm_a, parm_b, parm_c, parm_cnt, &p )) continue;
+
+		if ( (alt.year == result->date.year) && (alt.month == result->date.month) &&
+			 (alt.day == result->date.day) ) continue;
+		for (j=0; j<result->candidate_count; j++)
+			if ( (alt.year == result->candidate[j].year) &&
+				 (alt.month == result->candidate[j].month) &&
+				 (alt.day == result->candidate[j].day) ) break;
+		if (j == result->candidate_count)
+		{
+			result->candidate[j] = alt;
+			result->candidate_count++;
+		}
+	}
+	return HDATE_PARSE_SUCCESS;
+}
+
+
+/************************************************************
+* hdate_parse_date
+*
+* currently returns TRUE on success, or reports the error
+* to stderr and returns FALSE. Ambiguous parameters are
+* resolved relative to today's date.
+************************************************************/
+int hdate_parse_date( const char* parm_a, const char* parm_b, const char* parm_c,
+					 int* ret_year, int* ret_month, int* ret_day, const int parm_cnt,
+					 const int prefer_hebrew, const int prefer_parm,
+					 const int base_year_h, const int base_year_g )
+{
+	hdate_struct h;
+	parse_date_struct p;
+
+	hdate_set_gdate (&h, 0, 0, 0);	/// set date for today
+
+	p.ret_year = ret_year;
+	p.ret_month = ret_month;
+	p.ret_day = ret_day;
+	p.prefer_hebrew = prefer_hebrew;
+	p.prefer_parm = prefer_parm;
+	p.base_year_g = base_year_g;
+	p.base_year_h = base_year_h;
+	p.reference = &h;
+
+	if (parse_date_core( parm_a, parm_b, parm_c, parm_cnt, &p )) return TRUE;
+
+	switch (p.error)
+	{
+	case HDATE_PARSE_ERR_YEAR: print_parm_error(year_text); break;
+	case HDATE_PARSE_ERR_MONTH: print_parm_error(month_text); break;
+	case HDATE_PARSE_ERR_DAY: print_parm_error(day_text); break;
+	case HDATE_PARSE_ERR_MISMATCH: print_parm_mismatch_error(); break;
+	case HDATE_PARSE_ERR_MULTIPLE_MONTHS:
+		error(0,0,"%s: %s",error_text, N_("multiple month parameters detected"));
+		break;
+	case HDATE_PARSE_ERR_MULTIPLE_YEARS:
+		error(0,0,"%s: %s",error_text, N_("multiple year parameters detected"));
+		break;
+	case HDATE_PARSE_ERR_PARM_COUNT: break;
+	case HDATE_PARSE_ERR_UNSUPPORTED:
+		printf("ERROR: reached function gregorian_three_parm_parse in local_functions, but it hasn't been coded yet\n");
+		return TRUE;
+	default:
+		error(0,0,"%s: %s",error_text, N_("unexpected error in parse_date\n"));
+		break;
+	}
+	return FALSE;
+}
+
+
+/************************************************************
+* bulk_date_to_jd
+*
+* validates the day against the length of the month, and
+* converts a parsed date (month 101 - 114 for Hebrew) to a
+* julian day number. Returns an HDATE_PARSE_ code.
+************************************************************/
+static int bulk_date_to_jd( const int year, const int month, const int day, int* jd )
+{
+	int jd_tishrey1, jd_tishrey1_next_year;
+	int size_of_year, year_type;
+
+	if (month == 0) return HDATE_PARSE_ERR_INCOMPLETE;
+	if (day == 0) return HDATE_PARSE_ERR_INCOMPLETE;
+
+	if (month > 100)
+	{
+		if ( (year < HDATE_HEB_YR_LOWER_BOUND) || (year > HDATE_HEB_YR_UPPER_BOUND) )
+			return HDATE_PARSE_ERR_YEAR;
+		*jd = hdate_hdate_to_jd( day, month - 100, year, &jd_tishrey1, &jd_tishrey1_next_year );
+		size_of_year = jd_tishrey1_next_year - jd_tishrey1;
+		/// Adar I/II exist only in leap years
+		if ( (month > 112) && (size_of_year < 383) ) return HDATE_PARSE_ERR_MONTH;
+		year_type = hdate_get_year_type( size_of_year, (jd_tishrey1 + 1) % 7 + 1 );
+		if (day > hdate_get_size_of_hebrew_month( month - 100, year_type ))
+			return HDATE_PARSE_ERR_DAY;
+		return HDATE_PARSE_SUCCESS;
+	}
+
+	if ( (year < HDATE_GREG_YR_LOWER_BOUND) || (year > HDATE_GREG_YR_UPPER_BOUND) )
+		return HDATE_PARSE_ERR_YEAR;
+	if (day > hdate_get_size_of_gregorian_month( month, year ))
+		return HDATE_PARSE_ERR_DAY;
+	*jd = hdate_gdate_to_jd( day, month, year );
+	return HDATE_PARSE_SUCCESS;
+}
+
+
+/************************************************************
+* hdate_parse_date_bulk
+*
+* parses a buffer of date strings, one per row, into julian
+* day numbers. Within a row, fields may be separated by
+* spaces, tabs, '/', '-', '.' or ',' (unless that character
+* is the row delimiter). Adjacent non-numeric fields are
+* rejoined with a space, so that names such as "Adar II" or
+* "Menachem-Av" reach the month parser intact. Each row is
+* then parsed by the same logic as hdate_parse_date_r.
+*
+* returns the number of rows parsed. Rows with errors get
+* jd 0 and a non-zero row_error code. Unless at_end, a last
+* row without its delimiter is left for the next buffer.
+************************************************************/
+size_t hdate_parse_date_bulk( const char* buffer, const size_t len, const char delimiter,
+					 const int at_end,
+					 const int prefer_hebrew, const int prefer_parm,
+					 const int base_year_h, const int base_year_g,
+					 hdate_struct const *reference,
+					 int* jd, int* row_error, const size_t max_rows,
+					 size_t* bytes_used )
+{
+	char row[HDATE_PARSE_BULK_ROW_MAX];
+	char* parm[3];
+	const char* row_start;
+	const char* row_end;
+	const char* buffer_end = buffer + len;
+	parse_date_struct p;
+	int year, month, day;
+	int parm_cnt, prev_numeric, numeric, prev_end, token_start;
+	size_t i, row_len, rows = 0;
+	unsigned char c;
+
+	p.ret_year = &year;
+	p.ret_month = &month;
+	p.ret_day = &day;
+	p.prefer_hebrew = prefer_hebrew;
+	p.prefer_parm = prefer_parm;
+	p.base_year_g = base_year_g;
+	p.base_year_h = base_year_h;
+	p.reference = reference;
+
+	row_start = buffer;
+	while ( (row_start < buffer_end) && (rows < max_rows) )
+	{
+		row_end = memchr(row_start, delimiter, buffer_end - row_start);
+		if (row_end == NULL)
+		{
+			/// the rest of the row may be in the next buffer
+			if (!at_end) break;
+			row_end = buffer_end;
+		}
+		row_len = row_end - row_start;
+		if ( (row_len > 0) && (row_start[row_len-1] == '\r') ) row_len--;
+
+		jd[rows] = 0;
+		if (row_len >= HDATE_PARSE_BULK_ROW_MAX)
+		{
+			row_error[rows] = HDATE_PARSE_ERR_ROW_LENGTH;
+			goto next_row;
+		}
+
+		/// tokenize a private copy of the row, in place
+		memcpy(row, row_start, row_len);
+		row[row_len] = '\0';
+		parm_cnt = 0;
+		prev_numeric = TRUE;
+		prev_end = -2;
+		token_start = -1;
+		for (i=0; i<=row_len; i++)
+		{
+			c = row[i];
+			if ( (c != ' ') && (c != '\t') && (c != '\0') &&
+				 ( (c == delimiter) ||
+				   ( (c != '/') && (c != '-') && (c != '.') && (c != ',') ) ) )
+			{
+				if (token_start < 0) token_start = i;
+				continue;
+			}
+			row[i] = '\0';
+			if (token_start < 0) continue;
+
+			numeric = ( (row[token_start] >= '0') && (row[token_start] <= '9') );
+			/// rejoin a name split by a single separator, eg. "Adar II"
+			if ( (!numeric) && (!prev_numeric) && (prev_end == token_start - 1) )
+				row[prev_end] = ' ';
+			else if (parm_cnt < 3) parm[parm_cnt++] = &row[token_start];
+			else { parm_cnt++; break; }
+			prev_numeric = numeric;
+			prev_end = i;
+			token_start = -1;
+		}
+
+		if ( (parm_cnt == 0) || (parm_cnt > 3) )
+		{
+			row_error[rows] = HDATE_PARSE_ERR_PARM_COUNT;
+			goto next_row;
+		}
+		for (i=parm_cnt; i<3; i++) parm[i] = "";
+
+		year = 0;
+		month = 0;
+		day = 0;
+		if (!parse_date_core( parm[0], parm[1], parm[2], parm_cnt, &p ))
+			row_error[rows] = p.error;
+		else row_error[rows] = bulk_date_to_jd( year, month, day, &jd[rows] );
+		if (row_error[rows] != HDATE_PARSE_SUCCESS) jd[rows] = 0;
+
+next_row:
+		rows++;
+		row_start = row_end + 1;
+	}
+
+	if (bytes_used != NULL)
+	{
+		if (row_start > buffer_end) row_start = buffer_end;
+		*bytes_used = row_start - buffer;
+	}
+	return rows;
+}
@@ -0,0 +1,725 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  calendar snapshot: a file of precomputed holidays, parashiot,
+ *  custom days and dst transitions for a range of years and a set
+ *  of locations, mmap'ed for use without recomputation
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE		/// for asprintf, mkstemp, st_mtim
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>		/// for close, unlink
+#include <fcntl.h>		/// for open
+#include <sys/stat.h>	/// for stat
+#include <sys/mman.h>	/// for mmap
+#include "hdate.h"
+#include "support.h"
+#include "zdump3.h"
+
+#define SNAPSHOT_MAGIC "hdsnap01"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define NO_STRING UINT32_MAX
+#define EPOCH_JD 2440588
+#define SECONDS_PER_DAY 86400
+
+/// The file is the header followed by the sections below, in order,
+/// each padded to a multiple of 8 bytes. All values are in the byte
+/// order of the machine that wrote the file; a snapshot from another
+/// machine, or from another version of the format, is not opened.
+typedef struct
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	int32_t year_first;
+	int32_t year_last;
+	int32_t jd_first;
+	uint32_t day_count;
+	uint32_t has_custom_days;
+	uint32_t custom_day_count;
+	uint32_t location_count;
+	uint32_t transition_count;
+	uint32_t source_count;
+	uint32_t string_size;
+	uint64_t file_size;
+} snapshot_header;
+
+/// a file the snapshot was computed from; if it has changed, the
+/// snapshot is stale
+typedef struct
+{
+	uint32_t path;				/// offset into the strings
+	uint32_t padding;
+	int64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+} snapshot_source;
+
+/// [0] in Israel, [1] in the diaspora
+typedef struct
+{
+	uint8_t halachic[2];
+	uint8_t israeli[2];
+	uint8_t parasha[2];
+	uint8_t padding[2];
+} snapshot_day;
+
+typedef struct
+{
+	int32_t jd;
+	int32_t rule;
+} snapshot_custom_day;
+
+typedef struct
+{
+	uint32_t name;				/// offsets into the strings, or NO_STRING
+	uint32_t tz_name;
+	double latitude;
+	double longitude;
+	uint32_t first_transition;
+	uint32_t transition_count;
+} snapshot_location;
+
+/// the first transition of a location is its state at the
+/// start of the range
+typedef struct
+{
+	int64_t start;				/// seconds from epoch
+	int32_t utc_offset;			/// seconds east of UTC
+	int32_t isdst;
+} snapshot_transition;
+
+struct hdate_snapshot
+{
+	void* map;
+	size_t map_size;
+	const snapshot_header* header;
+	const snapshot_source* source;
+	const snapshot_day* day;
+	const snapshot_custom_day* custom_day;
+	const snapshot_location* location;
+	const snapshot_transition* transition;
+	const char* strings;
+};
+
+
+/************************************************************
+* padded
+************************************************************/
+static size_t padded( const size_t size )
+{
+	return (size + 7) & ~((size_t) 7);
+}
+
+
+/************************************************************
+* snapshot_layout
+*
+* the offset of each section, from the counts of the header;
+* returns the size of the file
+************************************************************/
+static size_t snapshot_layout( const snapshot_header* header, size_t* offset )
+{
+	offset[0] = padded(sizeof(snapshot_header));
+	offset[1] = offset[0] + padded(header->source_count * sizeof(snapshot_source));
+	offset[2] = offset[1] + padded(header->day_count * sizeof(snapshot_day));
+	offset[3] = offset[2] + padded(header->custom_day_count * sizeof(snapshot_custom_day));
+	offset[4] = offset[3] + padded(header->location_count * sizeof(snapshot_location));
+	offset[5] = offset[4] + padded(header->transition_count * sizeof(snapshot_transition));
+	return offset[5] + padded(header->string_size);
+}
+
+
+/************************************************************
+* add_string
+*
+* appends text to the string table, returning its offset
+************************************************************/
+static uint32_t add_string( const char* text, char* strings, uint32_t* string_size )
+{
+	uint32_t offset = *string_size;
+
+	if (text == NULL) return NO_STRING;
+	if (strings != NULL) strcpy(strings + offset, text);
+	*string_size += strlen(text) + 1;
+	return offset;
+}
+
+
+/************************************************************
+* location_transitions
+*
+* the dst transitions of a timezone over the range of the
+* snapshot, malloc'ed into *transition; returns their count,
+* or -1 upon failure
+************************************************************/
+static int location_transitions( const char* tz_name, const time_t start,
+								 const time_t end, snapshot_transition** transition )
+{
+	const zd_zone* zone;
+	zdumpinfo* info = NULL;
+	int count = 0;
+	int i;
+
+	*transition = NULL;
+	if (tz_name == NULL) return 0;
+	if ( (zdump_zone_open(tz_name, &zone) != 0) ||
+		 (zdump_r(zone, start, end, &count, (void**) &info) != 0) ||
+		 (count < 1) )
+	{
+		free(info);
+		return -1;
+	}
+	*transition = malloc(count * sizeof(snapshot_transition));
+	if (*transition == NULL) { free(info); return -1; }
+	for (i = 0; i < count; i++)
+	{
+		(*transition)[i].start = info[i].start;
+		(*transition)[i].utc_offset = info[i].utc_offset;
+		(*transition)[i].isdst = (info[i].save_secs != 0);
+	}
+	free(info);
+	return count;
+}
+
+
+/************************************************************
+* range_seconds
+*
+* the instants covered by the dst transitions of a snapshot:
+* one day beyond the range on either side, for any timezone
+************************************************************/
+static void range_seconds( const int jd_first, const int day_count,
+						   time_t* start, time_t* end )
+{
+	*start = (time_t) (jd_first - EPOCH_JD - 1) * SECONDS_PER_DAY;
+	*end = (time_t) (jd_first + day_count - EPOCH_JD + 1) * SECONDS_PER_DAY;
+}
+
+
+
+/************************************************************
+* write_section
+*
+* writes size bytes of data, then pads them to a multiple of 8
+************************************************************/
+static int write_section( FILE* file, const void* data, const size_t size )
+{
+	static const char zeros[8] = { 0 };
+
+	if ( (size > 0) && (fwrite(data, size, 1, file) != 1) ) return FALSE;
+	if ( (padded(size) > size) &&
+		 (fwrite(zeros, padded(size) - size, 1, file) != 1) ) return FALSE;
+	return TRUE;
+}
+
+
+/************************************************************
+* write_snapshot_file
+*
+* writes the sections to a temporary file beside path, and
+* renames it to path; returns 0, or -1 with errno set
+************************************************************/
+static int write_snapshot_file( const char* path, const snapshot_header* header,
+								const snapshot_source* source, const snapshot_day* day,
+								const snapshot_custom_day* custom_day,
+								const snapshot_location* location,
+								const snapshot_transition* transition,
+								const char* strings )
+{
+	char* temp_path = NULL;
+	FILE* file;
+	int fd;
+	int ok;
+	int saved_errno;
+
+	if (asprintf(&temp_path, "%s.XXXXXX", path) == -1) return -1;
+	fd = mkstemp(temp_path);
+	if (fd == -1) { free(temp_path); return -1; }
+	file = fdopen(fd, "w");
+	if (file == NULL)
+	{
+		saved_errno = errno;
+		close(fd); unlink(temp_path); free(temp_path);
+		errno = saved_errno;
+		return -1;
+	}
+
+	ok = write_section(file, header, sizeof(snapshot_header)) &&
+		 write_section(file, source, header->source_count * sizeof(snapshot_source)) &&
+		 write_section(file, day, header->day_count * sizeof(snapshot_day)) &&
+		 write_section(file, custom_day, header->custom_day_count * sizeof(snapshot_custom_day)) &&
+		 write_section(file, location, header->location_count * sizeof(snapshot_location)) &&
+		 write_section(file, transition, header->transition_count * sizeof(snapshot_transition)) &&
+		 write_section(file, strings, header->string_size);
+	saved_errno = errno;
+	if (fclose(file) != 0) { if (ok) saved_errno = errno; ok = FALSE; }
+	if ( ok && (rename(temp_path, path) != 0) ) { saved_errno = errno; ok = FALSE; }
+	if (!ok) unlink(temp_path);
+	free(temp_path);
+	errno = saved_errno;
+	return ok ? 0 : -1;
+}
+
+
+/**
+ @brief   compute a snapshot of a range of years and write it to a
+          file, replacing any prior file atomically
+ @return  0 on success, or -1 upon failure, with errno set
+ @param path            the snapshot file
+ @param year_first      first gregorian year
+ @param year_last       last gregorian year
+ @param locations       locations whose dst transitions to include;
+                        may be NULL
+ @param location_count  number of locations
+ @param custom_days     custom days to include; may be NULL
+ @param sources         files the snapshot is computed from, eg. a
+                        custom days file. If any of them later
+                        changes, the snapshot will not be opened.
+                        May be NULL.
+ @param source_count    number of sources
+*/
+int
+hdate_snapshot_write( const char* path, const int year_first, const int year_last,
+					  const hdate_location* locations, const size_t location_count,
+					  hdate_custom_days* custom_days,
+					  const char* const* sources, const size_t source_count )
+{
+	snapshot_header header;
+	snapshot_source* source = NULL;
+	snapshot_day* day = NULL;
+	snapshot_custom_day* custom_day = NULL;
+	snapshot_location* location = NULL;
+	snapshot_transition* transition = NULL;
+	snapshot_transition* zone_transition;
+	snapshot_transition* grown;
+	hdate_custom_day* found = NULL;
+	hdate_struct h;
+	struct stat source_stat;
+	char* strings = NULL;
+	time_t start, end;
+	size_t offset[6];
+	size_t i, strings_size = 0;
+	int count, diaspora;
+	int result = -1;
+
+	if ( (year_first < HDATE_GREG_YR_LOWER_BOUND) || (year_last > HDATE_GREG_YR_UPPER_BOUND) ||
+		 (year_first > year_last) )
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.byte_order = SNAPSHOT_BYTE_ORDER;
+	header.year_first = year_first;
+	header.year_last = year_last;
+	header.jd_first = hdate_gdate_to_jd(1, 1, year_first);
+	header.day_count = hdate_gdate_to_jd(1, 1, year_last + 1) - header.jd_first;
+	header.source_count = source_count;
+	header.location_count = location_count;
+	header.has_custom_days = (custom_days != NULL);
+
+	for (i = 0; i < source_count; i++) strings_size += strlen(sources[i]) + 1;
+	for (i = 0; i < location_count; i++)
+	{
+		if (locations[i].name != NULL) strings_size += strlen(locations[i].name) + 1;
+		if (locations[i].tz_name != NULL) strings_size += strlen(locations[i].tz_name) + 1;
+	}
+	errno = ENOMEM;
+	strings = malloc(strings_size + 1);
+	source = calloc(source_count + 1, sizeof(snapshot_source));
+	day = calloc(header.day_count, sizeof(snapshot_day));
+	location = calloc(location_count + 1, sizeof(snapshot_location));
+	if ( (strings == NULL) || (source == NULL) || (day == NULL) || (location == NULL) )
+		goto done;
+
+	for (i = 0; i < source_count; i++)
+	{
+		if (stat(sources[i], &source_stat) != 0) goto done;
+		source[i].path = add_string(sources[i], strings, &header.string_size);
+		source[i].size = source_stat.st_size;
+		source[i].mtime_sec = source_stat.st_mtim.tv_sec;
+		source[i].mtime_nsec = source_stat.st_mtim.tv_nsec;
+	}
+
+	for (i = 0; i < header.day_count; i++)
+	{
+		hdate_set_jd(&h, header.jd_first + i);
+		for (diaspora = 0; diaspora < 2; diaspora++)
+		{
+			day[i].halachic[diaspora] = hdate_get_halachic_day(&h, diaspora);
+			day[i].israeli[diaspora] = hdate_get_israeli_day(&h, diaspora);
+			day[i].parasha[diaspora] = hdate_get_parasha(&h, diaspora);
+		}
+	}
+
+	if (custom_days != NULL)
+	{
+		count = hdate_custom_days_get(custom_days, header.jd_first,
+									  header.jd_first + header.day_count - 1, NULL, 0);
+		if (count < 0) goto done;
+		found = malloc((count + 1) * sizeof(hdate_custom_day));
+		custom_day = malloc((count + 1) * sizeof(snapshot_custom_day));
+		if ( (found == NULL) || (custom_day == NULL) ) goto done;
+		count = hdate_custom_days_get(custom_days, header.jd_first,
+									  header.jd_first + header.day_count - 1, found, count);
+		if (count < 0) goto done;
+		for (i = 0; i < (size_t) count; i++)
+		{
+			custom_day[i].jd = found[i].jd;
+			custom_day[i].rule = found[i].rule;
+		}
+		header.custom_day_count = count;
+	}
+
+	range_seconds(header.jd_first, header.day_count, &start, &end);
+	for (i = 0; i < location_count; i++)
+	{
+		location[i].name = add_string(locations[i].name, strings, &header.string_size);
+		location[i].tz_name = add_string(locations[i].tz_name, strings, &header.string_size);
+		location[i].latitude = locations[i].latitude;
+		location[i].longitude = locations[i].longitude;
+		location[i].first_transition = header.transition_count;
+		count = location_transitions(locations[i].tz_name, start, end, &zone_transition);
+		if (count < 0) { errno = ENOENT; goto done; }
+		if (count == 0) continue;
+		grown = realloc(transition, (header.transition_count + count) * sizeof(snapshot_transition));
+		if (grown == NULL) { free(zone_transition); errno = ENOMEM; goto done; }
+		transition = grown;
+		memcpy(transition + header.transition_count, zone_transition,
+			   count * sizeof(snapshot_transition));
+		free(zone_transition);
+		location[i].transition_count = count;
+		header.transition_count += count;
+	}
+
+	header.file_size = snapshot_layout(&header, offset);
+	result = write_snapshot_file(path, &header, source, day, custom_day,
+								 location, transition, strings);
+
+done:
+	free(strings);
+	free(source);
+	free(day);
+	free(found);
+	free(custom_day);
+	free(location);
+	free(transition);
+	return result;
+}
+
+
+/**
+ @brief   open a snapshot written by hdate_snapshot_write
+ @return  the snapshot, to be released with hdate_snapshot_close, or
+          NULL if the file is absent, is not a snapshot of this
+          version for this machine, or is stale: one of its
+          sources has changed
+ @param path  the snapshot file
+*/
+hdate_snapshot*
+hdate_snapshot_open( const char* path )
+{
+	hdate_snapshot* snapshot;
+	const snapshot_header* header;
+	struct stat file_stat, source_stat;
+	size_t offset[6];
+	void* map;
+	uint32_t i;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1) return NULL;
+	if ( (fstat(fd, &file_stat) != 0) ||
+		 (file_stat.st_size < (off_t) sizeof(snapshot_header)) )
+	{
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return NULL;
+
+	header = map;
+	if ( (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) ||
+		 (header->version != SNAPSHOT_VERSION) ||
+		 (header->byte_order != SNAPSHOT_BYTE_ORDER) ||
+		 (header->file_size != (uint64_t) file_stat.st_size) ||
+		 (snapshot_layout(header, offset) != (size_t) file_stat.st_size) )
+	{
+		munmap(map, file_stat.st_size);
+		return NULL;
+	}
+	snapshot = calloc(1, sizeof(hdate_snapshot));
+	if (snapshot == NULL)
+	{
+		munmap(map, file_stat.st_size);
+		return NULL;
+	}
+	snapshot->map = map;
+	snapshot->map_size = file_stat.st_size;
+	snapshot->header = header;
+	snapshot->source = (const snapshot_source*) ((char*) map + offset[0]);
+	snapshot->day = (const snapshot_day*) ((char*) map + offset[1]);
+	snapshot->custom_day = (const snapshot_custom_day*) ((char*) map + offset[2]);
+	snapshot->location = (const snapshot_location*) ((char*) map + offset[3]);
+	snapshot->transition = (const snapshot_transition*) ((char*) map + offset[4]);
+	snapshot->strings = (const char*) map + offset[5];
+
+	for (i = 0; i < header->location_count; i++)
+	{
+		if ( (snapshot->location[i].first_transition > header->transition_count) ||
+			 (snapshot->location[i].transition_count >
+			  header->transition_count - snapshot->location[i].first_transition) )
+		{
+			hdate_snapshot_close(snapshot);
+			return NULL;
+		}
+	}
+	for (i = 0; i < header->source_count; i++)
+	{
+		if ( (snapshot->source[i].path >= header->string_size) ||
+			 (stat(snapshot->strings + snapshot->source[i].path, &source_stat) != 0) ||
+			 (snapshot->source[i].size != source_stat.st_size) ||
+			 (snapshot->source[i].mtime_sec != source_stat.st_mtim.tv_sec) ||
+			 (snapshot->source[i].mtime_nsec != source_stat.st_mtim.tv_nsec) )
+		{
+			hdate_snapshot_close(snapshot);
+			return NULL;
+		}
+	}
+	return snapshot;
+}
+
+
+/**
+ @brief   release a snapshot opened by hdate_snapshot_open
+ @param snapshot  the snapshot; may be NULL
+*/
+void
+hdate_snapshot_close( hdate_snapshot* snapshot )
+{
+	if (snapshot == NULL) return;
+	munmap(snapshot->map, snapshot->map_size);
+	free(snapshot);
+}
+
+
+/**
+ @brief   the range of julian days of a snapshot
+ @return  non-zero if the snapshot covers every day of the range,
+          otherwise 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param jd_first  first julian day of the range
+ @param jd_last   last julian day of the range
+*/
+int
+hdate_snapshot_covers( hdate_snapshot const* snapshot, const int jd_first, const int jd_last )
+{
+	if (snapshot == NULL) return FALSE;
+	return ( (jd_first >= snapshot->header->jd_first) &&
+			 (jd_last < snapshot->header->jd_first + (int) snapshot->header->day_count) &&
+			 (jd_first <= jd_last) );
+}
+
+
+/************************************************************
+* snapshot_day_of
+*
+* the record of a julian day, or NULL if it is not covered
+************************************************************/
+static const snapshot_day* snapshot_day_of( hdate_snapshot const* snapshot, const int jd )
+{
+	if (!hdate_snapshot_covers(snapshot, jd, jd)) return NULL;
+	return &snapshot->day[jd - snapshot->header->jd_first];
+}
+
+
+/**
+ @brief   the halachic holiday of a day, as hdate_get_halachic_day,
+          from the snapshot if it covers the day, otherwise computed
+ @return  the number of the holiday, or 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param h         the day
+ @param diaspora  if non-zero, give diaspora holidays
+*/
+int
+hdate_snapshot_halachic_day( hdate_snapshot const* snapshot, hdate_struct const* h,
+							 const int diaspora )
+{
+	const snapshot_day* day = snapshot_day_of(snapshot, h->hd_jd);
+
+	if (day == NULL) return hdate_get_halachic_day(h, diaspora);
+	return day->halachic[diaspora ? 1 : 0];
+}
+
+
+/**
+ @brief   the holiday or Israeli custom day of a day, as
+          hdate_get_holyday, from the snapshot if it covers the day,
+          otherwise computed
+ @return  the number of the holiday, or 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param h         the day
+ @param diaspora  if non-zero, give diaspora holidays
+*/
+int
+hdate_snapshot_holyday( hdate_snapshot const* snapshot, hdate_struct const* h,
+						const int diaspora )
+{
+	const snapshot_day* day = snapshot_day_of(snapshot, h->hd_jd);
+
+	if (day == NULL) return hdate_get_holyday(h, diaspora);
+	if (day->halachic[diaspora ? 1 : 0]) return day->halachic[diaspora ? 1 : 0];
+	return day->israeli[diaspora ? 1 : 0];
+}
+
+
+/**
+ @brief   the parasha of a day, as hdate_get_parasha, from the
+          snapshot if it covers the day, otherwise computed
+ @return  the number of the parasha, or 0
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param h         the day
+ @param diaspora  if non-zero, give the diaspora reading
+*/
+int
+hdate_snapshot_parasha( hdate_snapshot const* snapshot, hdate_struct const* h,
+						const int diaspora )
+{
+	const snapshot_day* day = snapshot_day_of(snapshot, h->hd_jd);
+
+	if (day == NULL) return hdate_get_parasha(h, diaspora);
+	return day->parasha[diaspora ? 1 : 0];
+}
+
+
+/**
+ @brief   the custom days of a snapshot in a range of julian days,
+          as hdate_custom_days_get for the set it was written with
+ @return  the number of custom days in the range, which may be more
+          than max_days, or -1 if the snapshot has no custom days or
+          does not cover the range, in which case the caller should
+          compute them
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param jd_first  first julian day of the range
+ @param jd_last   last julian day of the range
+ @param days      receives up to max_days custom days, sorted by julian
+                  day and then by rule; may be NULL if max_days is 0
+ @param max_days  size of days
+*/
+int
+hdate_snapshot_custom_days( hdate_snapshot const* snapshot, const int jd_first,
+							const int jd_last, hdate_custom_day* days,
+							const size_t max_days )
+{
+	const snapshot_custom_day* custom_day;
+	size_t low, high, middle, i;
+
+	if ( (!hdate_snapshot_covers(snapshot, jd_first, jd_last)) ||
+		 (!snapshot->header->has_custom_days) )
+		return -1;
+	custom_day = snapshot->custom_day;
+	low = 0;
+	high = snapshot->header->custom_day_count;
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+		if (custom_day[middle].jd < jd_first) low = middle + 1;
+		else high = middle;
+	}
+	for (i = 0; (low + i < snapshot->header->custom_day_count) &&
+				(custom_day[low + i].jd <= jd_last); i++)
+	{
+		if (i < max_days)
+		{
+			days[i].jd = custom_day[low + i].jd;
+			days[i].rule = custom_day[low + i].rule;
+		}
+	}
+	return i;
+}
+
+
+/**
+ @brief   find a location of a snapshot by its timezone
+ @return  the index of the first location with that timezone, or -1
+ @param snapshot  as opened by hdate_snapshot_open; may be NULL
+ @param tz_name   timezone name, eg. Asia/Jerusalem
+*/
+int
+hdate_snapshot_find_location( hdate_snapshot const* snapshot, const char* tz_name )
+{
+	uint32_t i;
+
+	if ( (snapshot == NULL) || (tz_name == NULL) ) return -1;
+	for (i = 0; i < snapshot->header->location_count; i++)
+	{
+		if ( (snapshot->location[i].tz_name < snapshot->header->string_size) &&
+			 (strcmp(snapshot->strings + snapshot->location[i].tz_name, tz_name) == 0) )
+			return i;
+	}
+	return -1;
+}
+
+
+/**
+ @brief   the UTC offset of a location of a snapshot at an instant
+ @return  0 on success, or -1 if the snapshot does not cover the
+          instant or the location has no timezone, in which case the
+          caller should use zdump_offset
+ @param snapshot    as opened by hdate_snapshot_open; may be NULL
+ @param location    index of the location, as from
+                    hdate_snapshot_find_location
+ @param t           seconds from epoch
+ @param utc_offset  receives the offset, in seconds east of UTC
+ @param isdst       if not NULL, receives non-zero if dst is in effect
+*/
+int
+hdate_snapshot_utc_offset( hdate_snapshot const* snapshot, const int location,
+						   const time_t t, int* utc_offset, int* isdst )
+{
+	const snapshot_transition* transition;
+	time_t start, end;
+	size_t low, high, middle;
+
+	if ( (snapshot == NULL) || (location < 0) ||
+		 ((uint32_t) location >= snapshot->header->location_count) ||
+		 (snapshot->location[location].transition_count == 0) )
+		return -1;
+	range_seconds(snapshot->header->jd_first, snapshot->header->day_count, &start, &end);
+	transition = snapshot->transition + snapshot->location[location].first_transition;
+	if ( (t < start) || (t >= end) || (t < transition[0].start) ) return -1;
+
+	/// the last transition at or before t
+	low = 0;
+	high = snapshot->location[location].transition_count;
+	while (high - low > 1)
+	{
+		middle = low + (high - low) / 2;
+		if (transition[middle].start <= t) low = middle;
+		else high = middle;
+	}
+	*utc_offset = transition[low].utc_offset;
+	if (isdst != NULL) *isdst = transition[low].isdst;
+	return 0;
+}
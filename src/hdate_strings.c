@@ -22,9 +22,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <fnmatch.h>  /// For fnmatch
 #include <langinfo.h> /// for nl_langinfo()
 #include <locale.h>   /// for set_locale()
+#include <pthread.h>  /// for the interned string table mutex
 #include "hdate.h"
 #include "support.h"
 
@@ -81,6 +81,854 @@ static char *gregorian_months[2][12] = {
 };
 
 
+/// Alternative latin character spellings of Hebrew Months
+/// and alternative names of Hebrew months in latin characters
+static char *alt_latin_spell_hebrew_months[14] = {
+	"@(?(@(Y|J)ere@(ch|kh|h|x|j)?( |_|-)Ha?(-))@(A|Ai|Ay|Ei)t?(h)a?(h)n@(i|ee)m|Ti[cs]hr@([ie]?(y)|a[iy]))",
+	"@(b@(oo|ou|u)?(l)l|?(Mar?( |-|_))@(?(C|K)h|X|J)e[sc]hva?(h)n)",
+	"Kisl@(e|[ae][iy])v",
+	"T@(e|[ae][iy])v@(e|[ae][iy])t",
+	"[SC]h?([e'])vat",
+	"Ad?(d)a?(h)r",
+	"N@(i|ee)s?(s)a?(h)n",
+	"@(ziv|zeev|@(I|e|Ee)?(y|yy|j)?(')a?(h)r)",
+	"[SC]@(i|ee)v?(v)a?(h)n",
+	"Tam?(m)uz",
+	"?(Mena@(ch|kh|x|j)@(e|ei|ey|ai|ay|i)m?( |_|-))A?(h)v",
+	"El?(l)@(u|ou|oo)l?(l)",
+	"Ad?(d)a?(h)r?( |-|_)@(A|1|I|alef|aleph)",
+	"Ad?(d)a?(h)r?( |-|_)@(B|2|II|bet?(h))"
+	};
+
+/// Alternative Hebrew names for Hebrew Months
+static char *alt_hebrew_spell_hebrew_months[14] = {
+	"?(ירח?( |-|־)ה)איתנים",
+	"@(?(מר?( |-|־))חשון|בול)",
+	"",
+	"",
+	"",
+	"",
+	"",
+	"זיו",
+	"",
+	"",
+	"?(מנחם?( |-|־))אב",
+	"",
+	"אדר?( |-|־)א?(')",
+	"אדר?( |-|־)ב?(')"
+	};
+
+
+// FIXME - The english array should not be necessary because
+//         we can/should rely on the system locale and
+//         nl_langinfo()
+static char *days[2][2][7] = {
+	{ /// begin english
+	{ /// begin english long
+	N_("Sunday"), N_("Monday"), N_("Tuesday"), N_("Wednesday"),
+	 N_("Thursday"), N_("Friday"), N_("Saturday")},
+	{ /// begin english short
+	 N_("Sun"), N_("Mon"), N_("Tue"), N_("Wed"), N_("Thu"),
+	 N_("Fri"), N_("Sat")}
+	},
+	{ /// begin hebrew
+	{ /// begin hebrew long
+	"ראשון", "שני", "שלישי", "רביעי", "חמישי", "שישי", "שבת"},
+	{ /// begin hebrew short
+	"א", "ב", "ג", "ד", "ה", "ו", "ש"}
+	}
+	};
+
+static char *parashaot[2][2][62] = {
+	{ /// begin english
+	{ /// begin english long
+	 N_("none"),		N_("Bereshit"),		N_("Noach"),
+	 N_("Lech-Lecha"),	N_("Vayera"),		N_("Chayei_Sara"),
+	 N_("Toldot"),		N_("Vayetzei"),		N_("Vayishlach"),
+	 N_("Vayeshev"),	N_("Miketz"),		N_("Vayigash"),		/* 11 */
+	 N_("Vayechi"),		N_("Shemot"),		N_("Vaera"),
+	 N_("Bo"),		N_("Beshalach"),	N_("Yitro"),
+	 N_("Mishpatim"),	N_("Terumah"),		N_("Tetzaveh"),		/* 20 */
+	 N_("Ki_Tisa"),		N_("Vayakhel"),		N_("Pekudei"),
+	 N_("Vayikra"),		N_("Tzav"),		N_("Shmini"),
+	 N_("Tazria"),		N_("Metzora"),		N_("Achrei_Mot"),
+	 N_("Kedoshim"),	N_("Emor"),		N_("Behar"),		/* 32 */
+	 N_("Bechukotai"),	N_("Bamidbar"),		N_("Nasso"),
+	 N_("Beha'alotcha"),	N_("Sh'lach"),		N_("Korach"),
+	 N_("Chukat"),		N_("Balak"),		N_("Pinchas"),		/* 41 */
+	 N_("Matot"),		N_("Masei"),		N_("Devarim"),
+	 N_("Vaetchanan"),	N_("Eikev"),		N_("Re'eh"),
+	 N_("Shoftim"),		N_("Ki_Teitzei"),	N_("Ki_Tavo"),		/* 50 */
+	 N_("Nitzavim"),	N_("Vayeilech"),	N_("Ha'Azinu"),
+	 N_("Vezot_HaBracha"),	/* 54 */
+	 N_("Vayakhel-Pekudei"),N_("Tazria-Metzora"),	N_("Achrei_Mot-Kedoshim"),
+	 N_("Behar-Bechukotai"),N_("Chukat-Balak"),	N_("Matot-Masei"),
+	 N_("Nitzavim-Vayeilech")},
+	{ /// begin english short
+	 N_("none"),		N_("Bereshit"),		N_("Noach"),
+	 N_("Lech-Lecha"),	N_("Vayera"),		N_("Chayei_Sara"),
+	 N_("Toldot"),		N_("Vayetzei"),		N_("Vayishlach"),
+	 N_("Vayeshev"),	N_("Miketz"),		N_("Vayigash"),		/* 11 */
+	 N_("Vayechi"),		N_("Shemot"),		N_("Vaera"),
+	 N_("Bo"),		N_("Beshalach"),	N_("Yitro"),
+	 N_("Mishpatim"),	N_("Terumah"),		N_("Tetzaveh"),		/* 20 */
+	 N_("Ki_Tisa"),		N_("Vayakhel"),		N_("Pekudei"),
+	 N_("Vayikra"),		N_("Tzav"),		N_("Shmini"),
+	 N_("Tazria"),		N_("Metzora"),		N_("Achrei_Mot"),
+	 N_("Kedoshim"),	N_("Emor"),		N_("Behar"),		/* 32 */
+	 N_("Bechukotai"),	N_("Bamidbar"),		N_("Nasso"),
+	 N_("Beha'alotcha"),	N_("Sh'lach"),		N_("Korach"),
+	 N_("Chukat"),		N_("Balak"),		N_("Pinchas"),		/* 41 */
+	 N_("Matot"),		N_("Masei"),		N_("Devarim"),
+	 N_("Vaetchanan"),	N_("Eikev"),		N_("Re'eh"),
+	 N_("Shoftim"),		N_("Ki_Teitzei"),	N_("Ki_Tavo"),		/* 50 */
+	 N_("Nitzavim"),	N_("Vayeilech"),	N_("Ha'Azinu"),
+	 N_("Vezot_HaBracha"),	/* 54 */
+	 N_("Vayakhel-Pekudei"),N_("Tazria-Metzora"),	N_("Achrei_Mot-Kedoshim"),
+	 N_("Behar-Bechukotai"),N_("Chukat-Balak"),	N_("Matot-Masei"),
+	 N_("Nitzavim-Vayeilech")}
+	},
+	{ /// begin hebrew
+	{ /// begin hebrew long
+	 "none",		"בראשית",		"נח",
+	 "לך_לך",		"וירא",			"חיי_שרה",
+	 "תולדות",		"ויצא",			"וישלח",
+	 "וישב",		"מקץ",			"ויגש",		/* 11 */
+	 "ויחי",		"שמות",			"וארא",
+	 "בא",			"בשלח",			"יתרו",
+	 "משפטים",		"תרומה",		"תצוה",		/* 20 */
+	 "כי_תשא",		"ויקהל",		"פקודי",
+	 "ויקרא",		"צו",			"שמיני",
+	 "תזריע",		"מצורע",		"אחרי_מות",
+	 "קדושים",		"אמור",			"בהר",		/* 32 */
+	 "בחוקתי",		"במדבר",		"נשא",
+	 "בהעלתך",		"שלח",			"קרח",
+	 "חקת",			"בלק",			"פנחס",		/* 41 */
+	 "מטות",		"מסעי",			"דברים",
+	 "ואתחנן",		"עקב",			"ראה",
+	 "שופטים",		"כי_תצא",		"כי_תבוא",		/* 50 */
+	 "נצבים",		"וילך",			"האזינו",
+	 "וזאת_הברכה",	/* 54 */
+	 "ויקהל-פקודי",	"תזריע-מצורע",	"אחרי_מות-קדושים",
+	 "בהר-בחוקתי",	"חוקת-בלק",		"מטות-מסעי",
+	 "נצבים-וילך"},
+	{ /// begin hebrew short
+	 "none",		"בראשית",		"נח",
+	 "לך_לך",		"וירא",			"חיי_שרה",
+	 "תולדות",		"ויצא",			"וישלח",
+	 "וישב",		"מקץ",			"ויגש",		/* 11 */
+	 "ויחי",		"שמות",			"וארא",
+	 "בא",			"בשלח",			"יתרו",
+	 "משפטים",		"תרומה",		"תצוה",		/* 20 */
+	 "כי_תשא",		"ויקהל",		"פקודי",
+	 "ויקרא",		"צו",			"שמיני",
+	 "תזריע",		"מצורע",		"אחרי_מות",
+	 "קדושים",		"אמור",			"בהר",		/* 32 */
+	 "בחוקתי",		"במדבר",		"נשא",
+	 "בהעלתך",		"שלח",			"קרח",
+	 "חקת",			"בלק",			"פנחס",		/* 41 */
+	 "מטות",		"מסעי",			"דברים",
+	 "ואתחנן",		"עקב",			"ראה",
+	 "שופטים",		"כי_תצא",		"כי_תבוא",		/* 50 */
+	 "נצבים",		"וילך",			"האזינו",
+	 "וזאת_הברכה",	/* 54 */
+	 "ויקהל-פקודי",	"תזריע-מצורע",	"אחרי_מות-קדושים",
+	 "בהר-בחוקתי",	"חוקת-בלק",		"מטות-מסעי",
+	 "נצבים-וילך"}
+	}
+	};
+
+
+static char *holidays[2][2][40] = {
+	{ /// begin english
+	{ /// begin english long
+/**  0 **/ N_("regular_weekday_(no_holiday)"),
+/**  1 **/ N_("Rosh_HaShana_(first_day)"),	N_("Rosh HaShana_(second_day)"),
+	   N_("Tzom_Gedaliah"),				N_("Yom_Kippur"),
+/**  5 **/ N_("Sukkot"),						N_("Hol_HaMoed_Sukkot"),
+	   N_("Hoshana_Rabbah"),				N_("Simchat_Torah"),
+/**  9 **/ N_("Chanukah"),					N_("Asara_B'Tevet"),
+	   N_("Tu_B'Shvat"),					N_("Ta'anit_Esther"),
+/** 13 **/ N_("Purim"),						N_("Shushan_Purim"),
+	   N_("Pesach"),						N_("Hol_HaMoed_Pesach"),
+/** 17 **/ N_("Yom_HaAtzma'ut"),				N_("Lag_B'Omer"),
+	   N_("Erev_Shavuot"),				N_("Shavuot"),
+/** 21 **/ N_("Tzom_Tammuz"),					N_("Tish'a_B'Av"),
+	   N_("Tu_B'Av"),						N_("Yom_HaShoah"),
+/** 25 **/ N_("Yom_HaZikaron"),				N_("Yom_Yerushalayim"),
+	   N_("Shmini_Atzeret"),				N_("Shevi'i_shel_Pesach"),
+/** 29 **/ N_("Acharon_shel_Pesach"),			N_("Shavuot_(second_day)"),
+	   N_("Sukkot_(second_day)"),			N_("Pesach_(second_day)"),
+/** 33 **/ N_("Family_Day"),					N_("Memorial_day_for_fallen_whose_place_of_burial_is_unknown"),
+	   N_("Yitzhak_Rabin_memorial_day"),	N_("Zeev_Zhabotinsky_day"),
+/** 37 **/ N_("Erev_Yom_Kippur"),				N_("Erev_Pesach"),
+/** 39 **/ N_("Erev_Sukkot")},
+	{ /// begin_english short
+/**  0 **/ N_("regular_day"),
+	 N_("Rosh HaShana_(day_1)"),	N_("Rosh HaShana_(day_2)"),
+	 N_("Tzom_Gedaliah"),			N_("Yom_Kippur"),
+	 N_("Sukkot"),					N_("Hol_HaMoed_Sukkot"),
+	 N_("Hoshana_Rabbah"),			N_("Simchat_Torah"),
+	 N_("Chanukah"),				N_("Asara_B'Tevet"),	/* 10 */
+	 N_("Tu_B'Shvat"),				N_("Ta'anit_Esther"),
+	 N_("Purim"),					N_("Shushan_Purim"),
+	 N_("Pesach"),					N_("Hol_HaMoed_Pesach"),
+	 N_("Yom_HaAtzma'ut"),			N_("Lag_B'Omer"),
+	 N_("Erev_Shavuot"),			N_("Shavuot"),			/* 20 */
+	 N_("Tzom_Tammuz"),				N_("Tish'a_B'Av"),
+	 N_("Tu_B'Av"),					N_("Yom_HaShoah"),
+	 N_("Yom_HaZikaron"),			N_("Yom_Yerushalayim"),
+	 N_("Shmini_Atzeret"),			N_("Pesach_(day_7)"),
+	 N_("Pesach_(day_8)"),			N_("Shavuot_(day_2)"),   /* 30 */
+	 N_("Sukkot_(day_2)"),			N_("Pesach_(day_2)"),
+	 N_("Family_Day"),				N_("Memorial_day_for_fallen_whose_place_of_burial_is_unknown"),
+	 N_("Rabin_memorial_day"),		N_("Zhabotinsky_day"),
+	 N_("Erev_Yom_Kippur"),			N_("Erev_Pesach"),
+	 N_("Erev_Sukkot")}
+	},
+	{ /// begin hebrew
+	{ /// begin hebrew long
+	 "יום_חול",
+	 "א'_ראש_השנה",		"ב'_ראש_השנה",
+	 "צום_גדליה",		"יום_הכפורים",
+	 "סוכות",		"חול_המועד_סוכות",
+	 "הושענא_רבה",		"שמחת_תורה",
+	 "חנוכה",		"צום_עשרה_בטבת",/* 10 */
+	 "ט\"ו_בשבט",		"תענית_אסתר",
+	 "פורים",		"שושן_פורים",
+	 "פסח",			"חול_המועד_פסח",
+	 "יום_העצמאות",		"ל\"ג_בעומר",
+	 "ערב_שבועות",		"שבועות",	/* 20 */
+	 "צום_שבעה_עשר_בתמוז",	"תשעה_באב",
+	 "ט\"ו_באב",		"יום_השואה",
+	 "יום_הזכרון",		"יום_ירושלים",
+	 "שמיני_עצרת",		"שביעי_פסח",
+	 "אחרון_של_פסח",	"שני_של_שבועות",/* 30 */
+	 "שני_של_סוכות",	"שני_של_פסח",
+	 "יום_המשפחה",		"יום_זכרון...",
+	 "יום_הזכרון_ליצחק_רבין","יום_ז\'בוטינסקי",
+	 "ערב_יום_הכפורים",	"ערב_פסח",
+	 "ערב_סוכות"},
+	{ /// begin hebrew short
+	 "חול",
+	 "א_ר\"ה",		 "ב'_ר\"ה",
+	 "צום_גדליה",		 "יוה\"כ",
+	 "סוכות",		 "חוה\"מ סוכות",
+	 "הוש\"ר",		 "שמח\"ת",
+	 "חנוכה",		 "י' בטבת",	/* 10 */
+	 "ט\"ו_בשבט",		 "תענית_אסתר",
+	 "פורים",		 "שושן_פורים",
+	 "פסח",			 "חוה\"מ פסח",
+	 "יום_העצמאות",		 "ל\"ג_בעומר",
+	 "ערב_שבועות",		 "שבועות",	/* 20 */
+	 "צום_תמוז",		 "ט' באב",
+	 "ט\"ו_באב",		 "יום_השואה",
+	 "יום_הזכרון",		 "יום_י-ם",
+	 "שמיני_עצרת",		 "ז' פסח",
+	 "אחרון_של_פסח",	 "ב' שבועות",   /* 30 */
+	 "ב' סוכות",		 "ב' פסח",
+	 "יום_המשפחה",		 "יום_זכרון...",
+	 "יום_הזכרון_ליצחק_רבין","יום_ז\'בוטינסקי",
+	 "עיוה\"כ",			"ע\"פ",
+	 "ערב_סוכות"}	}
+	};
+
+
+/************************************************************
+* interned string table
+*
+* All of the names above (and their gettext / nl_langinfo
+* translations) are resolved once, copied into a single
+* arena, and stored with their lengths. After that, a name
+* lookup is just an array index. The table is built lazily
+* by the first caller, under a mutex; readers after that do
+* not lock.
+************************************************************/
+typedef struct {
+	const char *str;
+	size_t      len;
+} hdate_string_entry;
+
+/// offsets of each string type within the flat entry array
+#define STRING_TABLE_DOW      0
+#define STRING_TABLE_PARASHA  (STRING_TABLE_DOW + 2*2*7)
+#define STRING_TABLE_HMONTH   (STRING_TABLE_PARASHA + 2*2*62)
+#define STRING_TABLE_GMONTH   (STRING_TABLE_HMONTH + 2*2*14)
+#define STRING_TABLE_HOLIDAY  (STRING_TABLE_GMONTH + 2*2*12)
+#define STRING_TABLE_SIZE     (STRING_TABLE_HOLIDAY + 2*2*40)
+
+typedef struct hdate_string_table {
+	hdate_string_entry entry[STRING_TABLE_SIZE];
+	char *arena;
+	/// tables discarded by hdate_string_table_reset() are kept on
+	/// this list, so that pointers already handed out stay valid
+	struct hdate_string_table *retired;
+} hdate_string_table;
+
+static hdate_string_table *string_table = NULL;
+static hdate_string_table *retired_string_tables = NULL;
+static pthread_mutex_t string_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/************************************************************
+* string_table_index
+*
+* returns the position of a name in the flat entry array,
+* or -1 if the type or index is out of range. The index
+* ranges are those accepted by hdate_string().
+************************************************************/
+static int string_table_index( int const type_of_string, int const index,
+						int const short_form, int const hebrew_form )
+{
+	switch (type_of_string)
+	{
+	case HDATE_STRING_DOW:
+		if (index < 1 || index > 7) return -1;
+		return STRING_TABLE_DOW + ((hebrew_form*2 + short_form)*7) + index - 1;
+	case HDATE_STRING_PARASHA:
+		if (index < 1 || index > 61) return -1;
+		return STRING_TABLE_PARASHA + ((hebrew_form*2 + short_form)*62) + index;
+	case HDATE_STRING_HMONTH:
+		if (index < 1 || index > 14) return -1;
+		return STRING_TABLE_HMONTH + ((hebrew_form*2 + short_form)*14) + index - 1;
+	case HDATE_STRING_GMONTH:
+		if (index < 1 || index > 12) return -1;
+		return STRING_TABLE_GMONTH + ((hebrew_form*2 + short_form)*12) + index - 1;
+	case HDATE_STRING_HOLIDAY:
+		if (index < 0 || index > 39) return -1;
+		return STRING_TABLE_HOLIDAY + ((hebrew_form*2 + short_form)*40) + index;
+	}
+	return -1;
+}
+
+
+/************************************************************
+* string_table_resolve
+*
+* the translation rules formerly applied by hdate_string() on
+* every call. The returned pointer may belong to gettext or to
+* nl_langinfo_l, so the caller must copy it away. time_locale
+* is (locale_t) 0 if the user's LC_TIME locale is unavailable.
+************************************************************/
+static const char* string_table_resolve( int const type_of_string, int const index,
+						int const short_form, int const hebrew_form,
+						locale_t const time_locale )
+{
+	char* langinfo_ptr;
+
+	switch (type_of_string)
+	{
+	case HDATE_STRING_DOW:
+	/** Use our local data structure and very limited set of gettext po
+	 ** translations only if the host OS does not have, or fails to set,
+	 ** the locale for time and date data. The exception for Hebrew is
+	 ** because it's expected to be used by users in all locales. **/
+		if ( (time_locale == (locale_t) 0) || hebrew_form )
+			return _(days[hebrew_form][short_form][index - 1]);
+		langinfo_ptr = nl_langinfo_l(langinfo_days[ ( (short_form*7)) + (index-1) ], time_locale);
+	/** nl_langinfo may return a pointer to a null string if it does
+	 ** not have the requested value. **/
+		if ( strcmp(langinfo_ptr, "") == 0 ) return _(days[hebrew_form][short_form][index - 1]);
+		return langinfo_ptr;
+	case HDATE_STRING_PARASHA:
+		return _(parashaot[hebrew_form][short_form][index]);
+	case HDATE_STRING_HMONTH:
+		return _(hebrew_months[hebrew_form][short_form][index - 1]);
+	case HDATE_STRING_GMONTH:
+		if (time_locale == (locale_t) 0)
+			return _(gregorian_months[short_form][index - 1]);
+		langinfo_ptr = nl_langinfo_l(langinfo_months[ ((index-1)+(short_form*12)) ], time_locale);
+		if ( strcmp(langinfo_ptr, "") == 0 ) return _(gregorian_months[short_form][index - 1]);
+		return langinfo_ptr;
+	case HDATE_STRING_HOLIDAY:
+		return _(holidays[hebrew_form][short_form][index]);
+	}
+	return "";
+}
+
+
+/************************************************************
+* string_table_build
+*
+* resolves every name, then copies them all into one arena.
+* returns NULL on allocation failure.
+************************************************************/
+static hdate_string_table* string_table_build()
+{
+	static const int types[5] = { HDATE_STRING_DOW, HDATE_STRING_PARASHA,
+		HDATE_STRING_HMONTH, HDATE_STRING_GMONTH, HDATE_STRING_HOLIDAY };
+	static const int first_index[5] = { 1, 1, 1, 1, 0 };
+	static const int last_index[5]  = { 7, 61, 14, 12, 39 };
+
+	hdate_string_table *table;
+	const char *source;
+	char *arena_ptr;
+	size_t arena_size = 0;
+	locale_t time_locale;
+	int t, i, short_form, hebrew_form, position;
+
+#ifdef ENABLE_NLS
+	bindtextdomain (PACKAGE, PACKAGE_LOCALE_DIR);
+	bind_textdomain_codeset (PACKAGE, "UTF-8");
+#endif
+
+	table = calloc(1, sizeof(hdate_string_table));
+	if (table == NULL) return NULL;
+
+	/** The LC_TIME locale that setlocale(LC_TIME,"") would set, read
+	 ** without setting it, as for month_trie_build **/
+	time_locale = newlocale(LC_TIME_MASK, "", (locale_t) 0);
+
+	/// first pass: resolve each name and total the arena size. Unused
+	/// slots (eg. parasha 0) keep str == NULL.
+	for (t=0; t<5; t++)
+	for (hebrew_form=0; hebrew_form<2; hebrew_form++)
+	for (short_form=0; short_form<2; short_form++)
+	for (i=first_index[t]; i<=last_index[t]; i++)
+	{
+		position = string_table_index(types[t], i, short_form, hebrew_form);
+		source = string_table_resolve(types[t], i, short_form, hebrew_form, time_locale);
+		table->entry[position].str = source;
+		table->entry[position].len = strlen(source);
+		arena_size = arena_size + table->entry[position].len + 1;
+	}
+
+	table->arena = malloc(arena_size);
+	if (table->arena == NULL)
+	{
+		if (time_locale != (locale_t) 0) freelocale(time_locale);
+		free(table);
+		return NULL;
+	}
+
+	/// second pass: copy into the arena, so that later locale changes
+	/// or freeing time_locale cannot invalidate our pointers
+	arena_ptr = table->arena;
+	for (position=0; position<STRING_TABLE_SIZE; position++)
+	{
+		if (table->entry[position].str == NULL) continue;
+		memcpy(arena_ptr, table->entry[position].str, table->entry[position].len + 1);
+		table->entry[position].str = arena_ptr;
+		arena_ptr = arena_ptr + table->entry[position].len + 1;
+	}
+	if (time_locale != (locale_t) 0) freelocale(time_locale);
+	return table;
+}
+
+
+/************************************************************
+* string_table_get
+*
+* returns the current interned table, building it if needed.
+************************************************************/
+static hdate_string_table* string_table_get()
+{
+	hdate_string_table *table;
+
+	table = __atomic_load_n(&string_table, __ATOMIC_ACQUIRE);
+	if (table != NULL) return table;
+
+	pthread_mutex_lock(&string_table_mutex);
+	table = string_table;
+	if (table == NULL)
+	{
+		table = string_table_build();
+		__atomic_store_n(&string_table, table, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&string_table_mutex);
+	return table;
+}
+
+
+/**
+ @brief   resolve all name translations into the interned table now,
+          instead of upon first use
+ @return  0 on success, -1 on memory allocation failure
+*/
+int hdate_string_table_init()
+{
+	if (string_table_get() == NULL) return -1;
+	return 0;
+}
+
+
+/**
+ @brief   discard the interned table, so that the next lookup
+          re-resolves all names (eg. after a change of locale)
+*/
+void hdate_string_table_reset()
+{
+	hdate_string_table *table;
+
+	pthread_mutex_lock(&string_table_mutex);
+	table = string_table;
+	__atomic_store_n(&string_table, NULL, __ATOMIC_RELEASE);
+	if (table != NULL)
+	{
+		table->retired = retired_string_tables;
+		retired_string_tables = table;
+	}
+	pthread_mutex_unlock(&string_table_mutex);
+}
+
+
+/**
+ @brief   Return an interned name, and its length
+ @return  a pointer to a static string, or NULL if the type or index
+          is out of range (or upon memory allocation failure).
+ @param type_of_string one of the static string types of hdate_string()
+ @param index          as for hdate_string()
+ @param short_form     0 = long format
+ @param hebrew_form    0 = not hebrew (native/embedded)
+ @param len            if not NULL, receives the length of the string,
+                       in bytes, excluding the terminating null
+*/
+const char* hdate_string_ref( int const type_of_string, int const index,
+						int const input_short_form, int const input_hebrew_form,
+						size_t* len )
+{
+	hdate_string_table *table;
+	int position;
+
+	position = string_table_index(type_of_string, index,
+						(input_short_form != 0), (input_hebrew_form != 0));
+	if (position < 0) return NULL;
+
+	table = string_table_get();
+	if (table == NULL) return NULL;
+
+	if (len != NULL) *len = table->entry[position].len;
+	return table->entry[position].str;
+}
+
+
+/************************************************************
+* month name trie
+*
+* Every spelling accepted by hdate_match_month_name() is
+* compiled once, for the LC_TIME locale of the environment,
+* into a byte trie. The
+* extglob alternative-spelling patterns are expanded into
+* plain strings at build time, so a lookup is one walk down
+* the trie, instead of a series of strcasecmp() and fnmatch()
+* passes. ASCII is folded to lower case both when building
+* and when matching; Hebrew (UTF-8) is matched byte for byte.
+*
+* Node values are coded as for hdate_parse_month_text_string:
+* 1 - 12 gregorian, 101 - 114 Hebrew.
+************************************************************/
+#define MONTH_TRIE_NONE       0
+#define MONTH_TRIE_AMBIGUOUS -1
+
+typedef struct {
+	int   child;		/// index of first child node, or 0 for none
+	int   sibling;		/// index of next sibling node, or 0 for none
+	short value;		/// month code if a spelling ends here
+	short prefix_value;	/// month code if all spellings below here agree
+	unsigned char c;
+} month_trie_node;
+
+typedef struct month_trie {
+	month_trie_node *node;
+	int node_count;
+	int node_max;
+} month_trie;
+
+static month_trie *current_month_trie = NULL;
+static pthread_mutex_t month_trie_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static unsigned char month_trie_fold( unsigned char c )
+{
+	if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+	return c;
+}
+
+
+/************************************************************
+* month_trie_insert
+*
+* returns 0 on success, -1 on memory allocation failure. An
+* earlier insertion takes priority over a later one for the
+* same spelling, as did the order of the original sequential
+* passes.
+************************************************************/
+static int month_trie_insert( month_trie *trie, const char* text, int const value )
+{
+	month_trie_node *new_node;
+	int position = 0;
+	int next;
+	unsigned char c;
+
+	if (*text == '\0') return 0;
+	for (; *text != '\0'; text++)
+	{
+		c = month_trie_fold(*text);
+		for (next = trie->node[position].child; next != 0; next = trie->node[next].sibling)
+			if (trie->node[next].c == c) break;
+		if (next == 0)
+		{
+			if (trie->node_count == trie->node_max)
+			{
+				new_node = realloc(trie->node, sizeof(month_trie_node) * trie->node_max * 2);
+				if (new_node == NULL) return -1;
+				trie->node = new_node;
+				trie->node_max = trie->node_max * 2;
+			}
+			next = trie->node_count;
+			trie->node_count++;
+			memset(&trie->node[next], 0, sizeof(month_trie_node));
+			trie->node[next].c = c;
+			trie->node[next].sibling = trie->node[position].child;
+			trie->node[position].child = next;
+		}
+		position = next;
+	}
+	if (trie->node[position].value == MONTH_TRIE_NONE)
+		trie->node[position].value = value;
+	return 0;
+}
+
+
+/************************************************************
+* month_trie_insert_pattern
+*
+* expands the subset of extglob used by the alternative
+* spelling arrays - @(a|b), ?(a|b) and [ab] - by rewriting the
+* first group in the pattern once per alternative, and
+* recursing until no groups remain.
+************************************************************/
+static int month_trie_insert_pattern( month_trie *trie, const char* pattern, int const value )
+{
+	const char *group_start, *group_end, *alt_start, *p;
+	char *expanded;
+	size_t prefix_len, suffix_len;
+	int depth, optional, ret_val = 0;
+
+	/// find the first group
+	for (group_start = pattern; *group_start != '\0'; group_start++)
+	{
+		if (*group_start == '[') break;
+		if ( (*group_start == '@' || *group_start == '?') && group_start[1] == '(' ) break;
+	}
+	if (*group_start == '\0') return month_trie_insert(trie, pattern, value);
+
+	prefix_len = group_start - pattern;
+
+	if (*group_start == '[')
+	{
+		group_end = strchr(group_start, ']');
+		if (group_end == NULL) return month_trie_insert(trie, pattern, value);
+		suffix_len = strlen(group_end + 1);
+		expanded = malloc(prefix_len + 1 + suffix_len + 1);
+		if (expanded == NULL) return -1;
+		memcpy(expanded, pattern, prefix_len);
+		memcpy(expanded + prefix_len + 1, group_end + 1, suffix_len + 1);
+		for (p = group_start + 1; p < group_end && ret_val == 0; p++)
+		{
+			expanded[prefix_len] = *p;
+			ret_val = month_trie_insert_pattern(trie, expanded, value);
+		}
+		free(expanded);
+		return ret_val;
+	}
+
+	/// find the matching close parenthesis
+	optional = (*group_start == '?');
+	depth = 0;
+	for (group_end = group_start + 1; *group_end != '\0'; group_end++)
+	{
+		if (*group_end == '(') depth++;
+		else if (*group_end == ')' && --depth == 0) break;
+	}
+	if (*group_end == '\0') return month_trie_insert(trie, pattern, value);
+	suffix_len = strlen(group_end + 1);
+
+	expanded = malloc(strlen(pattern) + 1);
+	if (expanded == NULL) return -1;
+	memcpy(expanded, pattern, prefix_len);
+
+	if (optional)
+	{
+		memcpy(expanded + prefix_len, group_end + 1, suffix_len + 1);
+		ret_val = month_trie_insert_pattern(trie, expanded, value);
+	}
+
+	/// each top-level alternative between the parentheses
+	alt_start = group_start + 2;
+	depth = 0;
+	for (p = alt_start; p <= group_end && ret_val == 0; p++)
+	{
+		if (*p == '(') depth++;
+		else if (*p == ')' && p != group_end) depth--;
+		else if ( (*p == '|' && depth == 0) || p == group_end )
+		{
+			memcpy(expanded + prefix_len, alt_start, p - alt_start);
+			memcpy(expanded + prefix_len + (p - alt_start), group_end + 1, suffix_len + 1);
+			ret_val = month_trie_insert_pattern(trie, expanded, value);
+			alt_start = p + 1;
+		}
+	}
+	free(expanded);
+	return ret_val;
+}
+
+
+/************************************************************
+* month_trie_build
+*
+* inserts all accepted spellings, in the priority order of
+* the original sequential matching passes.
+************************************************************/
+static month_trie* month_trie_build()
+{
+	month_trie *trie;
+	locale_t time_locale;
+	int i, ret_val = 0;
+
+	trie = calloc(1, sizeof(month_trie));
+	if (trie == NULL) return NULL;
+	trie->node_max = 1024;
+	trie->node = calloc(trie->node_max, sizeof(month_trie_node));
+	if (trie->node == NULL) goto build_failure;
+	trie->node_count = 1; /// the root
+
+	/** The LC_TIME locale that setlocale(LC_TIME,"") would set, but
+	 ** read without setting it, since changing or even querying the
+	 ** locale of the process races with other threads that set it **/
+	time_locale = newlocale(LC_TIME_MASK, "", (locale_t) 0);
+
+	/// the user's locale (both full month names and abbreviations)
+	for (i=0; i<24 && ret_val == 0; i++)
+		ret_val = month_trie_insert(trie, (time_locale != (locale_t) 0) ?
+					nl_langinfo_l(langinfo_months[i], time_locale) :
+					nl_langinfo(langinfo_months[i]), (i%12)+1);
+	if (time_locale != (locale_t) 0) freelocale(time_locale);
+
+	/// the latin and Hebrew character strings for Hebrew months.
+	/// The 'short' versions are in practice identical to the 'long'
+	for (i=0; i<14 && ret_val == 0; i++)
+	{
+		ret_val = month_trie_insert(trie, hebrew_months[0][0][i], i+101);
+		if (ret_val == 0) ret_val = month_trie_insert(trie, hebrew_months[1][0][i], i+101);
+	}
+
+	/// alternative spellings and names of Hebrew months
+	for (i=0; i<14 && ret_val == 0; i++)
+		ret_val = month_trie_insert_pattern(trie, alt_latin_spell_hebrew_months[i], i+101);
+	for (i=0; i<14 && ret_val == 0; i++)
+		ret_val = month_trie_insert_pattern(trie, alt_hebrew_spell_hebrew_months[i], i+101);
+
+	/** nl_langinfo may return a pointer to a null string if it does
+	 ** not have the requested value. In such a case use the English
+	 ** strings **/
+	for (i=0; i<12 && ret_val == 0; i++)
+	{
+		ret_val = month_trie_insert(trie, gregorian_months[0][i], i+1);
+		if (ret_val == 0) ret_val = month_trie_insert(trie, gregorian_months[1][i], i+1);
+	}
+	if (ret_val != 0) goto build_failure;
+
+	/// A child always has a higher index than its parent, so one
+	/// reverse pass computes which month, if any, each prefix implies
+	for (i = trie->node_count - 1; i >= 0; i--)
+	{
+		int child;
+		short prefix_value = trie->node[i].value;
+
+		for (child = trie->node[i].child; child != 0; child = trie->node[child].sibling)
+		{
+			if (trie->node[child].prefix_value == MONTH_TRIE_NONE) continue;
+			if (prefix_value == MONTH_TRIE_NONE)
+				prefix_value = trie->node[child].prefix_value;
+			else if (prefix_value != trie->node[child].prefix_value)
+				prefix_value = MONTH_TRIE_AMBIGUOUS;
+		}
+		trie->node[i].prefix_value = prefix_value;
+	}
+	return trie;
+
+build_failure:
+	free(trie->node);
+	free(trie);
+	return NULL;
+}
+
+
+/************************************************************
+* month_trie_get
+*
+* returns the trie, building it on first use. It is never
+* changed or freed after that, so any thread may walk it.
+************************************************************/
+static month_trie* month_trie_get()
+{
+	month_trie *trie;
+
+	trie = __atomic_load_n(&current_month_trie, __ATOMIC_ACQUIRE);
+	if (trie != NULL) return trie;
+
+	pthread_mutex_lock(&month_trie_mutex);
+	trie = current_month_trie;
+	if (trie == NULL)
+	{
+		trie = month_trie_build();
+		__atomic_store_n(&current_month_trie, trie, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&month_trie_mutex);
+	return trie;
+}
+
+
+/**
+ @brief   match a month name, in any accepted spelling
+ @return  month number (1 - 12 gregorian, 1 - 14 Hebrew), or 0 if
+          there is no match, or the prefix is ambiguous
+ @param text      the month name; need not be null terminated
+ @param len       the number of bytes of text to match
+ @param flags     HDATE_MONTH_MATCH_PREFIX to also accept an
+                  unambiguous prefix of a spelling
+ @param calendar  if not NULL, receives HDATE_CALENDAR_GREGORIAN or
+                  HDATE_CALENDAR_HEBREW, or 0 if there is no match
+*/
+int hdate_match_month_name( const char* text, size_t const len,
+						int const flags, int* calendar )
+{
+	month_trie *trie;
+	int position = 0;
+	int value;
+	size_t i;
+	unsigned char c;
+
+	if (calendar != NULL) *calendar = 0;
+	if ( (text == NULL) || (len == 0) ) return 0;
+
+	trie = month_trie_get();
+	if (trie == NULL) return 0;
+
+	for (i=0; i<len; i++)
+	{
+		c = month_trie_fold(text[i]);
+		for (position = trie->node[position].child; position != 0;
+			 position = trie->node[position].sibling)
+			if (trie->node[position].c == c) break;
+		if (position == 0) return 0;
+	}
+
+	value = trie->node[position].value;
+	if ( (value == MONTH_TRIE_NONE) && (flags & HDATE_MONTH_MATCH_PREFIX) )
+		value = trie->node[position].prefix_value;
+	if (value <= MONTH_TRIE_NONE) return 0;
+
+	if (value > 100)
+	{
+		if (calendar != NULL) *calendar = HDATE_CALENDAR_HEBREW;
+		return value - 100;
+	}
+	if (calendar != NULL) *calendar = HDATE_CALENDAR_GREGORIAN;
+	return value;
+}
+
 
 
 /**
@@ -287,9 +1135,6 @@ char* hdate_string( int const type_of_string, int const index, int const input_s
 	char *return_string = NULL;
 	int return_string_len = -1;
 
-	/// for nl_langinfo calls for DOW an gregrorian months
-	char* langinfo_ptr;
-
 	#define H_CHAR_WIDTH 2
 	static char *digits[3][10] = {
 		{" ", "א", "ב", "ג", "ד", "ה", "ו", "ז", "ח", "ט"},
@@ -297,220 +1142,6 @@ char* hdate_string( int const type_of_string, int const index, int const input_s
 		{" ", "ק", "ר", "ש", "ת"}
 	};
 
-	// FIXME - The english array should not be necessary because
-	//         we can/should rely on the system locale and
-	//         nl_langinfo()
-	static char *days[2][2][7] = {
-		{ /// begin english
-		{ /// begin english long
-		N_("Sunday"), N_("Monday"), N_("Tuesday"), N_("Wednesday"),
-		 N_("Thursday"), N_("Friday"), N_("Saturday")},
-		{ /// begin english short
-		 N_("Sun"), N_("Mon"), N_("Tue"), N_("Wed"), N_("Thu"),
-		 N_("Fri"), N_("Sat")}
-		},
-		{ /// begin hebrew
-		{ /// begin hebrew long
-		"ראשון", "שני", "שלישי", "רביעי", "חמישי", "שישי", "שבת"},
-		{ /// begin hebrew short
-		"א", "ב", "ג", "ד", "ה", "ו", "ש"}
-		}
-		};
-
-	static char *parashaot[2][2][62] = {
-		{ /// begin english
-		{ /// begin english long
-		 N_("none"),		N_("Bereshit"),		N_("Noach"),
-		 N_("Lech-Lecha"),	N_("Vayera"),		N_("Chayei_Sara"),
-		 N_("Toldot"),		N_("Vayetzei"),		N_("Vayishlach"),
-		 N_("Vayeshev"),	N_("Miketz"),		N_("Vayigash"),		/* 11 */
-		 N_("Vayechi"),		N_("Shemot"),		N_("Vaera"),
-		 N_("Bo"),		N_("Beshalach"),	N_("Yitro"),
-		 N_("Mishpatim"),	N_("Terumah"),		N_("Tetzaveh"),		/* 20 */
-		 N_("Ki_Tisa"),		N_("Vayakhel"),		N_("Pekudei"),
-		 N_("Vayikra"),		N_("Tzav"),		N_("Shmini"),
-		 N_("Tazria"),		N_("Metzora"),		N_("Achrei_Mot"),
-		 N_("Kedoshim"),	N_("Emor"),		N_("Behar"),		/* 32 */
-		 N_("Bechukotai"),	N_("Bamidbar"),		N_("Nasso"),
-		 N_("Beha'alotcha"),	N_("Sh'lach"),		N_("Korach"),
-		 N_("Chukat"),		N_("Balak"),		N_("Pinchas"),		/* 41 */
-		 N_("Matot"),		N_("Masei"),		N_("Devarim"),
-		 N_("Vaetchanan"),	N_("Eikev"),		N_("Re'eh"),
-		 N_("Shoftim"),		N_("Ki_Teitzei"),	N_("Ki_Tavo"),		/* 50 */
-		 N_("Nitzavim"),	N_("Vayeilech"),	N_("Ha'Azinu"),
-		 N_("Vezot_HaBracha"),	/* 54 */
-		 N_("Vayakhel-Pekudei"),N_("Tazria-Metzora"),	N_("Achrei_Mot-Kedoshim"),
-		 N_("Behar-Bechukotai"),N_("Chukat-Balak"),	N_("Matot-Masei"),
-		 N_("Nitzavim-Vayeilech")},
-		{ /// begin english short
-		 N_("none"),		N_("Bereshit"),		N_("Noach"),
-		 N_("Lech-Lecha"),	N_("Vayera"),		N_("Chayei_Sara"),
-		 N_("Toldot"),		N_("Vayetzei"),		N_("Vayishlach"),
-		 N_("Vayeshev"),	N_("Miketz"),		N_("Vayigash"),		/* 11 */
-		 N_("Vayechi"),		N_("Shemot"),		N_("Vaera"),
-		 N_("Bo"),		N_("Beshalach"),	N_("Yitro"),
-		 N_("Mishpatim"),	N_("Terumah"),		N_("Tetzaveh"),		/* 20 */
-		 N_("Ki_Tisa"),		N_("Vayakhel"),		N_("Pekudei"),
-		 N_("Vayikra"),		N_("Tzav"),		N_("Shmini"),
-		 N_("Tazria"),		N_("Metzora"),		N_("Achrei_Mot"),
-		 N_("Kedoshim"),	N_("Emor"),		N_("Behar"),		/* 32 */
-		 N_("Bechukotai"),	N_("Bamidbar"),		N_("Nasso"),
-		 N_("Beha'alotcha"),	N_("Sh'lach"),		N_("Korach"),
-		 N_("Chukat"),		N_("Balak"),		N_("Pinchas"),		/* 41 */
-		 N_("Matot"),		N_("Masei"),		N_("Devarim"),
-		 N_("Vaetchanan"),	N_("Eikev"),		N_("Re'eh"),
-		 N_("Shoftim"),		N_("Ki_Teitzei"),	N_("Ki_Tavo"),		/* 50 */
-		 N_("Nitzavim"),	N_("Vayeilech"),	N_("Ha'Azinu"),
-		 N_("Vezot_HaBracha"),	/* 54 */
-		 N_("Vayakhel-Pekudei"),N_("Tazria-Metzora"),	N_("Achrei_Mot-Kedoshim"),
-		 N_("Behar-Bechukotai"),N_("Chukat-Balak"),	N_("Matot-Masei"),
-		 N_("Nitzavim-Vayeilech")}
-		},
-		{ /// begin hebrew
-		{ /// begin hebrew long
-		 "none",		"בראשית",		"נח",
-		 "לך_לך",		"וירא",			"חיי_שרה",
-		 "תולדות",		"ויצא",			"וישלח",
-		 "וישב",		"מקץ",			"ויגש",		/* 11 */
-		 "ויחי",		"שמות",			"וארא",
-		 "בא",			"בשלח",			"יתרו",
-		 "משפטים",		"תרומה",		"תצוה",		/* 20 */
-		 "כי_תשא",		"ויקהל",		"פקודי",
-		 "ויקרא",		"צו",			"שמיני",
-		 "תזריע",		"מצורע",		"אחרי_מות",
-		 "קדושים",		"אמור",			"בהר",		/* 32 */
-		 "בחוקתי",		"במדבר",		"נשא",
-		 "בהעלתך",		"שלח",			"קרח",
-		 "חקת",			"בלק",			"פנחס",		/* 41 */
-		 "מטות",		"מסעי",			"דברים",
-		 "ואתחנן",		"עקב",			"ראה",
-		 "שופטים",		"כי_תצא",		"כי_תבוא",		/* 50 */
-		 "נצבים",		"וילך",			"האזינו",
-		 "וזאת_הברכה",	/* 54 */
-		 "ויקהל-פקודי",	"תזריע-מצורע",	"אחרי_מות-קדושים",
-		 "בהר-בחוקתי",	"חוקת-בלק",		"מטות-מסעי",
-		 "נצבים-וילך"},
-		{ /// begin hebrew short
-		 "none",		"בראשית",		"נח",
-		 "לך_לך",		"וירא",			"חיי_שרה",
-		 "תולדות",		"ויצא",			"וישלח",
-		 "וישב",		"מקץ",			"ויגש",		/* 11 */
-		 "ויחי",		"שמות",			"וארא",
-		 "בא",			"בשלח",			"יתרו",
-		 "משפטים",		"תרומה",		"תצוה",		/* 20 */
-		 "כי_תשא",		"ויקהל",		"פקודי",
-		 "ויקרא",		"צו",			"שמיני",
-		 "תזריע",		"מצורע",		"אחרי_מות",
-		 "קדושים",		"אמור",			"בהר",		/* 32 */
-		 "בחוקתי",		"במדבר",		"נשא",
-		 "בהעלתך",		"שלח",			"קרח",
-		 "חקת",			"בלק",			"פנחס",		/* 41 */
-		 "מטות",		"מסעי",			"דברים",
-		 "ואתחנן",		"עקב",			"ראה",
-		 "שופטים",		"כי_תצא",		"כי_תבוא",		/* 50 */
-		 "נצבים",		"וילך",			"האזינו",
-		 "וזאת_הברכה",	/* 54 */
-		 "ויקהל-פקודי",	"תזריע-מצורע",	"אחרי_מות-קדושים",
-		 "בהר-בחוקתי",	"חוקת-בלק",		"מטות-מסעי",
-		 "נצבים-וילך"}
-		}
-		};
-
-
-	static char *holidays[2][2][40] = {
-		{ /// begin english
-		{ /// begin english long
-/**  0 **/ N_("regular_weekday_(no_holiday)"),
-/**  1 **/ N_("Rosh_HaShana_(first_day)"),	N_("Rosh HaShana_(second_day)"),
-		   N_("Tzom_Gedaliah"),				N_("Yom_Kippur"),
-/**  5 **/ N_("Sukkot"),						N_("Hol_HaMoed_Sukkot"),
-		   N_("Hoshana_Rabbah"),				N_("Simchat_Torah"),
-/**  9 **/ N_("Chanukah"),					N_("Asara_B'Tevet"),
-		   N_("Tu_B'Shvat"),					N_("Ta'anit_Esther"),
-/** 13 **/ N_("Purim"),						N_("Shushan_Purim"),
-		   N_("Pesach"),						N_("Hol_HaMoed_Pesach"),
-/** 17 **/ N_("Yom_HaAtzma'ut"),				N_("Lag_B'Omer"),
-		   N_("Erev_Shavuot"),				N_("Shavuot"),
-/** 21 **/ N_("Tzom_Tammuz"),					N_("Tish'a_B'Av"),
-		   N_("Tu_B'Av"),						N_("Yom_HaShoah"),
-/** 25 **/ N_("Yom_HaZikaron"),				N_("Yom_Yerushalayim"),
-		   N_("Shmini_Atzeret"),				N_("Shevi'i_shel_Pesach"),
-/** 29 **/ N_("Acharon_shel_Pesach"),			N_("Shavuot_(second_day)"),
-		   N_("Sukkot_(second_day)"),			N_("Pesach_(second_day)"),
-/** 33 **/ N_("Family_Day"),					N_("Memorial_day_for_fallen_whose_place_of_burial_is_unknown"),
-		   N_("Yitzhak_Rabin_memorial_day"),	N_("Zeev_Zhabotinsky_day"),
-/** 37 **/ N_("Erev_Yom_Kippur"),				N_("Erev_Pesach"),
-/** 39 **/ N_("Erev_Sukkot")},
-		{ /// begin_english short
-/**  0 **/ N_("regular_day"),
-		 N_("Rosh HaShana_(day_1)"),	N_("Rosh HaShana_(day_2)"),
-		 N_("Tzom_Gedaliah"),			N_("Yom_Kippur"),
-		 N_("Sukkot"),					N_("Hol_HaMoed_Sukkot"),
-		 N_("Hoshana_Rabbah"),			N_("Simchat_Torah"),
-		 N_("Chanukah"),				N_("Asara_B'Tevet"),	/* 10 */
-		 N_("Tu_B'Shvat"),				N_("Ta'anit_Esther"),
-		 N_("Purim"),					N_("Shushan_Purim"),
-		 N_("Pesach"),					N_("Hol_HaMoed_Pesach"),
-		 N_("Yom_HaAtzma'ut"),			N_("Lag_B'Omer"),
-		 N_("Erev_Shavuot"),			N_("Shavuot"),			/* 20 */
-		 N_("Tzom_Tammuz"),				N_("Tish'a_B'Av"),
-		 N_("Tu_B'Av"),					N_("Yom_HaShoah"),
-		 N_("Yom_HaZikaron"),			N_("Yom_Yerushalayim"),
-		 N_("Shmini_Atzeret"),			N_("Pesach_(day_7)"),
-		 N_("Pesach_(day_8)"),			N_("Shavuot_(day_2)"),   /* 30 */
-		 N_("Sukkot_(day_2)"),			N_("Pesach_(day_2)"),
-		 N_("Family_Day"),				N_("Memorial_day_for_fallen_whose_place_of_burial_is_unknown"),
-		 N_("Rabin_memorial_day"),		N_("Zhabotinsky_day"),
-		 N_("Erev_Yom_Kippur"),			N_("Erev_Pesach"),
-		 N_("Erev_Sukkot")}
-		},
-		{ /// begin hebrew
-		{ /// begin hebrew long
-		 "יום_חול",
-		 "א'_ראש_השנה",		"ב'_ראש_השנה",
-		 "צום_גדליה",		"יום_הכפורים",
-		 "סוכות",		"חול_המועד_סוכות",
-		 "הושענא_רבה",		"שמחת_תורה",
-		 "חנוכה",		"צום_עשרה_בטבת",/* 10 */
-		 "ט\"ו_בשבט",		"תענית_אסתר",
-		 "פורים",		"שושן_פורים",
-		 "פסח",			"חול_המועד_פסח",
-		 "יום_העצמאות",		"ל\"ג_בעומר",
-		 "ערב_שבועות",		"שבועות",	/* 20 */
-		 "צום_שבעה_עשר_בתמוז",	"תשעה_באב",
-		 "ט\"ו_באב",		"יום_השואה",
-		 "יום_הזכרון",		"יום_ירושלים",
-		 "שמיני_עצרת",		"שביעי_פסח",
-		 "אחרון_של_פסח",	"שני_של_שבועות",/* 30 */
-		 "שני_של_סוכות",	"שני_של_פסח",
-		 "יום_המשפחה",		"יום_זכרון...",
-		 "יום_הזכרון_ליצחק_רבין","יום_ז\'בוטינסקי",
-		 "ערב_יום_הכפורים",	"ערב_פסח",
-		 "ערב_סוכות"},
-		{ /// begin hebrew short
-		 "חול",
-		 "א_ר\"ה",		 "ב'_ר\"ה",
-		 "צום_גדליה",		 "יוה\"כ",
-		 "סוכות",		 "חוה\"מ סוכות",
-		 "הוש\"ר",		 "שמח\"ת",
-		 "חנוכה",		 "י' בטבת",	/* 10 */
-		 "ט\"ו_בשבט",		 "תענית_אסתר",
-		 "פורים",		 "שושן_פורים",
-		 "פסח",			 "חוה\"מ פסח",
-		 "יום_העצמאות",		 "ל\"ג_בעומר",
-		 "ערב_שבועות",		 "שבועות",	/* 20 */
-		 "צום_תמוז",		 "ט' באב",
-		 "ט\"ו_באב",		 "יום_השואה",
-		 "יום_הזכרון",		 "יום_י-ם",
-		 "שמיני_עצרת",		 "ז' פסח",
-		 "אחרון_של_פסח",	 "ב' שבועות",   /* 30 */
-		 "ב' סוכות",		 "ב' פסח",
-		 "יום_המשפחה",		 "יום_זכרון...",
-		 "יום_הזכרון_ליצחק_רבין","יום_ז\'בוטינסקי",
-		 "עיוה\"כ",			"ע\"פ",
-		 "ערב_סוכות"}	}
-		};
-
 	/// This next is for counting days, weeks, or months
 	static char *count_days[23] = {
 		"שני", "אחד", "שניים", "שלשה", "ארבעה",	"חמשה",
@@ -520,63 +1151,21 @@ char* hdate_string( int const type_of_string, int const index, int const input_s
 
 	static char *vav = "ו";
 
-#ifdef ENABLE_NLS
-	bindtextdomain (PACKAGE, PACKAGE_LOCALE_DIR);
-	bind_textdomain_codeset (PACKAGE, "UTF-8");
-#endif
-
 	/// validate parameters
 	if (input_short_form != 0) short_form = 1;
 	if (input_hebrew_form != 0) hebrew_form = 1;
 
 	switch (type_of_string)
 	{
-	case HDATE_STRING_DOW: if (index >= 1 && index <= 7)
-		{
-	/** Use our local data structure and very limited set of gettext po
-	 ** translations only if the host OS does not have, or fails to set,
-	 ** the locale for time and date data. The exception for Hebrew is
-	 ** because a) it's expected to be used by users in all locales; and
-	 ** b) it's much 'cheap'er than setting and resetting the locale **/
-		if ((setlocale(LC_TIME,"") == NULL) || hebrew_form )
-				return _(days[hebrew_form][short_form][index - 1]);
-	/** If setlocale() returns a string, then the system has information
-	 ** that nl_langinfo can use to give us a localized string. **/
-		langinfo_ptr = nl_langinfo(langinfo_days[ ( (short_form*7)) + (index-1) ]);
-
-	/** nl_langinfo may return a pointer to a null string if it does
-	 ** not have the requeste value. In such a case return the English
-	 ** (or possibly gettext ?) string **/
-		if ( strcmp(langinfo_ptr, "") == 0 ) return _(days[hebrew_form][short_form][index - 1]);
-		else return langinfo_ptr;
-		}
-		break;
-	case HDATE_STRING_PARASHA: if (index >= 1 && index <= 61)
-				return _(parashaot[hebrew_form][short_form][index]);
-				break;
-	case HDATE_STRING_HMONTH: if (index >= 1 && index <= 14)
-				return _(hebrew_months[hebrew_form][short_form][index - 1]);
-				break;
-	case HDATE_STRING_GMONTH: if (index >= 1 && index <= 12)
-	/** Use our local data structure and very limited set of gettext po
-	 ** translations only if the host OS does not have, or fails to set,
-	 ** the locale for time and date data. **/
-		if (setlocale(LC_TIME,"") == NULL)
-				return _(gregorian_months[short_form][index - 1]);
-	/** This code improvement is to enable full internationalization
-	 ** using nl_langinfo(), which requires glibc/gcc constant literals
-	 ** so I've defined an array 'langinfo_months' with the list, for
-	 ** all month full names an abbreviations **/
-		langinfo_ptr = nl_langinfo(langinfo_months[ ((index-1)+(short_form*12)) ]);
-
-	/** nl_langinfo may return a pointer to a null string if it does
-	 ** not have the requested value. In such a case return the English
-	 ** (or possibly gettext ?) string **/
-		if ( strcmp(langinfo_ptr, "") == 0 ) return _(gregorian_months[short_form][index - 1]);
-		else return langinfo_ptr;
-		break;
-	case HDATE_STRING_HOLIDAY: if (index >= 0 && index <= 39)
-				return _(holidays[hebrew_form][short_form][index]);
+	case HDATE_STRING_DOW:
+	case HDATE_STRING_PARASHA:
+	case HDATE_STRING_HMONTH:
+	case HDATE_STRING_GMONTH:
+	case HDATE_STRING_HOLIDAY:
+	/** These are all static names, resolved once into the
+	 ** interned string table **/
+				return (char*) hdate_string_ref(type_of_string, index,
+									short_form, hebrew_form, NULL);
 				break;
 	case HDATE_STRING_OMER:
 				if (index > 0 && index < 50)
@@ -681,86 +1270,12 @@ char* hdate_string( int const type_of_string, int const index, int const input_s
 *                      101 - 114 for Hebrew
 * returns 0 on failure
 ************************************************************/
-// Better idea maybe: return 101 - 114 for Hebrew
 int hdate_parse_month_text_string( const char* month_text )
 {
-	/** This next call is supposed to guarantee that, if a locale
-	 ** exists, that the time spec for it is set. This is to enable
-	 ** full internationalization using nl_langinfo() **/
-	setlocale(LC_TIME,"");
-
-	int i;
-
-	/// Check for a match against the list of month strings for the
-	/// user's locale (both full month names and abbreviations)
-	for (i=0; i<24; i++)
-		if ( strcasecmp( month_text, nl_langinfo(langinfo_months[i])) == 0 )
-			return (i%12)+1;
-
-	/// Maybe the user entered a Hebrew month
-	for (i=0; i<14; i++)
-		if (( strcasecmp( month_text, hebrew_months[0][0][i]) == 0 ) ||
-			( strcasecmp( month_text, hebrew_months[1][0][i]) == 0 ) )
-			/// This checks the latin and Hebrew character strings
-			/// It ignores the 'short' versions because they are
-			/// in practice identical to the 'long' versions
-			return (i%14)+101;
-
-	/// Alternative latin character spellings of Hebrew Months
-	/// and alternative names of Hebrew months in latin characters
-	static char *alt_latin_spell_hebrew_months[14] = {
-		"@(?(@(Y|J)ere@(ch|kh|h|x|j)?( |_|-)Ha?(-))@(A|Ai|Ay|Ei)t?(h)a?(h)n@(i|ee)m|Ti[cs]hr@([ie]?(y)|a[iy]))",
-		"@(b@(oo|ou|u)?(l)l|?(Mar?( |-|_))@(?(C|K)h|X|J)e[sc]hva?(h)n)",
-		"Kisl@(e|[ae][iy])v",
-		"T@(e|[ae][iy])v@(e|[ae][iy])t",
-		"[SC]h?([e'])vat",
-		"Ad?(d)a?(h)r",
-		"N@(i|ee)s?(s)a?(h)n",
-		"@(ziv|zeev|@(I|e|Ee)?(y|yy|j)?(')a?(h)r)",
-		"[SC]@(i|ee)v?(v)a?(h)n",
-		"Tam?(m)uz",
-		"?(Mena@(ch|kh|x|j)@(e|ei|ey|ai|ay|i)m?( |_|-))A?(h)v",
-		"El?(l)@(u|ou|oo)l?(l)",
-		"Ad?(d)a?(h)r?( |-|_)@(A|1|I|alef|aleph)",
-		"Ad?(d)a?(h)r?( |-|_)@(B|2|II|bet?(h))"
-		};
-
-	for (i=0; i<14; i++)
-		if ( fnmatch( alt_latin_spell_hebrew_months[i], month_text, FNM_EXTMATCH|FNM_CASEFOLD)==0 )
-			return (i+101);
-
-	/// Alternative Hebrew names for Hebrew Months
-	static char *alt_hebrew_spell_hebrew_months[14] = {
-		"?(ירח?( |-|־)ה)איתנים",
-		"@(?(מר?( |-|־))חשון|בול)",
-		"",
-		"",
-		"",
-		"",
-		"",
-		"זיו",
-		"",
-		"",
-		"?(מנחם?( |-|־))אב",
-		"",
-		"אדר?( |-|־)א?(')",
-		"אדר?( |-|־)ב?(')"
-		};
-
-	for (i=0; i<14; i++)
-		if ( fnmatch( alt_hebrew_spell_hebrew_months[i], month_text, FNM_EXTMATCH|FNM_CASEFOLD)==0 )
-			return (i+101);
-
+	int month, calendar;
 
-	// This REALLY should not be necessary ...
-	/** nl_langinfo may return a pointer to a null string if it does
-	 ** not have the requested value. In such a case return the English
-	 ** (or possibly gettext ?) string **/
-	for (i=0; i<14; i++)
-		if (( strcasecmp( month_text, gregorian_months[0][i]) == 0 ) ||
-			( strcasecmp( month_text, gregorian_months[1][i]) == 0 ) )
-			return (i%12)+1;
-
-
-	return 0;
+	if (month_text == NULL) return 0;
+	month = hdate_match_month_name(month_text, strlen(month_text), 0, &calendar);
+	if (calendar == HDATE_CALENDAR_HEBREW) return month + 100;
+	return month;
 }
@@ -117,8 +117,8 @@ hdate_get_utc_sun_time_deg_seconds ( const int day, const int month, const int y
 	/* check for too high altitudes and return negative values */
 	if (errno == EDOM)
 	{
-		*sunrise = -720;
-		*sunset = -720;
+		*sunrise = HDATE_NO_ZMAN;
+		*sunset = HDATE_NO_ZMAN;
 		return;
 	}
 
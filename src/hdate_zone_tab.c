@@ -0,0 +1,382 @@
+/*  libhdate - Hebrew calendar library: http://libhdate.sourceforge.net
+ *
+ *  zone.tab index: timezone names, countries and coordinates, read
+ *  once and shared by all callers
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE		/// for strcasestr
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>	/// for strcasecmp
+#include <math.h>
+#include <pthread.h>	/// for pthread_once
+#include "hdate.h"
+#include "support.h"
+
+#define DEFAULT_ZONE_TAB_PATH "/usr/share/zoneinfo/zone.tab"
+#define EARTH_RADIUS_KM 6371.0
+#define RADIANS(x) ((x) * M_PI / 180.0)
+
+
+/// the zone.tab index. Built once; never modified or released.
+typedef struct
+{
+	char* text;							/// the file, tokenized in place
+	hdate_zone_tab_entry* entry;		/// in file order
+	size_t count;
+	const hdate_zone_tab_entry** by_name;	/// sorted by name, ignoring case
+	const hdate_zone_tab_entry** by_lat;	/// sorted by latitude
+} zone_tab;
+
+static zone_tab zone_tab_index;
+static pthread_once_t zone_tab_once = PTHREAD_ONCE_INIT;
+
+
+/************************************************************
+* parse_dms
+*
+* reads a signed coordinate of the form [+-]DDMM[SS] or
+* [+-]DDDMM[SS], with deg_digits digits of degrees. returns a
+* pointer past it, or NULL.
+************************************************************/
+static const char* parse_dms( const char* s, const int deg_digits, double* value )
+{
+	int sign, digits, i;
+	long field[3] = {0, 0, 0};
+
+	if ( (*s != '+') && (*s != '-') ) return NULL;
+	sign = (*s == '-') ? -1 : 1;
+	s++;
+	for (digits = 0; (s[digits] >= '0') && (s[digits] <= '9'); digits++);
+	if ( (digits != deg_digits + 2) && (digits != deg_digits + 4) ) return NULL;
+	for (i = 0; i < digits; i++)
+	{
+		if (i < deg_digits) field[0] = field[0] * 10 + (s[i] - '0');
+		else field[(i - deg_digits) / 2 + 1] = field[(i - deg_digits) / 2 + 1] * 10 + (s[i] - '0');
+	}
+	*value = sign * (field[0] + (double) field[1] / 60 + (double) field[2] / 3600);
+	return s + digits;
+}
+
+
+/************************************************************
+* compare_name, compare_lat
+*
+* qsort() and bsearch() comparisons for the indices
+************************************************************/
+static int compare_name( const void* a, const void* b )
+{
+	return strcasecmp( (*(const hdate_zone_tab_entry**) a)->name,
+					   (*(const hdate_zone_tab_entry**) b)->name );
+}
+
+static int compare_lat( const void* a, const void* b )
+{
+	double lat_a = (*(const hdate_zone_tab_entry**) a)->latitude;
+	double lat_b = (*(const hdate_zone_tab_entry**) b)->latitude;
+	return (lat_a > lat_b) - (lat_a < lat_b);
+}
+
+
+/************************************************************
+* zone_tab_read
+*
+* reads the whole of zone.tab from TZDIR, or the default path
+************************************************************/
+static char* zone_tab_read( void )
+{
+	char* tzdir;
+	char* path = NULL;
+	FILE* file = NULL;
+	char* text = NULL;
+	long size;
+
+	tzdir = getenv("TZDIR");
+	if ( (tzdir != NULL) && (asprintf(&path, "%s/zone.tab", tzdir) != -1) )
+	{
+		file = fopen(path, "rb");
+		free(path);
+	}
+	if (file == NULL) file = fopen(DEFAULT_ZONE_TAB_PATH, "rb");
+	if (file == NULL) return NULL;
+	if ( (fseek(file, 0, SEEK_END) == 0) && ((size = ftell(file)) > 0) &&
+		 (fseek(file, 0, SEEK_SET) == 0) )
+	{
+		text = malloc(size + 1);
+		if ( (text != NULL) && (fread(text, 1, size, file) == (size_t) size) )
+			text[size] = '\0';
+		else
+		{
+			free(text);
+			text = NULL;
+		}
+	}
+	fclose(file);
+	return text;
+}
+
+
+/************************************************************
+* zone_tab_build
+*
+* parses zone.tab into zone_tab_index. Each line is:
+*   country-code  coordinates  TZ  [comments]
+* separated by tabs; lines beginning with '#' are comments.
+************************************************************/
+static void zone_tab_build( void )
+{
+	zone_tab* tab = &zone_tab_index;
+	hdate_zone_tab_entry* entry;
+	char *line, *next_line, *field[4];
+	const char* ptr;
+	size_t lines = 1;
+	size_t i;
+	int fields;
+
+	tab->text = zone_tab_read();
+	if (tab->text == NULL) return;
+	for (line = tab->text; (line = strchr(line, '\n')) != NULL; line++) lines++;
+	tab->entry = malloc(lines * sizeof(hdate_zone_tab_entry));
+	if (tab->entry == NULL) return;
+
+	for (line = tab->text; line != NULL; line = next_line)
+	{
+		next_line = strchr(line, '\n');
+		if (next_line != NULL) *next_line++ = '\0';
+		if ( (*line == '#') || (*line == '\0') ) continue;
+		for (fields = 0; (fields < 4) && (line != NULL); fields++)
+		{
+			field[fields] = line;
+			line = (fields < 3) ? strchr(line, '\t') : NULL;
+			if (line != NULL) *line++ = '\0';
+		}
+		if ( (fields < 3) || (strlen(field[0]) != 2) ) continue;
+
+		entry = &tab->entry[tab->count];
+		ptr = parse_dms(field[1], 2, &entry->latitude);
+		if (ptr == NULL) continue;
+		ptr = parse_dms(ptr, 3, &entry->longitude);
+		if ( (ptr == NULL) || (*ptr != '\0') ) continue;
+		memcpy(entry->country, field[0], 3);
+		entry->name = field[2];
+		entry->comment = (fields == 4) ? field[3] : "";
+		tab->count++;
+	}
+
+	tab->by_name = malloc(tab->count * sizeof(hdate_zone_tab_entry*));
+	tab->by_lat = malloc(tab->count * sizeof(hdate_zone_tab_entry*));
+	if ( (tab->by_name == NULL) || (tab->by_lat == NULL) )
+	{
+		tab->count = 0;
+		return;
+	}
+	for (i = 0; i < tab->count; i++)
+		tab->by_name[i] = tab->by_lat[i] = &tab->entry[i];
+	qsort(tab->by_name, tab->count, sizeof(hdate_zone_tab_entry*), compare_name);
+	qsort(tab->by_lat, tab->count, sizeof(hdate_zone_tab_entry*), compare_lat);
+}
+
+
+/************************************************************
+* zone_tab_get
+*
+* the index, built upon first use
+************************************************************/
+static const zone_tab* zone_tab_get( void )
+{
+	pthread_once(&zone_tab_once, zone_tab_build);
+	return &zone_tab_index;
+}
+
+
+/**
+ @brief   the number of entries in the zone.tab index. The file is
+          read upon first use of any hdate_zone_tab function.
+ @return  the number of entries, or 0 if zone.tab could not be read
+*/
+size_t
+hdate_zone_tab_count( void )
+{
+	return zone_tab_get()->count;
+}
+
+
+/**
+ @brief   an entry of the zone.tab index, in file order
+ @return  the entry, or NULL if index is out of range
+ @param index  0 to hdate_zone_tab_count() - 1
+*/
+const hdate_zone_tab_entry*
+hdate_zone_tab_get( const size_t index )
+{
+	const zone_tab* tab = zone_tab_get();
+
+	if (index >= tab->count) return NULL;
+	return &tab->entry[index];
+}
+
+
+/**
+ @brief   look up a timezone by its exact name, ignoring case
+ @return  the entry, or NULL if not found
+ @param name  eg. Asia/Jerusalem
+*/
+const hdate_zone_tab_entry*
+hdate_zone_tab_find( const char* name )
+{
+	const zone_tab* tab = zone_tab_get();
+	hdate_zone_tab_entry key;
+	const hdate_zone_tab_entry* key_ptr = &key;
+	const hdate_zone_tab_entry** found;
+
+	if ( (name == NULL) || (tab->count == 0) ) return NULL;
+	key.name = name;
+	found = bsearch(&key_ptr, tab->by_name, tab->count,
+					sizeof(hdate_zone_tab_entry*), compare_name);
+	return (found == NULL) ? NULL : *found;
+}
+
+
+/**
+ @brief   search for a timezone by part of its name, ignoring case.
+          Leading and trailing spaces are ignored, and embedded
+          spaces match underscores, so that "new york" finds
+          America/New_York.
+ @return  an exact match if there is one, else the first matching
+          entry in file order, or NULL
+ @param text  the search string
+*/
+const hdate_zone_tab_entry*
+hdate_zone_tab_search( const char* text )
+{
+	const zone_tab* tab = zone_tab_get();
+	const hdate_zone_tab_entry* found = NULL;
+	char* search_string;
+	size_t len, i;
+
+	if (text == NULL) return NULL;
+	text += strspn(text, " ");
+	len = strlen(text);
+	while ( (len) && (text[len - 1] == ' ') ) len--;
+	if (len == 0) return NULL;
+	search_string = malloc(len + 1);
+	if (search_string == NULL) return NULL;
+	for (i = 0; i < len; i++) search_string[i] = (text[i] == ' ') ? '_' : text[i];
+	search_string[len] = '\0';
+
+	found = hdate_zone_tab_find(search_string);
+	for (i = 0; (i < tab->count) && (found == NULL); i++)
+		if (strcasestr(tab->entry[i].name, search_string) != NULL)
+			found = &tab->entry[i];
+	free(search_string);
+	return found;
+}
+
+
+/**
+ @brief   great-circle distance between two points, in kilometers
+ @return  the distance
+*/
+double
+hdate_distance_km( const double lat_a, const double lon_a,
+				   const double lat_b, const double lon_b )
+{
+	double d_lat = RADIANS(lat_b - lat_a);
+	double d_lon = RADIANS(lon_b - lon_a);
+	double h;
+
+	h = sin(d_lat / 2) * sin(d_lat / 2) +
+		cos(RADIANS(lat_a)) * cos(RADIANS(lat_b)) * sin(d_lon / 2) * sin(d_lon / 2);
+	return 2 * EARTH_RADIUS_KM * asin( sqrt( (h > 1) ? 1 : h ) );
+}
+
+
+/**
+ @brief   the zone.tab entry whose coordinates are nearest a point
+ @return  the entry, or NULL if the index is empty
+ @param latitude     of the point
+ @param longitude    of the point
+ @param distance_km  if not NULL, receives the distance to the entry
+*/
+const hdate_zone_tab_entry*
+hdate_zone_tab_nearest( const double latitude, const double longitude,
+						double* distance_km )
+{
+	const zone_tab* tab = zone_tab_get();
+	const hdate_zone_tab_entry* best = NULL;
+	double best_distance = HUGE_VAL;
+	double distance;
+	size_t low, high, mid;
+	size_t up, down;
+	int searching_up, searching_down;
+
+	if (tab->count == 0) return NULL;
+
+	/// start at the point's latitude, and work outwards. A point
+	/// cannot be nearer than its difference in latitude alone.
+	low = 0;
+	high = tab->count;
+	while (low < high)
+	{
+		mid = low + (high - low) / 2;
+		if (tab->by_lat[mid]->latitude < latitude) low = mid + 1;
+		else high = mid;
+	}
+	up = low;
+	down = low;
+	searching_up = (up < tab->count);
+	searching_down = (down > 0);
+	while (searching_up || searching_down)
+	{
+		if (searching_up)
+		{
+			if (EARTH_RADIUS_KM * RADIANS(tab->by_lat[up]->latitude - latitude) > best_distance)
+				searching_up = FALSE;
+			else
+			{
+				distance = hdate_distance_km(latitude, longitude,
+								tab->by_lat[up]->latitude, tab->by_lat[up]->longitude);
+				if (distance < best_distance)
+				{
+					best_distance = distance;
+					best = tab->by_lat[up];
+				}
+				up++;
+				searching_up = (up < tab->count);
+			}
+		}
+		if (searching_down)
+		{
+			if (EARTH_RADIUS_KM * RADIANS(latitude - tab->by_lat[down - 1]->latitude) > best_distance)
+				searching_down = FALSE;
+			else
+			{
+				distance = hdate_distance_km(latitude, longitude,
+								tab->by_lat[down - 1]->latitude, tab->by_lat[down - 1]->longitude);
+				if (distance < best_distance)
+				{
+					best_distance = distance;
+					best = tab->by_lat[down - 1];
+				}
+				down--;
+				searching_down = (down > 0);
+			}
+		}
+	}
+	if (distance_km != NULL) *distance_km = best_distance;
+	return best;
+}
@@ -27,6 +27,8 @@
 #ifndef __HDATE_PP_H__
 #define __HDATE_PP_H__
 
+#include <string>
+#include <vector>
 #include <hdate.h>
 
 /**
@@ -667,8 +669,127 @@ namespace hdate
 			diaspora = HDATE_ISRAEL_FLAG;
 		}
 
+		////////////////////////////////////////
+		////////////////////////////////////////
+
+		/*
+		 The range methods return the results for count days, from
+		 this date on, packed as native-endian 32 bit integers in a
+		 binary string, so that a batch crosses the language boundary
+		 once: Ruby String#unpack("l*"), Perl unpack("l*", ...), PHP
+		 unpack("l*", ...), Python struct.unpack, which the python
+		 binding gives bytes rather than str.
+		 */
+
+		/**
+		 @brief gregorian dates of a range of days
+
+		 @param count number of days
+		 @return day, month, year of each day
+		*/
+		std::string
+		get_gdate_range (int count)
+		{
+			std::vector<int> jd = range (count);
+			if (jd.empty ()) return std::string ();
+			std::string packed (jd.size () * 3 * sizeof (int), '\0');
+			int *out = (int *) &packed[0];
+
+			for (size_t i = 0; i < jd.size (); i++)
+				hdate_jd_to_gdate (jd[i], &out[3 * i], &out[3 * i + 1], &out[3 * i + 2]);
+			return packed;
+		}
+
+		/**
+		 @brief Hebrew dates of a range of days
+
+		 @param count number of days
+		 @return day, month, year of each day; months are 1..14, as
+			for hdate_jd_to_hdate_bulk
+		*/
+		std::string
+		get_hdate_range (int count)
+		{
+			std::vector<int> jd = range (count);
+			if (jd.empty ()) return std::string ();
+			std::string packed (jd.size () * 3 * sizeof (int), '\0');
+			int *out = (int *) &packed[0];
+
+			for (size_t i = 0; i < jd.size (); i++)
+				hdate_jd_to_hdate (jd[i], &out[3 * i], &out[3 * i + 1], &out[3 * i + 2],
+					NULL, NULL);
+			return packed;
+		}
+
+		/**
+		 @brief holidays of a range of days
+
+		 @param count number of days
+		 @return the holiday number of each day, or 0
+		*/
+		std::string
+		get_holyday_range (int count)
+		{
+			std::vector<int> jd = range (count);
+			if (jd.empty ()) return std::string ();
+			std::string packed (jd.size () * sizeof (int), '\0');
+
+			hdate_get_holyday_bulk (&jd[0], jd.size (), diaspora, (int *) &packed[0]);
+			return packed;
+		}
+
+		/**
+		 @brief parashiot of a range of days
+
+		 @param count number of days
+		 @return the parasha number of each day, or 0
+		*/
+		std::string
+		get_parasha_range (int count)
+		{
+			std::vector<int> jd = range (count);
+			if (jd.empty ()) return std::string ();
+			std::string packed (jd.size () * sizeof (int), '\0');
+
+			hdate_get_parasha_bulk (&jd[0], jd.size (), diaspora, (int *) &packed[0]);
+			return packed;
+		}
+
+		/**
+		 @brief times of a range of days at this location
+
+		 @param count number of days
+		 @return the fourteen members of hdate_zmanim of each day, in
+			seconds after midnight (00:00) utc
+		*/
+		std::string
+		get_zmanim_range (int count)
+		{
+			std::vector<int> jd = range (count);
+			if (jd.empty ()) return std::string ();
+			std::string packed (jd.size () * sizeof (hdate_zmanim), '\0');
+
+			hdate_get_utc_zmanim_bulk (&jd[0], jd.size (), &latitude, &longitude, 1, 0,
+				(hdate_zmanim *) &packed[0]);
+			return packed;
+		}
+
 	private:
 
+		/**
+		 @brief julian days of count days from this date; none if
+			count is not positive
+		*/
+		std::vector<int>
+		range (int count)
+		{
+			std::vector<int> jd (count > 0 ? count : 0);
+
+			for (size_t i = 0; i < jd.size (); i++)
+				jd[i] = h->hd_jd + i;
+			return jd;
+		}
+
 		int diaspora;
 		double latitude;
 		double longitude;
@@ -25,7 +25,6 @@
 // next possibly not necessary
 #define _GNU_SOURCE     /// feature_test_macro - for memmem
 #define _POSIX_C_SOURCE 1
-#define _BSD_SOURCE 1   /// for tm.tm_zone, tm.tm_gmtoff (man(3) ctime)
 #include <time.h>		/// for time, ctime
 #include <stdlib.h>		/// for getenv
 #include <unistd.h>		/// for getcwd, fstat
@@ -34,6 +33,10 @@
 #include <sys/stat.h>	/// for fstat
 #include <unistd.h>		/// for fstat
 #include <string.h> 	/// for memcpy
+#include <fcntl.h>		/// for open
+#include <sys/mman.h>	/// for mmap
+#include <pthread.h>	/// for the zone cache mutex
+#include <limits.h>		/// for LONG_MAX
 
 #define ZD_SUCCESS  0
 #define ZD_FAILURE -1
@@ -44,11 +47,6 @@
 #define ZD_MALLOC      5005 /** memory allocation error */
 #define ZD_TZIF_HEADER 5006 /** unable to parse tzif header */
 
-#define NUMERIC "-123456789"
-#define TIMERIC "-123456789:"
-#define NOTABBR "-123456789:,"
-
-
 /// zdumpinfo - an element of the array to return
 #define MAX_TZ_ABBR_SIZE   10  /// safe
 typedef struct {
@@ -73,32 +71,66 @@ typedef struct {
 	} timezonefileheader;
 #define TZIF1_FIELD_SIZE 4
 #define TZIF2_FIELD_SIZE 8
-static char *local_time_type_ptr, *ttinfo_ptr, *tz_abbrev_ptr;
 #define SIZE_OF_TTINFO 6
 
 
+/// rule_change - a change of a posix rule, into DST or back to STD
+typedef struct {
+	char type;			/// 'J' (1-365, no leap day), 'N' (0-365) or 'M'
+	int  j;				/// day of year, for 'J' and 'N'
+	int  m, w, d;		/// month, week and day of week, for 'M'
+	int  time;			/// seconds after local midnight
+	} rule_change;
+
 /// posix rule details
 typedef struct {
-	char type[2];
 	char abbr[2][MAX_TZ_ABBR_SIZE];
-	int j[2];
-	int m[2];
-	int w[2];
-	int d[2];
-	int offset[2];
-	int start_time[2];
-	int hour[2];
-	int min[2];
-	int sec[2];
-	int has_dst;
-	int save_secs[2];
+	int  utc_offset[2];	/// seconds east of UTC
+	int  has_dst;
+	int  save_secs;
+	rule_change change[2];	/// [DST] into daylight time, [STD] back
 	} rule_detail;
 #define STD 0
 #define DST 1
 #define DEFAULT_START_TIME 2 * 60 * 60
-#define DEFAULT_START_HOUR 2
-#define DEFAULT_START_MIN  0
-#define DEFAULT_START_SEC  0
+
+
+/// zd_zone - a TZif file, mapped and parsed once, then kept in a
+/// process-wide cache. The transition times are decoded into a
+/// sorted array, so that an instant can be found by binary search.
+/// Once published, a zone is never modified, so any number of
+/// threads may query it.
+typedef struct zd_zone {
+	char*		dir;			/// cache key: zoneinfo directory
+	char*		name;			/// cache key: zone name
+	char*		map;			/// the mmap()ed file
+	size_t		map_size;
+	long unsigned timecnt;
+	time_t*		transition;		/// [timecnt] ascending
+	unsigned char* type_index;	/// [timecnt] index into ttinfo
+	long unsigned typecnt;
+	const char*	ttinfo;			/// [typecnt * SIZE_OF_TTINFO], in map
+	const char*	abbrev;			/// [charcnt], in map
+	long unsigned charcnt;
+	char*		rule;			/// POSIX TZ footer string, or NULL
+	rule_detail	p_rule;			/// the footer, decoded
+	int			has_rule;
+	struct zd_zone* next;
+	} zd_zone;
+
+static zd_zone *zone_cache = NULL;
+static pthread_mutex_t zone_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// zd_dir - an open zoneinfo directory, for openat()
+typedef struct zd_dir {
+	char*		path;
+	int			fd;
+	struct zd_dir* next;
+	} zd_dir;
+
+static zd_dir *zone_dirs = NULL;
+static const char* zone_default_dir = NULL;
+static pthread_once_t zone_default_dir_once = PTHREAD_ONCE_INIT;
 
 
 #define BUFFER_INCREMENT 3  /// safe for a single year
@@ -131,27 +163,6 @@ signed long flip_tz_long( const char *sourceptr, const unsigned int field_size)
 	return retval;
 }
 
-void j_to_md ( int j, int* m, int* d)
-{
-	/// For the TZ rule,   j = 1 - 365. no leap yeaers recognized
-	/// For the tm struct, j = 0 -365, leap years ARE recognized
-	/// This function parses the TZ POSIX rule into terms compatible
-	/// with the tm struct: m = 0 - 11, d = 1 -31
-/**jan*/if (j<32)         { *m = 0; *d = j; }
-/**feb*/else if (j < 60)  { *m = 1; *d = j-31; }
-/**mar*/else if (j < 91)  { *m = 2; *d = j-60; }
-/**apr*/else if (j < 121) { *m = 3; *d = j-91 ; }
-/**may*/else if (j < 152) { *m = 4; *d = j-121; }
-/**jun*/else if (j < 182) { *m = 5; *d = j-152; }
-/**jul*/else if (j < 213) { *m = 6; *d = j-182; }
-/**aug*/else if (j < 244) { *m = 7; *d = j-213; }
-/**sep*/else if (j < 274) { *m = 8; *d = j-244; }
-/**oct*/else if (j < 305) { *m = 9; *d = j-274; }
-/**nov*/else if (j < 335) { *m = 10; *d = j-305; }
-/**dec*/else              { *m = 11; *d = j-335; }
-	return;
-}
-
 int read_tz_header( timezonefileheader *header,  const char *temp_buffer)
 {
 	const int field_size = 4;
@@ -179,377 +190,720 @@ void add_a_rule_entry( const time_t start, void* return_data, int* num_entries,
 	*num_entries = *num_entries + 1;
 }
 
-void add_a_tzif_entry( const int i, const time_t start, void* return_data, int* num_entries )
+void add_a_tzif_entry( const zd_zone* zone, const int i, const time_t start,
+                       void* return_data, int* num_entries )
 {
 	char* endptr;
-	int local_time_offset = local_time_type_ptr[i] * SIZE_OF_TTINFO;
-	char* tzabbr;
+	int local_time_offset = zone->type_index[i] * SIZE_OF_TTINFO;
+	const char* tzabbr;
 	zdumpinfo* zd;
 	int prior_local_time_offset;
 
 	zd = (zdumpinfo*) return_data + *num_entries;
 	zd->start = start;
-	zd->utc_offset = (int) flip_tz_long( ttinfo_ptr + local_time_offset, 4);
+	zd->utc_offset = (int) flip_tz_long( zone->ttinfo + local_time_offset, 4);
 	zd->save_secs = 0;
-	if ((i != 0) && (ttinfo_ptr[ local_time_offset + 4 ]))
+	if ((i != 0) && (zone->ttinfo[ local_time_offset + 4 ]))
 	{
-		prior_local_time_offset = local_time_type_ptr[i-1] * SIZE_OF_TTINFO;
+		prior_local_time_offset = zone->type_index[i-1] * SIZE_OF_TTINFO;
 		zd->save_secs = abs( zd->utc_offset
-						- ((int) flip_tz_long( ttinfo_ptr + prior_local_time_offset, 4)) );
+						- ((int) flip_tz_long( zone->ttinfo + prior_local_time_offset, 4)) );
 	}
-	tzabbr = &tz_abbrev_ptr[ (int) ttinfo_ptr[ local_time_offset + 5 ] ];
-	endptr = mempcpy( zd->abbr, tzabbr, strlen(tzabbr) );
+	tzabbr = &zone->abbrev[ (unsigned char) zone->ttinfo[ local_time_offset + 5 ] ];
+	endptr = mempcpy( zd->abbr, tzabbr, strnlen(tzabbr, MAX_TZ_ABBR_SIZE - 1) );
 	memset( endptr, '\0', 1);
 	*num_entries = *num_entries + 1;
 }
 
-int get_time( char *strptr, int *hour, int *min, int *sec )
+/************************************************************
+* rule_abbr
+*
+* reads a POSIX TZ abbreviation, either alphabetic or quoted
+* in angle brackets. returns a pointer past it, or NULL.
+************************************************************/
+static const char* rule_abbr( const char* s, char* abbr )
 {
-	int fields_found = 0;
-	int sign;
+	size_t len;
 
-	fields_found = sscanf(strptr, "%i:%i:%i", hour, min, sec);
-	switch (fields_found)
+	if (*s == '<')
+	{
+		s++;
+		len = strcspn(s, ">");
+		if (s[len] != '>') return NULL;
+	}
+	else
 	{
-	case 0: *hour = DEFAULT_START_HOUR;
-	case 1: *min = DEFAULT_START_MIN;
-	case 2: *sec = DEFAULT_START_SEC;
+		for (len = 0; ((s[len] >= 'a') && (s[len] <= 'z')) ||
+					  ((s[len] >= 'A') && (s[len] <= 'Z')); len++);
 	}
-	sign = *hour < 0 ? -1 : 1;
-	return (*hour * 3600) + (sign * ((*min * 60) + *sec));
+	if (len == 0) return NULL;
+	memcpy(abbr, s, (len < MAX_TZ_ABBR_SIZE) ? len : MAX_TZ_ABBR_SIZE - 1);
+	abbr[(len < MAX_TZ_ABBR_SIZE) ? len : MAX_TZ_ABBR_SIZE - 1] = '\0';
+	s += len;
+	if (*s == '>') s++;
+	return s;
 }
 
-char* rule_julian( int i, char* next, rule_detail* p_rule )
+
+/************************************************************
+* rule_time
+*
+* reads [+|-]hh[:mm[:ss]] into seconds. returns a pointer past
+* it, or NULL.
+************************************************************/
+static const char* rule_time( const char* s, int* secs )
 {
-	char julian[4];
-	int  len = 0;
-
-
-	next++;
-	p_rule->type[i] = 'J';
-	len = strspn(next, NUMERIC);
-	if (len > 3) return NULL;
-	memcpy(&julian, next, len);
-	memset(&julian[len],'\0',1);
-	p_rule->j[i] = atoi( (char*) &julian);
-	j_to_md(p_rule->j[i], &p_rule->m[i], &p_rule->d[i]);
-	next += len;
-	if (*next == '/') p_rule->start_time[i] = get_time(next+1,
-									&p_rule->hour[i], &p_rule->min[i], &p_rule->sec[i]);
-	else
+	int sign = 1;
+	int field = 0;
+	int value;
+
+	*secs = 0;
+	if (*s == '+') s++;
+	else if (*s == '-') {sign = -1; s++;};
+	for (field = 0; field < 3; field++)
 	{
-		p_rule->start_time[i] = DEFAULT_START_TIME;
-		p_rule->hour[i] = DEFAULT_START_HOUR;
-		p_rule->min[i] = DEFAULT_START_MIN;
-		p_rule->sec[i] = DEFAULT_START_SEC;
+		if ( (*s < '0') || (*s > '9') ) return NULL;
+		for (value = 0; (*s >= '0') && (*s <= '9'); s++)
+			value = (value * 10) + (*s - '0');
+		if (value > ((field == 0) ? 167 : 59)) return NULL;
+		*secs += value * ((field == 0) ? 3600 : (field == 1) ? 60 : 1);
+		if ((*s != ':') || (field == 2)) break;
+		s++;
 	}
-	return strchr( next, ',' );
+	*secs *= sign;
+	return s;
 }
 
-char* rule_mwd( int i, char* next, rule_detail* p_rule )
+
+/************************************************************
+* rule_date
+*
+* reads one date of a POSIX TZ rule: Jn, n, or Mm.w.d, with an
+* optional /time. returns a pointer past it, or NULL.
+************************************************************/
+static const char* rule_date( const char* s, rule_change* change )
 {
-	char *next_time  = NULL;
-	p_rule->type[i] = 'M';
-	next++;
-	// maybe error-check for 3 values read in sscanf?
-	sscanf(next, "%i.%i.%i", &p_rule->m[i], &p_rule->w[i], &p_rule->d[i]);
-	next_time = strchr( next, '/' );
-	next      = strchr( next, ',' );
-	if ((next_time != NULL) && ((next == NULL) || (next_time < next)))
+	char* endptr;
+
+	change->time = DEFAULT_START_TIME;
+	if (*s == 'M')
 	{
-		next_time++;
-		p_rule->start_time[i] = get_time(next_time, &p_rule->hour[i], &p_rule->min[i], &p_rule->sec[i]);
+		change->type = 'M';
+		change->m = strtol(s + 1, &endptr, 10);
+		if (*endptr != '.') return NULL;
+		change->w = strtol(endptr + 1, &endptr, 10);
+		if (*endptr != '.') return NULL;
+		change->d = strtol(endptr + 1, &endptr, 10);
+		if ( (change->m < 1) || (change->m > 12) || (change->w < 1) ||
+			 (change->w > 5) || (change->d < 0) || (change->d > 6) )
+			return NULL;
 	}
 	else
 	{
-		p_rule->start_time[i] = DEFAULT_START_TIME;
-		p_rule->hour[i] = DEFAULT_START_HOUR;
-		p_rule->min[i] = DEFAULT_START_MIN;
-		p_rule->sec[i] = DEFAULT_START_SEC;
+		change->type = (*s == 'J') ? 'J' : 'N';
+		if (*s == 'J') s++;
+		if ( (*s < '0') || (*s > '9') ) return NULL;
+		change->j = strtol(s, &endptr, 10);
+		if ( (change->j > 365) || ((change->type == 'J') && (change->j < 1)) )
+			return NULL;
 	}
-	return next;
+	s = endptr;
+	if (*s == '/') s = rule_time(s + 1, &change->time);
+	return s;
 }
 
-int rule_decode( const char* tzif, const size_t tzif_size, rule_detail* p_rule )
+
+/************************************************************
+* rule_decode
+*
+* parses a POSIX TZ string, eg. "IST-2IDT,M3.4.4/26,M10.5.0",
+* as found in the footer of a TZif version 2+ file.
+************************************************************/
+int rule_decode( const char* rule, rule_detail* p_rule )
 {
-	char *rule_string = NULL;
-	int  rule_len;
-	char *next = NULL;
-	int  len = 0;
-	int  offset_hour, offset_min, offset_sec;
-
-	// consider error checking and bounds checking
-	// don't depend on it being a valid file
-	if ( tzif[tzif_size] == '\x0a' ) return ZD_FAILURE;
-	rule_string = memrchr( tzif, '\x0a', tzif_size);
-	if (rule_string == NULL) return ZD_FAILURE;
-	rule_string++;
-	next = rule_string;
-	setenv("TZ",rule_string,1);
-	rule_len = strlen(rule_string);
-	if (rule_len == 0) return ZD_FAILURE;
+	const char* next = rule;
+	int offset;
+
+	if (rule == NULL) return ZD_FAILURE;
 	memset(p_rule,'\0',sizeof(rule_detail));
-	len = strcspn(rule_string, NUMERIC);
-	memcpy(p_rule->abbr[STD], rule_string, len);
-	next += len;
-	len = strspn(next, TIMERIC);
-	p_rule->offset[STD] = get_time( next, &offset_hour, &offset_min, &offset_sec );
-	next +=  len;
-	if ( next != (rule_string + rule_len -1) )
+	next = rule_abbr(next, p_rule->abbr[STD]);
+	if (next == NULL) return ZD_FAILURE;
+	next = rule_time(next, &offset);
+	if (next == NULL) return ZD_FAILURE;
+	/// POSIX offsets are positive west of Greenwich
+	p_rule->utc_offset[STD] = -offset;
+	if (*next == '\0') return ZD_SUCCESS;
+
+	p_rule->has_dst = 1;
+	next = rule_abbr(next, p_rule->abbr[DST]);
+	if (next == NULL) return ZD_FAILURE;
+	if ( (*next != ',') && (*next != '\0') )
 	{
-		p_rule->has_dst = 1;
-		len = strcspn(next, NOTABBR);
-		memcpy(p_rule->abbr[DST], next, len);
-		next += len;
-		len = strspn(next, TIMERIC);
-		if (len == 0) p_rule->offset[DST] = p_rule->offset[STD] + 3600;
-		else p_rule->offset[DST] = get_time( next, &offset_hour, &offset_min, &offset_sec );
-		next += len;
-		p_rule->save_secs[STD] = abs(p_rule->offset[DST] - p_rule->offset[STD]);
-		next++;
-		if (*next == 'J') next = rule_julian(STD, next, p_rule);
-		else next = rule_mwd(STD, next, p_rule);
-		if (next && *next == ',')
-		{
-			next++;
-			if (*next == 'J') next = rule_julian(DST, next, p_rule);
-			else next = rule_mwd(DST, next, p_rule);
-		}
+		next = rule_time(next, &offset);
+		if (next == NULL) return ZD_FAILURE;
+		p_rule->utc_offset[DST] = -offset;
 	}
-/** DEBUG
-	printf("rule details:\n\
-%c %6s j=%3d m=%2d w=%d d=%2d offset=%6d start_time=%6d h=%2d m=%2d s=%2d has_dst=%d save_secs=%d\n\
-%c %6s j=%3d m=%2d w=%d d=%2d offset=%6d start_time=%6d h=%2d m=%2d s=%2d has_dst=%d save_secs=%d\n",
-(int) p_rule->type[0], (char*) &p_rule->abbr[0], p_rule->j[0], p_rule->m[0], p_rule->w[0], p_rule->d[0],
-p_rule->offset[0], p_rule->start_time[0], p_rule->hour[0], p_rule->min[0], p_rule->sec[0], p_rule->has_dst, p_rule->save_secs[0],
-(int) p_rule->type[1], (char*) &p_rule->abbr[1], p_rule->j[1], p_rule->m[1], p_rule->w[1], p_rule->d[1],
-p_rule->offset[1], p_rule->start_time[1], p_rule->hour[1], p_rule->min[1], p_rule->sec[1], p_rule->has_dst, p_rule->save_secs[1]
-);
-exit(0);
-*/
+	else p_rule->utc_offset[DST] = p_rule->utc_offset[STD] + 3600;
+	p_rule->save_secs = abs(p_rule->utc_offset[DST] - p_rule->utc_offset[STD]);
+
+	/// zic always writes both dates; the default is the US rule
+	if (*next == '\0') next = ",M3.2.0,M11.1.0";
+	if (*next != ',') return ZD_FAILURE;
+	next = rule_date(next + 1, &p_rule->change[DST]);
+	if ( (next == NULL) || (*next != ',') ) return ZD_FAILURE;
+	next = rule_date(next + 1, &p_rule->change[STD]);
+	if ( (next == NULL) || (*next != '\0') ) return ZD_FAILURE;
 	return ZD_SUCCESS;
 }
 
-void init_tm_struct( struct tm *tmx )
+
+/************************************************************
+* days_from_civil
+*
+* days from 1970-01-01 to a proleptic gregorian date; month
+* is 1 - 12.
+************************************************************/
+static long days_from_civil( long year, const int month, const int day )
+{
+	long era;
+	long year_of_era, day_of_year;
+
+	year -= (month <= 2);
+	era = ((year >= 0) ? year : year - 399) / 400;
+	year_of_era = year - era * 400;
+	day_of_year = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+	return era * 146097 + year_of_era * 365 + year_of_era / 4
+		 - year_of_era / 100 + day_of_year - 719468;
+}
+
+
+/************************************************************
+* year_of_time
+*
+* the proleptic gregorian year in which t falls
+************************************************************/
+static long year_of_time( const time_t t )
+{
+	long days, era, day_of_era, year_of_era, day_of_year;
+
+	days = t / 86400;
+	if ((t % 86400) < 0) days--;
+	days += 719468;
+	era = ((days >= 0) ? days : days - 146096) / 146097;
+	day_of_era = days - era * 146097;
+	year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524
+				   - day_of_era / 146096) / 365;
+	day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+	/// the era begins on March 1st
+	return year_of_era + era * 400 + ((day_of_year >= 306) ? 1 : 0);
+}
+
+
+/************************************************************
+* rule_change_time
+*
+* the instant, in seconds from epoch, at which the rule
+* changes into state 'to' during 'year'. The time of day is
+* local time of the state being left.
+************************************************************/
+static time_t rule_change_time( const rule_detail* p_rule, const int to, const long year )
 {
-		tmx->tm_sec = 0;
-		tmx->tm_min = 0;
-		tmx->tm_hour = 0;
-		tmx->tm_mday = 0;
-		tmx->tm_mon = 0;
-		tmx->tm_year = 0;
-		tmx->tm_wday = 0;
-		tmx->tm_yday = 0;
-		tmx->tm_isdst = 0;
+	const rule_change* change = &p_rule->change[to];
+	int leap = ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+	int month_days[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+	long day;
+
+	switch (change->type)
+	{
+	case 'J': day = days_from_civil(year, 1, 1) + change->j - 1
+					+ ((leap && (change->j >= 60)) ? 1 : 0);
+			  break;
+	case 'N': day = days_from_civil(year, 1, 1) + change->j;
+			  break;
+	default:  day = days_from_civil(year, change->m, 1);
+			  /// 1970-01-01 was a Thursday
+			  day += (change->d - (((day + 4) % 7) + 7) % 7 + 7) % 7;
+			  day += (change->w - 1) * 7;
+			  if (leap) month_days[1] = 29;
+			  while (day >= days_from_civil(year, change->m, 1) + month_days[change->m - 1])
+				  day -= 7;
+			  break;
+	}
+	return (time_t) day * 86400 + change->time - p_rule->utc_offset[(to == DST) ? STD : DST];
 }
 
-int utc_seconds( const struct tm *tmx )
+
+/************************************************************
+* rule_state
+*
+* STD or DST, the state of the rule at instant t
+************************************************************/
+static int rule_state( const rule_detail* p_rule, const time_t t )
 {
-	return tmx->tm_sec + (tmx->tm_min * 60) + (tmx->tm_hour * 3600);
+	long year;
+	time_t to_dst, to_std;
+
+	if (!p_rule->has_dst) return STD;
+	year = year_of_time(t + p_rule->utc_offset[STD]);
+	to_dst = rule_change_time(p_rule, DST, year);
+	to_std = rule_change_time(p_rule, STD, year);
+	if (to_dst < to_std) return ((t >= to_dst) && (t < to_std)) ? DST : STD;
+	/// southern hemisphere; DST spans the new year
+	return ((t >= to_std) && (t < to_dst)) ? STD : DST;
 }
 
-int rule_dump( const char* tzif, const size_t tzif_size,
+
+/************************************************************
+* rule_next_change
+*
+* the first instant after t at which the rule changes into
+* state 'to'
+************************************************************/
+static time_t rule_next_change( const rule_detail* p_rule, const int to, const time_t t )
+{
+	long year;
+	time_t change;
+
+	year = year_of_time(t + p_rule->utc_offset[STD]) - 1;
+	do change = rule_change_time(p_rule, to, year++);
+	while (change <= t);
+	return change;
+}
+
+
+int rule_dump( const rule_detail* p_rule,
 					  const time_t start, const time_t end, time_t current,
 					  int* num_entries, void** return_data, size_t *ret_buff_size)
 {
-	rule_detail p_rule;
-	time_t prior;
-	struct tm tm_local, tm_gmt, tm_prior;
-	int utc_offset;
-	int save_secs;
 	zdumpinfo* zd;
 	int i;
 
-// PARTIALLY DONE: Make this a little simpler by using the glibc
-// version of struct tm which has additional fields:
-//
-//  long tm_gmtoff;           /* Seconds east of UTC */
-//  const char *tm_zone;      /* Timezone abbreviation */
-// returned by gmtime_r localtime_r
-	if (rule_decode( tzif, tzif_size, &p_rule ) == ZD_FAILURE) return ZD_FAILURE;
-	init_tm_struct(&tm_local);
-	init_tm_struct(&tm_gmt);
 	if (current < start)
 	{
-		// We really should try to be totally independant of
-		// these two functions localtime_r() and gmtime_r()
-		localtime_r(&start, &tm_local);
-		gmtime_r(&start, &tm_gmt);
-		utc_offset = utc_seconds(&tm_local) - utc_seconds(&tm_gmt);
-		// FIXME - account for possibility of initial transition being
-		// from standard to standard or DST to DST, with different offsets
-		if (tm_local.tm_isdst <= 0) save_secs = tm_local.tm_isdst;
-		else
-		{
-			localtime_r(&current, &tm_prior);
-			gmtime_r(&current, &tm_gmt);
-			save_secs = abs(utc_offset
-						- (utc_seconds(&tm_prior) - utc_seconds(&tm_gmt)) );
-		}
+		current = start;
+		i = rule_state(p_rule, current);
 		if ( !( *num_entries%BUFFER_INCREMENT) )
 		{
 			*return_data = perform_a_realloc(*return_data, ret_buff_size);
 			if (*return_data == NULL) return ZD_FAILURE;
 		}
-		add_a_rule_entry( start, *return_data, num_entries, tm_local.tm_gmtoff, save_secs, tm_local.tm_zone );
-		if (!p_rule.has_dst) return ZD_SUCCESS;
-		memcpy( (char*) &tm_prior, (char*) &tm_local, sizeof(struct tm));
+		add_a_rule_entry( start, *return_data, num_entries, p_rule->utc_offset[i],
+						  (i == DST) ? p_rule->save_secs : 0, p_rule->abbr[i] );
+		if (!p_rule->has_dst) return ZD_SUCCESS;
 	}
 	else
 	{
 		zd = (zdumpinfo*) *return_data + (*num_entries - 1);
-		prior = zd->start;
-		localtime_r(&prior, &tm_prior);
+		current = zd->start;
+		if (!p_rule->has_dst) return ZD_SUCCESS;
+		i = rule_state(p_rule, current);
 	}
-	if ((!tm_prior.tm_isdst) && (!p_rule.has_dst)) return ZD_SUCCESS;
-	i = tm_prior.tm_isdst > 0 ? 1 : 0;
 	while (1)
 	{
-		tm_local.tm_hour = p_rule.hour[i];
-		tm_local.tm_min  = p_rule.min[i];
-		tm_local.tm_sec  = p_rule.sec[i];
-		switch (p_rule.type[i])
+		i = (i == DST) ? STD : DST;
+		current = rule_next_change(p_rule, i, current);
+		if (current > end) break;
+		/// a rule such as "J1/0,J365/25" is in DST all year round,
+		/// so its nominal changes are not transitions
+		if (rule_state(p_rule, current) != i)
 		{
-		case 'M':
-			tm_local.tm_mday = 1;
-			tm_local.tm_mon = p_rule.m[i] - 1;
-			if ( tm_prior.tm_mon < tm_local.tm_mon ) tm_local.tm_year = tm_prior.tm_year;
-			else tm_local.tm_year = tm_prior.tm_year + 1;
-			current = mktime(&tm_local);
-			tm_local.tm_mday = ((p_rule.w[i]-1)*7) + p_rule.d[i] + 1 + (7 - tm_local.tm_wday);
-			break;
-		case 'J':
-			if ( tm_prior.tm_yday < p_rule.j[i] ) tm_local.tm_year = tm_prior.tm_year;
-			else tm_local.tm_year = tm_prior.tm_year + 1;
-			tm_local.tm_mday  = p_rule.j[i];
-			tm_local.tm_mon  = 0;
-			break;
-		default: return ZD_FAILURE; break;
+			i = (i == DST) ? STD : DST;
+			continue;
 		}
-		current = mktime(&tm_local);
-		if (current > end) break;
 		if ( !( *num_entries%BUFFER_INCREMENT) )
 		{
 			*return_data = perform_a_realloc(*return_data, ret_buff_size);
 			if (*return_data == NULL) return ZD_FAILURE;
 		}
-		add_a_rule_entry( current, *return_data, num_entries, tm_local.tm_gmtoff,
-							p_rule.save_secs[i], tm_local.tm_zone );
-		// this next is only for the first pass
-		if (!p_rule.has_dst) return ZD_SUCCESS;
-		memcpy( (char*) &tm_prior, (char*) &tm_local, sizeof(struct tm));
-		i = i > 0 ? 0 : 1;
+		add_a_rule_entry( current, *return_data, num_entries, p_rule->utc_offset[i],
+						  (i == DST) ? p_rule->save_secs : 0, p_rule->abbr[i] );
 	}
 	return ZD_SUCCESS;
 }
 
 
-int zdump(               /// returns 0 on ZD_SUCCESS, -1 on ZD_FAILURE
-    const char* tzname,  /// fully-qualified time-zone name (eg. Asia/Baku)
-                         ///    if NULL, use current system timezone
-    const time_t start,  /// seconds from epoch to be scanned
-    const time_t end,    /// seconds from epoch to be scanned
-    int* num_entries,    /// upon ZD_SUCCESSful return, int will contain number
-                         ///    of dst transitions + 1, for the interval
-                         ///    'start' to 'end'. The first entry will
-                         ///    always be the tz state at time_t start.
-                         ///    Returns 0 on ZD_FAILURE.
-    void** return_data   /// upon ZD_SUCCESSful return, will contain a pointer
-                         ///    to a malloc()ed space of 'num_entries' of
-                         ///    'tzinfo' data, as described below, sorted
-                         ///    in ascending chronological order.
-                         ///    Returns NULL on ZD_FAILURE.
-          )
+/************************************************************
+* zone_dir_open
+*
+* returns a descriptor for a zoneinfo directory, opened upon
+* first use and kept for the life of the process, or -1 if
+* the path is not a directory. Call with zone_cache_mutex held.
+************************************************************/
+static int zone_dir_open( const char* path )
+{
+	zd_dir* dir;
+	int fd;
+
+	for (dir = zone_dirs; dir != NULL; dir = dir->next)
+		if (strcmp(dir->path, path) == 0) return dir->fd;
+	fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd == -1) return -1;
+	dir = malloc(sizeof(zd_dir));
+	if (dir == NULL) {close(fd); return -1;};
+	dir->path = strdup(path);
+	if (dir->path == NULL) {close(fd); free(dir); return -1;};
+	dir->fd = fd;
+	dir->next = zone_dirs;
+	zone_dirs = dir;
+	return fd;
+}
+
+
+/************************************************************
+* zone_dir_name
+*
+* the zoneinfo directory in which to look for tzname: TZDIR if
+* set, else the standard locations. Absolute names need none.
+************************************************************/
+static void zone_default_dir_init( void )
 {
-// TODO - report errors and set errno
-	char* startdir = NULL;	/// current working directory on entry to this function
-	char* tzdir     = NULL;	/// system base timezone directory
 	char* tzdirlist[2] = { "/usr/share/zoneinfo/",	/// libc >= 5.4.6
 						   "/usr/lib/zoneinfo/" };	/// libc <  5.4.6
-	char* localtime_name = "localtime";
-	struct stat file_status;
-	char* tzif = NULL;		/// tz file copied into memory here
+	struct stat dir_status;
+
+	if ( (stat(tzdirlist[0], &dir_status) == 0) && (S_ISDIR(dir_status.st_mode)) )
+		zone_default_dir = tzdirlist[0];
+	else zone_default_dir = tzdirlist[1];
+}
+
+static const char* zone_dir_name( const char* tzname )
+{
+	char* tzdir;
+
+	if (tzname[0] == '/') return "";
+	tzdir = getenv("TZDIR");
+	if (tzdir != NULL) return tzdir;
+	pthread_once(&zone_default_dir_once, zone_default_dir_init);
+	return zone_default_dir;
+}
+
+
+/************************************************************
+* zone_parse
+*
+* decodes the mapped TZif file. For version 2 and later
+* files, the 64-bit data block and the POSIX TZ footer are
+* used; for version 1 files, the 32-bit block.
+************************************************************/
+static int zone_parse( zd_zone* zone )
+{
 	timezonefileheader tzh;
-	char* start_ptr;		/// point in *tzif where we start to parse
+	const char* start_ptr;	/// point in map where we start to parse
+	const char* footer_ptr;
+	size_t data_size;
 	unsigned int field_size;/// different for tzif and tzif2
-	FILE *tz_file;
-	int result;
-	unsigned int i;
-	signed long temp_long;
-	size_t ret_buff_size = 0;
-	char *transition_time_ptr;
+	long unsigned i;
 
-	*num_entries = 0;
-	if (end < start) return ZD_BAD_VALUES;
-	startdir = getcwd( NULL, 0 );
-	tzdir = getenv("TZDIR");
-	result = ZD_DIR_PATH;
-	if (tzdir != NULL) result = chdir(tzdir);
-	if (result)        result = chdir(tzdirlist[0]);
-	if (result)        result = chdir(tzdirlist[1]);
-	if (result)        return ZD_DIR_PATH;
-	result = ZD_SUCCESS;
-	if (tzname == NULL) tzname = localtime_name;
-	tz_file = fopen(tzname, "rb");
-	if (tz_file == NULL) {result= ZD_FOPEN; goto endpoint;};
-	if (fstat( fileno(tz_file), &file_status) != 0) {result= ZD_FREAD; goto endpoint;};
-	tzif = malloc( file_status.st_size );
-	if (tzif == NULL)  {result= ZD_MALLOC; goto endpoint;};
-	if (fread( tzif, file_status.st_size, 1, tz_file) != 1 )  {result= ZD_FREAD; goto endpoint;};
-	fclose(tz_file);
-	if (!read_tz_header( &tzh, tzif)) {result= ZD_TZIF_HEADER; goto endpoint;};
-	if (tzh.magicnumber[4] == 50 )
+	if (zone->map_size < HEADER_LEN) return ZD_TZIF_HEADER;
+	if (memcmp(zone->map, "TZif", 4) != 0) return ZD_TZIF_HEADER;
+	if ( (!read_tz_header( &tzh, zone->map )) && (zone->map[4] < '2') )
+		return ZD_TZIF_HEADER;
+	start_ptr = &zone->map[HEADER_LEN];
+	field_size = TZIF1_FIELD_SIZE;
+
+	if (zone->map[4] >= '2')
 	{
-		start_ptr = memmem( &tzif[HEADER_LEN], file_status.st_size - HEADER_LEN, "TZif2", 5 );
-		if (start_ptr == NULL) {result= ZD_TZIF_HEADER; goto endpoint;};
-		if (read_tz_header( &tzh, start_ptr ) == ZD_FAILURE ) {result= ZD_TZIF_HEADER; goto endpoint;};
-		start_ptr = start_ptr + HEADER_LEN;
+		/// skip the version 1 data block to reach the second header
+		start_ptr += tzh.timecnt * TZIF1_FIELD_SIZE + tzh.timecnt
+				   + tzh.typecnt * SIZE_OF_TTINFO + tzh.charcnt
+				   + tzh.leapcnt * (TZIF1_FIELD_SIZE + 4)
+				   + tzh.ttisstdcnt + tzh.ttisgmtcnt;
+		if ( (start_ptr + HEADER_LEN > zone->map + zone->map_size) ||
+			 (memcmp(start_ptr, "TZif", 4) != 0) )
+			return ZD_TZIF_HEADER;
+		read_tz_header( &tzh, start_ptr );
+		if (tzh.typecnt == 0) return ZD_TZIF_HEADER;
+		start_ptr += HEADER_LEN;
 		field_size = TZIF2_FIELD_SIZE;
 	}
-	else
+
+	data_size = tzh.timecnt * field_size + tzh.timecnt
+			  + tzh.typecnt * SIZE_OF_TTINFO + tzh.charcnt;
+	if (start_ptr + data_size > zone->map + zone->map_size) return ZD_TZIF_HEADER;
+
+	zone->timecnt = tzh.timecnt;
+	zone->typecnt = tzh.typecnt;
+	zone->charcnt = tzh.charcnt;
+	zone->transition = malloc( sizeof(time_t) * (tzh.timecnt + 1) );
+	zone->type_index = malloc( tzh.timecnt + 1 );
+	if ( (zone->transition == NULL) || (zone->type_index == NULL) ) return ZD_MALLOC;
+	for (i=0; i<tzh.timecnt; i++)
 	{
-		start_ptr = &tzif[HEADER_LEN];
-		field_size = TZIF1_FIELD_SIZE;
+		zone->transition[i] = (time_t) flip_tz_long( start_ptr + i * field_size, field_size );
+		zone->type_index[i] = start_ptr[ tzh.timecnt * field_size + i ];
+		if (zone->type_index[i] >= tzh.typecnt) return ZD_TZIF_HEADER;
 	}
+	zone->ttinfo = start_ptr + tzh.timecnt * field_size + tzh.timecnt;
+	zone->abbrev = zone->ttinfo + tzh.typecnt * SIZE_OF_TTINFO;
 
-	transition_time_ptr = start_ptr;
-	local_time_type_ptr = start_ptr + tzh.timecnt*field_size;
-	ttinfo_ptr = local_time_type_ptr + tzh.timecnt;
-	tz_abbrev_ptr = ttinfo_ptr + (tzh.typecnt * 6);
-	// TODO - replace this incremental search with something more efficient
-	for (i=0; i<tzh.timecnt; i++)
+	/// the footer is the last newline-enclosed line of the file
+	zone->rule = NULL;
+	if ( (field_size == TZIF2_FIELD_SIZE) && (zone->map[zone->map_size - 1] == '\x0a') )
 	{
-		temp_long = flip_tz_long( transition_time_ptr, field_size );
-		if (temp_long >= start)
+		footer_ptr = memrchr( zone->map, '\x0a', zone->map_size - 1 );
+		if (footer_ptr != NULL)
+		{
+			footer_ptr++;
+			zone->rule = strndup( footer_ptr, zone->map + zone->map_size - 1 - footer_ptr );
+			if (zone->rule == NULL) return ZD_MALLOC;
+		}
+	}
+	return ZD_SUCCESS;
+}
+
+
+/************************************************************
+* zone_load
+*
+* maps and parses a TZif file. returns NULL on failure, and
+* the error code in *result.
+************************************************************/
+static zd_zone* zone_load( const char* dir, const char* tzname, int* result )
+{
+	zd_zone* zone;
+	struct stat file_status;
+	int dir_fd = AT_FDCWD;
+	int fd;
+
+	if (dir[0] != '\0')
+	{
+		dir_fd = zone_dir_open(dir);
+		if (dir_fd == -1) {*result = ZD_DIR_PATH; return NULL;};
+	}
+	zone = calloc(1, sizeof(zd_zone));
+	if (zone == NULL) {*result = ZD_MALLOC; return NULL;};
+	zone->dir = strdup(dir);
+	zone->name = strdup(tzname);
+	if ( (zone->dir == NULL) || (zone->name == NULL) ) {*result = ZD_MALLOC; goto load_failure;};
+	fd = openat(dir_fd, tzname, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {*result = ZD_FOPEN; goto load_failure;};
+	if ( (fstat(fd, &file_status) != 0) || (file_status.st_size == 0) )
+	{
+		close(fd);
+		*result = ZD_FREAD;
+		goto load_failure;
+	}
+	zone->map_size = file_status.st_size;
+	zone->map = mmap(NULL, zone->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (zone->map == MAP_FAILED)
+	{
+		zone->map = NULL;
+		*result = ZD_FREAD;
+		goto load_failure;
+	}
+	*result = zone_parse(zone);
+	if (*result == ZD_SUCCESS)
+	{
+		if (rule_decode(zone->rule, &zone->p_rule) == ZD_SUCCESS) zone->has_rule = 1;
+		return zone;
+	}
+
+load_failure:
+	if (zone->map != NULL) munmap(zone->map, zone->map_size);
+	free(zone->transition);
+	free(zone->type_index);
+	free(zone->rule);
+	free(zone->dir);
+	free(zone->name);
+	free(zone);
+	return NULL;
+}
+
+
+/************************************************************
+* zone_lookup
+*
+* searches the zone cache. Zones are only ever prepended, and
+* never released, so readers need no lock.
+************************************************************/
+static const zd_zone* zone_lookup( const char* dir, const char* tzname )
+{
+	const zd_zone* zone;
+
+	for (zone = __atomic_load_n(&zone_cache, __ATOMIC_ACQUIRE);
+		 zone != NULL; zone = zone->next)
+		if ( (strcmp(zone->name, tzname) == 0) && (strcmp(zone->dir, dir) == 0) )
+			return zone;
+	return NULL;
+}
+
+
+int zdump_zone_open(     /// returns 0 on ZD_SUCCESS, or a ZD_ error code
+    const char* tzname,  /// fully-qualified time-zone name (eg. Asia/Baku)
+                         ///    if NULL, use current system timezone
+    const zd_zone** zone /// upon ZD_SUCCESSful return, the zone. It is
+                         ///    owned by the library, is never released,
+                         ///    and may be shared among threads.
+          )
+{
+	const char* dir;
+	zd_zone* new_zone;
+	int result = ZD_SUCCESS;
+
+	if (tzname == NULL) tzname = "localtime";
+	dir = zone_dir_name(tzname);
+	*zone = zone_lookup(dir, tzname);
+	if (*zone != NULL) return ZD_SUCCESS;
+
+	pthread_mutex_lock(&zone_cache_mutex);
+	*zone = zone_lookup(dir, tzname);
+	if (*zone == NULL)
+	{
+		new_zone = zone_load(dir, tzname, &result);
+		if (new_zone != NULL)
+		{
+			new_zone->next = zone_cache;
+			__atomic_store_n(&zone_cache, new_zone, __ATOMIC_RELEASE);
+			*zone = new_zone;
+		}
+	}
+	pthread_mutex_unlock(&zone_cache_mutex);
+	return result;
+}
+
+
+/************************************************************
+* zone_search
+*
+* returns the index of the first transition at or after t,
+* or zone->timecnt if there is none.
+************************************************************/
+static long unsigned zone_search( const zd_zone* zone, const time_t t )
+{
+	long unsigned low = 0;
+	long unsigned high = zone->timecnt;
+	long unsigned mid;
+
+	while (low < high)
+	{
+		mid = low + (high - low) / 2;
+		if (zone->transition[mid] < t) low = mid + 1;
+		else high = mid;
+	}
+	return low;
+}
+
+
+int zdump_offset(        /// returns 0 on ZD_SUCCESS, or a ZD_ error code
+    const zd_zone* zone, /// as returned by zdump_zone_open()
+    const time_t t,      /// seconds from epoch
+    int* utc_offset,     /// upon ZD_SUCCESSful return, seconds east of UTC
+    int* isdst,          /// upon ZD_SUCCESSful return, non-zero if dst.
+                         ///    may be NULL
+    char* abbr           /// upon ZD_SUCCESSful return, the abbreviation, in
+                         ///    MAX_TZ_ABBR_SIZE characters. may be NULL
+          )
+{
+	long unsigned i;
+	int state;
+	const char* ttinfo;
+	const char* tzabbr;
+
+	/// first transition after t
+	i = (t == LONG_MAX) ? zone->timecnt : zone_search(zone, t + 1);
+	if ( (i == zone->timecnt) && (zone->has_rule) &&
+		 ((zone->timecnt == 0) || (t > zone->transition[zone->timecnt - 1])) )
+	{
+		state = rule_state(&zone->p_rule, t);
+		*utc_offset = zone->p_rule.utc_offset[state];
+		if (isdst != NULL) *isdst = (state == DST);
+		if (abbr != NULL) memcpy(abbr, zone->p_rule.abbr[state], MAX_TZ_ABBR_SIZE);
+		return ZD_SUCCESS;
+	}
+	/// before the first transition, local time type 0 applies
+	ttinfo = &zone->ttinfo[ ((i > 0) ? zone->type_index[i-1] : 0) * SIZE_OF_TTINFO ];
+	*utc_offset = (int) flip_tz_long( ttinfo, 4);
+	if (isdst != NULL) *isdst = (ttinfo[4] != 0);
+	if (abbr != NULL)
+	{
+		tzabbr = &zone->abbrev[ (unsigned char) ttinfo[5] ];
+		if (tzabbr >= zone->abbrev + zone->charcnt) tzabbr = "";
+		memset(abbr, '\0', MAX_TZ_ABBR_SIZE);
+		memcpy(abbr, tzabbr, strnlen(tzabbr, MAX_TZ_ABBR_SIZE - 1));
+	}
+	return ZD_SUCCESS;
+}
+
+
+int zdump_r(             /// returns 0 on ZD_SUCCESS, -1 on ZD_FAILURE
+    const zd_zone* zone, /// as returned by zdump_zone_open()
+    const time_t start,  /// seconds from epoch to be scanned
+    const time_t end,    /// seconds from epoch to be scanned
+    int* num_entries,    /// as for zdump()
+    void** return_data   /// as for zdump()
+          )
+{
+	int result = ZD_SUCCESS;
+	long unsigned i;
+	time_t last_transition;
+	size_t ret_buff_size = 0;
+
+	*num_entries = 0;
+	if (end < start) return ZD_BAD_VALUES;
+
+	i = zone_search(zone, start);
+	if (i < zone->timecnt)
+	{
+		*return_data = perform_a_realloc(*return_data, &ret_buff_size);
+		if (*return_data == NULL) {result= ZD_MALLOC; goto endpoint;};
+		add_a_tzif_entry( zone, i>0 ? i-1: 0, start, *return_data, num_entries );
+	}
+	while ( (i < zone->timecnt) && (zone->transition[i] <= end) )
+	{
+		if ( !( *num_entries%BUFFER_INCREMENT) )
 		{
 			*return_data = perform_a_realloc(*return_data, &ret_buff_size);
 			if (*return_data == NULL) {result= ZD_MALLOC; goto endpoint;};
-			add_a_tzif_entry( i>0 ? i-1: 0, (time_t) start, *return_data, num_entries );
-			break;
 		}
-		transition_time_ptr = transition_time_ptr + field_size;
+		add_a_tzif_entry( zone, i, zone->transition[i], *return_data, num_entries );
+		i++;
 	}
-	while (i < tzh.timecnt)
+	last_transition = (zone->timecnt) ? zone->transition[zone->timecnt - 1] : start - 1;
+	if ((i == zone->timecnt) && (last_transition < end))
 	{
-		temp_long = flip_tz_long( transition_time_ptr, field_size );
-		if (temp_long > end) break;
-		if ( !( *num_entries%BUFFER_INCREMENT) ) *return_data = perform_a_realloc(*return_data, &ret_buff_size);
-		add_a_tzif_entry( i, (time_t) temp_long, *return_data, num_entries );
-		transition_time_ptr = transition_time_ptr + field_size;
-		i++;
+		if (!zone->has_rule) result = ZD_FAILURE;
+		else result = rule_dump(&zone->p_rule, start, end, last_transition,
+							num_entries, return_data, &ret_buff_size);
 	}
-	if ((i == tzh.timecnt) && (temp_long < end))
-		result = rule_dump(tzif, file_status.st_size-2, start, end, (time_t) temp_long,
-						num_entries, return_data, &ret_buff_size);
 
 /// cleanup and exit
 endpoint:
-	if (tzif != NULL) free(tzif);
-	chdir(startdir);
-	if (!(*num_entries))
+	if ( (*return_data == NULL) || (!(*num_entries)) )
 	{
 		if (*return_data != NULL) free(*return_data);
+		*return_data = NULL;
+		*num_entries = 0;
 		result = ZD_FAILURE;
 	}
 	return result;
 }
+
+
+int zdump(               /// returns 0 on ZD_SUCCESS, -1 on ZD_FAILURE
+    const char* tzname,  /// fully-qualified time-zone name (eg. Asia/Baku)
+                         ///    if NULL, use current system timezone
+    const time_t start,  /// seconds from epoch to be scanned
+    const time_t end,    /// seconds from epoch to be scanned
+    int* num_entries,    /// upon ZD_SUCCESSful return, int will contain number
+                         ///    of dst transitions + 1, for the interval
+                         ///    'start' to 'end'. The first entry will
+                         ///    always be the tz state at time_t start.
+                         ///    Returns 0 on ZD_FAILURE.
+    void** return_data   /// upon ZD_SUCCESSful return, will contain a pointer
+                         ///    to a malloc()ed space of 'num_entries' of
+                         ///    'tzinfo' data, as described below, sorted
+                         ///    in ascending chronological order.
+                         ///    Returns NULL on ZD_FAILURE.
+          )
+{
+// TODO - report errors and set errno
+	const zd_zone* zone;
+	int result;
+
+	*num_entries = 0;
+	if (end < start) return ZD_BAD_VALUES;
+	result = zdump_zone_open(tzname, &zone);
+	if (result != ZD_SUCCESS) return result;
+	return zdump_r(zone, start, end, num_entries, return_data);
+}
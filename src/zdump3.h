@@ -48,6 +48,40 @@ zdump(                   /// returns 0 on success, -1 on failure
           );
 
 
+/// zd_zone - a parsed timezone, owned and cached by the library.
+/// A zone is immutable once opened, so that any number of threads
+/// may query it concurrently.
+typedef struct zd_zone zd_zone;
+
+extern int
+zdump_zone_open(         /// returns 0 on success, or a ZD_ error code
+    const char* tzname,  /// fully-qualified time-zone name (eg. Asia/Baku)
+                         ///    if NULL, use current system timezone
+    const zd_zone** zone /// upon successful return, the zone. It is never
+                         ///    released, and may be shared among threads.
+          );
+
+extern int
+zdump_r(                 /// reentrant zdump(); returns 0 on success
+    const zd_zone* zone, /// as returned by zdump_zone_open()
+    const time_t start,  /// seconds from epoch to be scanned
+    const time_t end,    /// seconds from epoch to be scanned
+    int* num_entries,    /// as for zdump()
+    void** return_data   /// as for zdump()
+          );
+
+extern int
+zdump_offset(            /// returns 0 on success, or a ZD_ error code
+    const zd_zone* zone, /// as returned by zdump_zone_open()
+    const time_t t,      /// seconds from epoch; queries may be in any order
+    int* utc_offset,     /// upon successful return, seconds east of UTC
+    int* isdst,          /// upon successful return, non-zero if dst.
+                         ///    may be NULL
+    char* abbr           /// upon successful return, the abbreviation, in
+                         ///    MAX_TZ_ABBR_SIZE characters. may be NULL
+          );
+
+
 #define ZD_SUCCESS  0
 #define ZD_FAILURE -1
 #define ZD_BAD_VALUES  5001 /** time_t start > time_t end */